@@ -0,0 +1,106 @@
+#pragma once
+
+#include <juce_audio_basics/juce_audio_basics.h>
+#include <juce_dsp/juce_dsp.h>
+#include <array>
+#include <atomic>
+
+//==============================================================================
+/**
+ * AudioTap
+ *
+ * Single-producer/single-consumer ring of recent audio, from the audio thread
+ * to one reader (the editor's analysers). push() is a bounds check and a copy
+ * per channel into storage allocated in the constructor; a block that does not
+ * fit is dropped whole and counted, so the audio thread never waits.
+ *
+ * Up to maxChannels channels are kept; mono input is duplicated so readers can
+ * always assume two.
+ */
+class AudioTap
+{
+public:
+    static constexpr int capacity = 16384; // per channel; ~340 ms at 48 kHz
+    static constexpr int maxChannels = 2;
+
+    AudioTap() { storage.setSize(maxChannels, capacity); }
+
+    /** Audio thread. */
+    void push(const juce::dsp::AudioBlock<const float>& block) noexcept
+    {
+        const auto numSamples = static_cast<int>(block.getNumSamples());
+        const auto numChannels = static_cast<int>(block.getNumChannels());
+        if (numSamples == 0 || numChannels == 0)
+            return;
+
+        if (fifo.getFreeSpace() < numSamples)
+        {
+            dropped.fetch_add(1, std::memory_order_relaxed);
+            return;
+        }
+
+        const auto scope = fifo.write(numSamples);
+
+        for (int ch = 0; ch < maxChannels; ++ch)
+        {
+            const auto* source = block.getChannelPointer(static_cast<size_t>(juce::jmin(ch, numChannels - 1)));
+            auto* dest = storage.getWritePointer(ch);
+
+            if (scope.blockSize1 > 0)
+                std::memcpy(dest + scope.startIndex1, source, static_cast<size_t>(scope.blockSize1) * sizeof(float));
+            if (scope.blockSize2 > 0)
+                std::memcpy(dest + scope.startIndex2, source + scope.blockSize1, static_cast<size_t>(scope.blockSize2) * sizeof(float));
+        }
+    }
+
+    /** Reader. Copies everything pushed since the last read into dest (two channels),
+        skipping the oldest samples if there are more than dest holds. Returns the count. */
+    int read(juce::AudioBuffer<float>& dest)
+    {
+        jassert(dest.getNumChannels() >= maxChannels);
+
+        auto ready = fifo.getNumReady();
+        if (ready > dest.getNumSamples())
+        {
+            fifo.finishedRead(ready - dest.getNumSamples());
+            ready = dest.getNumSamples();
+        }
+
+        const auto scope = fifo.read(ready);
+
+        for (int ch = 0; ch < maxChannels; ++ch)
+        {
+            if (scope.blockSize1 > 0)
+                dest.copyFrom(ch, 0, storage, ch, scope.startIndex1, scope.blockSize1);
+            if (scope.blockSize2 > 0)
+                dest.copyFrom(ch, scope.blockSize1, storage, ch, scope.startIndex2, scope.blockSize2);
+        }
+
+        return ready;
+    }
+
+    /** Reader. Throws away whatever is queued, e.g. audio left over from before the
+        reader attached. */
+    void discard() { fifo.finishedRead(fifo.getNumReady()); }
+
+    /** Blocks dropped because the reader fell behind (diagnostics). */
+    int getNumDropped() const noexcept { return dropped.load(); }
+
+private:
+    juce::AbstractFifo fifo { capacity };
+    juce::AudioBuffer<float> storage;
+    std::atomic<int> dropped { 0 };
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(AudioTap)
+};
+
+//==============================================================================
+/** The processor's tap points. Written only while an analyser is attached. */
+struct SignalTaps
+{
+    enum Point { Input, PostFuzz, PostCompressor, Output, NumPoints };
+
+    AudioTap& operator[](Point point) noexcept { return points[static_cast<size_t>(point)]; }
+
+    std::array<AudioTap, NumPoints> points;
+};
@@ -0,0 +1,496 @@
+#include "BackingTrackPlayer.h"
+#include <cmath>
+
+namespace
+{
+    juce::String formatTime(double seconds)
+    {
+        const auto whole = static_cast<int>(seconds);
+        return juce::String::formatted("%02d:%02d", whole / 60, whole % 60);
+    }
+}
+
+//==============================================================================
+int BackingTrackPlayer::Index::getPoint(double seconds) const noexcept
+{
+    return juce::jlimit(0, numPoints - 1, static_cast<int>(seconds / interval));
+}
+
+juce::int64 BackingTrackPlayer::Index::getSourcePosition(int pointIndex) const noexcept
+{
+    return juce::jmin(length, static_cast<juce::int64>(std::llround(pointIndex * interval * fileRate)));
+}
+
+void BackingTrackPlayer::Stream::reset(juce::AudioFormatReader* newReader, juce::int64 newPosition) noexcept
+{
+    reader = newReader;
+    position = newPosition;
+    for (auto& interpolator : interpolators)
+        interpolator.reset();
+}
+
+juce::uint64 BackingTrackPlayer::packRequest(juce::uint32 requestGeneration, juce::uint32 indexId, int requestPoint, bool headUsed) noexcept
+{
+    return (static_cast<juce::uint64>(requestGeneration) << 32)
+         | (static_cast<juce::uint64>(indexId & 0xffff) << 16)
+         | (static_cast<juce::uint64>(requestPoint & 0x7fff) << 1)
+         | (headUsed ? 1u : 0u);
+}
+
+//==============================================================================
+BackingTrackPlayer::BackingTrackPlayer()
+{
+    formatManager.registerBasicFormats();
+
+    decodeThread.startThread();
+    readAheadThread.addTimeSliceClient(this);
+    readAheadThread.startThread(juce::Thread::Priority::high);
+}
+
+BackingTrackPlayer::~BackingTrackPlayer()
+{
+    readAheadThread.removeTimeSliceClient(this);
+    readAheadThread.stopThread(2000);
+
+    // The buffering readers are clients of decodeThread
+    source = nullptr;
+    pendingSource = nullptr;
+    decodeThread.stopThread(2000);
+}
+
+void BackingTrackPlayer::prepare(double sampleRate)
+{
+    const juce::ScopedLock sl(streamLock);
+
+    const auto frames = static_cast<int>(readAheadSeconds * sampleRate) + 1;
+    storage.setSize(2, frames);
+    fifo.setTotalSize(frames);
+    fifo.reset();
+
+    preparedRate = sampleRate;
+    needsIndex = true;
+    streamActive = false;
+
+    // The audio thread resumes from its position once it adopts the new index
+    smoothedGain.reset(sampleRate, 0.05);
+    headRemaining = 0;
+    streaming = false;
+}
+
+//==============================================================================
+bool BackingTrackPlayer::load(const juce::File& file, juce::String& error)
+{
+    auto* format = formatManager.findFormatForFileExtension(file.getFileExtension());
+    if (format == nullptr || ! file.existsAsFile())
+    {
+        error = "Cannot open " + file.getFileName();
+        return false;
+    }
+
+    auto next = std::make_unique<Source>();
+
+    // Uncompressed files are read straight from the page cache, one mapping per position
+    std::unique_ptr<juce::MemoryMappedAudioFormatReader> mapped(format->createMemoryMappedReader(file));
+    std::unique_ptr<juce::MemoryMappedAudioFormatReader> mappedIndex(format->createMemoryMappedReader(file));
+    if (mapped != nullptr && mappedIndex != nullptr && mapped->mapEntireFile() && mappedIndex->mapEntireFile())
+    {
+        next->streamReader = std::move(mapped);
+        next->indexReader = std::move(mappedIndex);
+        next->memoryMapped = true;
+    }
+    else
+    {
+        // Compressed: the stream is decoded ahead on decodeThread, the index decodes its own way
+        std::unique_ptr<juce::AudioFormatReader> reader(formatManager.createReaderFor(file));
+        next->indexReader.reset(formatManager.createReaderFor(file));
+        if (reader == nullptr || next->indexReader == nullptr)
+        {
+            error = "Cannot decode " + file.getFileName();
+            return false;
+        }
+
+        auto buffering = std::make_unique<juce::BufferingAudioReader>(reader.release(), decodeThread, decodeAheadFrames);
+        buffering->setReadTimeout(decodeTimeoutMs);
+        next->streamReader = std::move(buffering);
+    }
+
+    next->fileRate = next->indexReader->sampleRate;
+    next->length = next->indexReader->lengthInSamples;
+    if (next->fileRate <= 0.0 || next->length <= 0 || next->indexReader->numChannels == 0)
+    {
+        error = file.getFileName() + " has no audio";
+        return false;
+    }
+
+    next->serial = ++nextSerial;
+    playing.store(false, std::memory_order_relaxed);
+
+    loaded = true;
+    memoryMapped = next->memoryMapped;
+    name = file.getFileName();
+    lengthSeconds = static_cast<double>(next->length) / next->fileRate;
+
+    {
+        const juce::ScopedLock pl(pendingLock);
+        std::swap(pendingSource, next);
+    }
+
+    readAheadThread.notify();
+    return true; // A superseded pending source is freed here, on the message thread
+}
+
+//==============================================================================
+int BackingTrackPlayer::useTimeSlice()
+{
+    const juce::ScopedLock sl(streamLock);
+
+    indexPublisher.collectGarbage();
+    adoptSource();
+    if (source == nullptr || building == nullptr)
+        return 50;
+
+    serveRequest();
+
+    if (fillFifo())
+        return 0;
+
+    // The FIFO is full: index the track behind the playback
+    if (building->numReady.load(std::memory_order_relaxed) < building->numPoints)
+    {
+        buildNextHead();
+        return 0;
+    }
+
+    return 10;
+}
+
+void BackingTrackPlayer::adoptSource()
+{
+    std::unique_ptr<Source> next;
+    {
+        const juce::ScopedLock pl(pendingLock);
+        std::swap(next, pendingSource);
+    }
+
+    if (next != nullptr)
+    {
+        std::swap(source, next); // The previous track's readers go here
+        needsIndex = true;
+    }
+
+    if (needsIndex && source != nullptr && preparedRate > 0.0)
+    {
+        needsIndex = false;
+        publishIndex();
+    }
+}
+
+void BackingTrackPlayer::publishIndex()
+{
+    auto index = std::make_unique<Index>();
+    index->id = ++nextIndexId & 0xffff;
+    index->serial = source->serial;
+    index->fileRate = source->fileRate;
+    index->deviceRate = preparedRate;
+    index->length = source->length;
+
+    // Long tracks get a wider grid so the heads stay a few tens of MB
+    const auto trackSeconds = static_cast<double>(source->length) / source->fileRate;
+    index->interval = juce::jmax(indexIntervalSeconds, trackSeconds / maxIndexPoints);
+    index->numPoints = juce::jmax(1, static_cast<int>(std::ceil(trackSeconds / index->interval)));
+    index->headFrames = static_cast<int>(headSeconds * preparedRate);
+    index->heads.setSize(2, index->numPoints * index->headFrames);
+    index->headLengths.assign(static_cast<size_t>(index->numPoints), 0);
+
+    const auto ratio = source->fileRate / preparedRate;
+    input.setSize(2, static_cast<int>(std::ceil(chunkFrames * ratio)) + 2);
+    chunk.setSize(2, chunkFrames);
+
+    pointsIndexed.store(0, std::memory_order_relaxed);
+    numPoints.store(index->numPoints, std::memory_order_relaxed);
+
+    // Nothing is streamed until the audio thread asks for a position in this index
+    building = index.get();
+    streamActive = false;
+    indexPublisher.publish(std::move(index));
+}
+
+void BackingTrackPlayer::serveRequest()
+{
+    const auto word = request.load(std::memory_order_acquire);
+    const auto requestGeneration = static_cast<juce::uint32>(word >> 32);
+    if (requestGeneration == servedGeneration)
+        return;
+
+    // Everything written for older requests is already in the FIFO; once the audio
+    // thread has flushed it, consumerGeneration catches up and the refill starts
+    servedGeneration = requestGeneration;
+    producerGeneration.store(requestGeneration, std::memory_order_release);
+
+    const auto indexId = static_cast<juce::uint32>((word >> 16) & 0xffff);
+    if (indexId != building->id)
+    {
+        streamActive = false; // The audio thread has not adopted the newest index yet
+        return;
+    }
+
+    const auto requestPoint = static_cast<int>((word >> 1) & 0x7fff);
+    const auto headUsed = (word & 1) != 0;
+
+    // After a head, the stream starts at the point again with a fresh resampler, exactly
+    // as the head did, and drops what the head already played
+    stream.reset(source->streamReader.get(), building->getSourcePosition(requestPoint));
+    skipFrames = headUsed ? building->headLengths[static_cast<size_t>(requestPoint)] : 0;
+    streamActive = true;
+    ended = false;
+}
+
+bool BackingTrackPlayer::fillFifo()
+{
+    if (! streamActive || ended || consumerGeneration.load(std::memory_order_acquire) != servedGeneration)
+        return false;
+
+    if (fifo.getFreeSpace() < chunkFrames)
+        return false;
+
+    const auto frames = render(stream, chunkFrames);
+    if (frames < 0)
+        return false; // Still decoding; try again on the next slice
+
+    if (frames == 0)
+    {
+        ended = true;
+        endGeneration.store(servedGeneration, std::memory_order_release);
+        return false;
+    }
+
+    const auto skipped = juce::jmin(skipFrames, frames);
+    skipFrames -= skipped;
+
+    const auto toWrite = frames - skipped;
+    int start1, size1, start2, size2;
+    fifo.prepareToWrite(toWrite, start1, size1, start2, size2);
+    for (int ch = 0; ch < 2; ++ch)
+    {
+        if (size1 > 0)
+            storage.copyFrom(ch, start1, chunk, ch, skipped, size1);
+        if (size2 > 0)
+            storage.copyFrom(ch, start2, chunk, ch, skipped + size1, size2);
+    }
+    fifo.finishedWrite(size1 + size2);
+    return true;
+}
+
+void BackingTrackPlayer::buildNextHead()
+{
+    const auto k = building->numReady.load(std::memory_order_relaxed);
+    headStream.reset(source->indexReader.get(), building->getSourcePosition(k));
+
+    int produced = 0;
+    while (produced < building->headFrames)
+    {
+        const auto frames = render(headStream, juce::jmin(chunkFrames, building->headFrames - produced));
+        if (frames <= 0)
+            break;
+
+        for (int ch = 0; ch < 2; ++ch)
+            building->heads.copyFrom(ch, k * building->headFrames + produced, chunk, ch, 0, frames);
+        produced += frames;
+    }
+
+    building->headLengths[static_cast<size_t>(k)] = produced;
+    building->numReady.store(k + 1, std::memory_order_release);
+    pointsIndexed.store(k + 1, std::memory_order_relaxed);
+}
+
+int BackingTrackPlayer::render(Stream& from, int numFrames)
+{
+    const auto remaining = source->length - from.position;
+    if (remaining <= 0)
+        return 0;
+
+    const auto ratio = source->fileRate / building->deviceRate;
+    numFrames = static_cast<int>(juce::jmin(static_cast<juce::int64>(numFrames),
+                                            static_cast<juce::int64>(std::ceil(static_cast<double>(remaining) / ratio))));
+
+    // The interpolator pulls at most one input more than the ratio says; past the end it gets zeros
+    const auto needed = static_cast<int>(std::ceil(numFrames * ratio)) + 2;
+    const auto toRead = static_cast<int>(juce::jmin(static_cast<juce::int64>(needed), remaining));
+    const auto numChannels = juce::jmin(2, static_cast<int>(from.reader->numChannels));
+
+    input.clear(0, needed);
+    float* const channels[] = { input.getWritePointer(0), input.getWritePointer(1) };
+    if (! from.reader->read(channels, numChannels, from.position, toRead))
+        return -1;
+
+    if (numChannels == 1)
+        input.copyFrom(1, 0, input, 0, 0, toRead);
+
+    int consumed = 0;
+    for (int ch = 0; ch < 2; ++ch)
+        consumed = from.interpolators[static_cast<size_t>(ch)].process(ratio, input.getReadPointer(ch),
+                                                                        chunk.getWritePointer(ch), numFrames);
+
+    from.position = consumed > 0 ? from.position + consumed : source->length;
+    return numFrames;
+}
+
+//==============================================================================
+void BackingTrackPlayer::startSeek(const Index& index, int seekPoint) noexcept
+{
+    ++generation;
+    point = seekPoint;
+    headPosition = 0;
+    headRemaining = index.numReady.load(std::memory_order_acquire) > seekPoint
+                        ? index.headLengths[static_cast<size_t>(seekPoint)] : 0;
+    playedFrames = 0;
+    flushPending = true;
+    streaming = false;
+
+    request.store(packRequest(generation, index.id, seekPoint, headRemaining > 0), std::memory_order_release);
+    positionSeconds.store(seekPoint * index.interval, std::memory_order_relaxed);
+}
+
+void BackingTrackPlayer::mix(juce::AudioBuffer<float>& buffer, int destStart, const float* left, const float* right,
+                             int numSamples) noexcept
+{
+    const auto startGain = smoothedGain.getCurrentValue();
+    const auto endGain = smoothedGain.skip(numSamples);
+
+    const float* channels[] = { left, right };
+    for (int ch = 0; ch < juce::jmin(2, buffer.getNumChannels()); ++ch)
+        buffer.addFromWithRamp(ch, destStart, channels[ch], numSamples, startGain, endGain);
+}
+
+void BackingTrackPlayer::mixInto(juce::AudioBuffer<float>& buffer, int startSample, int numSamples) noexcept
+{
+    const auto* index = indexPublisher.acquire();
+    if (index == nullptr)
+        return;
+
+    // A new track starts at the top; the same track at a new rate carries on where it was
+    if (index != currentIndex || index->id != currentIndexId)
+    {
+        const auto sameTrack = currentIndex != nullptr && currentSerial == index->serial;
+        currentIndex = index;
+        currentIndexId = index->id;
+        currentSerial = index->serial;
+        startSeek(*index, sameTrack ? index->getPoint(positionSeconds.load(std::memory_order_relaxed)) : 0);
+    }
+
+    const auto requested = seekSeconds.exchange(-1.0, std::memory_order_acquire);
+    if (requested >= 0.0)
+        startSeek(*index, index->getPoint(requested));
+
+    // The read-ahead thread has stopped writing the old position: drop what it left
+    if (flushPending && producerGeneration.load(std::memory_order_acquire) == generation)
+    {
+        fifo.finishedRead(fifo.getNumReady());
+        consumerGeneration.store(generation, std::memory_order_release);
+        flushPending = false;
+    }
+
+    // Fade in on play and out on pause, rather than click
+    const auto wantPlaying = playing.load(std::memory_order_relaxed);
+    if (! wantPlaying && ! audible)
+        return;
+
+    if (wantPlaying && ! audible)
+    {
+        smoothedGain.setCurrentAndTargetValue(0.0f);
+        audible = true;
+    }
+
+    smoothedGain.setTargetValue(wantPlaying ? gain.load(std::memory_order_relaxed) : 0.0f);
+
+    int done = 0;
+    while (done < numSamples)
+    {
+        if (headRemaining > 0)
+        {
+            const auto n = juce::jmin(headRemaining, numSamples - done);
+            const auto offset = point * index->headFrames + headPosition;
+            mix(buffer, startSample + done, index->heads.getReadPointer(0, offset), index->heads.getReadPointer(1, offset), n);
+            headPosition += n;
+            headRemaining -= n;
+            done += n;
+            continue;
+        }
+
+        if (flushPending)
+            break; // No head for this point; the refill has not started yet
+
+        int start1, size1, start2, size2;
+        fifo.prepareToRead(numSamples - done, start1, size1, start2, size2);
+        if (size1 + size2 == 0)
+            break;
+
+        if (size1 > 0)
+            mix(buffer, startSample + done, storage.getReadPointer(0, start1), storage.getReadPointer(1, start1), size1);
+        if (size2 > 0)
+            mix(buffer, startSample + done + size1, storage.getReadPointer(0, start2), storage.getReadPointer(1, start2), size2);
+        fifo.finishedRead(size1 + size2);
+
+        done += size1 + size2;
+        streaming = true;
+    }
+
+    playedFrames += done;
+    positionSeconds.store(point * index->interval + static_cast<double>(playedFrames) / index->deviceRate,
+                          std::memory_order_relaxed);
+
+    if (! wantPlaying && ! smoothedGain.isSmoothing())
+        audible = false;
+
+    if (done == numSamples)
+        return;
+
+    if (! flushPending && endGeneration.load(std::memory_order_acquire) == generation && fifo.getNumReady() == 0)
+    {
+        // The end: stop and cue the top for the next play
+        playing.store(false, std::memory_order_relaxed);
+        audible = false;
+        startSeek(*index, 0);
+    }
+    else if (streaming)
+    {
+        underruns.fetch_add(1, std::memory_order_relaxed);
+
+        int suppressed = 0;
+        if (underrunThrottle.allow(suppressed))
+            realtimeLog->log(RealtimeLog::Level::warning, "Backing track read-ahead ran dry, {} of {} frames silent ({} more suppressed)",
+                             numSamples - done, numSamples, suppressed);
+    }
+}
+
+//==============================================================================
+BackingTrackPlayer::Stats BackingTrackPlayer::getStats() const
+{
+    Stats stats;
+    stats.loaded = loaded;
+    stats.playing = isPlaying();
+    stats.memoryMapped = memoryMapped;
+    stats.name = name;
+    stats.seconds = positionSeconds.load(std::memory_order_relaxed);
+    stats.lengthSeconds = lengthSeconds;
+    stats.pointsIndexed = pointsIndexed.load(std::memory_order_relaxed);
+    stats.numPoints = numPoints.load(std::memory_order_relaxed);
+    stats.underruns = underruns.load(std::memory_order_relaxed);
+    stats.fifoFill = static_cast<float>(fifo.getNumReady()) / static_cast<float>(juce::jmax(1, fifo.getTotalSize() - 1));
+    return stats;
+}
+
+juce::String BackingTrackPlayer::getSummary() const
+{
+    const auto stats = getStats();
+    if (! stats.loaded)
+        return {};
+
+    juce::String summary;
+    summary << "Track: " << formatTime(stats.seconds) << " / " << formatTime(stats.lengthSeconds);
+    if (stats.pointsIndexed < stats.numPoints)
+        summary << ", indexing " << stats.pointsIndexed << "/" << stats.numPoints;
+    if (stats.underruns > 0)
+        summary << ", " << stats.underruns << " underruns";
+    return summary;
+}
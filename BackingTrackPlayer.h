@@ -0,0 +1,192 @@
+#pragma once
+
+#include <juce_audio_formats/juce_audio_formats.h>
+#include "RealtimeLog.h"
+#include "RealtimePublisher.h"
+#include <array>
+#include <atomic>
+#include <memory>
+#include <vector>
+
+//==============================================================================
+/**
+ * BackingTrackPlayer
+ *
+ * Plays a backing track from disk alongside the guitar in the standalone host,
+ * without loading the file into memory.
+ *
+ * Uncompressed files (WAV, AIFF) are memory-mapped; anything else is decoded
+ * ahead by a BufferingAudioReader on decodeThread. A read-ahead TimeSliceThread
+ * converts the track to the device rate (windowed sinc) and keeps about
+ * readAheadSeconds of it in a preallocated AbstractFifo, so the audio thread
+ * only copies from memory: it never reads, decodes or waits.
+ *
+ * Seeks snap to an index of points every indexIntervalSeconds (wider for long
+ * tracks). Behind the playback, the read-ahead thread renders the first
+ * headSeconds after each point into the index; a seek plays that cached head
+ * at once while the read-ahead thread flushes the FIFO and refills it from the
+ * end of the head, which it reaches with the same resampler state, so the
+ * join is seamless. A seek to a point not indexed yet plays once the FIFO has
+ * refilled, usually within a few buffers.
+ */
+class BackingTrackPlayer : private juce::TimeSliceClient
+{
+public:
+    static constexpr double readAheadSeconds = 2.0;
+    static constexpr double indexIntervalSeconds = 5.0;
+    static constexpr int maxIndexPoints = 240;       // ~23 MB of heads at 48 kHz
+    static constexpr double headSeconds = 0.25;      // covers a refill after a seek
+    static constexpr int chunkFrames = 4096;         // read-ahead granularity, at the device rate
+    static constexpr int decodeAheadFrames = 1 << 17;
+    static constexpr int decodeTimeoutMs = 20;
+
+    struct Stats
+    {
+        bool loaded = false, playing = false, memoryMapped = false;
+        juce::String name;
+        double seconds = 0.0, lengthSeconds = 0.0;
+        int pointsIndexed = 0, numPoints = 0;
+        juce::int64 underruns = 0;
+        float fifoFill = 0.0f; // 0..1
+    };
+
+    BackingTrackPlayer();
+    ~BackingTrackPlayer() override;
+
+    /** Audio stopped (prepareToPlay). The index is rebuilt for the new rate. */
+    void prepare(double sampleRate);
+
+    //==============================================================================
+    /** Message thread. Opens the file (headers only) and hands it to the read-ahead
+        thread; the previous track stops. */
+    bool load(const juce::File& file, juce::String& error);
+
+    /** Message thread. */
+    void play() noexcept { playing.store(loaded, std::memory_order_relaxed); }
+    void pause() noexcept { playing.store(false, std::memory_order_relaxed); }
+    bool isPlaying() const noexcept { return playing.load(std::memory_order_relaxed); }
+    void seek(double seconds) noexcept { seekSeconds.store(juce::jmax(0.0, seconds), std::memory_order_release); }
+    void setGain(float newGain) noexcept { gain.store(newGain, std::memory_order_relaxed); }
+
+    Stats getStats() const;
+
+    /** e.g. "Track: 01:23 / 04:56" */
+    juce::String getSummary() const;
+
+    /** For a FileChooser: every format the player can open. */
+    juce::String getWildcard() const { return formatManager.getWildcardForAllFormats(); }
+
+    //==============================================================================
+    /** Audio thread: adds the track to the first two channels. Copies only. */
+    void mixInto(juce::AudioBuffer<float>& buffer, int startSample, int numSamples) noexcept;
+
+private:
+    struct Source
+    {
+        int serial = 0;
+        double fileRate = 0.0;
+        juce::int64 length = 0;
+        bool memoryMapped = false;
+        std::unique_ptr<juce::AudioFormatReader> streamReader, indexReader; // one per position
+    };
+
+    /** One per track and device rate, published to the audio thread. The read-ahead
+        thread fills the heads in order; numReady says how many the audio may use. */
+    struct Index
+    {
+        juce::uint32 id = 0;
+        int serial = 0;
+        double fileRate = 0.0, deviceRate = 0.0, interval = 0.0;
+        juce::int64 length = 0;
+        int numPoints = 0, headFrames = 0;
+        juce::AudioBuffer<float> heads; // point k at k * headFrames
+        std::vector<int> headLengths;   // shorter at the end of the track
+        std::atomic<int> numReady { 0 };
+
+        int getPoint(double seconds) const noexcept;
+        juce::int64 getSourcePosition(int point) const noexcept;
+    };
+
+    /** A position in a reader and the resampler state that goes with it. */
+    struct Stream
+    {
+        juce::AudioFormatReader* reader = nullptr;
+        juce::int64 position = 0;
+        std::array<juce::WindowedSincInterpolator, 2> interpolators;
+
+        void reset(juce::AudioFormatReader* newReader, juce::int64 newPosition) noexcept;
+    };
+
+    // Audio thread -> read-ahead thread: generation, index id, point and whether the
+    // head is playing, in one word so it is never read half-written
+    static juce::uint64 packRequest(juce::uint32 generation, juce::uint32 indexId, int point, bool headUsed) noexcept;
+
+    int useTimeSlice() override;
+
+    // Read-ahead thread, under streamLock
+    void adoptSource();
+    void publishIndex();
+    void serveRequest();
+    bool fillFifo();
+    void buildNextHead();
+    int render(Stream& stream, int numFrames);
+
+    // Audio thread
+    void startSeek(const Index& index, int point) noexcept;
+    void mix(juce::AudioBuffer<float>& buffer, int destStart, const float* left, const float* right, int numSamples) noexcept;
+
+    juce::AudioFormatManager formatManager;
+    juce::TimeSliceThread decodeThread { "Backing track decoder" };
+    juce::TimeSliceThread readAheadThread { "Backing track read-ahead" };
+    RealtimePublisher<Index> indexPublisher;
+
+    // Device rate, channels 0-1
+    juce::AudioBuffer<float> storage;
+    juce::AbstractFifo fifo { 2 };
+
+    // Message thread -> read-ahead thread
+    juce::CriticalSection pendingLock;
+    std::unique_ptr<Source> pendingSource;
+
+    // Read-ahead thread, under streamLock (prepare takes it too)
+    juce::CriticalSection streamLock;
+    std::unique_ptr<Source> source;
+    Index* building = nullptr; // the newest published index
+    bool needsIndex = false, streamActive = false, ended = false;
+    Stream stream, headStream;
+    juce::AudioBuffer<float> input, chunk;
+    juce::uint32 servedGeneration = 0, nextIndexId = 0;
+    int skipFrames = 0;
+    double preparedRate = 0.0;
+
+    std::atomic<juce::uint64> request { 0 };
+    std::atomic<juce::uint32> producerGeneration { 0 }, consumerGeneration { 0 }, endGeneration { ~0u };
+
+    // Audio thread. The last index may already be retired and deleted by the read-ahead
+    // thread, so it is never dereferenced: its address, id and track serial are kept instead
+    const Index* currentIndex = nullptr;
+    juce::uint32 currentIndexId = 0;
+    int currentSerial = -1;
+    juce::uint32 generation = 0;
+    int point = 0, headPosition = 0, headRemaining = 0;
+    juce::int64 playedFrames = 0;
+    bool flushPending = false, streaming = false, audible = false;
+    juce::SmoothedValue<float> smoothedGain;
+    juce::SharedResourcePointer<RealtimeLog> realtimeLog;
+    RealtimeLog::Throttle underrunThrottle;
+
+    // Shared
+    std::atomic<bool> playing { false };
+    std::atomic<float> gain { 1.0f };
+    std::atomic<double> seekSeconds { -1.0 }, positionSeconds { 0.0 };
+    std::atomic<juce::int64> underruns { 0 };
+    std::atomic<int> pointsIndexed { 0 }, numPoints { 0 };
+
+    // Message thread
+    int nextSerial = 0;
+    bool loaded = false, memoryMapped = false;
+    juce::String name;
+    double lengthSeconds = 0.0;
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(BackingTrackPlayer)
+};
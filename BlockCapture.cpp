@@ -0,0 +1,329 @@
+#include "BlockCapture.h"
+#include <cstring>
+#include <thread>
+
+namespace
+{
+    constexpr int recordHeaderBytes = 1 + 4;   // type, payload size
+    constexpr int preparePayloadBytes = 8 + 4 + 4;
+    constexpr int gapPayloadBytes = 8 + 8;
+}
+
+//==============================================================================
+class BlockCapture::Cursor
+{
+public:
+    Cursor(char* storageToUse, int start1, int size1, int start2) noexcept
+        : data(storageToUse), firstStart(start1), firstSize(size1), secondStart(start2) {}
+
+    void write(const void* source, size_t numBytes) noexcept
+    {
+        const auto* bytes = static_cast<const char*>(source);
+
+        while (numBytes > 0)
+        {
+            const bool inFirst = offset < static_cast<size_t>(firstSize);
+            const auto length = inFirst ? juce::jmin(numBytes, static_cast<size_t>(firstSize) - offset) : numBytes;
+            auto* dest = inFirst ? data + firstStart + offset : data + secondStart + (offset - static_cast<size_t>(firstSize));
+
+            std::memcpy(dest, bytes, length);
+            offset += length;
+            bytes += length;
+            numBytes -= length;
+        }
+    }
+
+    template <typename Value>
+    void put(Value value) noexcept { write(&value, sizeof(value)); }
+
+    void putRecord(RecordType type, int payloadBytes) noexcept
+    {
+        put(static_cast<juce::uint8>(type));
+        put(static_cast<juce::uint32>(payloadBytes));
+    }
+
+private:
+    char* data;
+    int firstStart, firstSize, secondStart;
+    size_t offset = 0;
+};
+
+//==============================================================================
+BlockCapture::BlockCapture(const juce::StringArray& parameterIDs)
+    : ids(parameterIDs)
+{
+    jassert(ids.size() <= maxParameters);
+    storage.allocate(static_cast<size_t>(fifoBytes), true);
+    diskThread.addTimeSliceClient(this);
+}
+
+BlockCapture::~BlockCapture()
+{
+    stop();
+    diskThread.removeTimeSliceClient(this);
+    diskThread.stopThread(5000);
+}
+
+juce::File BlockCapture::getDefaultFile()
+{
+    return juce::File::getSpecialLocation(juce::File::userApplicationDataDirectory)
+               .getChildFile("DSP4Guitar")
+               .getChildFile("Captures")
+               .getChildFile("Capture-" + juce::Time::getCurrentTime().formatted("%Y%m%d-%H%M%S") + ".d4gcap");
+}
+
+//==============================================================================
+bool BlockCapture::start(const juce::File& destination, juce::String& error)
+{
+    stop();
+
+    if (! destination.getParentDirectory().createDirectory())
+    {
+        error = "Could not create " + destination.getParentDirectory().getFullPathName();
+        return false;
+    }
+
+    auto out = std::make_unique<juce::FileOutputStream>(destination, streamBufferBytes);
+    if (out->failedToOpen())
+    {
+        error = "Could not write " + destination.getFullPathName();
+        return false;
+    }
+
+    out->setPosition(0);
+    out->truncate();
+
+    out->writeInt(static_cast<int>(magic));
+    out->writeInt(static_cast<int>(version));
+    out->writeInt(ids.size());
+    for (const auto& id : ids)
+    {
+        out->writeByte(static_cast<char>(id.getNumBytesAsUTF8()));
+        out->write(id.toRawUTF8(), id.getNumBytesAsUTF8());
+    }
+
+    // The running configuration; later prepares arrive as records
+    if (preparedRate.load(std::memory_order_acquire) > 0.0)
+    {
+        out->writeByte(static_cast<char>(RecordType::prepare));
+        out->writeInt(preparePayloadBytes);
+        out->writeDouble(preparedRate.load(std::memory_order_acquire));
+        out->writeInt(preparedBlockSize.load(std::memory_order_acquire));
+        out->writeInt(preparedChannels.load(std::memory_order_acquire));
+    }
+
+    file = destination;
+    capturedBlocks.store(0);
+    droppedBlocks.store(0);
+    writeFailed.store(false);
+    bytesWritten.store(out->getPosition());
+
+    {
+        // The audio thread is out (armed is false) and the disk thread waits on the lock
+        // between reads, so both sides of the FIFO can be reset here
+        const juce::ScopedLock sl(streamLock);
+        stream = std::move(out);
+        fifo.reset();
+    }
+
+    restart.store(true, std::memory_order_release);
+
+    if (! diskThread.isThreadRunning())
+        diskThread.startThread(juce::Thread::Priority::normal);
+
+    armed.store(true, std::memory_order_seq_cst);
+    return true;
+}
+
+void BlockCapture::stop()
+{
+    if (! armed.exchange(false, std::memory_order_seq_cst))
+        return;
+
+    // Let a block in progress finish, then drain whatever is buffered
+    while (busy.load(std::memory_order_seq_cst))
+        std::this_thread::yield();
+
+    const auto giveUp = juce::Time::getMillisecondCounter() + 10000;
+    while (fifo.getNumReady() > 0 && juce::Time::getMillisecondCounter() < giveUp)
+        juce::Thread::sleep(5);
+
+    const juce::ScopedLock sl(streamLock);
+    if (stream != nullptr)
+    {
+        stream->flush();
+        stream = nullptr;
+    }
+}
+
+juce::String BlockCapture::getSummary() const
+{
+    if (! isCapturing())
+        return "Not capturing";
+
+    juce::String summary;
+    summary << "CAP " << juce::String(static_cast<double>(bytesWritten.load()) / (1024.0 * 1024.0), 1) << " MB, "
+            << capturedBlocks.load() << " blocks, " << droppedBlocks.load() << " dropped";
+    if (writeFailed.load())
+        summary << " (write failed)";
+    return summary;
+}
+
+//==============================================================================
+void BlockCapture::prepare(double sampleRate, int maximumBlockSize, int numChannels) noexcept
+{
+    preparedRate.store(sampleRate, std::memory_order_release);
+    preparedBlockSize.store(maximumBlockSize, std::memory_order_release);
+    preparedChannels.store(numChannels, std::memory_order_release);
+
+    busy.store(true, std::memory_order_seq_cst);
+    if (armed.load(std::memory_order_seq_cst))
+        pushPrepare();
+    busy.store(false, std::memory_order_release);
+}
+
+void BlockCapture::pushPrepare() noexcept
+{
+    constexpr int total = recordHeaderBytes + preparePayloadBytes;
+    if (fifo.getFreeSpace() < total)
+        return;
+
+    int start1, size1, start2, size2;
+    fifo.prepareToWrite(total, start1, size1, start2, size2);
+
+    Cursor cursor(storage.get(), start1, size1, start2);
+    cursor.putRecord(RecordType::prepare, preparePayloadBytes);
+    cursor.put(preparedRate.load(std::memory_order_relaxed));
+    cursor.put(static_cast<juce::int32>(preparedBlockSize.load(std::memory_order_relaxed)));
+    cursor.put(static_cast<juce::int32>(preparedChannels.load(std::memory_order_relaxed)));
+    fifo.finishedWrite(total);
+
+    // Processors reset on prepare; so does the parameter chain
+    sendAllValues = true;
+}
+
+void BlockCapture::pushBlock(const juce::AudioBuffer<float>& buffer, int numChannels, const juce::MidiBuffer& midi,
+                             const float* parameterValues) noexcept
+{
+    // busy before armed, so stop() either sees this block or this block sees stop()
+    busy.store(true, std::memory_order_seq_cst);
+    if (! armed.load(std::memory_order_seq_cst))
+    {
+        busy.store(false, std::memory_order_release);
+        return;
+    }
+
+    if (restart.exchange(false, std::memory_order_acq_rel))
+    {
+        sendAllValues = true;
+        pendingDroppedBlocks = pendingDroppedSamples = 0;
+    }
+
+    const auto numSamples = buffer.getNumSamples();
+    numChannels = juce::jlimit(0, buffer.getNumChannels(), numChannels);
+
+    // Only the values that moved since the last block written
+    juce::uint64 changedMask = 0;
+    int numChanged = 0;
+    for (int i = 0; i < ids.size(); ++i)
+    {
+        if (sendAllValues || std::memcmp(&lastValues[static_cast<size_t>(i)], parameterValues + i, sizeof(float)) != 0)
+        {
+            changedMask |= juce::uint64(1) << i;
+            ++numChanged;
+        }
+    }
+
+    int numEvents = 0, midiBytes = 0;
+    for (const auto metadata : midi)
+    {
+        ++numEvents;
+        midiBytes += 4 + 2 + metadata.numBytes;
+    }
+
+    const auto audioBytes = numChannels * numSamples * static_cast<int>(sizeof(float));
+    const auto payload = 4 + 4 + 8 + numChanged * 4 + 4 + midiBytes + audioBytes;
+    const auto gapBytes = pendingDroppedBlocks > 0 ? recordHeaderBytes + gapPayloadBytes : 0;
+    const auto total = gapBytes + recordHeaderBytes + payload;
+
+    if (fifo.getFreeSpace() < total)
+    {
+        ++pendingDroppedBlocks;
+        pendingDroppedSamples += numSamples;
+        droppedBlocks.fetch_add(1, std::memory_order_relaxed);
+        sendAllValues = true; // The file lost this block's changes
+
+        int suppressed = 0;
+        if (dropThrottle.allow(suppressed))
+            realtimeLog->log(RealtimeLog::Level::warning, "Capture: disk too slow, dropped a {}-sample block ({} more suppressed)",
+                             numSamples, suppressed);
+
+        busy.store(false, std::memory_order_release);
+        return;
+    }
+
+    int start1, size1, start2, size2;
+    fifo.prepareToWrite(total, start1, size1, start2, size2);
+    Cursor cursor(storage.get(), start1, size1, start2);
+
+    if (gapBytes > 0)
+    {
+        cursor.putRecord(RecordType::gap, gapPayloadBytes);
+        cursor.put(pendingDroppedBlocks);
+        cursor.put(pendingDroppedSamples);
+        pendingDroppedBlocks = pendingDroppedSamples = 0;
+    }
+
+    cursor.putRecord(RecordType::block, payload);
+    cursor.put(static_cast<juce::int32>(numSamples));
+    cursor.put(static_cast<juce::int32>(numChannels));
+    cursor.put(changedMask);
+    for (int i = 0; i < ids.size(); ++i)
+        if ((changedMask >> i) & 1)
+            cursor.put(parameterValues[i]);
+
+    cursor.put(static_cast<juce::int32>(numEvents));
+    for (const auto metadata : midi)
+    {
+        cursor.put(static_cast<juce::int32>(metadata.samplePosition));
+        cursor.put(static_cast<juce::uint16>(metadata.numBytes));
+        cursor.write(metadata.data, static_cast<size_t>(metadata.numBytes));
+    }
+
+    for (int ch = 0; ch < numChannels; ++ch)
+        cursor.write(buffer.getReadPointer(ch), static_cast<size_t>(numSamples) * sizeof(float));
+
+    fifo.finishedWrite(total);
+
+    std::memcpy(lastValues.data(), parameterValues, static_cast<size_t>(ids.size()) * sizeof(float));
+    sendAllValues = false;
+    capturedBlocks.fetch_add(1, std::memory_order_relaxed);
+    busy.store(false, std::memory_order_release);
+}
+
+//==============================================================================
+int BlockCapture::useTimeSlice()
+{
+    // Held from prepareToRead to finishedRead, so start() never resets the FIFO mid-read
+    const juce::ScopedLock sl(streamLock);
+
+    const auto ready = fifo.getNumReady();
+    if (ready == 0)
+        return 20;
+
+    int start1, size1, start2, size2;
+    fifo.prepareToRead(ready, start1, size1, start2, size2);
+
+    if (stream != nullptr)
+    {
+        const auto written = stream->write(storage.get() + start1, static_cast<size_t>(size1))
+                             && (size2 == 0 || stream->write(storage.get() + start2, static_cast<size_t>(size2)));
+        if (! written)
+            writeFailed.store(true);
+    }
+
+    // Read either way: after stop() the leftovers of a capture that gave up are discarded
+    fifo.finishedRead(size1 + size2);
+    bytesWritten.fetch_add(size1 + size2, std::memory_order_relaxed);
+    return 0;
+}
@@ -0,0 +1,115 @@
+#pragma once
+
+#include <juce_audio_basics/juce_audio_basics.h>
+#include "RealtimeLog.h"
+#include <array>
+#include <atomic>
+#include <memory>
+
+//==============================================================================
+/**
+ * BlockCapture
+ *
+ * Opt-in capture of everything processBlock is given, so a live performance
+ * problem can be reproduced offline: each block's input audio, its length,
+ * the parameter values it started from and its MIDI, plus every prepare
+ * (sample rate and maximum block size). CaptureReplay feeds a capture back
+ * through a fresh processor (DSP4GuitarReplay console target).
+ *
+ * File (.d4gcap, little-endian, as on every platform the project builds for):
+ * a header, then one record after another, each a type byte and a 32-bit
+ * payload size.
+ *
+ *   header   "D4GC", version, parameter count, parameter IDs (length-prefixed)
+ *   prepare  sample rate (double), maximum block size, channels
+ *   block    samples, channels, a 64-bit mask of the parameters that changed
+ *            since the last block and their values, MIDI (position, size,
+ *            bytes per event), then the input audio, float, one channel after
+ *            another
+ *   gap      blocks and samples dropped before the next block
+ *
+ * The audio thread writes each record into one preallocated byte FIFO and a
+ * background TimeSliceThread drains it to a buffered file stream, so capturing
+ * never locks, allocates or touches the disk on the audio thread. A block that
+ * does not fit is dropped whole and counted; the next one carries every
+ * parameter, so a replay resumes exactly after a gap record.
+ */
+class BlockCapture : private juce::TimeSliceClient
+{
+public:
+    static constexpr juce::uint32 magic = 0x43473444; // "D4GC"
+    static constexpr juce::uint32 version = 1;
+    static constexpr int maxParameters = 64;           // one bit each in a block's mask
+    static constexpr int fifoBytes = 1 << 23;          // ~20 s of stereo input at 48 kHz
+    static constexpr int streamBufferBytes = 1 << 20;
+
+    enum class RecordType : juce::uint8 { prepare = 1, block = 2, gap = 3 };
+
+    /** The IDs in the order pushBlock() receives their values. */
+    explicit BlockCapture(const juce::StringArray& parameterIDs);
+    ~BlockCapture() override;
+
+    //==============================================================================
+    /** Message thread. Writes the header and the current prepare, then captures from
+        the next block. */
+    bool start(const juce::File& file, juce::String& error);
+
+    /** Message thread. Writes out what is buffered and closes the file. */
+    void stop();
+
+    bool isCapturing() const noexcept { return armed.load(std::memory_order_acquire); }
+
+    /** e.g. "CAP 12.4 MB, 2100 blocks, 0 dropped" */
+    juce::String getSummary() const;
+
+    const juce::File& getFile() const noexcept { return file; }
+
+    /** "<app data>/DSP4Guitar/Captures/Capture-<date>.d4gcap" */
+    static juce::File getDefaultFile();
+
+    //==============================================================================
+    /** prepareToPlay, audio stopped. */
+    void prepare(double sampleRate, int maximumBlockSize, int numChannels) noexcept;
+
+    /** Audio thread, before processing: the block's input, MIDI and starting parameter
+        values (one per ID). */
+    void pushBlock(const juce::AudioBuffer<float>& buffer, int numChannels, const juce::MidiBuffer& midi,
+                   const float* parameterValues) noexcept;
+
+private:
+    // Copies into the FIFO's one or two free regions in turn
+    class Cursor;
+
+    int useTimeSlice() override;
+    void pushPrepare() noexcept;
+
+    juce::TimeSliceThread diskThread { "Block capture" };
+    const juce::StringArray ids;
+
+    juce::HeapBlock<char> storage;
+    juce::AbstractFifo fifo { fifoBytes };
+
+    // Audio thread (and prepareToPlay, which never overlaps it)
+    std::atomic<bool> armed { false }, busy { false }, restart { false };
+    std::array<float, maxParameters> lastValues {};
+    bool sendAllValues = true;
+    juce::int64 pendingDroppedBlocks = 0, pendingDroppedSamples = 0;
+    juce::SharedResourcePointer<RealtimeLog> realtimeLog;
+    RealtimeLog::Throttle dropThrottle;
+
+    // Written by the audio thread only
+    std::atomic<juce::int64> capturedBlocks { 0 }, droppedBlocks { 0 };
+    std::atomic<double> preparedRate { 0.0 };
+    std::atomic<int> preparedBlockSize { 0 }, preparedChannels { 0 };
+
+    // Disk thread, under streamLock (which also covers each read of the FIFO)
+    juce::CriticalSection streamLock;
+    std::unique_ptr<juce::OutputStream> stream;
+    std::atomic<juce::int64> bytesWritten { 0 };
+    std::atomic<bool> writeFailed { false };
+
+    // Message thread
+    juce::File file;
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(BlockCapture)
+};
@@ -0,0 +1,346 @@
+#include "CaptureReplay.h"
+#include "MultiEffectProcessor.h"
+#include <algorithm>
+#include <bitset>
+#include <cstring>
+
+namespace
+{
+    constexpr size_t recordHeaderBytes = 1 + 4;
+    constexpr juce::uint64 hashPrime = 1099511628211ull; // FNV-1a
+
+    int countValues(juce::uint64 mask) noexcept { return static_cast<int>(std::bitset<64>(mask).count()); }
+}
+
+//==============================================================================
+CaptureReplay::Options CaptureReplay::Options::fromCommandLine(const juce::String& commandLine)
+{
+    Options result;
+
+    for (const auto& argument : juce::StringArray::fromTokens(commandLine, true))
+    {
+        const auto key = argument.upToFirstOccurrenceOf("=", false, false);
+        const auto value = argument.fromFirstOccurrenceOf("=", false, false).unquoted();
+
+        if (key == "--capture")     result.captureFile = juce::File::getCurrentWorkingDirectory().getChildFile(value);
+        else if (key == "--report") result.reportFile = juce::File::getCurrentWorkingDirectory().getChildFile(value);
+        else if (key == "--passes") result.passes = juce::jlimit(1, 1000, value.getIntValue());
+    }
+
+    if (result.reportFile == juce::File() && result.captureFile != juce::File())
+        result.reportFile = result.captureFile.getSiblingFile(result.captureFile.getFileNameWithoutExtension() + "-replay.csv");
+
+    return result;
+}
+
+//==============================================================================
+CaptureReplay::CaptureReplay(const Options& optionsToUse)
+    : options(optionsToUse)
+{
+}
+
+CaptureReplay::~CaptureReplay() = default;
+
+template <typename Value>
+Value CaptureReplay::read(size_t offset) const noexcept
+{
+    // Records are packed, so nothing in the file is aligned
+    Value value;
+    std::memcpy(&value, static_cast<const char*>(mapped->getData()) + offset, sizeof(value));
+    return value;
+}
+
+juce::Result CaptureReplay::load()
+{
+    mapped = std::make_unique<juce::MemoryMappedFile>(options.captureFile, juce::MemoryMappedFile::readOnly);
+    const auto size = mapped->getSize();
+    if (mapped->getData() == nullptr || size < 12)
+        return juce::Result::fail("Cannot read " + options.captureFile.getFullPathName());
+
+    if (read<juce::uint32>(0) != BlockCapture::magic)
+        return juce::Result::fail(options.captureFile.getFileName() + " is not a block capture");
+    if (read<juce::uint32>(4) > BlockCapture::version)
+        return juce::Result::fail(options.captureFile.getFileName() + " is from a newer version");
+
+    const auto numParameters = read<juce::int32>(8);
+    size_t position = 12;
+    for (int i = 0; i < numParameters; ++i)
+    {
+        if (position + 1 > size)
+            return juce::Result::fail("Truncated header");
+
+        const auto length = static_cast<size_t>(read<juce::uint8>(position));
+        if (position + 1 + length > size)
+            return juce::Result::fail("Truncated header");
+
+        parameterIDs.add(juce::String::fromUTF8(static_cast<const char*>(mapped->getData()) + position + 1, static_cast<int>(length)));
+        position += 1 + length;
+    }
+
+    // A capture cut short (a crash, a full disk) replays up to its last whole record
+    double sampleRate = 0.0;
+    while (position + recordHeaderBytes <= size)
+    {
+        Record record;
+        record.type = static_cast<BlockCapture::RecordType>(read<juce::uint8>(position));
+        record.payloadBytes = static_cast<int>(read<juce::uint32>(position + 1));
+        record.offset = position + recordHeaderBytes;
+        if (record.offset + static_cast<size_t>(record.payloadBytes) > size)
+            break;
+
+        switch (record.type)
+        {
+            case BlockCapture::RecordType::prepare:
+                sampleRate = read<double>(record.offset);
+                maxSamples = juce::jmax(maxSamples, read<juce::int32>(record.offset + 8));
+                maxChannels = juce::jmax(maxChannels, read<juce::int32>(record.offset + 12));
+                break;
+
+            case BlockCapture::RecordType::block:
+            {
+                BlockTiming timing;
+                timing.block = static_cast<int>(timings.size());
+                timing.numSamples = read<juce::int32>(record.offset);
+                timing.sampleRate = sampleRate;
+                timing.changedParameters = countValues(read<juce::uint64>(record.offset + 8));
+
+                const auto midiOffset = record.offset + 16 + static_cast<size_t>(timing.changedParameters) * 4;
+                timing.midiEvents = read<juce::int32>(midiOffset);
+
+                const auto audioBytes = static_cast<size_t>(read<juce::int32>(record.offset + 4) * timing.numSamples) * sizeof(float);
+                maxMidiBytes = juce::jmax(maxMidiBytes, static_cast<int>(record.offset + static_cast<size_t>(record.payloadBytes)
+                                                                         - audioBytes - midiOffset));
+                maxSamples = juce::jmax(maxSamples, timing.numSamples);
+                timings.push_back(timing);
+                break;
+            }
+
+            case BlockCapture::RecordType::gap:
+                ++gaps;
+                break;
+
+            default:
+                return juce::Result::fail("Unknown record at byte " + juce::String(static_cast<juce::int64>(position)));
+        }
+
+        records.push_back(record);
+        position = record.offset + static_cast<size_t>(record.payloadBytes);
+    }
+
+    if (timings.empty())
+        return juce::Result::fail(options.captureFile.getFileName() + " holds no blocks");
+
+    return juce::Result::ok();
+}
+
+//==============================================================================
+juce::Result CaptureReplay::run(std::function<void(int, double)> onPassFinished)
+{
+    passHashes.clear();
+
+    for (int pass = 0; pass < options.passes; ++pass)
+    {
+        const auto start = juce::Time::getMillisecondCounterHiRes();
+
+        juce::uint64 outputHash = outputHashSeed;
+        const auto result = replayPass(pass, outputHash);
+        if (result.failed())
+            return result;
+
+        passHashes.push_back(outputHash);
+        if (onPassFinished)
+            onPassFinished(pass, (juce::Time::getMillisecondCounterHiRes() - start) / 1000.0);
+    }
+
+    return juce::Result::ok();
+}
+
+juce::Result CaptureReplay::replayPass(int pass, juce::uint64& outputHash)
+{
+    // Fresh each pass, so no state carries over from the one before
+    auto processor = std::make_unique<MultiEffectProcessor>();
+
+    // Offline, so delay/reverb memory is bound inline at the same block on every pass
+    processor->setNonRealtime(true);
+
+    std::vector<std::atomic<float>*> targets;
+    for (const auto& id : parameterIDs)
+        targets.push_back(processor->apvts.getRawParameterValue(id));
+
+    // A block's changed values, straight to the raw parameter values processBlock reads;
+    // returns the position after them
+    auto writeValues = [this, &targets](size_t position)
+    {
+        const auto mask = read<juce::uint64>(position + 8);
+        position += 16;
+
+        for (int i = 0; i < 64; ++i)
+        {
+            if (((mask >> i) & 1) == 0)
+                continue;
+
+            const auto value = read<float>(position);
+            position += 4;
+            if (i < static_cast<int>(targets.size()) && targets[static_cast<size_t>(i)] != nullptr)
+                targets[static_cast<size_t>(i)]->store(value, std::memory_order_relaxed);
+        }
+
+        return position;
+    };
+
+    juce::AudioBuffer<float> buffer(juce::jmax(2, maxChannels), juce::jmax(1, maxSamples));
+    juce::MidiBuffer midi;
+    midi.ensureSize(static_cast<size_t>(maxMidiBytes) * 2);
+
+    const auto* data = static_cast<const char*>(mapped->getData());
+    const auto ticksToMicroseconds = 1.0e6 / static_cast<double>(juce::Time::getHighResolutionTicksPerSecond());
+    int numChannels = 0;
+    size_t block = 0;
+
+    for (size_t r = 0; r < records.size(); ++r)
+    {
+        const auto& record = records[r];
+
+        if (record.type == BlockCapture::RecordType::prepare)
+        {
+            // Live, the prepare saw the values its first block starts from: an effect
+            // already on was allocated up front, so give the fresh processor the same
+            for (auto next = r + 1; next < records.size(); ++next)
+            {
+                if (records[next].type == BlockCapture::RecordType::block)
+                {
+                    writeValues(records[next].offset);
+                    break;
+                }
+            }
+
+            const auto rate = read<double>(record.offset);
+            const auto blockSize = read<juce::int32>(record.offset + 8);
+            numChannels = juce::jmax(1, read<juce::int32>(record.offset + 12));
+
+            processor->setPlayConfigDetails(numChannels, numChannels, rate, blockSize);
+            processor->prepareToPlay(rate, blockSize);
+            continue;
+        }
+
+        if (record.type != BlockCapture::RecordType::block)
+            continue;
+
+        if (numChannels == 0)
+            return juce::Result::fail("The capture starts without a prepare");
+
+        const auto numSamples = read<juce::int32>(record.offset);
+        const auto capturedChannels = read<juce::int32>(record.offset + 4);
+        auto position = writeValues(record.offset);
+
+        midi.clear();
+        const auto numEvents = read<juce::int32>(position);
+        position += 4;
+        for (int i = 0; i < numEvents; ++i)
+        {
+            const auto samplePosition = read<juce::int32>(position);
+            const auto size = read<juce::uint16>(position + 4);
+            midi.addEvent(data + position + 6, size, samplePosition);
+            position += 6 + size;
+        }
+
+        for (int ch = 0; ch < numChannels; ++ch)
+        {
+            auto* dest = buffer.getWritePointer(ch);
+            if (ch < capturedChannels)
+                std::memcpy(dest, data + position + static_cast<size_t>(ch * numSamples) * sizeof(float),
+                            static_cast<size_t>(numSamples) * sizeof(float));
+            else
+                juce::FloatVectorOperations::clear(dest, numSamples);
+        }
+
+        juce::AudioBuffer<float> view(buffer.getArrayOfWritePointers(), numChannels, numSamples);
+
+        const auto start = juce::Time::getHighResolutionTicks();
+        processor->processBlock(view, midi);
+        const auto microseconds = static_cast<double>(juce::Time::getHighResolutionTicks() - start) * ticksToMicroseconds;
+
+        auto& timing = timings[block++];
+        timing.minMicroseconds = pass == 0 ? microseconds : juce::jmin(timing.minMicroseconds, microseconds);
+        timing.maxMicroseconds = pass == 0 ? microseconds : juce::jmax(timing.maxMicroseconds, microseconds);
+
+        outputHash = hashOutput(outputHash, view);
+    }
+
+    processor->releaseResources();
+    return juce::Result::ok();
+}
+
+juce::uint64 CaptureReplay::hashOutput(juce::uint64 hash, const juce::AudioBuffer<float>& block) noexcept
+{
+    for (int ch = 0; ch < block.getNumChannels(); ++ch)
+    {
+        const auto* samples = block.getReadPointer(ch);
+        for (int i = 0; i < block.getNumSamples(); ++i)
+        {
+            juce::uint32 bits;
+            std::memcpy(&bits, samples + i, sizeof(bits));
+            hash = (hash ^ bits) * hashPrime;
+        }
+    }
+
+    return hash;
+}
+
+//==============================================================================
+juce::Result CaptureReplay::writeReport(const juce::File& csvFile) const
+{
+    juce::String csv;
+    csv << "block,samples,sample_rate,changed_parameters,midi_events,min_us,max_us,load" << juce::newLine;
+
+    for (const auto& timing : timings)
+    {
+        csv << timing.block << ","
+            << timing.numSamples << ","
+            << juce::String(timing.sampleRate, 0) << ","
+            << timing.changedParameters << ","
+            << timing.midiEvents << ","
+            << juce::String(timing.minMicroseconds, 2) << ","
+            << juce::String(timing.maxMicroseconds, 2) << ","
+            << juce::String(timing.getLoad(), 4) << juce::newLine;
+    }
+
+    if (! csvFile.replaceWithText(csv))
+        return juce::Result::fail("Cannot write " + csvFile.getFullPathName());
+
+    return juce::Result::ok();
+}
+
+juce::String CaptureReplay::getSummary() const
+{
+    if (timings.empty())
+        return "No blocks";
+
+    double totalMicroseconds = 0.0, totalLoad = 0.0;
+    const auto* worst = &timings.front();
+    for (const auto& timing : timings)
+    {
+        totalMicroseconds += timing.minMicroseconds;
+        totalLoad += timing.getLoad();
+        if (timing.maxMicroseconds > worst->maxMicroseconds)
+            worst = &timing;
+    }
+
+    const auto count = static_cast<double>(timings.size());
+    juce::String summary;
+    summary << static_cast<int>(timings.size()) << " blocks, mean " << juce::String(totalMicroseconds / count, 1) << " us ("
+            << juce::roundToInt(100.0 * totalLoad / count) << "% of a period), worst block " << worst->block << " at "
+            << juce::String(worst->maxMicroseconds, 1) << " us";
+
+    if (passHashes.size() > 1)
+    {
+        const bool identical = std::all_of(passHashes.begin(), passHashes.end(),
+                                           [this](juce::uint64 hash) { return hash == passHashes.front(); });
+        summary << ", output " << (identical ? "identical" : "DIFFERENT") << " in " << static_cast<int>(passHashes.size()) << " passes";
+    }
+
+    if (gaps > 0)
+        summary << ", " << gaps << " gaps in the capture";
+
+    return summary;
+}
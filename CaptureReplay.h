@@ -0,0 +1,109 @@
+#pragma once
+
+#include <juce_audio_processors/juce_audio_processors.h>
+#include "BlockCapture.h"
+#include <functional>
+#include <memory>
+#include <vector>
+
+//==============================================================================
+/**
+ * CaptureReplay
+ *
+ * Feeds a BlockCapture file back through MultiEffectProcessor for the
+ * DSP4GuitarReplay console target, so a problem seen live can be run again,
+ * block for block, under a profiler.
+ *
+ * The file is memory-mapped and indexed up front. Each pass creates a fresh
+ * non-realtime processor on the calling (message) thread and replays every
+ * record in order: a prepare sets the channel count, rate and block size,
+ * after the values of the block that follows it, as live; a block
+ * writes its parameter values straight to the processor's raw parameter
+ * values (what processBlock reads), copies its input into a preallocated
+ * buffer and rebuilds its MIDI, then only processBlock itself is timed. With
+ * several passes the report keeps each block's fastest and slowest time, and
+ * a hash of every pass's output shows whether the passes rendered the same.
+ *
+ * Not replayed: preset recalls from the message thread, which jump to the
+ * values they land on instead of crossfading, and the write-back of values
+ * the audio thread changes itself (MIDI learn, program changes), since no
+ * message loop runs; those stay overridden until the next program change.
+ */
+class CaptureReplay
+{
+public:
+    struct Options
+    {
+        juce::File captureFile;
+        juce::File reportFile; // empty: <capture>-replay.csv
+        int passes = 1;
+
+        /** --capture=<file> [--report=<csv>] [--passes=N] */
+        static Options fromCommandLine(const juce::String& commandLine);
+    };
+
+    struct BlockTiming
+    {
+        int block = 0; // in the capture, from 0
+        int numSamples = 0;
+        double sampleRate = 0.0;
+        int changedParameters = 0, midiEvents = 0;
+        double minMicroseconds = 0.0, maxMicroseconds = 0.0;
+
+        /** The fastest pass against the block's own period. */
+        double getLoad() const noexcept
+        {
+            return numSamples > 0 ? minMicroseconds * 1.0e-6 * sampleRate / numSamples : 0.0;
+        }
+    };
+
+    explicit CaptureReplay(const Options& options);
+    ~CaptureReplay();
+
+    /** Maps the capture and indexes its records. */
+    juce::Result load();
+
+    int getNumBlocks() const noexcept { return static_cast<int>(timings.size()); }
+
+    /** Message thread: replays every pass; onPassFinished(pass, seconds) after each. */
+    juce::Result run(std::function<void(int pass, double seconds)> onPassFinished);
+
+    const std::vector<BlockTiming>& getTimings() const noexcept { return timings; }
+
+    /** block,samples,sample_rate,changed_parameters,midi_events,min_us,max_us,load */
+    juce::Result writeReport(const juce::File& csvFile) const;
+
+    /** e.g. "2100 blocks, mean 21.4 us (8% of a period), worst block 812 at 96.0 us, output identical in 3 passes" */
+    juce::String getSummary() const;
+
+    /** One per pass of the last run(): every output block folded in with hashOutput(). */
+    const std::vector<juce::uint64>& getOutputHashes() const noexcept { return passHashes; }
+
+    /** FNV-1a over the bits of every sample, channel by channel, so a live run can be
+        compared with a replay. Start from outputHashSeed. */
+    static constexpr juce::uint64 outputHashSeed = 14695981039346656037ull;
+    static juce::uint64 hashOutput(juce::uint64 hash, const juce::AudioBuffer<float>& block) noexcept;
+
+private:
+    struct Record
+    {
+        BlockCapture::RecordType type = BlockCapture::RecordType::block;
+        size_t offset = 0; // of the payload, in the mapped file
+        int payloadBytes = 0;
+    };
+
+    juce::Result replayPass(int pass, juce::uint64& outputHash);
+
+    template <typename Value>
+    Value read(size_t offset) const noexcept;
+
+    Options options;
+    std::unique_ptr<juce::MemoryMappedFile> mapped;
+    juce::StringArray parameterIDs;
+    std::vector<Record> records;
+    std::vector<BlockTiming> timings;
+    int maxChannels = 0, maxSamples = 0, maxMidiBytes = 0, gaps = 0;
+    std::vector<juce::uint64> passHashes;
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(CaptureReplay)
+};
@@ -1,6 +1,7 @@
 #pragma once
 
 #include <juce_gui_basics/juce_gui_basics.h>
+#include <vector>
 
 //==============================================================================
 /**
@@ -89,6 +90,10 @@ public:
 
     // =========================================================================
     // Rotary slider
+    //
+    // Everything that does not move with the value (glow, disc, track, ring,
+    // centre dot) is rendered once per knob size and display scale into a
+    // cached image; only the value arc and the pointer are drawn per repaint.
     void drawRotarySlider (juce::Graphics& g,
                            int x, int y, int width, int height,
                            float sliderPos,
@@ -103,22 +108,10 @@ public:
         const float rw       = radius * 2.0f;
         const float angle    = rotaryStartAngle + sliderPos * (rotaryEndAngle - rotaryStartAngle);
 
-        // Outer glow ring
-        g.setColour(matrixGreen.withAlpha(0.12f));
-        g.fillEllipse(rx - 4.0f, ry - 4.0f, rw + 8.0f, rw + 8.0f);
-
-        // Background disc
-        g.setColour(matrixBlack);
-        g.fillEllipse(rx, ry, rw, rw);
-
-        // Track arc (full range, dim)
-        {
-            juce::Path track;
-            track.addArc(rx + 2.0f, ry + 2.0f, rw - 4.0f, rw - 4.0f,
-                         rotaryStartAngle, rotaryEndAngle, true);
-            g.setColour(matrixDarkGreen.withAlpha(0.4f));
-            g.strokePath(track, juce::PathStrokeType(2.5f));
-        }
+        const auto scale = g.getInternalContext().getPhysicalPixelScaleFactor();
+        g.setOpacity(1.0f);
+        g.drawImage(getKnobBackground(width, height, rotaryStartAngle, rotaryEndAngle, scale),
+                    juce::Rectangle<float>((float)x, (float)y, (float)width, (float)height));
 
         // Value arc (filled, neon green)
         {
@@ -130,10 +123,6 @@ public:
                 juce::PathStrokeType::curved, juce::PathStrokeType::rounded));
         }
 
-        // Outer ring
-        g.setColour(matrixDarkGreen);
-        g.drawEllipse(rx, ry, rw, rw, 1.2f);
-
         // Thumb pointer
         {
             juce::Path thumb;
@@ -149,10 +138,64 @@ public:
             g.setColour(matrixGreen);
             g.fillPath(thumb, xform);
         }
+    }
+
+    /** Static knob layers for one knob size, at the given display scale. */
+    const juce::Image& getKnobBackground (int width, int height,
+                                          float rotaryStartAngle, float rotaryEndAngle,
+                                          float scale)
+    {
+        for (const auto& layer : knobBackgrounds)
+            if (layer.width == width && layer.height == height && layer.scale == scale
+                && layer.startAngle == rotaryStartAngle && layer.endAngle == rotaryEndAngle)
+                return layer.image;
+
+        // A handful of sizes at most; start over if resizing keeps adding new ones
+        if (knobBackgrounds.size() >= maxKnobBackgrounds)
+            knobBackgrounds.clear();
+
+        juce::Image image(juce::Image::ARGB,
+                          juce::jmax(1, juce::roundToInt((float)width * scale)),
+                          juce::jmax(1, juce::roundToInt((float)height * scale)), true);
+        {
+            juce::Graphics g(image);
+            g.addTransform(juce::AffineTransform::scale(scale));
+
+            const float radius   = (float)juce::jmin(width / 2, height / 2) - 4.0f;
+            const float centreX  = (float)width  * 0.5f;
+            const float centreY  = (float)height * 0.5f;
+            const float rx       = centreX - radius;
+            const float ry       = centreY - radius;
+            const float rw       = radius * 2.0f;
+
+            // Outer glow ring
+            g.setColour(matrixGreen.withAlpha(0.12f));
+            g.fillEllipse(rx - 4.0f, ry - 4.0f, rw + 8.0f, rw + 8.0f);
+
+            // Background disc
+            g.setColour(matrixBlack);
+            g.fillEllipse(rx, ry, rw, rw);
+
+            // Track arc (full range, dim)
+            {
+                juce::Path track;
+                track.addArc(rx + 2.0f, ry + 2.0f, rw - 4.0f, rw - 4.0f,
+                             rotaryStartAngle, rotaryEndAngle, true);
+                g.setColour(matrixDarkGreen.withAlpha(0.4f));
+                g.strokePath(track, juce::PathStrokeType(2.5f));
+            }
+
+            // Outer ring
+            g.setColour(matrixDarkGreen);
+            g.drawEllipse(rx, ry, rw, rw, 1.2f);
+
+            // Centre dot (the pointer never reaches the centre, so it can live here)
+            g.setColour(matrixGreen);
+            g.fillEllipse(centreX - 2.5f, centreY - 2.5f, 5.0f, 5.0f);
+        }
 
-        // Centre dot
-        g.setColour(matrixGreen);
-        g.fillEllipse(centreX - 2.5f, centreY - 2.5f, 5.0f, 5.0f);
+        knobBackgrounds.push_back({ width, height, rotaryStartAngle, rotaryEndAngle, scale, image });
+        return knobBackgrounds.back().image;
     }
 
     // =========================================================================
@@ -272,5 +315,15 @@ public:
     }
 
 private:
+    struct KnobBackground
+    {
+        int width, height;
+        float startAngle, endAngle, scale;
+        juce::Image image;
+    };
+
+    static constexpr size_t maxKnobBackgrounds = 8;
+    std::vector<KnobBackground> knobBackgrounds;
+
     JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(CyberpunkLookAndFeel)
 };
@@ -2,19 +2,15 @@
   ==============================================================================
 
     DSP4GuitarApp.h
-    Conceptual outline for a JUCE-based VST host application.
+    The DSP4Guitar Host application, built as the DSP4GuitarHost target
+    (Main.cpp starts it).
 
-    This is a simplified example to demonstrate:
-    - ASIO device setup via JUCE's AudioDeviceManager.
-    - VST plugin scanning and loading.
-    - Basic audio processing through a loaded plugin.
-    - A minimal UI for interaction.
-
-    To build a full application, you would need to:
-    - Set up a JUCE project using the Projucer or CMake.
-    - Expand UI for plugin selection, parameter control, FX chain management.
-    - Implement robust error handling and resource management.
-    - Add features like preset saving/loading, MIDI processing, etc.
+    - Audio device setup through JUCE's AudioDeviceManager (ASIO preferred on
+      Windows, --low-latency JACK/ALSA on Linux).
+    - Cached, out-of-process plugin scanning; the same executable is relaunched
+      as the scan and sandbox workers.
+    - A chain of the built-in DSP4Guitar processor and scanned plugins, loaded
+      off the audio thread, with recording and backing tracks around it.
 
   ==============================================================================
 */
@@ -32,101 +28,32 @@
 #include <juce_graphics/juce_graphics.h>
 #include <juce_gui_basics/juce_gui_basics.h>
 #include <juce_gui_extra/juce_gui_extra.h>
-
-// ==============================================================================
-// Main Application Class (Entry Point)
-// ==============================================================================
-class DSP4GuitarApplication : public juce::JUCEApplication
-{
-public:
-    DSP4GuitarApplication() {}
-
-    const juce::String getApplicationName() override { return ProjectInfo::projectName; }
-    const juce::String getApplicationVersion() override { return ProjectInfo::versionString; }
-    bool moreThanOneInstanceAllowed() override { return true; }
-
-    void initialise(const juce::String& commandLine) override
-    {
-        // This method is where you should put your application's initialisation code
-        mainWindow.reset(new MainHostWindow(getApplicationName()));
-    }
-
-    void shutdown() override
-    {
-        // Add your application's shutdown code here.
-        mainWindow = nullptr; // (deletes our window)
-    }
-
-    void systemRequestedQuit() override
-    {
-        quit();
-    }
-
-    void anotherInstanceStarted(const juce::String& commandLine) override
-    {
-        // When another instance of the app is launched while this one is running,
-        // this method is invoked, and the commandLine parameter tells you what
-        // the other instance's command-line arguments were.
-    }
-
-    // ==============================================================================
-    // Main Window Class
-    // ==============================================================================
-    class MainHostWindow : public juce::DocumentWindow
-    {
-    public:
-        MainHostWindow(juce::String name)
-            : DocumentWindow(name,
-                juce::Desktop::getInstance().getDefaultLookAndFeel()
-                .findColour(juce::ResizableWindow::backgroundColourId),
-                DocumentWindow::allButtons)
-        {
-            setUsingNativeTitleBar(true);
-            // The MainAudioComponent will be the heart of our app
-            mainAudioComponent = std::make_unique<MainAudioComponent>();
-            setContentOwned(mainAudioComponent.get(), true);
-
-           #if JUCE_IOS || JUCE_ANDROID
-            setFullScreen(true);
-           #else
-            setResizable(true, true);
-            centreWithSize(getWidth(), getHeight());
-           #endif
-
-            setVisible(true);
-        }
-
-        void closeButtonPressed() override
-        {
-            juce::JUCEApplication::getInstance()->systemRequestedQuit();
-        }
-
-    private:
-        std::unique_ptr<class MainAudioComponent> mainAudioComponent;
-        JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(MainHostWindow)
-    };
-
-private:
-    std::unique_ptr<MainHostWindow> mainWindow;
-};
-
+#include "PluginScanner.h"
+#include "HostChain.h"
+#include "HostPluginSlot.h"
+#include "LowLatencyMode.h"
+#include "DeadlineMonitor.h"
+#include "TraceRecorder.h"
+#include "RealtimeLog.h"
+#include "SandboxedPlugin.h"
+#include "SessionRecorder.h"
+#include "BackingTrackPlayer.h"
+#include <cstdio>
 
 // ==============================================================================
 // Main Audio Component (Handles Audio, Plugins, and Basic UI)
 // ==============================================================================
 class MainAudioComponent : public juce::AudioAppComponent,
                            public juce::Button::Listener,
-                           public juce::ComboBox::Listener,
                            private juce::Timer
 {
 public:
-    MainAudioComponent()
-        : AudioAppComponent(audioDeviceManager) // Pass the device manager to the base class
+    explicit MainAudioComponent(const LowLatencyMode::Options& lowLatencyOptions = {})
     {
         // Initialize AudioDeviceManager and request ASIO if available
         // The AudioAppComponent constructor will call setAudioChannels based on device capabilities.
         // We can further refine this in prepareToPlay.
-        juce::String audioError = audioDeviceManager.initialiseWithDefaultDevices(2, 2); // 2 ins, 2 outs
+        juce::String audioError = deviceManager.initialiseWithDefaultDevices(2, 2); // 2 ins, 2 outs
         if (audioError.isNotEmpty())
         {
             juce::Logger::writeToLog("Audio Device Init Error: " + audioError);
@@ -136,12 +63,12 @@ public:
         // On Windows, try to set up ASIO by default if a device is available
         #if JUCE_WINDOWS
         juce::OwnedArray<juce::AudioIODeviceType> availableTypes;
-        audioDeviceManager.createAudioDeviceTypes(availableTypes);
+        deviceManager.createAudioDeviceTypes(availableTypes);
         for (auto* type : availableTypes)
         {
             if (type->getTypeName() == "ASIO")
             {
-                audioDeviceManager.setCurrentAudioDeviceType("ASIO", true);
+                deviceManager.setCurrentAudioDeviceType("ASIO", true);
                 break;
             }
         }
@@ -154,50 +81,155 @@ public:
 
         addAndMakeVisible(scanPluginsButton);
         scanPluginsButton.setButtonText("Scan VST Plugins");
+        scanPluginsButton.setTooltip("Scans new and changed plugins. Shift-click to rescan everything.");
         scanPluginsButton.addListener(this);
 
+        addAndMakeVisible(exportTraceButton);
+        exportTraceButton.setButtonText(TraceRecorder::getInstance().isEnabled() ? "Export Trace" : "Record Trace");
+        exportTraceButton.setTooltip("Records a timeline of the audio, loader, scanner and UI threads and "
+                                     "exports it as Chrome trace JSON (chrome://tracing, ui.perfetto.dev)");
+        exportTraceButton.addListener(this);
+
+        addAndMakeVisible(recordButton);
+        recordButton.setButtonText("Record DI + Out");
+        recordButton.setTooltip("Records the dry input and the processed output to "
+                                + SessionRecorder::getDefaultFolder().getFullPathName()
+                                + " as 24-bit WAV (shift-click for FLAC)");
+        recordButton.addListener(this);
+
+        addAndMakeVisible(loadTrackButton);
+        loadTrackButton.setButtonText("Load Track...");
+        loadTrackButton.setTooltip("Streams a backing track from disk alongside the guitar");
+        loadTrackButton.addListener(this);
+
+        addAndMakeVisible(playTrackButton);
+        playTrackButton.setButtonText("Play");
+        playTrackButton.setEnabled(false);
+        playTrackButton.addListener(this);
+
+        addAndMakeVisible(trackPositionSlider);
+        trackPositionSlider.setSliderStyle(juce::Slider::LinearHorizontal);
+        trackPositionSlider.setTextBoxStyle(juce::Slider::TextBoxRight, true, 60, 20);
+        trackPositionSlider.setRange(0.0, 1.0);
+        trackPositionSlider.setEnabled(false);
+        trackPositionSlider.setTooltip("Seeks snap to the track's index, every few seconds");
+        trackPositionSlider.textFromValueFunction = [](double seconds)
+        {
+            const auto whole = static_cast<int>(seconds);
+            return juce::String::formatted("%02d:%02d", whole / 60, whole % 60);
+        };
+        trackPositionSlider.onDragEnd = [this] { backingTrack.seek(trackPositionSlider.getValue()); };
+
+        addAndMakeVisible(trackGainSlider);
+        trackGainSlider.setSliderStyle(juce::Slider::LinearHorizontal);
+        trackGainSlider.setTextBoxStyle(juce::Slider::NoTextBox, true, 0, 0);
+        trackGainSlider.setRange(0.0, 1.0);
+        trackGainSlider.setValue(1.0, juce::dontSendNotification);
+        trackGainSlider.setTooltip("Backing track level");
+        trackGainSlider.onValueChange = [this] { backingTrack.setGain(static_cast<float>(trackGainSlider.getValue())); };
+
         addAndMakeVisible(pluginSelectionComboBox);
         pluginSelectionComboBox.setTextWhenNoChoicesAvailable("No plugins found");
-        pluginSelectionComboBox.addListener(this);
-        pluginSelectionComboBox.setTooltip("Select a VST plugin to load");
+        pluginSelectionComboBox.setTooltip("Select a plugin to add to the chain");
+
+        addAndMakeVisible(addPluginButton);
+        addPluginButton.setButtonText("Add");
+        addPluginButton.setTooltip("Adds the selected plugin to the end of the chain");
+        addPluginButton.addListener(this);
+
+        addAndMakeVisible(addParallelButton);
+        addParallelButton.setButtonText("Add Parallel");
+        addParallelButton.setTooltip("Runs the selected plugin alongside the last stage of the chain, on its own core");
+        addParallelButton.addListener(this);
+
+        addAndMakeVisible(sandboxToggle);
+        sandboxToggle.setButtonText("Sandbox");
+        sandboxToggle.setTooltip("Runs plugins added from now on in their own process: a crash or hang bypasses "
+                                 "the plugin for one buffer and restarts it instead of taking down the host");
+        sandboxToggle.setEnabled(SandboxedPlugin::isSupported());
+
+        addAndMakeVisible(clearChainButton);
+        clearChainButton.setButtonText("Clear Chain");
+        clearChainButton.addListener(this);
+
+        addAndMakeVisible(chainLabel);
+        chainLabel.setText(chainLayout.describe(), juce::dontSendNotification);
+        chainLabel.setJustificationType(juce::Justification::centredLeft);
 
         addAndMakeVisible(statusLabel);
         statusLabel.setText("Welcome to DSP4Guitar Host!", juce::dontSendNotification);
         statusLabel.setJustificationType(juce::Justification::centred);
 
+        addAndMakeVisible(deadlineLabel);
+        deadlineLabel.setJustificationType(juce::Justification::centred);
+
         // Plugin Format Manager - for VST2 and VST3
         // You can add other formats like AU if targeting macOS
         pluginFormatManager.addDefaultFormats();
 
-        // Start a timer to periodically check for new plugins if scanning in background
-        // For this example, we'll do a blocking scan.
-        // startTimer(5000); // Check every 5 seconds
+        // Show the cached plugins at once, then rescan only what changed in the background
+        pluginScanner.onScanFinished = [this]
+        {
+            scanPluginsButton.setEnabled(true);
+            refreshPluginList();
+        };
+
+        pluginSlot.onLoaded = [this](const juce::String& error)
+        {
+            if (error.isNotEmpty())
+            {
+                statusLabel.setText("Failed to load chain. Error: " + error, juce::dontSendNotification);
+                juce::Logger::writeToLog("Plugin Load Error: " + error);
+                return;
+            }
+
+            const auto latency = pluginSlot.getLatencySamples();
+            statusLabel.setText("Loaded chain, latency " + juce::String(latency) + " samples", juce::dontSendNotification);
+            juce::Logger::writeToLog("Loaded chain: " + chainLayout.describe() + " (latency " + juce::String(latency) + " samples)");
+        };
+
+        if (pluginScanner.loadCache())
+            refreshPluginList();
+
+        scanForPlugins();
 
         // Set component size
         setSize(600, 400);
 
         // Tell AudioAppComponent we want 2 input and 2 output channels
         setAudioChannels(2, 2); 
+
+        // Callback load and xruns, shown below the status line and dumped every 10 s
+        deadlineMonitor.startDumping(DeadlineMonitor::getDefaultDumpFile("Host"), 10);
+        startTimer(250);
+
+        // Stage machines: JACK/ALSA with a negotiated period, locked and pre-faulted
+        // memory and SCHED_FIFO threads. Each step is reported; the thread steps
+        // arrive once the callbacks have run (see timerCallback)
+        if (lowLatencyOptions.enabled)
+        {
+            lowLatency.apply(deviceManager, lowLatencyOptions);
+            statusLabel.setTooltip(lowLatency.getReport());
+        }
     }
 
     ~MainAudioComponent() override
     {
-        shutdownAudio(); // This will call releaseResources()
-        loadedPluginInstance = nullptr; // Release the plugin
+        shutdownAudio(); // This will call releaseResources(); pluginSlot deletes the chain
     }
 
     //================ Audio Callbacks =========================================
     void prepareToPlay(int samplesPerBlockExpected, double newSampleRate) override
     {
+        DSP4G_TRACE_ZONE("MainAudioComponent::prepareToPlay");
         currentSampleRate = newSampleRate;
         currentBlockSize = samplesPerBlockExpected;
 
-        if (loadedPluginInstance)
-        {
-            loadedPluginInstance->setRateAndBufferSizeDetails(newSampleRate, samplesPerBlockExpected);
-            loadedPluginInstance->prepareToPlay(newSampleRate, samplesPerBlockExpected);
-        }
-        
+        pluginSlot.prepare(newSampleRate, samplesPerBlockExpected, 2); // stereo, see setAudioChannels
+        deadlineMonitor.prepare(newSampleRate);
+        sessionRecorder.prepare(newSampleRate);
+        backingTrack.prepare(newSampleRate);
+
         // You might want to prepare other things here, like internal buffers.
         statusLabel.setText("Audio prepared. Rate: " + juce::String(newSampleRate, 1) + " Hz, BlockSize: " + juce::String(samplesPerBlockExpected), juce::dontSendNotification);
     }
@@ -211,40 +243,41 @@ public:
         // Mute output if no plugin is loaded or if processing fails
         // bufferToFill.clearActiveBufferRegion(); // Good practice to clear first
 
-        if (loadedPluginInstance && loadedPluginInstance->isSuspended() == false)
-        {
-            // JUCE's AudioBuffer is what plugins expect
-            // The AudioSourceChannelInfo gives us a direct pointer to the audio data.
-            // We need to wrap it in an AudioBuffer for the plugin.
-            // Note: This is a simplified example. For complex routing or if the plugin
-            // has a different channel configuration, more sophisticated buffer management is needed.
-            
-            // Assuming plugin matches host channel config (stereo in, stereo out)
-            // If your plugin has a different layout, you'll need to adapt.
-            juce::AudioBuffer<float> pluginBuffer(bufferToFill.buffer->getArrayOfWritePointers(),
-                                                  bufferToFill.buffer->getNumChannels(),
-                                                  bufferToFill.startSample,
-                                                  bufferToFill.numSamples);
-
-
-            // Process the audio through the plugin
-            loadedPluginInstance->processBlock(pluginBuffer, juce::MidiBuffer()); // Pass an empty MIDI buffer if not handling MIDI
-        }
-        else
+        LowLatencyMode::applyThreadPolicy(LowLatencyMode::ThreadRole::audio, audioThreadPolicy);
+        DSP4G_TRACE_ZONE("MainAudioComponent::getNextAudioBlock");
+        const auto callbackStart = deadlineMonitor.beginCallback();
+
+        // DI before the chain, output after: a copy into the recorder's FIFO each, or
+        // nothing while it is not recording
+        sessionRecorder.pushInput(*bufferToFill.buffer, bufferToFill.startSample, bufferToFill.numSamples);
+
+        // The slot passes audio through until a chain has been loaded, and crossfades
+        // whenever the chain is edited
+        pluginSlot.process(*bufferToFill.buffer, bufferToFill.startSample, bufferToFill.numSamples);
+
+        sessionRecorder.pushOutput(*bufferToFill.buffer, bufferToFill.startSample, bufferToFill.numSamples);
+
+        // After the recorder, so the recordings stay guitar-only. A copy from memory:
+        // the player's read-ahead thread does the reading and resampling
+        backingTrack.mixInto(*bufferToFill.buffer, bufferToFill.startSample, bufferToFill.numSamples);
+
+        // The chain's plugins have no snapshot to offer; the time and size still say a lot
+        if (deadlineMonitor.endCallback(callbackStart, bufferToFill.numSamples))
         {
-            // If no plugin, or plugin suspended, pass audio through (or silence)
-            // For pass-through, do nothing if bufferToFill.buffer already contains input.
-            // For silence: bufferToFill.clearActiveBufferRegion(); (already done above)
+            deadlineMonitor.recordOverrun(nullptr, 0, -1);
+
+            int suppressed = 0;
+            if (overrunThrottle.allow(suppressed))
+                realtimeLog->log(RealtimeLog::Level::warning, "Host callback overran its {}-sample period at {} Hz ({} more suppressed)",
+                                 bufferToFill.numSamples, currentSampleRate, suppressed);
         }
     }
 
     void releaseResources() override
     {
         // This will be called when the audio device stops, or when samplesPerBlockExpected/sampleRate change.
-        if (loadedPluginInstance)
-        {
-            loadedPluginInstance->releaseResources();
-        }
+        DSP4G_TRACE_ZONE("MainAudioComponent::releaseResources");
+        pluginSlot.release();
         currentSampleRate = 0;
         currentBlockSize = 0;
         statusLabel.setText("Audio resources released.", juce::dontSendNotification);
@@ -259,11 +292,36 @@ public:
         openAudioSettingsButton.setBounds(topRow.removeFromLeft(150));
         topRow.removeFromLeft(10); // spacer
         scanPluginsButton.setBounds(topRow.removeFromLeft(150));
+        topRow.removeFromLeft(10); // spacer
+        exportTraceButton.setBounds(topRow.removeFromLeft(150));
+        topRow.removeFromLeft(10); // spacer
+        recordButton.setBounds(topRow.removeFromLeft(150));
         
         area.removeFromTop(10);
-        pluginSelectionComboBox.setBounds(area.removeFromTop(30));
+        juce::Rectangle<int> pluginRow = area.removeFromTop(30);
+        clearChainButton.setBounds(pluginRow.removeFromRight(100));
+        pluginRow.removeFromRight(10);
+        addParallelButton.setBounds(pluginRow.removeFromRight(100));
+        pluginRow.removeFromRight(10);
+        addPluginButton.setBounds(pluginRow.removeFromRight(60));
+        pluginRow.removeFromRight(10);
+        sandboxToggle.setBounds(pluginRow.removeFromRight(90));
+        pluginRow.removeFromRight(10);
+        pluginSelectionComboBox.setBounds(pluginRow);
+        area.removeFromTop(10);
+        chainLabel.setBounds(area.removeFromTop(30));
         area.removeFromTop(10);
         statusLabel.setBounds(area.removeFromTop(30));
+        deadlineLabel.setBounds(area.removeFromTop(30));
+        area.removeFromTop(10);
+        juce::Rectangle<int> trackRow = area.removeFromTop(30);
+        loadTrackButton.setBounds(trackRow.removeFromLeft(110));
+        trackRow.removeFromLeft(10);
+        playTrackButton.setBounds(trackRow.removeFromLeft(70));
+        trackRow.removeFromLeft(10);
+        trackGainSlider.setBounds(trackRow.removeFromRight(90));
+        trackRow.removeFromRight(10);
+        trackPositionSlider.setBounds(trackRow);
     }
 
     void buttonClicked(juce::Button* button) override
@@ -271,17 +329,17 @@ public:
         if (button == &openAudioSettingsButton)
         {
             // JUCE provides a handy component for audio settings
-            juce::AudioDeviceSelectorComponent settingsComp(audioDeviceManager,
+            auto* settingsComp = new juce::AudioDeviceSelectorComponent(deviceManager,
                 0, 256,     // min/max input channels
                 0, 256,     // min/max output channels
                 true,       // showMidiInputOptions
                 true,       // showMidiOutputSelector
                 true,       // showChannelsAsStereoPairs
                 true);      // showChannelNames
-            settingsComp.setSize(500, 450);
+            settingsComp->setSize(500, 450);
 
             juce::DialogWindow::LaunchOptions o;
-            o.content.setOwned(&settingsComp);
+            o.content.setOwned(settingsComp); // the dialog deletes it when closed
             o.content.setSize(500, 450);
             o.dialogTitle = "Audio Settings";
             o.dialogBackgroundColour = getLookAndFeel().findColour(juce::ResizableWindow::backgroundColourId);
@@ -291,85 +349,94 @@ public:
         }
         else if (button == &scanPluginsButton)
         {
-            scanForPlugins();
+            scanForPlugins(juce::ModifierKeys::currentModifiers.isShiftDown());
         }
-    }
-
-    void comboBoxChanged(juce::ComboBox* comboBoxThatHasChanged) override
-    {
-        if (comboBoxThatHasChanged == &pluginSelectionComboBox)
+        else if (button == &exportTraceButton)
+        {
+            exportTrace();
+        }
+        else if (button == &recordButton)
+        {
+            toggleRecording(juce::ModifierKeys::currentModifiers.isShiftDown() ? SessionRecorder::Format::flac
+                                                                               : SessionRecorder::Format::wav);
+        }
+        else if (button == &loadTrackButton)
+        {
+            chooseBackingTrack();
+        }
+        else if (button == &playTrackButton)
+        {
+            if (backingTrack.isPlaying())
+                backingTrack.pause();
+            else
+                backingTrack.play();
+        }
+        else if (button == &addPluginButton || button == &addParallelButton)
+        {
+            addSelectedPlugin(button == &addParallelButton);
+        }
+        else if (button == &clearChainButton)
         {
-            loadSelectedPlugin();
+            chainLayout.stages.clear();
+            loadChain();
         }
     }
     
     //================ Plugin Management =======================================
-    void scanForPlugins()
+    void scanForPlugins(bool fullRescan = false)
     {
-        statusLabel.setText("Scanning for VST plugins...", juce::dontSendNotification);
-        knownPluginList.clear(); // Clear previous scan results
+        // Runs on the scanner's thread pool; timerCallback shows progress and
+        // onScanFinished refreshes the list
+        pluginScanner.startScan(fullRescan);
+        scanPluginsButton.setEnabled(false);
+        statusLabel.setText(fullRescan ? "Rescanning all plugins..." : "Scanning for new or changed plugins...",
+                            juce::dontSendNotification);
+        startTimer(250);
+    }
 
-        // You can specify paths to scan, or use default VST paths.
-        // For simplicity, using default paths.
-        // juce::FileSearchPath searchPath;
-        // searchPath.addDefaultPluginSearchPaths();
+    void refreshPluginList()
+    {
+        const auto selectedId = pluginSelectionComboBox.getSelectedId();
+        const auto selectedIdentifier = selectedId > 0 && selectedId <= pluginDescriptions.size()
+                                            ? pluginDescriptions[selectedId - 1].createIdentifierString() : juce::String();
 
-        // For VST3, JUCE typically finds them automatically.
-        // For VST (legacy), you might need to specify paths.
-        // Example: searchPath.add(juce::File::getSpecialLocation(juce::File::commonApplicationDataDirectory).getChildFile("VST"));
-        
         pluginSelectionComboBox.clear(juce::dontSendNotification);
         pluginDescriptions.clear();
 
-        for (int i = pluginFormatManager.getNumFormats(); --i >= 0;)
-        {
-            juce::AudioPluginFormat* format = pluginFormatManager.getFormat(i);
-            // We are interested in VST and VST3
-            if (format->getName() == "VST" || format->getName() == "VST3")
-            {
-                // The true flag means it's a blocking scan.
-                // For background scanning, you'd use a PluginDirectoryScanner.
-                // This can take some time.
-                juce::PluginDirectoryScanner scanner (knownPluginList, *format,
-                                                      format->getDefaultLocationsToSearch(),
-                                                      true, /*recursive*/
-                                                      juce::File(), /*deadMansPedal*/
-                                                      true /*allowPluginsWhichRequireRestart*/);
-                
-                juce::String pluginPathBeingScanned;
-                while(scanner.scanNextFile(true, pluginPathBeingScanned)) {
-                    // Optionally update UI with pluginPathBeingScanned
-                }
-            }
-        }
+        // The built-in effect chain is always available
+        const auto internal = ChainLayout::getInternalDescription();
+        pluginSelectionComboBox.addItem(internal.descriptiveName, 1);
+        pluginDescriptions.add(internal);
 
         // Populate the ComboBox
-        int itemId = 1;
-        for (const juce::PluginDescription* desc : knownPluginList.getTypes())
+        int itemId = 2;
+        for (const auto& desc : knownPluginList.getTypes())
         {
             // Only add plugins that are VST or VST3 and can be used as effects
             // (i.e., has audio inputs and outputs)
-            if ((desc->pluginFormatName == "VST" || desc->pluginFormatName == "VST3") &&
-                desc->hasAudioInput() && desc->hasAudioOutput() && !desc->isInstrument())
+            if ((desc.pluginFormatName == "VST" || desc.pluginFormatName == "VST3") &&
+                desc.numInputChannels > 0 && desc.numOutputChannels > 0 && !desc.isInstrument)
             {
-                pluginSelectionComboBox.addItem(desc->name + " (" + desc->pluginFormatName + ")", itemId++);
-                pluginDescriptions.add(*desc); // Store the description for later loading
+                pluginSelectionComboBox.addItem(desc.name + " (" + desc.pluginFormatName + ")", itemId);
+                pluginDescriptions.add(desc); // Store the description for later loading
+
+                if (desc.createIdentifierString() == selectedIdentifier)
+                    pluginSelectionComboBox.setSelectedId(itemId, juce::dontSendNotification);
+                ++itemId;
             }
         }
 
-        if (pluginSelectionComboBox.getNumItems() > 0)
-        {
-            pluginSelectionComboBox.setSelectedId(1, juce::sendNotification); // Select first plugin by default
-            statusLabel.setText("Plugin scan complete. Select a plugin.", juce::dontSendNotification);
-        }
+        if (pluginSelectionComboBox.getSelectedId() == 0)
+            pluginSelectionComboBox.setSelectedId(1, juce::dontSendNotification); // The built-in chain by default
+
+        if (pluginSelectionComboBox.getNumItems() > 1)
+            statusLabel.setText(juce::String(pluginSelectionComboBox.getNumItems() - 1) + " plugins available.",
+                                juce::dontSendNotification);
         else
-        {
             statusLabel.setText("No suitable VST effect plugins found.", juce::dontSendNotification);
-        }
-        pluginSelectionComboBox.setEnabled(pluginSelectionComboBox.getNumItems() > 0);
     }
 
-    void loadSelectedPlugin()
+    void addSelectedPlugin(bool parallel)
     {
         int selectedId = pluginSelectionComboBox.getSelectedId();
         if (selectedId == 0 || selectedId > pluginDescriptions.size()) // 0 means no selection
@@ -378,101 +445,312 @@ public:
             return;
         }
 
-        const juce::PluginDescription& desc = pluginDescriptions[selectedId - 1];
+        // Plugins already in the chain carry their current settings into the rebuilt one
+        pluginSlot.captureStates(chainLayout);
+
+        // The built-in chain (item 1) is ours: it never needs a sandbox
+        ChainLayout::Branch branch;
+        branch.plugins.push_back({ pluginDescriptions[selectedId - 1], {}, selectedId > 1 && sandboxToggle.getToggleState() });
 
-        // Release previous plugin if any
-        if (loadedPluginInstance)
+        if (parallel && ! chainLayout.stages.empty())
         {
-            if (currentSampleRate > 0 && currentBlockSize > 0)
-                loadedPluginInstance->releaseResources();
-            loadedPluginInstance = nullptr;
+            // Parallel branches are summed, so each gets an equal share
+            auto& stage = chainLayout.stages.back();
+            stage.push_back(std::move(branch));
+            for (auto& b : stage)
+                b.gain = 1.0f / static_cast<float>(stage.size());
+        }
+        else
+        {
+            chainLayout.stages.push_back({ std::move(branch) });
         }
-        
-        juce::String errorMessage;
-        statusLabel.setText("Loading plugin: " + desc.name, juce::dontSendNotification);
 
-        // Create instance of the plugin
-        // This can also take some time and potentially crash if the plugin is faulty.
-        // Consider doing this on a background thread or with error boundaries in a real app.
-        loadedPluginInstance = pluginFormatManager.createPluginInstance(desc, currentSampleRate, currentBlockSize, errorMessage);
+        loadChain();
+    }
 
-        if (!loadedPluginInstance)
+    void exportTrace()
+    {
+        auto& recorder = TraceRecorder::getInstance();
+        if (! recorder.isEnabled())
         {
-            statusLabel.setText("Failed to load plugin: " + desc.name + ". Error: " + errorMessage, juce::dontSendNotification);
-            juce::Logger::writeToLog("Plugin Load Error: " + errorMessage);
+            // The first click starts recording; the next one exports what was captured
+            recorder.setEnabled(true);
+            exportTraceButton.setButtonText("Export Trace");
+            statusLabel.setText("Recording trace...", juce::dontSendNotification);
             return;
         }
 
-        // Prepare the plugin for playback
-        if (currentSampleRate > 0 && currentBlockSize > 0) // Check if audio device is ready
+        const auto file = TraceRecorder::getDefaultTraceFile();
+        const auto result = recorder.exportChromeTrace(file);
+        const auto missing = recorder.getNumUnrecordedThreads();
+        statusLabel.setText(result.wasOk() ? "Trace written to " + file.getFullPathName()
+                                                 + (missing > 0 ? " (" + juce::String(missing) + " threads not recorded: trace buffers full)" : juce::String())
+                                           : "Trace export failed: " + result.getErrorMessage(),
+                            juce::dontSendNotification);
+        if (result.wasOk())
+            file.revealToUser();
+    }
+
+    void toggleRecording(SessionRecorder::Format format)
+    {
+        if (sessionRecorder.isRecording())
         {
-            loadedPluginInstance->setRateAndBufferSizeDetails(currentSampleRate, currentBlockSize);
-            loadedPluginInstance->prepareToPlay(currentSampleRate, currentBlockSize);
+            sessionRecorder.stop(); // Writes out what the disk has not caught up with yet
+            statusLabel.setText("Recording saved to " + SessionRecorder::getDefaultFolder().getFullPathName(),
+                                juce::dontSendNotification);
+            recordButton.setButtonText("Record DI + Out");
+            return;
         }
-        
-        // Enable processing
-        loadedPluginInstance->enableAllBuses(); // Ensure buses are enabled
-
-        statusLabel.setText("Loaded plugin: " + desc.name, juce::dontSendNotification);
-        juce::Logger::writeToLog("Loaded plugin: " + desc.name + " (" + desc.fileOrIdentifier + ")");
-
-        // Optional: Show plugin editor
-        // auto* editor = loadedPluginInstance->createEditor();
-        // if (editor)
-        // {
-        //     // Add editor to your UI. This requires more setup.
-        //     // For simplicity, not shown here.
-        // }
+
+        juce::String error;
+        if (! sessionRecorder.start(SessionRecorder::getDefaultFolder(), format, error))
+            statusLabel.setText("Could not record: " + error, juce::dontSendNotification);
+    }
+
+    void chooseBackingTrack()
+    {
+        trackChooser = std::make_unique<juce::FileChooser>("Load a backing track", juce::File::getSpecialLocation(juce::File::userMusicDirectory),
+                                                           backingTrack.getWildcard());
+        trackChooser->launchAsync(juce::FileBrowserComponent::openMode | juce::FileBrowserComponent::canSelectFiles,
+                                  [this](const juce::FileChooser& chooser)
+                                  {
+                                      const auto file = chooser.getResult();
+                                      if (file == juce::File())
+                                          return;
+
+                                      // Only the headers are read here; the track streams from the player's thread
+                                      juce::String error;
+                                      if (! backingTrack.load(file, error))
+                                      {
+                                          statusLabel.setText("Could not load track: " + error, juce::dontSendNotification);
+                                          return;
+                                      }
+
+                                      const auto stats = backingTrack.getStats();
+                                      trackPositionSlider.setRange(0.0, juce::jmax(1.0, stats.lengthSeconds));
+                                      trackPositionSlider.setEnabled(true);
+                                      playTrackButton.setEnabled(true);
+                                      statusLabel.setText("Loaded " + stats.name + (stats.memoryMapped ? " (memory-mapped)" : " (decoded ahead)"),
+                                                          juce::dontSendNotification);
+                                  });
+    }
+
+    void loadChain()
+    {
+        // Built and prepared on the slot's loader thread; the current chain keeps
+        // playing until the new one is ready (see onLoaded in the constructor)
+        chainLabel.setText(chainLayout.describe(), juce::dontSendNotification);
+        statusLabel.setText("Loading chain...", juce::dontSendNotification);
+        pluginSlot.load(chainLayout);
+
+        // Optional: Show plugin editors
+        // (the slot would need to hand out the chain's instances)
     }
 
 
 private:
     //================ Member Variables ========================================
-    // Audio Device Manager - handles device selection (ASIO, CoreAudio, etc.)
-    // This is already a member of AudioAppComponent, but we keep a reference for clarity if needed.
-    // juce::AudioDeviceManager& audioDeviceManager; (inherited)
+    // Device selection (ASIO, CoreAudio, JACK...) is AudioAppComponent's deviceManager
 
     // Plugin Management
     juce::AudioPluginFormatManager pluginFormatManager;
     juce::KnownPluginList knownPluginList;
+    PluginScanner pluginScanner { pluginFormatManager, knownPluginList }; // cached, background, out-of-process
     juce::Array<juce::PluginDescription> pluginDescriptions; // To map ComboBox IDs to descriptions
-    std::unique_ptr<juce::AudioPluginInstance> loadedPluginInstance;
+    HostPluginSlot pluginSlot { pluginFormatManager }; // loaded off the audio thread, swapped with a crossfade
+    ChainLayout chainLayout; // what pluginSlot was last asked to play
 
     // UI Elements
     juce::TextButton openAudioSettingsButton;
     juce::TextButton scanPluginsButton;
+    juce::TextButton exportTraceButton;
+    juce::TextButton recordButton;
+    juce::TextButton loadTrackButton;
+    juce::TextButton playTrackButton;
+    juce::Slider trackPositionSlider;
+    juce::Slider trackGainSlider;
     juce::ComboBox pluginSelectionComboBox;
+    juce::TextButton addPluginButton;
+    juce::TextButton addParallelButton;
+    juce::ToggleButton sandboxToggle;
+    juce::TextButton clearChainButton;
+    juce::Label chainLabel;
     juce::Label statusLabel;
+    juce::Label deadlineLabel;
 
     // Audio state
     double currentSampleRate = 0.0;
     int currentBlockSize = 0;
 
-    // Timer callback (not used in this simplified blocking scan example)
-    void timerCallback() override {
-        // Example: could trigger a non-blocking scan for new plugins
-        // knownPluginList.scanAndAddDragAndDroppedFiles();
+    DeadlineMonitor deadlineMonitor;
+    SessionRecorder sessionRecorder;
+    BackingTrackPlayer backingTrack; // streamed, never read on the audio thread
+    std::unique_ptr<juce::FileChooser> trackChooser;
+    bool recordWhenAudioStarts = juce::JUCEApplicationBase::getCommandLineParameters().contains("--record");
+    juce::SharedResourcePointer<RealtimeLog> realtimeLog;
+    RealtimeLog::Throttle overrunThrottle; // audio thread
+    LowLatencyMode lowLatency;
+    juce::uint32 audioThreadPolicy = 0; // audio thread
+    juce::String lowLatencyReport;
+
+    // Scan progress while the background scan runs, callback deadlines, and the
+    // low-latency report as the real-time threads fill it in
+    void timerCallback() override
+    {
+        if (pluginScanner.isScanning())
+            statusLabel.setText(pluginScanner.getStatus(), juce::dontSendNotification);
+
+        if (auto* device = deviceManager.getCurrentAudioDevice())
+            deadlineMonitor.setDeviceXRuns(device->getXRunCount());
+
+        deadlineMonitor.update();
+
+        // --record[=flac] starts once the device is running, for unattended shows
+        if (recordWhenAudioStarts && currentSampleRate > 0.0)
+        {
+            recordWhenAudioStarts = false;
+            const auto parameters = juce::JUCEApplicationBase::getCommandLineParameters();
+            toggleRecording(parameters.contains("--record=flac") ? SessionRecorder::Format::flac : SessionRecorder::Format::wav);
+        }
+
+        sessionRecorder.update();
+        if (sessionRecorder.isRecording())
+            recordButton.setButtonText("Stop Recording");
+
+        if (! trackPositionSlider.isMouseButtonDown())
+            trackPositionSlider.setValue(backingTrack.getStats().seconds, juce::dontSendNotification);
+        playTrackButton.setButtonText(backingTrack.isPlaying() ? "Pause" : "Play");
+
+        const auto trackSummary = backingTrack.getSummary();
+        deadlineLabel.setText(deadlineMonitor.getSummary()
+                                  + (sessionRecorder.isRecording() ? "    " + sessionRecorder.getSummary() : juce::String())
+                                  + (trackSummary.isNotEmpty() ? "    " + trackSummary : juce::String()),
+                              juce::dontSendNotification);
+        if (! deadlineMonitor.getRecentOverruns().empty())
+            deadlineLabel.setTooltip(deadlineMonitor.getReport());
+
+        if (lowLatency.isEnabled())
+        {
+            const auto report = lowLatency.getReport();
+            if (report != lowLatencyReport)
+            {
+                lowLatencyReport = report;
+                statusLabel.setTooltip(report);
+                juce::Logger::writeToLog("Low-latency mode:\n" + report);
+
+                if (! pluginScanner.isScanning())
+                    statusLabel.setText(lowLatency.allSucceeded() ? "Low-latency mode: all steps OK"
+                                                                  : "Low-latency mode: some steps failed (hover for details)",
+                                        juce::dontSendNotification);
+            }
+        }
     }
 
     JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(MainAudioComponent)
 };
 
 
-//==============================================================================
-// This macro generates the main() function that launches the app.
-// You need a Main.cpp file in your JUCE project that contains ONLY this:
-//
-// #include "DSP4GuitarApp.h" /* (or whatever your main app header is called) */
-// START_JUCE_APPLICATION (DSP4GuitarApplication)
-//
-// For this example, I'm putting a simplified version here to make it runnable
-// in a conceptual way, but in a real JUCE project, this would be in its own file.
-//==============================================================================
+// ==============================================================================
+// Main Application Class (Entry Point)
+// ==============================================================================
+class DSP4GuitarApplication : public juce::JUCEApplication
+{
+public:
+    DSP4GuitarApplication() {}
 
-/*
-// In your Main.cpp or equivalent:
-#include "AppHeader.h" // Assuming the classes above are in AppHeader.h
+    const juce::String getApplicationName() override { return JUCE_APPLICATION_NAME_STRING; }
+    const juce::String getApplicationVersion() override { return JUCE_APPLICATION_VERSION_STRING; }
+    bool moreThanOneInstanceAllowed() override { return true; }
 
-// This macro creates the application's main() function.
-START_JUCE_APPLICATION (DSP4GuitarApplication)
-*/
+    void initialise(const juce::String& commandLine) override
+    {
+        // Relaunched by PluginScanner to scan plugins out of process: no window
+        childWorker = PluginScanner::createScanWorker(commandLine);
+        if (childWorker != nullptr)
+            return;
+
+        // Relaunched by SandboxedPlugin to run a plugin out of process: no window
+        childWorker = SandboxedPlugin::createWorker(commandLine);
+        if (childWorker != nullptr)
+            return;
+
+        // --sandbox-benchmark [--rate=48000] [--period=64]: prints the sandbox's round-trip
+        // cost and quits. Printed as well as logged: on Windows the logger only reaches
+        // a debugger, never the console the benchmark was started from
+        if (commandLine.contains("--sandbox-benchmark"))
+        {
+            const auto options = LowLatencyMode::Options::fromCommandLine(commandLine);
+            const auto report = SandboxedPlugin::measureOverhead(options.sampleRate, options.periodSize, 2000);
+            std::printf("%s\n", report.toRawUTF8());
+            std::fflush(stdout);
+            juce::Logger::writeToLog(report);
+            quit();
+            return;
+        }
+
+        // --trace records from startup; export with the host's "Export Trace" button
+        if (commandLine.contains("--trace"))
+            TraceRecorder::getInstance().setEnabled(true);
+
+        // This method is where you should put your application's initialisation code
+        mainWindow.reset(new MainHostWindow(getApplicationName(), LowLatencyMode::Options::fromCommandLine(commandLine)));
+    }
+
+    void shutdown() override
+    {
+        // Add your application's shutdown code here.
+        mainWindow = nullptr; // (deletes our window)
+        childWorker = nullptr;
+    }
+
+    void systemRequestedQuit() override
+    {
+        quit();
+    }
+
+    void anotherInstanceStarted(const juce::String& commandLine) override
+    {
+        // When another instance of the app is launched while this one is running,
+        // this method is invoked, and the commandLine parameter tells you what
+        // the other instance's command-line arguments were.
+    }
+
+    // ==============================================================================
+    // Main Window Class
+    // ==============================================================================
+    class MainHostWindow : public juce::DocumentWindow
+    {
+    public:
+        MainHostWindow(juce::String name, const LowLatencyMode::Options& lowLatencyOptions)
+            : DocumentWindow(name,
+                juce::Desktop::getInstance().getDefaultLookAndFeel()
+                .findColour(juce::ResizableWindow::backgroundColourId),
+                DocumentWindow::allButtons)
+        {
+            setUsingNativeTitleBar(true);
+            // The MainAudioComponent will be the heart of our app; the window owns it
+            setContentOwned(new MainAudioComponent(lowLatencyOptions), true);
+
+           #if JUCE_IOS || JUCE_ANDROID
+            setFullScreen(true);
+           #else
+            setResizable(true, true);
+            centreWithSize(getWidth(), getHeight());
+           #endif
+
+            setVisible(true);
+        }
+
+        void closeButtonPressed() override
+        {
+            juce::JUCEApplication::getInstance()->systemRequestedQuit();
+        }
+
+    private:
+        JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(MainHostWindow)
+    };
+
+private:
+    std::unique_ptr<MainHostWindow> mainWindow;
+    std::unique_ptr<juce::ChildProcessWorker> childWorker; // set when relaunched as a scanner or sandbox
+};
@@ -0,0 +1,189 @@
+#pragma once
+
+#include <juce_core/juce_core.h>
+#include <cstring>
+#include <type_traits>
+#include <vector>
+
+//==============================================================================
+/**
+ * DSPArena
+ *
+ * One contiguous, 64-byte aligned block that holds every buffer of an effect
+ * chain. Processors expose a carveFrom() method that requests their slices;
+ * prepareToPlay() runs those methods twice:
+ *
+ *   arena.beginLayout();  carve...   // measuring pass – carve() returns nullptr
+ *   arena.allocate();     carve...   // carving pass   – carve() returns memory
+ *
+ * Both passes must request the same slices in the same order, which falls out
+ * naturally because they run the same code. After allocate() nothing else is
+ * allocated, so processors never touch the heap while audio is running.
+ */
+class DSPArena
+{
+public:
+    static constexpr size_t alignment = 64;
+
+    struct Entry
+    {
+        const char* owner; // string literal naming the processor that carved the slice
+        size_t bytes;
+    };
+
+    struct Report
+    {
+        size_t arenaBytes  = 0;     // bytes carved from the arena (including alignment padding)
+        size_t objectBytes = 0;     // bytes of the owning object itself (filled in by the owner)
+        std::vector<Entry> entries; // per owner, in carve order
+
+        size_t getTotalBytes() const noexcept { return arenaBytes + objectBytes; }
+
+        /** Adds bytes to owner's entry (or a new one), e.g. to merge several arenas. */
+        void addEntry(const char* owner, size_t bytes) { mergeEntry(entries, owner, bytes); }
+
+        /** The total, then one "owner: size" line per entry, in KiB. */
+        juce::String toString() const
+        {
+            auto kib = [](size_t bytes) { return juce::String(static_cast<double>(bytes) / 1024.0, 1) + " KiB"; };
+
+            juce::String text;
+            text << "Total " << kib(getTotalBytes()) << " (arena " << kib(arenaBytes) << ", object " << kib(objectBytes) << ")";
+            for (const auto& entry : entries)
+                text << juce::newLine << entry.owner << ": " << kib(entry.bytes);
+            return text;
+        }
+    };
+
+    DSPArena() = default;
+
+    //==============================================================================
+    /** Starts a measuring pass. Previously carved pointers stay valid until allocate(). */
+    void beginLayout()
+    {
+        measuring = true;
+        offset = 0;
+        entries.clear();
+    }
+
+    /** Allocates the block measured since beginLayout() and starts the carving pass.
+        The block is only reallocated when it has to grow; the carved part is always zeroed. */
+    void allocate()
+    {
+        jassert(measuring);
+
+        if (offset > capacity || base == nullptr)
+        {
+            storage.free();
+            storage.calloc(offset + alignment);
+            capacity = offset;
+
+            const auto address = reinterpret_cast<uintptr_t>(storage.get());
+            base = storage.get() + ((alignment - (address % alignment)) % alignment);
+        }
+        else
+        {
+            std::memset(base, 0, offset);
+        }
+
+        carved = offset;
+        measuring = false;
+        offset = 0;
+    }
+
+    /** Frees the block. Every pointer handed out so far becomes invalid. */
+    void release()
+    {
+        storage.free();
+        base = nullptr;
+        capacity = 0;
+        carved = 0;
+        offset = 0;
+        entries.clear();
+        measuring = true;
+    }
+
+    //==============================================================================
+    /** Carves count zero-initialised objects. Returns nullptr during the measuring pass. */
+    template <typename Type>
+    Type* carve(const char* owner, size_t count)
+    {
+        static_assert(std::is_trivially_destructible_v<Type>, "Arena memory is never destructed");
+        static_assert(alignof(Type) <= alignment, "Type needs a stricter alignment than the arena");
+
+        const auto bytes = roundUp(sizeof(Type) * count);
+        const auto start = offset;
+        offset += bytes;
+
+        if (measuring)
+        {
+            addEntry(owner, bytes);
+            return nullptr;
+        }
+
+        jassert(offset <= capacity); // the carving pass asked for more than it measured
+        return reinterpret_cast<Type*>(base + start);
+    }
+
+    /** Carves a channel-pointer array plus one aligned slice per channel. */
+    template <typename SampleType>
+    SampleType** carveChannels(const char* owner, size_t numChannels, size_t numSamples)
+    {
+        auto** channels = carve<SampleType*>(owner, numChannels);
+
+        for (size_t ch = 0; ch < numChannels; ++ch)
+        {
+            auto* data = carve<SampleType>(owner, numSamples);
+            if (channels != nullptr)
+                channels[ch] = data;
+        }
+
+        return channels;
+    }
+
+    //==============================================================================
+    bool isAllocated() const noexcept   { return base != nullptr && ! measuring; }
+    size_t getCapacity() const noexcept { return capacity; }    // allocated, the high-water mark
+    size_t getCarvedBytes() const noexcept { return carved; }   // in use by the last layout
+
+    /** What the last layout carved; after a shrink the block keeps its larger capacity. */
+    Report getReport() const
+    {
+        Report report;
+        report.arenaBytes = carved;
+        report.entries = entries;
+        return report;
+    }
+
+private:
+    static constexpr size_t roundUp(size_t bytes) noexcept
+    {
+        return (bytes + alignment - 1) & ~(alignment - 1);
+    }
+
+    void addEntry(const char* owner, size_t bytes) { mergeEntry(entries, owner, bytes); }
+
+    static void mergeEntry(std::vector<Entry>& list, const char* owner, size_t bytes)
+    {
+        for (auto& e : list)
+        {
+            if (std::strcmp(e.owner, owner) == 0)
+            {
+                e.bytes += bytes;
+                return;
+            }
+        }
+
+        list.push_back({ owner, bytes });
+    }
+
+    juce::HeapBlock<char> storage;
+    char* base = nullptr;
+    size_t capacity = 0;
+    size_t carved = 0;
+    size_t offset = 0;
+    bool measuring = true;
+    std::vector<Entry> entries;
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(DSPArena)
+};
@@ -0,0 +1,288 @@
+#include "DeadlineMonitor.h"
+#include "CyberpunkLookAndFeel.h"
+#include <algorithm>
+#include <cmath>
+
+//==============================================================================
+DeadlineMonitor::~DeadlineMonitor()
+{
+    stopTimer();
+}
+
+void DeadlineMonitor::prepare(double newSampleRate, const juce::StringArray& valueNames)
+{
+    sampleRate = newSampleRate > 0.0 ? newSampleRate : 44100.0;
+    names = valueNames;
+    lastStartTicks = 0;
+    lastNumSamples = 0;
+}
+
+juce::File DeadlineMonitor::getDefaultDumpFile(const juce::String& name)
+{
+    return juce::File::getSpecialLocation(juce::File::userApplicationDataDirectory)
+               .getChildFile("DSP4Guitar")
+               .getChildFile(name + "Deadlines-" + juce::Time::getCurrentTime().formatted("%Y%m%d-%H%M%S") + ".txt")
+               .getNonexistentSibling();
+}
+
+//==============================================================================
+juce::int64 DeadlineMonitor::beginCallback() noexcept
+{
+    const auto now = juce::Time::getHighResolutionTicks();
+
+    if (resetRequested.exchange(false, std::memory_order_acq_rel))
+    {
+        for (auto& bucket : histogram)
+            bucket.store(0, std::memory_order_relaxed);
+        for (auto* counter : { &callbacks, &overruns, &xruns })
+            counter->store(0, std::memory_order_relaxed);
+        peakLoad.store(0.0f, std::memory_order_relaxed);
+        loadSum.store(0.0, std::memory_order_relaxed);
+        lastStartTicks = 0;
+    }
+
+    // The previous buffer should have been due one period after it started
+    if (lastStartTicks != 0 && lastNumSamples > 0)
+    {
+        const auto gap = static_cast<double>(now - lastStartTicks) / ticksPerSecond;
+        const auto period = lastNumSamples / sampleRate;
+        if (gap > period * xrunGapPeriods && gap < 1.0)
+            xruns.fetch_add(1, std::memory_order_relaxed);
+    }
+
+    lastStartTicks = now;
+    return now;
+}
+
+bool DeadlineMonitor::endCallback(juce::int64 startTicks, int numSamples) noexcept
+{
+    lastNumSamples = numSamples;
+    if (numSamples <= 0)
+        return false;
+
+    const auto seconds = static_cast<double>(juce::Time::getHighResolutionTicks() - startTicks) / ticksPerSecond;
+    const auto load = static_cast<float>(seconds * sampleRate / numSamples);
+
+    const auto bucket = juce::jlimit(0, numBuckets - 1, static_cast<int>(load / bucketWidth));
+    histogram[static_cast<size_t>(bucket)].fetch_add(1, std::memory_order_relaxed);
+
+    // Single writer: plain load/store
+    if (load > peakLoad.load(std::memory_order_relaxed))
+        peakLoad.store(load, std::memory_order_relaxed);
+    loadSum.store(loadSum.load(std::memory_order_relaxed) + load, std::memory_order_relaxed);
+    callbacks.fetch_add(1, std::memory_order_release);
+
+    if (load <= 1.0f)
+        return false;
+
+    overruns.fetch_add(1, std::memory_order_relaxed);
+    lastOverrunTicks = juce::Time::getHighResolutionTicks();
+    lastOverrunLoad = load;
+    return true;
+}
+
+void DeadlineMonitor::recordOverrun(const float* values, int numValues, int preset) noexcept
+{
+    const auto scope = overrunFifo.write(1);
+    if (scope.blockSize1 == 0)
+        return;
+
+    auto& slot = overrunQueue[static_cast<size_t>(scope.startIndex1)];
+    slot.ticks = lastOverrunTicks;
+    slot.load = lastOverrunLoad;
+    slot.numSamples = lastNumSamples;
+    slot.preset = preset;
+    slot.numValues = values != nullptr ? juce::jmin(numValues, maxValues) : 0;
+    std::copy(values, values + slot.numValues, slot.values.begin());
+}
+
+//==============================================================================
+void DeadlineMonitor::update()
+{
+    overrunFifo.read(overrunFifo.getNumReady()).forEach([this](int index)
+    {
+        recentOverruns.push_back(overrunQueue[static_cast<size_t>(index)]);
+        if (recentOverruns.size() > static_cast<size_t>(maxRecentOverruns))
+            recentOverruns.pop_front();
+    });
+}
+
+DeadlineMonitor::Stats DeadlineMonitor::getStats() const
+{
+    Stats stats;
+    stats.callbacks = callbacks.load(std::memory_order_acquire);
+    stats.overruns = overruns.load(std::memory_order_relaxed);
+    stats.xruns = xruns.load(std::memory_order_relaxed);
+    stats.deviceXRuns = deviceXRuns;
+    stats.peakLoad = peakLoad.load(std::memory_order_relaxed);
+    stats.averageLoad = stats.callbacks > 0
+                      ? static_cast<float>(loadSum.load(std::memory_order_relaxed) / static_cast<double>(stats.callbacks))
+                      : 0.0f;
+
+    for (size_t i = 0; i < histogram.size(); ++i)
+        stats.histogram[i] = histogram[i].load(std::memory_order_relaxed);
+
+    return stats;
+}
+
+juce::String DeadlineMonitor::getSummary() const
+{
+    const auto stats = getStats();
+    juce::String summary;
+    summary << "DSP " << juce::roundToInt(stats.averageLoad * 100.0f) << "% (peak "
+            << juce::roundToInt(stats.peakLoad * 100.0f) << "%)  overruns " << static_cast<juce::int64>(stats.overruns)
+            << "  xruns " << static_cast<juce::int64>(stats.xruns);
+
+    if (stats.deviceXRuns >= 0)
+        summary << " (device " << stats.deviceXRuns << ")";
+
+    return summary;
+}
+
+juce::String DeadlineMonitor::describeOverrun(const Overrun& overrun) const
+{
+    // Ticks are converted to wall-clock time relative to now
+    const auto ageSeconds = static_cast<double>(juce::Time::getHighResolutionTicks() - overrun.ticks) / ticksPerSecond;
+    const auto when = juce::Time::getCurrentTime() - juce::RelativeTime::seconds(ageSeconds);
+    const auto periodMs = 1000.0 * overrun.numSamples / sampleRate;
+
+    juce::String line;
+    line << when.toString(false, true, true, true) << "  " << juce::roundToInt(overrun.load * 100.0f) << "% of "
+         << juce::String(periodMs, 2) << " ms (" << overrun.numSamples << " samples)";
+
+    if (overrun.preset >= 0)
+        line << ", preset " << overrun.preset;
+
+    for (int i = 0; i < overrun.numValues; ++i)
+        line << (i == 0 ? ": " : " ") << (i < names.size() ? names[i] : "#" + juce::String(i))
+             << "=" << juce::String(overrun.values[static_cast<size_t>(i)], 3);
+
+    return line;
+}
+
+juce::String DeadlineMonitor::getReport() const
+{
+    const auto stats = getStats();
+    const auto overrunPercent = stats.callbacks > 0 ? 100.0 * static_cast<double>(stats.overruns) / static_cast<double>(stats.callbacks) : 0.0;
+
+    juce::String report;
+    report << "DSP4Guitar deadline report, " << juce::Time::getCurrentTime().toString(true, true, true, true) << juce::newLine
+           << "Callbacks: " << static_cast<juce::int64>(stats.callbacks)
+           << ", overruns: " << static_cast<juce::int64>(stats.overruns) << " (" << juce::String(overrunPercent, 3) << "%)"
+           << ", xruns detected: " << static_cast<juce::int64>(stats.xruns);
+    if (stats.deviceXRuns >= 0)
+        report << ", device xruns: " << stats.deviceXRuns;
+    report << juce::newLine
+           << "Load: average " << juce::String(stats.averageLoad * 100.0f, 1) << "%, peak "
+           << juce::String(stats.peakLoad * 100.0f, 1) << "%" << juce::newLine << juce::newLine
+           << "Callback time / buffer period:" << juce::newLine;
+
+    const auto largest = juce::jmax(1u, *std::max_element(stats.histogram.begin(), stats.histogram.end()));
+    for (int i = 0; i < numBuckets; ++i)
+    {
+        const auto count = stats.histogram[static_cast<size_t>(i)];
+        if (count == 0)
+            continue;
+
+        const auto from = juce::roundToInt(static_cast<float>(i) * bucketWidth * 100.0f);
+        const auto label = i == numBuckets - 1 ? juce::String(from) + "%+"
+                                               : juce::String(from) + "-" + juce::String(from + juce::roundToInt(bucketWidth * 100.0f)) + "%";
+        report << label.paddedLeft(' ', 9) << " |" << juce::String::repeatedString("#", static_cast<int>(40ull * count / largest))
+               << " " << static_cast<juce::int64>(count) << juce::newLine;
+    }
+
+    if (! recentOverruns.empty())
+    {
+        report << juce::newLine << "Recent overruns (newest last):" << juce::newLine;
+        for (const auto& overrun : recentOverruns)
+            report << "  " << describeOverrun(overrun) << juce::newLine;
+    }
+
+    return report;
+}
+
+//==============================================================================
+void DeadlineMonitor::startDumping(const juce::File& file, int intervalSeconds)
+{
+    dumpFile = file;
+    startTimer(juce::jmax(1, intervalSeconds) * 1000);
+}
+
+void DeadlineMonitor::timerCallback()
+{
+    update();
+
+    // Only while audio runs, so an idle instance leaves the last report alone
+    const auto count = callbacks.load(std::memory_order_acquire);
+    if (count == callbacksAtLastDump)
+        return;
+
+    callbacksAtLastDump = count;
+    dumpFile.getParentDirectory().createDirectory();
+    if (! dumpFile.replaceWithText(getReport()))
+        juce::Logger::writeToLog("Could not write deadline report: " + dumpFile.getFullPathName());
+}
+
+//==============================================================================
+void DeadlineDisplay::refresh()
+{
+    monitor.update();
+    stats = monitor.getStats();
+
+    // The tooltip only changes when there is a new overrun to show
+    if (stats.overruns != shownOverruns)
+    {
+        shownOverruns = stats.overruns;
+        const auto report = monitor.getReport();
+        setTooltip(report.fromFirstOccurrenceOf("Recent overruns", true, false).isNotEmpty()
+                       ? report.fromFirstOccurrenceOf("Recent overruns", true, false) : juce::String("No overruns"));
+    }
+
+    repaint();
+}
+
+void DeadlineDisplay::paint(juce::Graphics& g)
+{
+    using CP = CyberpunkLookAndFeel;
+
+    const auto bounds = getLocalBounds();
+    g.fillAll(CP::matrixDarkBG);
+    g.setColour(juce::Colour(0xFF080812));
+    g.fillRoundedRectangle(bounds.toFloat(), 5.0f);
+    g.setColour(CP::matrixGreen.withAlpha(0.6f));
+    g.drawRoundedRectangle(bounds.toFloat().reduced(0.5f), 5.0f, 1.2f);
+
+    auto area = bounds.reduced(8);
+    auto text = area.removeFromTop(28);
+
+    g.setFont(CyberpunkLookAndFeel::getCustomFont().withHeight(12.0f).boldened());
+    g.setColour(CP::matrixGreen);
+    g.drawText("DEADLINE", text.removeFromTop(14), juce::Justification::centredLeft);
+
+    g.setFont(CyberpunkLookAndFeel::getCustomFont().withHeight(10.0f));
+    g.setColour(stats.overruns > 0 || stats.xruns > 0 ? CP::matrixPurple : CP::matrixCyan);
+    g.drawText(monitor.getSummary(), text, juce::Justification::centredLeft, true);
+
+    g.setColour(CP::matrixBlack);
+    g.fillRect(area);
+
+    // Histogram, 0 to 200 % of the period on a log count axis; the deadline is the line at 100 %
+    const auto largest = juce::jmax(1u, *std::max_element(stats.histogram.begin(), stats.histogram.end()));
+    const auto barWidth = static_cast<float>(area.getWidth()) / DeadlineMonitor::numBuckets;
+    const auto height = static_cast<float>(area.getHeight());
+
+    for (int i = 0; i < DeadlineMonitor::numBuckets; ++i)
+    {
+        const auto count = stats.histogram[static_cast<size_t>(i)];
+        if (count == 0)
+            continue;
+
+        const auto proportion = std::log1p(static_cast<float>(count)) / std::log1p(static_cast<float>(largest));
+        const auto x = static_cast<float>(area.getX()) + barWidth * static_cast<float>(i);
+        g.setColour(i * DeadlineMonitor::bucketWidth >= 1.0f ? CP::matrixPurple : CP::matrixGreen);
+        g.fillRect(x, static_cast<float>(area.getBottom()) - height * proportion, juce::jmax(1.0f, barWidth - 1.0f), height * proportion);
+    }
+
+    g.setColour(CP::matrixCyan.withAlpha(0.8f));
+    g.drawVerticalLine(area.getX() + area.getWidth() / 2, static_cast<float>(area.getY()), static_cast<float>(area.getBottom()));
+}
@@ -0,0 +1,158 @@
+#pragma once
+
+#include <juce_audio_basics/juce_audio_basics.h>
+#include <juce_gui_basics/juce_gui_basics.h>
+#include <array>
+#include <atomic>
+#include <deque>
+
+//==============================================================================
+/**
+ * DeadlineMonitor
+ *
+ * Measures every audio callback against its deadline, the buffer period
+ * (numSamples / sampleRate), so dropouts can be tied to the settings that
+ * caused them.
+ *
+ * Audio thread, per callback:
+ *   const auto start = monitor.beginCallback();
+ *   ... process ...
+ *   if (monitor.endCallback(start, numSamples))
+ *       monitor.recordOverrun(values, numValues, presetIndex);
+ *
+ * The load (time taken / period) goes into a lock-free histogram of 5 %
+ * buckets; a callback over 100 % is an overrun and its parameter snapshot is
+ * queued through an AbstractFifo. A start more than 1.5 periods after the
+ * previous one is counted as an xrun (the device ran dry in between); gaps
+ * over a second are taken as a stopped transport, not an xrun. The host can
+ * add the device's own xrun count with setDeviceXRuns().
+ *
+ * Message thread: update() drains the overrun queue into recent history;
+ * getStats() and getRecentOverruns() feed the UI, and startDumping() rewrites
+ * a plain-text report every few seconds while callbacks keep arriving.
+ */
+class DeadlineMonitor : private juce::Timer
+{
+public:
+    static constexpr int numBuckets = 40; // 5 % each; the last one is >= 195 %
+    static constexpr float bucketWidth = 0.05f;
+    static constexpr int maxValues = 64;
+    static constexpr double xrunGapPeriods = 1.5;
+
+    struct Overrun
+    {
+        juce::int64 ticks = 0;   // high-resolution ticks at the end of the callback
+        float load = 0.0f;       // time taken / period
+        int numSamples = 0;
+        int preset = -1;
+        int numValues = 0;
+        std::array<float, maxValues> values {};
+    };
+
+    struct Stats
+    {
+        juce::uint64 callbacks = 0, overruns = 0, xruns = 0;
+        int deviceXRuns = -1; // -1: not reported by the device
+        float averageLoad = 0.0f, peakLoad = 0.0f;
+        std::array<juce::uint32, numBuckets> histogram {};
+    };
+
+    DeadlineMonitor() = default;
+    ~DeadlineMonitor() override;
+
+    /** Message thread, audio stopped. valueNames label the snapshot values in the dump. */
+    void prepare(double sampleRate, const juce::StringArray& valueNames = {});
+
+    //==============================================================================
+    /** Audio thread. */
+    juce::int64 beginCallback() noexcept;
+
+    /** Audio thread. True if this callback overran its period. */
+    bool endCallback(juce::int64 startTicks, int numSamples) noexcept;
+
+    /** Audio thread, after endCallback returned true; values may be nullptr. Dropped
+        if the queue is full. */
+    void recordOverrun(const float* values, int numValues, int preset) noexcept;
+
+    //==============================================================================
+    /** Message thread. */
+    void update();
+    Stats getStats() const;
+    const std::deque<Overrun>& getRecentOverruns() const noexcept { return recentOverruns; }
+    void setDeviceXRuns(int count) noexcept { deviceXRuns = count; }
+
+    /** Clears the history now and the counters at the next callback. */
+    void reset()
+    {
+        recentOverruns.clear();
+        resetRequested.store(true, std::memory_order_release);
+    }
+
+    /** One line, e.g. "DSP 41% (peak 97%)  overruns 2  xruns 1". */
+    juce::String getSummary() const;
+
+    /** Rewrites file with getReport() every intervalSeconds while audio runs. */
+    void startDumping(const juce::File& file, int intervalSeconds);
+    void stopDumping() { stopTimer(); }
+    bool isDumping() const { return isTimerRunning(); }
+    juce::File getDumpFile() const { return dumpFile; }
+
+    juce::String getReport() const;
+
+    /** <name>Deadlines-<date>-<time>.txt, so instances dumping at once keep their own files. */
+    static juce::File getDefaultDumpFile(const juce::String& name);
+
+    static constexpr int maxRecentOverruns = 16;
+
+private:
+    void timerCallback() override;
+    juce::String describeOverrun(const Overrun& overrun) const;
+
+    // Audio thread
+    double sampleRate = 44100.0;
+    double ticksPerSecond = static_cast<double>(juce::Time::getHighResolutionTicksPerSecond());
+    juce::int64 lastStartTicks = 0, lastOverrunTicks = 0;
+    int lastNumSamples = 0;
+    float lastOverrunLoad = 0.0f;
+
+    // Written by the audio thread only
+    std::array<std::atomic<juce::uint32>, numBuckets> histogram {};
+    std::atomic<juce::uint64> callbacks { 0 }, overruns { 0 }, xruns { 0 };
+    std::atomic<float> peakLoad { 0.0f };
+    std::atomic<double> loadSum { 0.0 };
+    std::atomic<bool> resetRequested { false };
+
+    static constexpr int queueSize = 32;
+    juce::AbstractFifo overrunFifo { queueSize };
+    std::array<Overrun, queueSize> overrunQueue;
+
+    // Message thread
+    juce::StringArray names;
+    std::deque<Overrun> recentOverruns;
+    int deviceXRuns = -1;
+    juce::File dumpFile;
+    juce::uint64 callbacksAtLastDump = 0;
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(DeadlineMonitor)
+};
+
+//==============================================================================
+/** Load histogram with overrun and xrun counts; hover for the latest overruns. */
+class DeadlineDisplay : public juce::Component,
+                        public juce::SettableTooltipClient
+{
+public:
+    explicit DeadlineDisplay(DeadlineMonitor& monitorToShow) : monitor(monitorToShow) { setOpaque(true); }
+
+    /** Message thread, from a UI timer: drains the monitor and repaints. */
+    void refresh();
+
+    void paint(juce::Graphics&) override;
+
+private:
+    DeadlineMonitor& monitor;
+    DeadlineMonitor::Stats stats;
+    juce::uint64 shownOverruns = 0;
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(DeadlineDisplay)
+};
@@ -0,0 +1,482 @@
+#include "HostChain.h"
+#include "LowLatencyMode.h"
+#include "MultiEffectProcessor.h"
+#include "SandboxedPlugin.h"
+#include "TraceRecorder.h"
+#include <thread>
+
+namespace
+{
+    constexpr const char* internalFormatName = "Internal";
+
+    juce::String describeBranch(const ChainLayout::Branch& branch)
+    {
+        juce::StringArray names;
+        for (const auto& plugin : branch.plugins)
+            names.add(plugin.description.name + (plugin.sandboxed ? " (sandboxed)" : ""));
+        return names.joinIntoString(" -> ");
+    }
+
+    // Instances for formats that need an unblocked message thread are created there;
+    // the loader thread waits for them. Shared, so an instance that arrives after the
+    // loader gave up is deleted with the callback, on the message thread
+    struct AsyncCreation
+    {
+        juce::WaitableEvent done;
+        std::unique_ptr<juce::AudioProcessor> instance;
+        juce::String error;
+    };
+
+    // Waits in short slices: a slot destroyed on the message thread stops the loader
+    // and waits for it there, so one long wait would hang the UI until stopThread's
+    // timeout killed the loader
+    std::unique_ptr<juce::AudioProcessor> waitForMessageThread(AsyncCreation& creation, juce::String& error)
+    {
+        constexpr int sliceMs = 50, timeoutMs = 30000;
+
+        for (int waited = 0; ! creation.done.wait(sliceMs); waited += sliceMs)
+        {
+            if (juce::Thread::currentThreadShouldExit())
+            {
+                error = "Cancelled";
+                return nullptr;
+            }
+
+            if (waited >= timeoutMs)
+            {
+                error = "Timed out waiting for the message thread";
+                return nullptr;
+            }
+        }
+
+        error = creation.error;
+        return std::move(creation.instance);
+    }
+
+    std::unique_ptr<juce::AudioProcessor> createProcessor(const juce::PluginDescription& description,
+                                                          juce::AudioPluginFormatManager& formats,
+                                                          double sampleRate, int blockSize,
+                                                          juce::String& error, bool& createdOnMessageThread)
+    {
+        // The built-in processor starts juce::Timers (its parameter mirror), which belong
+        // to the message thread, so it is created there like async-only formats
+        if (description.pluginFormatName == internalFormatName)
+        {
+            createdOnMessageThread = true;
+            auto creation = std::make_shared<AsyncCreation>();
+            juce::MessageManager::callAsync([creation]
+            {
+                creation->instance = std::make_unique<MultiEffectProcessor>();
+                creation->done.signal();
+            });
+
+            return waitForMessageThread(*creation, error);
+        }
+
+        for (auto* format : formats.getFormats())
+        {
+            if (format->getName() != description.pluginFormatName
+                || ! format->requiresUnblockedMessageThreadDuringCreation(description))
+                continue;
+
+            createdOnMessageThread = true;
+            auto creation = std::make_shared<AsyncCreation>();
+            formats.createPluginInstanceAsync(description, sampleRate, blockSize,
+                [creation](std::unique_ptr<juce::AudioPluginInstance> instance, const juce::String& message)
+                {
+                    creation->instance = std::move(instance);
+                    creation->error = message;
+                    creation->done.signal();
+                });
+
+            return waitForMessageThread(*creation, error);
+        }
+
+        return formats.createPluginInstance(description, sampleRate, blockSize, error);
+    }
+}
+
+//==============================================================================
+int ChainLayout::getNumPlugins() const
+{
+    int count = 0;
+    for (const auto& stage : stages)
+        for (const auto& branch : stage)
+            count += static_cast<int>(branch.plugins.size());
+    return count;
+}
+
+juce::String ChainLayout::describe() const
+{
+    juce::StringArray parts;
+
+    for (const auto& stage : stages)
+    {
+        if (stage.size() == 1)
+        {
+            parts.add(describeBranch(stage.front()));
+            continue;
+        }
+
+        juce::StringArray branches;
+        for (const auto& branch : stage)
+            branches.add(describeBranch(branch));
+        parts.add("[" + branches.joinIntoString(" | ") + "]");
+    }
+
+    return parts.isEmpty() ? juce::String("(empty: dry signal)") : parts.joinIntoString(" -> ");
+}
+
+juce::PluginDescription ChainLayout::getInternalDescription()
+{
+    juce::PluginDescription description;
+    description.name = "DSP4Guitar";
+    description.descriptiveName = "DSP4Guitar multi-effect (built in)";
+    description.pluginFormatName = internalFormatName;
+    description.fileOrIdentifier = "DSP4Guitar";
+    description.manufacturerName = "GizzZmo";
+    description.category = "Effect";
+    description.numInputChannels = 2;
+    description.numOutputChannels = 2;
+    return description;
+}
+
+//==============================================================================
+class BranchWorkers::Worker : public juce::Thread
+{
+public:
+    Worker(BranchWorkers& workersToServe, int index)
+        : juce::Thread("Branch worker " + juce::String(index)), owner(workersToServe) {}
+
+    void run() override
+    {
+        juce::uint32 policyGeneration = 0;
+
+        while (! threadShouldExit())
+        {
+            wakeUp.wait(-1);
+            if (threadShouldExit())
+                break;
+
+            LowLatencyMode::applyThreadPolicy(LowLatencyMode::ThreadRole::worker, policyGeneration);
+            owner.drain();
+        }
+    }
+
+    juce::WaitableEvent wakeUp;
+
+private:
+    BranchWorkers& owner;
+};
+
+BranchWorkers::BranchWorkers(int numWorkers)
+{
+    for (int i = 0; i < numWorkers; ++i)
+    {
+        auto* worker = workers.add(new Worker(*this, i));
+        if (! worker->startRealtimeThread(juce::Thread::RealtimeOptions().withPriority(8)))
+            worker->startThread(juce::Thread::Priority::highest);
+    }
+}
+
+BranchWorkers::~BranchWorkers()
+{
+    for (auto* worker : workers)
+    {
+        worker->signalThreadShouldExit();
+        worker->wakeUp.signal();
+    }
+
+    for (auto* worker : workers)
+        worker->stopThread(1000);
+}
+
+void BranchWorkers::run(TaskFunction task, void* context, int count) noexcept
+{
+    if (count <= 0)
+        return;
+
+    taskFunction = task;
+    taskContext = context;
+    numTasks.store(count, std::memory_order_relaxed);
+    finishedTasks.store(0, std::memory_order_relaxed);
+    nextTask.store(0, std::memory_order_release);
+
+    for (int i = 0; i < juce::jmin(count - 1, workers.size()); ++i)
+        workers.getUnchecked(i)->wakeUp.signal();
+
+    drain();
+
+    while (finishedTasks.load(std::memory_order_acquire) < count)
+        std::this_thread::yield();
+
+    // A worker woken late must be out before the next run rewrites the task
+    nextTask.store(closed, std::memory_order_relaxed);
+    while (activeWorkers.load(std::memory_order_acquire) != 0)
+        std::this_thread::yield();
+}
+
+void BranchWorkers::drain() noexcept
+{
+    activeWorkers.fetch_add(1, std::memory_order_acq_rel);
+
+    for (;;)
+    {
+        const auto index = nextTask.fetch_add(1, std::memory_order_acq_rel);
+        if (index >= numTasks.load(std::memory_order_acquire))
+            break;
+
+        taskFunction(taskContext, index);
+        finishedTasks.fetch_add(1, std::memory_order_release);
+    }
+
+    activeWorkers.fetch_sub(1, std::memory_order_release);
+}
+
+//==============================================================================
+std::unique_ptr<HostChain> HostChain::create(const ChainLayout& layout,
+                                             juce::AudioPluginFormatManager& formats,
+                                             double sampleRate, int maximumBlockSize,
+                                             juce::String& error)
+{
+    auto chain = std::make_unique<HostChain>();
+
+    for (const auto& stageLayout : layout.stages)
+    {
+        Stage stage;
+
+        for (const auto& branchLayout : stageLayout)
+        {
+            Branch branch;
+            branch.gain = branchLayout.gain;
+
+            for (const auto& plugin : branchLayout.plugins)
+            {
+                std::unique_ptr<juce::AudioProcessor> processor;
+                if (plugin.sandboxed && SandboxedPlugin::isSupported())
+                    processor = SandboxedPlugin::create(plugin.description, sampleRate, maximumBlockSize, error);
+                else
+                    processor = createProcessor(plugin.description, formats, sampleRate, maximumBlockSize,
+                                                error, chain->createdOnMessageThread);
+                if (processor == nullptr)
+                {
+                    error = plugin.description.name + ": " + (error.isNotEmpty() ? error : juce::String("could not be created"));
+
+                    // What was already created on the message thread is deleted there too
+                    if (chain->createdOnMessageThread)
+                        juce::MessageManager::callAsync([discarded = std::shared_ptr<HostChain>(std::move(chain))] {});
+
+                    return nullptr;
+                }
+
+                if (plugin.state.getSize() > 0)
+                    processor->setStateInformation(plugin.state.getData(), static_cast<int>(plugin.state.getSize()));
+
+                branch.processors.push_back(std::move(processor));
+                branch.traceNames.push_back(TraceRecorder::getInstance().intern(plugin.description.name));
+            }
+
+            if (! branch.processors.empty())
+                stage.branches.push_back(std::move(branch));
+        }
+
+        if (! stage.branches.empty())
+            chain->stages.push_back(std::move(stage));
+    }
+
+    return chain;
+}
+
+void HostChain::prepare(double sampleRate, int maximumBlockSize, int numChannels)
+{
+    latencySamples = 0;
+
+    for (auto& stage : stages)
+    {
+        auto stageLatency = 0;
+
+        for (auto& branch : stage.branches)
+        {
+            branch.latency = 0;
+            auto widestChannels = 0;
+
+            for (auto& processor : branch.processors)
+            {
+                applyDeviceLayout(*processor, numChannels);
+                processor->setRateAndBufferSizeDetails(sampleRate, maximumBlockSize);
+                processor->prepareToPlay(sampleRate, maximumBlockSize);
+                branch.latency += processor->getLatencySamples();
+                widestChannels = juce::jmax(widestChannels, processor->getTotalNumInputChannels(),
+                                            processor->getTotalNumOutputChannels());
+            }
+
+            // Only plugins that would not take the device layout run on the scratch buffer
+            branch.scratch.setSize(widestChannels > numChannels ? widestChannels : 0,
+                                   widestChannels > numChannels ? maximumBlockSize : 0);
+            stageLatency = juce::jmax(stageLatency, branch.latency);
+        }
+
+        const bool parallel = stage.branches.size() > 1;
+
+        for (auto& branch : stage.branches)
+        {
+            branch.compensation = stageLatency - branch.latency;
+            branch.buffer.setSize(numChannels, parallel ? maximumBlockSize : 0);
+            branch.delay.setSize(numChannels, juce::jmax(1, branch.compensation));
+            branch.delay.clear();
+            branch.delayPosition = 0;
+            branch.midi.ensureSize(256);
+        }
+
+        latencySamples += stageLatency;
+    }
+}
+
+void HostChain::applyDeviceLayout(juce::AudioProcessor& processor, int numChannels)
+{
+    // Main buses at the device's channel count, sidechains and aux buses off
+    auto layout = processor.getBusesLayout();
+    for (auto* buses : { &layout.inputBuses, &layout.outputBuses })
+        for (int bus = 1; bus < buses->size(); ++bus)
+            buses->getReference(bus) = juce::AudioChannelSet::disabled();
+
+    const auto deviceSet = juce::AudioChannelSet::canonicalChannelSet(numChannels);
+    auto deviceLayout = layout;
+    if (! deviceLayout.inputBuses.isEmpty())
+        deviceLayout.inputBuses.getReference(0) = deviceSet;
+    if (! deviceLayout.outputBuses.isEmpty())
+        deviceLayout.outputBuses.getReference(0) = deviceSet;
+
+    // Failing that, its own main layout with the other buses off; failing that, as it is
+    if (! processor.setBusesLayout(deviceLayout))
+        processor.setBusesLayout(layout);
+}
+
+void HostChain::release()
+{
+    for (auto& stage : stages)
+        for (auto& branch : stage.branches)
+            for (auto& processor : branch.processors)
+                processor->releaseResources();
+}
+
+void HostChain::captureStates(ChainLayout& layout) const
+{
+    for (size_t s = 0; s < juce::jmin(stages.size(), layout.stages.size()); ++s)
+    {
+        const auto& branches = stages[s].branches;
+        auto& branchLayouts = layout.stages[s];
+
+        for (size_t b = 0; b < juce::jmin(branches.size(), branchLayouts.size()); ++b)
+        {
+            const auto& processors = branches[b].processors;
+            auto& plugins = branchLayouts[b].plugins;
+
+            for (size_t p = 0; p < juce::jmin(processors.size(), plugins.size()); ++p)
+                processors[p]->getStateInformation(plugins[p].state);
+        }
+    }
+}
+
+//==============================================================================
+void HostChain::Branch::process(juce::AudioBuffer<float>& block) noexcept
+{
+    for (size_t i = 0; i < processors.size(); ++i)
+    {
+        auto& processor = *processors[i];
+        if (processor.isSuspended())
+            continue;
+
+        DSP4G_TRACE_ZONE(traceNames[i]);
+        midi.clear();
+
+        const auto numChannels = juce::jmax(processor.getTotalNumInputChannels(), processor.getTotalNumOutputChannels());
+        if (numChannels <= block.getNumChannels())
+        {
+            processor.processBlock(block, midi);
+            continue;
+        }
+
+        // More channels than the device has: the extra ones start silent and are dropped
+        juce::AudioBuffer<float> wide(scratch.getArrayOfWritePointers(), numChannels, block.getNumSamples());
+        for (int ch = 0; ch < numChannels; ++ch)
+        {
+            if (ch < block.getNumChannels())
+                wide.copyFrom(ch, 0, block, ch, 0, block.getNumSamples());
+            else
+                wide.clear(ch, 0, block.getNumSamples());
+        }
+
+        processor.processBlock(wide, midi);
+
+        for (int ch = 0; ch < block.getNumChannels(); ++ch)
+            block.copyFrom(ch, 0, wide, ch, 0, block.getNumSamples());
+    }
+
+    if (compensation == 0)
+        return;
+
+    // Delay to the stage's longest branch
+    const auto numSamples = block.getNumSamples();
+    auto position = delayPosition;
+
+    for (int ch = 0; ch < juce::jmin(block.getNumChannels(), delay.getNumChannels()); ++ch)
+    {
+        auto* data = block.getWritePointer(ch);
+        auto* line = delay.getWritePointer(ch);
+        position = delayPosition;
+
+        for (int i = 0; i < numSamples; ++i)
+        {
+            const auto delayed = line[position];
+            line[position] = data[i];
+            data[i] = delayed;
+            if (++position == compensation)
+                position = 0;
+        }
+    }
+
+    delayPosition = position;
+}
+
+void HostChain::processBranchTask(void* context, int index) noexcept
+{
+    DSP4G_TRACE_ZONE("Parallel branch");
+    auto& stage = *static_cast<Stage*>(context);
+    auto& branch = stage.branches[static_cast<size_t>(index)];
+
+    const auto numChannels = juce::jmin(stage.input->getNumChannels(), branch.buffer.getNumChannels());
+    juce::AudioBuffer<float> view(branch.buffer.getArrayOfWritePointers(), numChannels, 0, stage.numSamples);
+
+    for (int ch = 0; ch < numChannels; ++ch)
+        view.copyFrom(ch, 0, *stage.input, ch, 0, stage.numSamples);
+
+    branch.process(view);
+}
+
+void HostChain::process(juce::AudioBuffer<float>& block, BranchWorkers& workers) noexcept
+{
+    const auto numSamples = block.getNumSamples();
+
+    for (auto& stage : stages)
+    {
+        if (stage.branches.size() == 1)
+        {
+            auto& branch = stage.branches.front();
+            branch.process(block);
+            if (branch.gain != 1.0f)
+                block.applyGain(branch.gain);
+            continue;
+        }
+
+        // Every branch reads the stage input into its own buffer, in parallel
+        stage.input = &block;
+        stage.numSamples = numSamples;
+        workers.run(&HostChain::processBranchTask, &stage, static_cast<int>(stage.branches.size()));
+
+        block.clear();
+        for (auto& branch : stage.branches)
+            for (int ch = 0; ch < juce::jmin(block.getNumChannels(), branch.buffer.getNumChannels()); ++ch)
+                block.addFrom(ch, 0, branch.buffer, ch, 0, numSamples, branch.gain);
+    }
+}
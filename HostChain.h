@@ -0,0 +1,157 @@
+#pragma once
+
+#include <juce_audio_processors/juce_audio_processors.h>
+#include <atomic>
+#include <memory>
+#include <vector>
+
+//==============================================================================
+/**
+ * ChainLayout
+ *
+ * What the host should play, as plain data: a series of stages, each stage one
+ * or more parallel branches, each branch a series of plugins. A stage's input
+ * is fed to every branch and the branch outputs are summed (times their gain)
+ * into the next stage. States are filled in by HostPluginSlot::captureStates()
+ * so that a rebuilt chain picks up where the playing one was.
+ */
+struct ChainLayout
+{
+    struct Plugin
+    {
+        juce::PluginDescription description;
+        juce::MemoryBlock state;
+        bool sandboxed = false; // run in a child process (SandboxedPlugin), where supported
+    };
+
+    struct Branch
+    {
+        std::vector<Plugin> plugins;
+        float gain = 1.0f;
+    };
+
+    using Stage = std::vector<Branch>;
+    std::vector<Stage> stages;
+
+    int getNumPlugins() const;
+
+    /** e.g. "DSP4Guitar -> [Reverb | Delay] -> Limiter" */
+    juce::String describe() const;
+
+    /** The built-in effect chain, offered alongside scanned plugins. */
+    static juce::PluginDescription getInternalDescription();
+};
+
+//==============================================================================
+/**
+ * BranchWorkers
+ *
+ * Real-time worker threads that run the parallel branches of a stage. The
+ * audio thread hands out tasks through an atomic counter, runs tasks itself
+ * too, and spins until every task has finished, so a stage costs as long as
+ * its slowest branch rather than the sum. Workers sleep on an event between
+ * callbacks.
+ */
+class BranchWorkers
+{
+public:
+    using TaskFunction = void (*)(void* context, int taskIndex) noexcept;
+
+    explicit BranchWorkers(int numWorkers);
+    ~BranchWorkers();
+
+    int getNumWorkers() const noexcept { return workers.size(); }
+
+    /** Audio thread. Calls task(context, i) for every i in [0, numTasks) and returns
+        when all have finished. Not reentrant. */
+    void run(TaskFunction task, void* context, int numTasks) noexcept;
+
+private:
+    class Worker;
+    void drain() noexcept;
+
+    static constexpr int closed = 1 << 30;
+
+    juce::OwnedArray<Worker> workers;
+    TaskFunction taskFunction = nullptr;
+    void* taskContext = nullptr;
+    std::atomic<int> numTasks { 0 };
+    std::atomic<int> nextTask { closed };
+    std::atomic<int> finishedTasks { 0 };
+    std::atomic<int> activeWorkers { 0 };
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(BranchWorkers)
+};
+
+//==============================================================================
+/**
+ * HostChain
+ *
+ * One built ChainLayout: the plugin instances plus every buffer the audio
+ * thread needs, allocated in prepare(). Branches shorter in latency than the
+ * longest in their stage are delayed to match it before the sum, so parallel
+ * paths stay phase-aligned; getLatencySamples() is the sum over stages.
+ * Latencies are read when the chain is prepared. Sandboxed plugins are
+ * SandboxedPlugin proxies and are processed like any other.
+ *
+ * create() runs on HostPluginSlot's loader thread, and gives up with a null
+ * chain when that thread is asked to exit; process() runs on the audio thread.
+ */
+class HostChain
+{
+public:
+    static std::unique_ptr<HostChain> create(const ChainLayout& layout,
+                                             juce::AudioPluginFormatManager& formats,
+                                             double sampleRate, int maximumBlockSize,
+                                             juce::String& error);
+
+    /** Audio stopped. Prepares every plugin, at the device layout where it takes one,
+        and (re)allocates buffers and delay lines. */
+    void prepare(double sampleRate, int maximumBlockSize, int numChannels);
+    void release();
+
+    /** Audio thread. block holds at most the prepared block size. */
+    void process(juce::AudioBuffer<float>& block, BranchWorkers& workers) noexcept;
+
+    int getLatencySamples() const noexcept { return latencySamples; }
+
+    /** True if a plugin was created on the message thread and must be deleted there. */
+    bool shouldDeleteOnMessageThread() const noexcept { return createdOnMessageThread; }
+
+    /** Message thread. Stores each plugin's state into the matching layout entry. */
+    void captureStates(ChainLayout& layout) const;
+
+private:
+    struct Branch
+    {
+        std::vector<std::unique_ptr<juce::AudioProcessor>> processors;
+        std::vector<const char*> traceNames; // interned plugin names, one per processor
+        float gain = 1.0f;
+
+        int latency = 0, compensation = 0;
+        juce::AudioBuffer<float> buffer, delay;
+        juce::AudioBuffer<float> scratch; // for plugins wider than the device, see prepare()
+        int delayPosition = 0;
+        juce::MidiBuffer midi;
+
+        void process(juce::AudioBuffer<float>& block) noexcept;
+    };
+
+    struct Stage
+    {
+        std::vector<Branch> branches;
+        juce::AudioBuffer<float>* input = nullptr; // audio thread, for the branch tasks
+        int numSamples = 0;
+    };
+
+    static void processBranchTask(void* stage, int branch) noexcept;
+
+    /** Before prepareToPlay: main buses at the device's channel count, every other bus off. */
+    static void applyDeviceLayout(juce::AudioProcessor& processor, int numChannels);
+
+    std::vector<Stage> stages;
+    int latencySamples = 0;
+    bool createdOnMessageThread = false;
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(HostChain)
+};
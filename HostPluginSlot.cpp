@@ -0,0 +1,274 @@
+#include "HostPluginSlot.h"
+#include "TraceRecorder.h"
+#include <cmath>
+
+//==============================================================================
+HostPluginSlot::HostPluginSlot(juce::AudioPluginFormatManager& formats)
+    : formatManager(formats)
+{
+    loaderThread.addTimeSliceClient(this);
+    loaderThread.startThread();
+}
+
+HostPluginSlot::~HostPluginSlot()
+{
+    // Audio has stopped (the host shuts its device down first). Signalled first, so a
+    // build waiting for this (message) thread to create a plugin gives up at once
+    loaderThread.signalThreadShouldExit();
+    loaderThread.removeTimeSliceClient(this);
+    loaderThread.stopThread(10000);
+    cancelPendingUpdate();
+
+    for (auto* entry : { current, outgoing, pending.exchange(nullptr), retired.exchange(nullptr) })
+        delete entry;
+}
+
+//==============================================================================
+void HostPluginSlot::prepare(double newSampleRate, int maximumBlockSize, int newNumChannels)
+{
+    const juce::ScopedLock sl(loaderLock);
+
+    sampleRate = newSampleRate;
+    maxBlockSize = juce::jmax(1, maximumBlockSize);
+    numChannels = juce::jmax(1, newNumChannels);
+
+    outgoingBuffer.setSize(numChannels, maxBlockSize);
+    gainIn.assign(static_cast<size_t>(maxBlockSize), 0.0f);
+    gainOut.assign(static_cast<size_t>(maxBlockSize), 0.0f);
+    fadeLength = juce::jmax(1, static_cast<int>(crossfadeSeconds * sampleRate));
+
+    // A crossfade cut short by a device change ends here
+    if (fading)
+    {
+        fading = false;
+        dispose(outgoing);
+        outgoing = nullptr;
+    }
+
+    for (auto* entry : { current, pending.load() })
+        if (entry != nullptr && entry->chain != nullptr)
+            prepareChain(*entry->chain);
+}
+
+void HostPluginSlot::release()
+{
+    const juce::ScopedLock sl(loaderLock);
+
+    for (auto* entry : { current, outgoing, pending.load() })
+        if (entry != nullptr && entry->chain != nullptr)
+            entry->chain->release();
+}
+
+void HostPluginSlot::prepareChain(HostChain& chain) const
+{
+    if (sampleRate <= 0.0)
+        return; // Prepared by prepare() once the device starts
+
+    chain.prepare(sampleRate, maxBlockSize, numChannels);
+}
+
+//==============================================================================
+void HostPluginSlot::load(const ChainLayout& layout)
+{
+    const juce::ScopedLock sl(loaderLock);
+    request = std::make_unique<ChainLayout>(layout);
+}
+
+void HostPluginSlot::captureStates(ChainLayout& layout)
+{
+    // published is only disposed under loaderLock once a newer entry replaces it
+    const juce::ScopedLock sl(loaderLock);
+
+    if (published != nullptr && published->chain != nullptr)
+        published->chain->captureStates(layout);
+}
+
+//==============================================================================
+int HostPluginSlot::useTimeSlice()
+{
+    collectGarbage();
+
+    std::unique_ptr<ChainLayout> next;
+    double rate;
+    int blockSize;
+    {
+        const juce::ScopedLock sl(loaderLock);
+        next = std::move(request);
+        rate = sampleRate > 0.0 ? sampleRate : 44100.0;
+        blockSize = maxBlockSize > 0 ? maxBlockSize : 512;
+    }
+
+    if (next == nullptr)
+        return 20;
+
+    auto entry = std::make_unique<Entry>();
+
+    if (next->getNumPlugins() > 0)
+    {
+        DSP4G_TRACE_ZONE("Build host chain");
+        // Formats that need the message thread are created there; this thread waits
+        juce::String error;
+        entry->chain = HostChain::create(*next, formatManager, rate, blockSize, error);
+
+        if (entry->chain == nullptr)
+        {
+            reportResult(error.isNotEmpty() ? error : juce::String("Could not create the chain"), 0);
+            return 0;
+        }
+    }
+
+    int latency = 0;
+    {
+        const juce::ScopedLock sl(loaderLock);
+
+        if (request != nullptr)
+        {
+            // Superseded while loading: never played, so disposed right here
+            dispose(entry.release());
+            return 0;
+        }
+
+        if (entry->chain != nullptr)
+        {
+            prepareChain(*entry->chain); // With the device settings as they are now
+            latency = entry->chain->getLatencySamples();
+        }
+
+        publish(entry.release());
+    }
+
+    reportResult({}, latency);
+    return 0;
+}
+
+void HostPluginSlot::publish(Entry* entry)
+{
+    published = entry;
+    dispose(pending.exchange(entry, std::memory_order_acq_rel));
+}
+
+void HostPluginSlot::collectGarbage()
+{
+    dispose(retired.exchange(nullptr, std::memory_order_acquire));
+}
+
+void HostPluginSlot::dispose(Entry* entry)
+{
+    if (entry == nullptr)
+        return;
+
+    if (entry->chain != nullptr)
+    {
+        entry->chain->release();
+
+        if (entry->chain->shouldDeleteOnMessageThread())
+        {
+            juce::MessageManager::callAsync([entry] { delete entry; });
+            return;
+        }
+    }
+
+    delete entry;
+}
+
+void HostPluginSlot::reportResult(const juce::String& error, int latency)
+{
+    {
+        const juce::ScopedLock sl(resultLock);
+        resultError = error;
+        resultLatency = latency;
+    }
+    triggerAsyncUpdate();
+}
+
+void HostPluginSlot::handleAsyncUpdate()
+{
+    juce::String error;
+    int latency;
+    {
+        const juce::ScopedLock sl(resultLock);
+        error = resultError;
+        latency = resultLatency;
+    }
+
+    if (error.isEmpty())
+        loadedLatency = latency;
+
+    if (onLoaded != nullptr)
+        onLoaded(error);
+}
+
+//==============================================================================
+void HostPluginSlot::process(juce::AudioBuffer<float>& buffer, int startSample, int numSamples) noexcept
+{
+    DSP4G_TRACE_ZONE("HostPluginSlot::process");
+    const auto maxChunk = outgoingBuffer.getNumSamples();
+    if (maxChunk == 0)
+        return;
+
+    for (int done = 0; done < numSamples; done += maxChunk)
+        processChunk(buffer, startSample + done, juce::jmin(maxChunk, numSamples - done));
+}
+
+void HostPluginSlot::processChunk(juce::AudioBuffer<float>& buffer, int startSample, int numSamples) noexcept
+{
+    const auto channels = juce::jmin(buffer.getNumChannels(), outgoingBuffer.getNumChannels());
+    juce::AudioBuffer<float> block(buffer.getArrayOfWritePointers(), channels, startSample, numSamples);
+
+    // Adopt a newly loaded chain once the previous swap has been cleaned up
+    if (! fading && retired.load(std::memory_order_relaxed) == nullptr)
+    {
+        if (auto* next = pending.exchange(nullptr, std::memory_order_acquire))
+        {
+            DSP4G_TRACE_INSTANT("Chain crossfade");
+            outgoing = current;
+            current = next;
+            fading = true;
+            fadePosition = 0;
+        }
+    }
+
+    if (! fading)
+    {
+        run(current, block);
+        return;
+    }
+
+    // Both chains run on the same input; their outputs are equal-power crossfaded
+    juce::AudioBuffer<float> outgoingBlock(outgoingBuffer.getArrayOfWritePointers(), channels, 0, numSamples);
+    for (int ch = 0; ch < channels; ++ch)
+        outgoingBlock.copyFrom(ch, 0, block, ch, 0, numSamples);
+
+    run(current, block);
+    run(outgoing, outgoingBlock);
+
+    for (int i = 0; i < numSamples; ++i)
+    {
+        const auto t = juce::jmin(1.0f, static_cast<float>(fadePosition + i) / static_cast<float>(fadeLength));
+        gainIn[static_cast<size_t>(i)]  = std::sin(t * juce::MathConstants<float>::halfPi);
+        gainOut[static_cast<size_t>(i)] = std::cos(t * juce::MathConstants<float>::halfPi);
+    }
+
+    for (int ch = 0; ch < channels; ++ch)
+    {
+        juce::FloatVectorOperations::multiply(block.getWritePointer(ch), gainIn.data(), numSamples);
+        juce::FloatVectorOperations::addWithMultiply(block.getWritePointer(ch), outgoingBlock.getReadPointer(ch), gainOut.data(), numSamples);
+    }
+
+    fadePosition += numSamples;
+    if (fadePosition >= fadeLength)
+    {
+        // The loader thread releases and deletes it
+        retired.store(outgoing, std::memory_order_release);
+        outgoing = nullptr;
+        fading = false;
+    }
+}
+
+void HostPluginSlot::run(Entry* entry, juce::AudioBuffer<float>& block) noexcept
+{
+    if (entry == nullptr || entry->chain == nullptr)
+        return; // Dry
+
+    entry->chain->process(block, workers);
+}
@@ -0,0 +1,113 @@
+#pragma once
+
+#include <juce_audio_processors/juce_audio_processors.h>
+#include "HostChain.h"
+#include <atomic>
+#include <functional>
+#include <memory>
+#include <vector>
+
+//==============================================================================
+/**
+ * HostPluginSlot
+ *
+ * The standalone host's plugin chain, swappable while audio runs. The message
+ * thread asks for a ChainLayout with load(); a loader thread builds the
+ * HostChain, prepares it and publishes it. The audio thread adopts it at the
+ * start of a block through an atomic pointer swap and equal-power crossfades
+ * from the old chain (or the dry signal) to the new one. The old chain is then
+ * handed back and released and deleted on the loader thread. Every edit builds
+ * a whole new chain, with states captured from the playing one, so adding or
+ * removing a plugin never interrupts the sound.
+ *
+ * Same three-slot handoff as RealtimePublisher:
+ *   pending – loader publishes a prepared chain
+ *   current – audio thread's chain (plus `outgoing` during a crossfade)
+ *   retired – audio hands the previous chain back; the loader deletes it
+ *
+ * The audio thread never allocates, locks or deletes, and only swaps when the
+ * retired slot is empty. Both chains of a crossfade share one BranchWorkers.
+ */
+class HostPluginSlot : private juce::TimeSliceClient,
+                       private juce::AsyncUpdater
+{
+public:
+    explicit HostPluginSlot(juce::AudioPluginFormatManager& formats);
+    ~HostPluginSlot() override;
+
+    //==============================================================================
+    /** Audio stopped. Re-prepares the current chain for the new device settings. */
+    void prepare(double sampleRate, int maximumBlockSize, int numChannels);
+    void release();
+
+    /** Audio thread. Processes numSamples of buffer from startSample in place. */
+    void process(juce::AudioBuffer<float>& buffer, int startSample, int numSamples) noexcept;
+
+    //==============================================================================
+    /** Message thread. Replaces any load that has not started yet. onLoaded gets an
+        empty string on success, else the error, on the message thread. An empty
+        layout plays the dry signal. */
+    void load(const ChainLayout& layout);
+    void unload() { load({}); }
+
+    std::function<void(const juce::String& error)> onLoaded;
+
+    /** Message thread. Copies the newest published chain's plugin states into layout,
+        which should be the layout that chain was loaded from. */
+    void captureStates(ChainLayout& layout);
+
+    /** Message thread: the latency of the chain last loaded, in samples. */
+    int getLatencySamples() const noexcept { return loadedLatency; }
+
+    static constexpr double crossfadeSeconds = 0.02;
+
+private:
+    struct Entry
+    {
+        std::unique_ptr<HostChain> chain; // nullptr: dry
+    };
+
+    int useTimeSlice() override;
+    void handleAsyncUpdate() override;
+
+    void processChunk(juce::AudioBuffer<float>& buffer, int startSample, int numSamples) noexcept;
+    void run(Entry* entry, juce::AudioBuffer<float>& block) noexcept;
+    void prepareChain(HostChain& chain) const;
+    void publish(Entry* entry);
+    void collectGarbage();
+    void dispose(Entry* entry);
+    void reportResult(const juce::String& error, int latency);
+
+    juce::AudioPluginFormatManager& formatManager;
+    juce::TimeSliceThread loaderThread { "Host plugin loader" };
+    BranchWorkers workers { juce::jlimit(0, 3, juce::SystemStats::getNumCpus() - 2) };
+
+    // Loader side: device settings, the newest request and the newest published
+    // entry (for captureStates), guarded by loaderLock
+    juce::CriticalSection loaderLock;
+    double sampleRate = 0.0;
+    int maxBlockSize = 0, numChannels = 2;
+    std::unique_ptr<ChainLayout> request;
+    Entry* published = nullptr;
+
+    // Results for the message thread
+    juce::CriticalSection resultLock;
+    juce::String resultError;
+    int resultLatency = 0;
+
+    int loadedLatency = 0; // message thread
+
+    // Handoff
+    std::atomic<Entry*> pending { nullptr };
+    std::atomic<Entry*> retired { nullptr };
+
+    // Audio thread
+    Entry* current = nullptr;
+    Entry* outgoing = nullptr;
+    bool fading = false;
+    int fadePosition = 0, fadeLength = 1;
+    juce::AudioBuffer<float> outgoingBuffer;
+    std::vector<float> gainIn, gainOut;
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(HostPluginSlot)
+};
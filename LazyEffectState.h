@@ -0,0 +1,224 @@
+#pragma once
+
+#include <juce_core/juce_core.h>
+#include <juce_dsp/juce_dsp.h>
+#include "DSPArena.h"
+#include <atomic>
+#include <memory>
+
+//==============================================================================
+/**
+ * DSPBackgroundThread
+ *
+ * One low-priority worker shared by every plugin instance in the process.
+ * Non-real-time DSP housekeeping (allocating and freeing effect state) runs
+ * here as TimeSliceClients, never on the audio or message thread.
+ */
+class DSPBackgroundThread : public juce::TimeSliceThread
+{
+public:
+    DSPBackgroundThread() : juce::TimeSliceThread("DSP4Guitar background") { startThread(); }
+    ~DSPBackgroundThread() override { stopThread(2000); }
+};
+
+//==============================================================================
+/**
+ * LazyEffectState
+ *
+ * Keeps the large buffers of one effect (TapeDelay, RoomReverb) out of memory
+ * until the effect is switched on, and gives them back after it has been off
+ * for an idle period set per instance (30 s by default: long enough that
+ * toggling an effect during a song never reallocates, short enough that an
+ * unused delay does not hold its memory for the whole session).
+ *
+ * The audio thread owns the processor and the bound arena. The only traffic
+ * between threads is three atomics:
+ *   requested – audio asks for memory (effect on, nothing bound)
+ *   pending   – background publishes a freshly zeroed arena
+ *   retired   – audio hands back an arena it no longer uses
+ *
+ * Offline (setSynchronous(true), for a non-realtime processor) update()
+ * allocates and frees on the calling thread instead, so the effect comes in at
+ * the same sample on every render rather than whenever the background thread
+ * gets to it.
+ *
+ * ProcessorType must provide carveFrom(DSPArena&, const ProcessSpec&),
+ * detach() and startFadeIn().
+ */
+template <typename ProcessorType>
+class LazyEffectState : private juce::TimeSliceClient
+{
+public:
+    static constexpr double defaultIdleReleaseSeconds = 30.0;
+
+    explicit LazyEffectState(const char* reportName) : name(reportName)
+    {
+        backgroundThread->addTimeSliceClient(this);
+    }
+
+    ~LazyEffectState() override
+    {
+        backgroundThread->removeTimeSliceClient(this);
+        freeAll();
+    }
+
+    //==============================================================================
+    /** Call from prepareToPlay (audio stopped). Drops any existing memory and, if the
+        effect is already on, allocates and binds synchronously so playback starts clean. */
+    void prepare(const juce::dsp::ProcessSpec& newSpec, ProcessorType& processor, bool allocateNow)
+    {
+        const juce::ScopedLock sl(lock);
+
+        processor.detach();
+        freeAll();
+
+        spec = newSpec;
+        idleSamples = 0;
+
+        if (allocateNow)
+        {
+            current = createArena().release();
+            residentBytes = current->getCapacity();
+            processor.carveFrom(*current, spec);
+        }
+    }
+
+    /** Any thread: how long the effect must stay off before its memory is freed. */
+    void setIdleReleaseSeconds(double seconds) noexcept { idleReleaseSeconds.store(juce::jmax(0.0, seconds)); }
+    double getIdleReleaseSeconds() const noexcept       { return idleReleaseSeconds.load(); }
+
+    /** Call before prepare (audio stopped): true when blocks are not rendered in real time. */
+    void setSynchronous(bool shouldAllocateInline) noexcept { synchronous = shouldAllocateInline; }
+
+    /** Call from releaseResources (audio stopped). */
+    void release(ProcessorType& processor)
+    {
+        const juce::ScopedLock sl(lock);
+        processor.detach();
+        freeAll();
+    }
+
+    //==============================================================================
+    /** Audio thread, once per block before the chain runs. Binds newly published
+        memory (with a fade-in), requests memory when needed, and retires it once
+        the effect has been idle long enough. Never allocates or locks unless synchronous. */
+    void update(ProcessorType& processor, bool effectOn, int numSamples) noexcept
+    {
+        if (current == nullptr)
+        {
+            if (auto* arena = pending.exchange(nullptr, std::memory_order_acquire))
+            {
+                current = arena;
+                idleSamples = 0;
+                processor.carveFrom(*current, spec);
+                processor.startFadeIn();
+            }
+            else if (effectOn && synchronous)
+            {
+                const juce::ScopedLock sl(lock);
+                current = createArena().release();
+                residentBytes = current->getCapacity();
+                idleSamples = 0;
+                processor.carveFrom(*current, spec);
+                processor.startFadeIn();
+            }
+            else if (effectOn)
+            {
+                requested.store(true, std::memory_order_release);
+            }
+            return;
+        }
+
+        if (effectOn)
+        {
+            idleSamples = 0;
+            return;
+        }
+
+        idleSamples += numSamples;
+        const auto idleLimit = static_cast<juce::int64>(idleReleaseSeconds.load(std::memory_order_relaxed) * spec.sampleRate);
+
+        if (idleSamples >= idleLimit && synchronous)
+        {
+            const juce::ScopedLock sl(lock);
+            processor.detach();
+            delete current;
+            current = nullptr;
+            residentBytes = 0;
+        }
+        else if (idleSamples >= idleLimit && retired.load(std::memory_order_relaxed) == nullptr)
+        {
+            processor.detach();
+            retired.store(current, std::memory_order_release);
+            current = nullptr;
+        }
+    }
+
+    /** True when the processor currently has memory bound (audio thread). */
+    bool isBound() const noexcept { return current != nullptr; }
+
+    /** Bytes currently held for this effect, for memory reports (any thread). */
+    size_t getResidentBytes() const noexcept { return residentBytes.load(); }
+    const char* getName() const noexcept     { return name; }
+
+private:
+    int useTimeSlice() override
+    {
+        const juce::ScopedLock sl(lock);
+
+        if (auto* arena = retired.exchange(nullptr, std::memory_order_acquire))
+        {
+            delete arena;
+            residentBytes = 0;
+        }
+
+        if (requested.exchange(false, std::memory_order_acquire)
+            && pending.load(std::memory_order_relaxed) == nullptr
+            && spec.sampleRate > 0.0)
+        {
+            auto arena = createArena();
+            residentBytes = arena->getCapacity();
+            pending.store(arena.release(), std::memory_order_release);
+        }
+
+        return 20;
+    }
+
+    std::unique_ptr<DSPArena> createArena() const
+    {
+        // Measure with a scratch processor so the real one is never touched off the audio thread
+        auto arena = std::make_unique<DSPArena>();
+        ProcessorType scratch;
+        arena->beginLayout();
+        scratch.carveFrom(*arena, spec);
+        arena->allocate();
+        return arena;
+    }
+
+    void freeAll()
+    {
+        delete current;
+        current = nullptr;
+        delete pending.exchange(nullptr);
+        delete retired.exchange(nullptr);
+        requested = false;
+        residentBytes = 0;
+    }
+
+    const char* name;
+    juce::SharedResourcePointer<DSPBackgroundThread> backgroundThread;
+    juce::CriticalSection lock; // background thread vs prepare/release only
+
+    juce::dsp::ProcessSpec spec {};
+    DSPArena* current = nullptr; // audio thread
+    juce::int64 idleSamples = 0; // audio thread
+    bool synchronous = false;    // set while audio is stopped
+
+    std::atomic<DSPArena*> pending { nullptr };
+    std::atomic<DSPArena*> retired { nullptr };
+    std::atomic<bool> requested { false };
+    std::atomic<size_t> residentBytes { 0 };
+    std::atomic<double> idleReleaseSeconds { defaultIdleReleaseSeconds };
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(LazyEffectState)
+};
@@ -0,0 +1,396 @@
+#include "LowLatencyMode.h"
+#include <cerrno>
+#include <cmath>
+#include <cstdlib>
+#include <cstring>
+
+#if JUCE_LINUX
+ #include <malloc.h>
+ #include <pthread.h>
+ #include <sched.h>
+ #include <sys/mman.h>
+ #include <sys/resource.h>
+ #include <unistd.h>
+#endif
+
+namespace
+{
+    constexpr int pageBytes = 4096;
+    constexpr int stackPrefaultBytes = 128 * 1024;
+
+    // Published by apply() for the real-time threads; read after an acquire of generation
+    struct ThreadPolicy
+    {
+        std::atomic<juce::uint32> generation { 0 };
+        std::atomic<int> priority[2] {};
+        std::atomic<juce::uint64> cores[2] {}; // bit n: CPU n; 0 leaves affinity alone
+    };
+
+    // Written by the threads themselves, read by getReport()
+    struct ThreadResults
+    {
+        std::atomic<int> promoted { 0 }, promoteFailed { 0 }, lastError { 0 };
+        std::atomic<int> pinned { 0 }, pinFailed { 0 };
+    };
+
+    ThreadPolicy threadPolicy;
+    ThreadResults threadResults[2];
+
+    juce::Array<int> parseCores(const juce::String& text)
+    {
+        juce::Array<int> cores;
+        for (const auto& token : juce::StringArray::fromTokens(text, ",", {}))
+            if (token.trim().containsOnly("0123456789"))
+                cores.addIfNotAlreadyThere(token.trim().getIntValue());
+        return cores;
+    }
+
+    juce::uint64 toMask(const juce::Array<int>& cores)
+    {
+        juce::uint64 mask = 0;
+        for (auto core : cores)
+            if (core >= 0 && core < 64)
+                mask |= juce::uint64(1) << core;
+        return mask;
+    }
+
+    juce::String describeCores(const juce::Array<int>& cores)
+    {
+        juce::StringArray names;
+        for (auto core : cores)
+            names.add(juce::String(core));
+        return names.joinIntoString(",");
+    }
+
+    // Touches the pages below the current frame so the first deep call in a
+    // callback does not fault them in
+    JUCE_NO_INLINE void prefaultStack() noexcept
+    {
+        volatile unsigned char stack[stackPrefaultBytes];
+        for (int i = 0; i < stackPrefaultBytes; i += pageBytes)
+            stack[i] = 0;
+    }
+}
+
+//==============================================================================
+LowLatencyMode::Options LowLatencyMode::Options::fromCommandLine(const juce::String& commandLine)
+{
+    Options result;
+
+    for (const auto& argument : juce::StringArray::fromTokens(commandLine, true))
+    {
+        const auto key = argument.upToFirstOccurrenceOf("=", false, false);
+        const auto value = argument.fromFirstOccurrenceOf("=", false, false).unquoted();
+
+        if (key == "--low-latency")       result.enabled = true;
+        else if (key == "--device")       result.deviceTypes = { value.toUpperCase() };
+        else if (key == "--rate")         result.sampleRate = value.getDoubleValue();
+        else if (key == "--period")       result.periodSize = value.getIntValue();
+        else if (key == "--rt-priority")  result.realtimePriority = juce::jlimit(2, 99, value.getIntValue());
+        else if (key == "--audio-cpus")   result.audioCores = parseCores(value);
+        else if (key == "--worker-cpus")  result.workerCores = parseCores(value);
+        else if (key == "--prefault-mb")  result.prefaultMegabytes = juce::jmax(0, value.getIntValue());
+        else if (key == "--no-mlock")     result.lockMemory = false;
+    }
+
+    return result;
+}
+
+//==============================================================================
+void LowLatencyMode::apply(juce::AudioDeviceManager& deviceManager, const Options& newOptions)
+{
+    options = newOptions;
+    steps.clear();
+
+    if (! options.enabled)
+        return;
+
+    applyDevice(deviceManager);
+    lockMemory();
+    prefaultHeap();
+
+    // Picked up by each real-time thread at its next callback
+    threadPolicy.priority[static_cast<int>(ThreadRole::audio)].store(options.realtimePriority, std::memory_order_relaxed);
+    threadPolicy.priority[static_cast<int>(ThreadRole::worker)].store(options.realtimePriority - 1, std::memory_order_relaxed);
+    threadPolicy.cores[static_cast<int>(ThreadRole::audio)].store(toMask(options.audioCores), std::memory_order_relaxed);
+    threadPolicy.cores[static_cast<int>(ThreadRole::worker)].store(toMask(options.workerCores), std::memory_order_relaxed);
+
+    for (auto& results : threadResults)
+        for (auto* counter : { &results.promoted, &results.promoteFailed, &results.lastError, &results.pinned, &results.pinFailed })
+            counter->store(0, std::memory_order_relaxed);
+
+    threadPolicy.generation.fetch_add(1, std::memory_order_release);
+
+    juce::Logger::writeToLog("Low-latency mode:\n" + getReport());
+}
+
+void LowLatencyMode::addStep(const juce::String& name, bool succeeded, const juce::String& detail)
+{
+    steps.add({ name, succeeded, detail });
+}
+
+void LowLatencyMode::applyDevice(juce::AudioDeviceManager& deviceManager)
+{
+    juce::String chosenType;
+    for (const auto& type : options.deviceTypes)
+    {
+        deviceManager.setCurrentAudioDeviceType(type, true);
+        if (deviceManager.getCurrentAudioDeviceType().equalsIgnoreCase(type)
+            && deviceManager.getCurrentAudioDevice() != nullptr)
+        {
+            chosenType = deviceManager.getCurrentAudioDeviceType();
+            break;
+        }
+    }
+
+    addStep("Device type", chosenType.isNotEmpty(),
+            chosenType.isNotEmpty() ? chosenType
+                                    : "none of " + options.deviceTypes.joinIntoString("/") + " available, using "
+                                      + deviceManager.getCurrentAudioDeviceType());
+
+    auto* device = deviceManager.getCurrentAudioDevice();
+    if (device == nullptr)
+    {
+        addStep("Period", false, "no audio device open");
+        return;
+    }
+
+    // Nearest rate the device has; smallest period at least as long as requested
+    auto setup = deviceManager.getAudioDeviceSetup();
+    const auto rates = device->getAvailableSampleRates();
+    setup.sampleRate = rates.isEmpty() ? options.sampleRate : rates.getFirst();
+    for (auto rate : rates)
+        if (std::abs(rate - options.sampleRate) < std::abs(setup.sampleRate - options.sampleRate))
+            setup.sampleRate = rate;
+
+    const auto sizes = device->getAvailableBufferSizes();
+    setup.bufferSize = sizes.isEmpty() ? options.periodSize : sizes.getLast();
+    for (auto size : sizes)
+    {
+        if (size >= options.periodSize)
+        {
+            setup.bufferSize = size;
+            break;
+        }
+    }
+
+    const auto error = deviceManager.setAudioDeviceSetup(setup, true);
+    device = deviceManager.getCurrentAudioDevice();
+
+    if (device == nullptr)
+    {
+        addStep("Period", false, error.isNotEmpty() ? error : juce::String("device closed"));
+        return;
+    }
+
+    const auto rate = device->getCurrentSampleRate();
+    const auto period = device->getCurrentBufferSizeSamples();
+    const auto succeeded = error.isEmpty() && period == options.periodSize && rate == options.sampleRate;
+
+    auto detail = "requested " + juce::String(options.periodSize) + " @ " + juce::String(options.sampleRate, 0)
+                + " Hz, running " + juce::String(period) + " @ " + juce::String(rate, 0) + " Hz ("
+                + juce::String(1000.0 * period / juce::jmax(1.0, rate), 2) + " ms, output latency "
+                + juce::String(device->getOutputLatencyInSamples()) + " samples)";
+
+    if (error.isNotEmpty())
+        detail << ": " << error;
+    else if (chosenType == "JACK" && period != options.periodSize)
+        detail << "; JACK's period is set by the server (jackd -p)";
+
+    addStep("Period", succeeded, detail);
+}
+
+void LowLatencyMode::lockMemory()
+{
+   #if JUCE_LINUX
+    // Freed memory stays in the heap instead of going back to the kernel, and large
+    // blocks come from the heap rather than fresh mmaps. Also without mlock: the
+    // heap pre-fault relies on it to keep its pages resident
+    heapRetained = mallopt(M_TRIM_THRESHOLD, -1) != 0 && mallopt(M_MMAP_MAX, 0) != 0;
+
+    if (! options.lockMemory)
+    {
+        addStep("mlockall", false, "disabled by --no-mlock");
+        return;
+    }
+
+    if (mlockall(MCL_CURRENT | MCL_FUTURE) == 0)
+    {
+        addStep("mlockall", true, "current and future pages locked");
+        return;
+    }
+
+    const auto error = errno;
+    juce::String detail(std::strerror(error));
+
+    rlimit limit {};
+    if (getrlimit(RLIMIT_MEMLOCK, &limit) == 0 && limit.rlim_cur != RLIM_INFINITY)
+        detail << "; RLIMIT_MEMLOCK is " << juce::String(static_cast<juce::int64>(limit.rlim_cur / 1024))
+               << " KiB (raise memlock in /etc/security/limits.conf)";
+
+    addStep("mlockall", false, detail);
+   #else
+    addStep("mlockall", false, "not supported on this platform");
+   #endif
+}
+
+void LowLatencyMode::prefaultHeap()
+{
+    const auto bytes = static_cast<size_t>(options.prefaultMegabytes) * 1024 * 1024;
+    if (bytes == 0)
+    {
+        addStep("Heap pre-fault", true, "skipped (--prefault-mb=0)");
+        return;
+    }
+
+   #if JUCE_LINUX
+    if (! heapRetained)
+    {
+        addStep("Heap pre-fault", false, "mallopt failed, so freed pages would go back to the kernel");
+        return;
+    }
+
+    // Touched once, then freed back into the heap: later DSP allocations (prepareToPlay,
+    // chain rebuilds) reuse pages that are already resident
+    auto* reserve = static_cast<unsigned char*>(std::malloc(bytes));
+    if (reserve == nullptr)
+    {
+        addStep("Heap pre-fault", false, "could not allocate " + juce::String(options.prefaultMegabytes) + " MiB");
+        return;
+    }
+
+    for (size_t i = 0; i < bytes; i += pageBytes)
+        reserve[i] = 0;
+
+    std::free(reserve);
+
+    const auto locked = steps.getLast().name == "mlockall" && steps.getLast().succeeded;
+    addStep("Heap pre-fault", true,
+            juce::String(options.prefaultMegabytes) + " MiB resident" + (locked ? " and locked" : ", not locked"));
+   #else
+    addStep("Heap pre-fault", false, "not supported on this platform");
+   #endif
+}
+
+//==============================================================================
+void LowLatencyMode::applyThreadPolicy(ThreadRole role, juce::uint32& generation) noexcept
+{
+    const auto latest = threadPolicy.generation.load(std::memory_order_acquire);
+    if (latest == generation)
+        return;
+
+    generation = latest;
+
+   #if JUCE_LINUX
+    const auto index = static_cast<int>(role);
+    auto& results = threadResults[index];
+
+    prefaultStack();
+
+    sched_param parameters {};
+    parameters.sched_priority = threadPolicy.priority[index].load(std::memory_order_relaxed);
+    if (const auto error = pthread_setschedparam(pthread_self(), SCHED_FIFO, &parameters))
+    {
+        results.lastError.store(error, std::memory_order_relaxed);
+        results.promoteFailed.fetch_add(1, std::memory_order_release);
+    }
+    else
+    {
+        results.promoted.fetch_add(1, std::memory_order_release);
+    }
+
+    if (const auto mask = threadPolicy.cores[index].load(std::memory_order_relaxed))
+    {
+        cpu_set_t cores;
+        CPU_ZERO(&cores);
+        for (int core = 0; core < 64; ++core)
+            if ((mask >> core) & 1)
+                CPU_SET(core, &cores);
+
+        if (pthread_setaffinity_np(pthread_self(), sizeof(cores), &cores) == 0)
+            results.pinned.fetch_add(1, std::memory_order_release);
+        else
+            results.pinFailed.fetch_add(1, std::memory_order_release);
+    }
+   #else
+    juce::ignoreUnused(role);
+   #endif
+}
+
+bool LowLatencyMode::pinCurrentThread(int core) noexcept
+{
+   #if JUCE_LINUX
+    if (core < 0 || core >= CPU_SETSIZE)
+        return false;
+
+    cpu_set_t cores;
+    CPU_ZERO(&cores);
+    CPU_SET(core, &cores);
+    return pthread_setaffinity_np(pthread_self(), sizeof(cores), &cores) == 0;
+   #else
+    juce::ignoreUnused(core);
+    return false;
+   #endif
+}
+
+int LowLatencyMode::getCurrentCore() noexcept
+{
+   #if JUCE_LINUX
+    return sched_getcpu();
+   #else
+    return -1;
+   #endif
+}
+
+//==============================================================================
+juce::String LowLatencyMode::getReport() const
+{
+    if (! options.enabled)
+        return "Low-latency mode is off (start with --low-latency)";
+
+    juce::StringArray lines;
+    for (const auto& step : steps)
+        lines.add(juce::String(step.succeeded ? "[ OK ] " : "[FAIL] ") + step.name + ": " + step.detail);
+
+   #if JUCE_LINUX
+    const auto describeThreads = [this, &lines](ThreadRole role, const juce::String& name, const juce::Array<int>& cores)
+    {
+        const auto& results = threadResults[static_cast<int>(role)];
+        const auto promoted = results.promoted.load(std::memory_order_acquire);
+        const auto failed = results.promoteFailed.load(std::memory_order_acquire);
+        const auto priority = options.realtimePriority - (role == ThreadRole::worker ? 1 : 0);
+
+        if (promoted + failed == 0)
+        {
+            lines.add("[ -- ] " + name + " SCHED_FIFO: not run yet");
+            return;
+        }
+
+        auto detail = juce::String(promoted) + " of " + juce::String(promoted + failed) + " at priority " + juce::String(priority);
+        if (failed > 0)
+            detail << "; " << std::strerror(results.lastError.load(std::memory_order_relaxed))
+                   << " (needs rtprio in /etc/security/limits.conf or CAP_SYS_NICE)";
+        lines.add(juce::String(failed == 0 ? "[ OK ] " : "[FAIL] ") + name + " SCHED_FIFO: " + detail);
+
+        if (cores.isEmpty())
+            return;
+
+        const auto pinned = results.pinned.load(std::memory_order_acquire);
+        const auto pinFailed = results.pinFailed.load(std::memory_order_acquire);
+        lines.add(juce::String(pinFailed == 0 ? "[ OK ] " : "[FAIL] ") + name + " pinned to CPU " + describeCores(cores)
+                  + ": " + juce::String(pinned) + " of " + juce::String(pinned + pinFailed));
+    };
+
+    describeThreads(ThreadRole::audio, "Audio thread", options.audioCores);
+    describeThreads(ThreadRole::worker, "Branch workers", options.workerCores);
+   #else
+    lines.add("[FAIL] SCHED_FIFO / CPU pinning: not supported on this platform");
+   #endif
+
+    return lines.joinIntoString("\n");
+}
+
+bool LowLatencyMode::allSucceeded() const
+{
+    return ! getReport().contains("[FAIL]");
+}
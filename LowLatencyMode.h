@@ -0,0 +1,93 @@
+#pragma once
+
+#include <juce_audio_devices/juce_audio_devices.h>
+#include <atomic>
+
+//==============================================================================
+/**
+ * LowLatencyMode
+ *
+ * Opt-in runtime setup for the standalone host on Linux stage machines, in
+ * place of external tuning scripts:
+ *   - JACK, else ALSA, with the requested sample rate and period size
+ *     negotiated against what the device offers
+ *   - mlockall() so the process is never paged out, with the heap kept from
+ *     shrinking back to the kernel
+ *   - DSP memory pre-faulted: a heap reserve and each real-time thread's stack
+ *   - SCHED_FIFO and optional CPU pinning for the audio thread and the
+ *     host's branch workers
+ *
+ * Every step is recorded with whether it worked and why not, so a machine can
+ * be checked without rebooting into a different kernel. Thread steps run on
+ * the threads themselves: they call applyThreadPolicy() once per callback,
+ * which costs one atomic load unless the policy has changed, and the results
+ * show up in getReport() afterwards.
+ *
+ * On other platforms only the device step runs; the others report as
+ * unsupported.
+ */
+class LowLatencyMode
+{
+public:
+    struct Options
+    {
+        bool enabled = false;
+        juce::StringArray deviceTypes { "JACK", "ALSA" }; // in order of preference
+        double sampleRate = 48000.0;
+        int periodSize = 64;
+        int realtimePriority = 70;   // SCHED_FIFO, 1-99; workers run one below
+        bool lockMemory = true;
+        juce::Array<int> audioCores; // empty: not pinned
+        juce::Array<int> workerCores;
+        int prefaultMegabytes = 64;
+
+        /** --low-latency [--device=jack|alsa] [--rate=48000] [--period=64] [--rt-priority=70]
+            [--audio-cpus=2] [--worker-cpus=3,4] [--prefault-mb=64] [--no-mlock] */
+        static Options fromCommandLine(const juce::String& commandLine);
+    };
+
+    enum class ThreadRole { audio, worker };
+
+    LowLatencyMode() = default;
+
+    /** Message thread, after the device manager has been initialised. Sets up the
+        device and the process, and publishes the thread policy. */
+    void apply(juce::AudioDeviceManager& deviceManager, const Options& options);
+
+    /** Real-time threads, at the start of each callback. generation is the calling
+        thread's own counter, starting at 0. */
+    static void applyThreadPolicy(ThreadRole role, juce::uint32& generation) noexcept;
+
+    /** Narrows the calling thread to one core, within its role's cores (Linux only).
+        The rig server spreads its workers one per core this way. */
+    static bool pinCurrentThread(int core) noexcept;
+
+    /** The core the calling thread is running on, or -1 where unknown. */
+    static int getCurrentCore() noexcept;
+
+    /** One line per step: "[ OK ] ..." or "[FAIL] ...". Thread steps appear once the
+        threads have run. */
+    juce::String getReport() const;
+
+    /** True once every step that was attempted so far succeeded. */
+    bool allSucceeded() const;
+
+    bool isEnabled() const noexcept { return options.enabled; }
+
+private:
+    struct Step
+    {
+        juce::String name;
+        bool succeeded = false;
+        juce::String detail;
+    };
+
+    void addStep(const juce::String& name, bool succeeded, const juce::String& detail);
+    void applyDevice(juce::AudioDeviceManager& deviceManager);
+    void lockMemory();
+    void prefaultHeap();
+
+    Options options;
+    juce::Array<Step> steps;
+    bool heapRetained = false; // mallopt keeps freed memory in the heap (set by lockMemory)
+};
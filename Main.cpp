@@ -0,0 +1,3 @@
+#include "DSP4GuitarApp.h"
+
+START_JUCE_APPLICATION(DSP4GuitarApplication)
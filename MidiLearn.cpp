@@ -0,0 +1,286 @@
+#include "MidiLearn.h"
+#include <algorithm>
+#include <cmath>
+
+const juce::Identifier MidiLearn::stateType { "MidiMappings" };
+
+namespace
+{
+    // Steepness of the exponential/logarithmic tapers (about 35 dB of curvature)
+    constexpr float taperAmount = 4.0f;
+
+    float applyCurve(MidiLearn::Curve curve, float x)
+    {
+        switch (curve)
+        {
+            case MidiLearn::Curve::Exponential: return (std::exp(taperAmount * x) - 1.0f) / (std::exp(taperAmount) - 1.0f);
+            case MidiLearn::Curve::Logarithmic: return std::log1p((std::exp(taperAmount) - 1.0f) * x) / taperAmount;
+            case MidiLearn::Curve::SCurve:      return x * x * (3.0f - 2.0f * x);
+            case MidiLearn::Curve::Linear:      break;
+        }
+        return x;
+    }
+
+    int packEvent(MidiLearn::Source source, int number, int channel)
+    {
+        return (static_cast<int>(source) << 16) | (channel << 8) | number;
+    }
+}
+
+MidiLearn::MidiLearn(juce::AudioProcessor& processor)
+{
+    // Same indexing as PresetManager and ParameterSnapshot
+    for (auto* p : processor.getParameters())
+    {
+        if (auto* ranged = dynamic_cast<juce::RangedAudioParameter*>(p))
+        {
+            parameters.add(ranged);
+            parameterIDs.add(ranged->getParameterID());
+        }
+    }
+}
+
+//==============================================================================
+std::vector<MidiLearn::Mapping> MidiLearn::getMappings() const
+{
+    const juce::ScopedLock sl(modelLock);
+    return mappings;
+}
+
+std::optional<MidiLearn::Mapping> MidiLearn::getMapping(int parameterIndex) const
+{
+    const juce::ScopedLock sl(modelLock);
+
+    for (const auto& mapping : mappings)
+        if (mapping.parameterIndex == parameterIndex)
+            return mapping;
+
+    return std::nullopt;
+}
+
+void MidiLearn::setMapping(const Mapping& mapping)
+{
+    if (! juce::isPositiveAndBelow(mapping.parameterIndex, parameters.size()))
+        return;
+
+    const juce::ScopedLock sl(modelLock);
+
+    auto existing = std::find_if(mappings.begin(), mappings.end(),
+                                 [&](const Mapping& m) { return m.parameterIndex == mapping.parameterIndex; });
+    if (existing != mappings.end())
+        *existing = mapping;
+    else
+        mappings.push_back(mapping);
+
+    publish();
+}
+
+void MidiLearn::setCurve(int parameterIndex, Curve curve)
+{
+    if (auto mapping = getMapping(parameterIndex))
+    {
+        mapping->curve = curve;
+        setMapping(*mapping);
+    }
+}
+
+void MidiLearn::removeMapping(int parameterIndex)
+{
+    const juce::ScopedLock sl(modelLock);
+    mappings.erase(std::remove_if(mappings.begin(), mappings.end(),
+                                  [=](const Mapping& m) { return m.parameterIndex == parameterIndex; }),
+                   mappings.end());
+    publish();
+}
+
+void MidiLearn::clear()
+{
+    const juce::ScopedLock sl(modelLock);
+    mappings.clear();
+    publish();
+}
+
+void MidiLearn::publish()
+{
+    auto table = std::make_unique<Table>();
+    table->entries.reserve(mappings.size());
+
+    for (const auto& mapping : mappings)
+    {
+        auto* parameter = parameters[mapping.parameterIndex];
+
+        Table::Entry entry;
+        entry.source = mapping.source;
+        entry.number = mapping.number;
+        entry.channel = mapping.channel;
+        entry.parameterIndex = static_cast<size_t>(mapping.parameterIndex);
+        entry.isSwitch = dynamic_cast<juce::AudioParameterBool*>(parameter) != nullptr;
+
+        for (int i = 0; i <= Table::lutSize; ++i)
+        {
+            const auto shaped = applyCurve(mapping.curve, static_cast<float>(i) / static_cast<float>(Table::lutSize));
+            const auto normalised = mapping.rangeStart + (mapping.rangeEnd - mapping.rangeStart) * shaped;
+            entry.lut[static_cast<size_t>(i)] = parameter->convertFrom0to1(juce::jlimit(0.0f, 1.0f, normalised));
+        }
+
+        table->entries.push_back(entry);
+    }
+
+    tables.publish(std::move(table));
+}
+
+//==============================================================================
+void MidiLearn::startLearning(int parameterIndex)
+{
+    learnedEvent = -1;
+    learningParameter = parameterIndex;
+}
+
+void MidiLearn::cancelLearning()
+{
+    learningParameter = -1;
+    learnedEvent = -1;
+}
+
+bool MidiLearn::pollLearnedMapping()
+{
+    const auto packed = learnedEvent.exchange(-1);
+    if (packed < 0)
+        return false;
+
+    const auto parameterIndex = learningParameter.exchange(-1);
+    if (parameterIndex < 0)
+        return false;
+
+    // Relearning keeps the curve and range the parameter already had
+    auto mapping = getMapping(parameterIndex).value_or(Mapping {});
+    mapping.source = static_cast<Source>(packed >> 16);
+    mapping.channel = (packed >> 8) & 0xff;
+    mapping.number = packed & 0xff;
+    mapping.parameterIndex = parameterIndex;
+
+    setMapping(mapping);
+    return true;
+}
+
+void MidiLearn::offer(Source source, int number, int channel) noexcept
+{
+    if (learningParameter.load(std::memory_order_relaxed) < 0)
+        return;
+
+    auto expected = -1;
+    learnedEvent.compare_exchange_strong(expected, packEvent(source, number, channel));
+}
+
+bool MidiLearn::decode(const juce::MidiMessage& message, Source& source, int& number, float& position) noexcept
+{
+    if (message.isController())
+    {
+        number = message.getControllerNumber();
+        if (number == 0 || number == 32 || number >= 120)
+            return false;
+
+        source = Source::Controller;
+        position = static_cast<float>(message.getControllerValue()) / 127.0f;
+        return true;
+    }
+
+    number = 0;
+
+    if (message.isPitchWheel())
+    {
+        source = Source::PitchBend;
+        position = static_cast<float>(message.getPitchWheelValue()) / 16383.0f;
+        return true;
+    }
+
+    if (message.isChannelPressure() || message.isAftertouch())
+    {
+        source = Source::Aftertouch;
+        position = static_cast<float>(message.isChannelPressure() ? message.getChannelPressureValue()
+                                                                  : message.getAfterTouchValue()) / 127.0f;
+        return true;
+    }
+
+    return false;
+}
+
+//==============================================================================
+juce::String MidiLearn::getParameterName(int parameterIndex) const
+{
+    if (auto* parameter = parameters[parameterIndex])
+        return parameter->getName(64);
+
+    return {};
+}
+
+juce::String MidiLearn::getCurveName(Curve curve)
+{
+    switch (curve)
+    {
+        case Curve::Exponential: return "Exponential";
+        case Curve::Logarithmic: return "Logarithmic";
+        case Curve::SCurve:      return "S-Curve";
+        case Curve::Linear:      break;
+    }
+    return "Linear";
+}
+
+juce::String MidiLearn::describe(const Mapping& mapping)
+{
+    juce::String text;
+
+    switch (mapping.source)
+    {
+        case Source::Controller: text = "CC " + juce::String(mapping.number); break;
+        case Source::PitchBend:  text = "Pitch Bend"; break;
+        case Source::Aftertouch: text = "Aftertouch"; break;
+    }
+
+    return text + (mapping.channel > 0 ? " / Ch " + juce::String(mapping.channel) : juce::String(" / Omni"));
+}
+
+juce::ValueTree MidiLearn::createState() const
+{
+    const juce::ScopedLock sl(modelLock);
+    juce::ValueTree state(stateType);
+
+    for (const auto& mapping : mappings)
+    {
+        juce::ValueTree child("Mapping");
+        child.setProperty("parameter", parameterIDs[mapping.parameterIndex], nullptr);
+        child.setProperty("source", static_cast<int>(mapping.source), nullptr);
+        child.setProperty("number", mapping.number, nullptr);
+        child.setProperty("channel", mapping.channel, nullptr);
+        child.setProperty("curve", static_cast<int>(mapping.curve), nullptr);
+        child.setProperty("start", mapping.rangeStart, nullptr);
+        child.setProperty("end", mapping.rangeEnd, nullptr);
+        state.appendChild(child, nullptr);
+    }
+
+    return state;
+}
+
+void MidiLearn::restoreState(const juce::ValueTree& state)
+{
+    const juce::ScopedLock sl(modelLock);
+    mappings.clear();
+
+    for (const auto& child : state)
+    {
+        Mapping mapping;
+        mapping.parameterIndex = parameterIDs.indexOf(child["parameter"].toString());
+        if (mapping.parameterIndex < 0)
+            continue; // Parameter no longer exists
+
+        mapping.source = static_cast<Source>(juce::jlimit(0, 2, static_cast<int>(child["source"])));
+        mapping.number = juce::jlimit(0, 127, static_cast<int>(child["number"]));
+        mapping.channel = juce::jlimit(0, 16, static_cast<int>(child["channel"]));
+        mapping.curve = static_cast<Curve>(juce::jlimit(0, 3, static_cast<int>(child["curve"])));
+        mapping.rangeStart = static_cast<float>(child.getProperty("start", 0.0f));
+        mapping.rangeEnd = static_cast<float>(child.getProperty("end", 1.0f));
+        mappings.push_back(mapping);
+    }
+
+    publish();
+}
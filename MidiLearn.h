@@ -0,0 +1,139 @@
+#pragma once
+
+#include <juce_audio_processors/juce_audio_processors.h>
+#include "RealtimePublisher.h"
+#include <array>
+#include <atomic>
+#include <optional>
+#include <vector>
+
+//==============================================================================
+/**
+ * MidiLearn
+ *
+ * Maps MIDI controllers (CC, pitch bend, channel/poly aftertouch) onto any
+ * parameter, addressed by index in createParameterLayout() order. One mapping
+ * per parameter; one controller may drive several parameters.
+ *
+ * The editable mapping list lives on the message thread. Every edit rebuilds
+ * an immutable Table in which each mapping carries a lookup table from
+ * controller position to plain parameter value (curve and range baked in), and
+ * publishes it through a RealtimePublisher. The audio thread only ever reads
+ * a Table.
+ *
+ * Learn: startLearning(index) arms a parameter; the audio thread reports the
+ * next controller it sees through offer(), and pollLearnedMapping() (message
+ * thread, e.g. from the editor's timer) turns it into a mapping.
+ */
+class MidiLearn
+{
+public:
+    enum class Source { Controller, PitchBend, Aftertouch };
+    enum class Curve { Linear, Exponential, Logarithmic, SCurve };
+
+    struct Mapping
+    {
+        Source source = Source::Controller;
+        int number = 0;          // CC number; ignored for pitch bend and aftertouch
+        int channel = 0;         // 1-16, 0 = any channel
+        int parameterIndex = -1;
+        Curve curve = Curve::Linear;
+        float rangeStart = 0.0f; // Normalised parameter value at controller minimum
+        float rangeEnd = 1.0f;   // ... and maximum (start > end inverts the controller)
+    };
+
+    /** Audio-thread view of the mappings. */
+    struct Table
+    {
+        static constexpr int lutSize = 256;
+
+        struct Entry
+        {
+            Source source = Source::Controller;
+            int number = 0;
+            int channel = 0;
+            size_t parameterIndex = 0;
+            bool isSwitch = false; // On/off parameters jump instead of ramping
+            std::array<float, lutSize + 1> lut {};
+
+            bool matches(Source s, int n, int ch) const noexcept
+            {
+                return source == s && (source != Source::Controller || number == n)
+                       && (channel == 0 || channel == ch);
+            }
+
+            /** Controller position 0..1 to plain parameter value. */
+            float lookup(float position) const noexcept
+            {
+                const auto x = juce::jlimit(0.0f, 1.0f, position) * static_cast<float>(lutSize);
+                const auto i = juce::jmin(static_cast<int>(x), lutSize - 1);
+                const auto frac = x - static_cast<float>(i);
+                const auto value = lut[static_cast<size_t>(i)] + frac * (lut[static_cast<size_t>(i) + 1] - lut[static_cast<size_t>(i)]);
+                return isSwitch ? (value >= 0.5f ? 1.0f : 0.0f) : value;
+            }
+        };
+
+        std::vector<Entry> entries;
+    };
+
+    explicit MidiLearn(juce::AudioProcessor& processor);
+
+    //==============================================================================
+    // Message thread
+
+    std::vector<Mapping> getMappings() const;
+    std::optional<Mapping> getMapping(int parameterIndex) const;
+
+    /** Adds the mapping, replacing any existing mapping of the same parameter. */
+    void setMapping(const Mapping& mapping);
+    void setCurve(int parameterIndex, Curve curve);
+    void removeMapping(int parameterIndex);
+    void clear();
+
+    void startLearning(int parameterIndex);
+    void cancelLearning();
+    int getLearningParameter() const noexcept { return learningParameter.load(); }
+
+    /** Turns the controller caught while learning into a mapping. True if one was added. */
+    bool pollLearnedMapping();
+
+    int getParameterIndex(const juce::String& parameterID) const { return parameterIDs.indexOf(parameterID); }
+    juce::String getParameterName(int parameterIndex) const;
+
+    /** Mappings by parameter ID, for the plugin state. */
+    juce::ValueTree createState() const;
+    void restoreState(const juce::ValueTree& state);
+
+    static const juce::Identifier stateType;
+
+    static juce::String getCurveName(Curve curve);
+    static juce::String describe(const Mapping& mapping);
+
+    //==============================================================================
+    // Audio thread
+
+    /** Newest published table, or nullptr before the first mapping. */
+    const Table* acquireTable() noexcept { return tables.acquire(); }
+
+    /** Reports a controller to learn mode; cheap when nothing is being learned. */
+    void offer(Source source, int number, int channel) noexcept;
+
+    /** Classifies a message as a mappable controller with its position 0..1. Bank
+        Select and the channel-mode controllers (120-127) are not mappable. */
+    static bool decode(const juce::MidiMessage& message, Source& source, int& number, float& position) noexcept;
+
+private:
+    void publish(); // Call with modelLock held
+
+    juce::Array<juce::RangedAudioParameter*> parameters;
+    juce::StringArray parameterIDs;
+
+    juce::CriticalSection modelLock; // Editor vs setStateInformation
+    std::vector<Mapping> mappings;
+    RealtimePublisher<Table> tables;
+
+    std::atomic<int> learningParameter { -1 };
+    std::atomic<int> learnedEvent { -1 }; // source << 16 | channel << 8 | number
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(MidiLearn)
+};
@@ -1,76 +1,231 @@
 #include "MultiEffectProcessor.h"
-#include "PluginEditor.h"
+#include <cstring>
+
+//==============================================================================
+const char* const ParameterSnapshot::ids[ParameterSnapshot::NumParameters] =
+{
+    "bitcrusherOn", "bitcrusherDepth", "bitcrusherRate",
+    "ringModOn", "ringModRate", "ringModDepth",
+    "phaserOn", "phaserRate", "phaserDepth", "phaserFeedback", "phaserMix",
+    "chorusOn", "chorusRate", "chorusDepth", "chorusMix",
+    "tremoloOn", "tremoloRate", "tremoloDepth",
+    "delayOn", "delayTime", "delayFeedback", "delayMix",
+    "reverbOn", "reverbRoomSize", "reverbDamping", "reverbWetLevel", "reverbDryLevel", "reverbWidth",
+    "compressorOn", "compressorLowThresh", "compressorMidThresh", "compressorHighThresh", "compressorRatio", "compressorAttack", "compressorRelease", "compressorMakeup",
+    "wahOn", "wahRate", "wahDepth", "wahFreq", "wahResonance", "wahMix",
+    "fuzzOn", "fuzzDrive", "fuzzTone", "fuzzLevel", "fuzzMix",
+};
+
+//==============================================================================
+void EffectEngine::prepare(const juce::dsp::ProcessSpec& newSpec, const Snapshot& params)
+{
+    spec = newSpec;
+    current = params;
+
+    // Size one block for the whole chain, then hand out the slices.
+    // Nothing in the chain allocates after this point.
+    arena.beginLayout();
+    carveChain(spec);
+    arena.allocate();
+    carveChain(spec);
+
+    // Heavy state is only allocated up front for effects that are already on
+    delayState.prepare(spec, effectChain.get<DelayIndex>(), current.isOn(Snapshot::DelayOn));
+    reverbState.prepare(spec, effectChain.get<ReverbIndex>(), current.isOn(Snapshot::ReverbOn));
+
+    effectChain.prepare(spec);
+
+    applyParameters(); // Set initial values
+}
+
+void EffectEngine::release()
+{
+    delayState.release(effectChain.get<DelayIndex>());
+    reverbState.release(effectChain.get<ReverbIndex>());
+}
+
+void EffectEngine::load(const Snapshot& params)
+{
+    delayState.prepare(spec, effectChain.get<DelayIndex>(), params.isOn(Snapshot::DelayOn));
+    reverbState.prepare(spec, effectChain.get<ReverbIndex>(), params.isOn(Snapshot::ReverbOn));
+    loadRealtime(params);
+}
+
+void EffectEngine::loadRealtime(const Snapshot& params) noexcept
+{
+    current = params;
+
+    // Targets first, then reset, so smoothed values start at the preset instead of gliding to it
+    applyParameters();
+    effectChain.reset();
+}
+
+void EffectEngine::carveChain(const juce::dsp::ProcessSpec& chainSpec)
+{
+    // Carve in chain order so neighbouring processors are neighbours in memory
+    effectChain.get<FuzzIndex>().carveFrom(arena, chainSpec);
+    effectChain.get<CompressorIndex>().carveFrom(arena, chainSpec);
+    effectChain.get<WahIndex>().carveFrom(arena, chainSpec);
+    // Ring mod and tremolo only need the shared LFO table (SharedDSPResources);
+    // delay and reverb are carved from their own LazyEffectState arenas
+}
+
+DSPArena::Report EffectEngine::getMemoryReport() const
+{
+    auto report = arena.getReport();
+
+    for (const auto& [name, bytes] : { std::make_pair(delayState.getName(),  delayState.getResidentBytes()),
+                                       std::make_pair(reverbState.getName(), reverbState.getResidentBytes()) })
+    {
+        if (bytes > 0)
+        {
+            report.entries.push_back({ name, bytes });
+            report.arenaBytes += bytes;
+        }
+    }
+
+    return report;
+}
+
+void EffectEngine::process(const juce::dsp::ProcessContextReplacing<float>& context, Taps* taps) noexcept
+{
+    const auto numSamples = static_cast<int>(context.getOutputBlock().getNumSamples());
+
+    // Bind/request/retire lazily allocated delay and reverb memory
+    delayState.update(effectChain.get<DelayIndex>(), current.isOn(Snapshot::DelayOn), numSamples);
+    reverbState.update(effectChain.get<ReverbIndex>(), current.isOn(Snapshot::ReverbOn), numSamples);
+
+    applyParameters(); // Update DSPs before processing
+
+    if (taps == nullptr)
+    {
+        processStages(context, std::make_index_sequence<NumEffects> {});
+        return;
+    }
+
+    // Gain staging taps between Fuzz and the compressor, and after it
+    const auto& block = context.getOutputBlock();
+    processStages(context, std::index_sequence<BitcrusherIndex, FuzzIndex> {});
+    (*taps)[Taps::PostFuzz].push(block);
+    processStages(context, std::index_sequence<CompressorIndex> {});
+    (*taps)[Taps::PostCompressor].push(block);
+    processStages(context, std::index_sequence<RingModIndex, WahIndex, PhaserIndex, ChorusIndex,
+                                               TremoloIndex, DelayIndex, ReverbIndex> {});
+}
+
+void EffectEngine::applyParameters() noexcept
+{
+    // --- Bitcrusher ---
+    auto& bitcrusher = effectChain.get<BitcrusherIndex>();
+    bitcrusher.setBitDepth(current[Snapshot::BitcrusherDepth]);
+    bitcrusher.setRate(current[Snapshot::BitcrusherRate]);
+    effectChain.setBypassed<BitcrusherIndex>(!current.isOn(Snapshot::BitcrusherOn));
+
+    // --- Ring Mod ---
+    auto& ringMod = effectChain.get<RingModIndex>();
+    ringMod.setRate(current[Snapshot::RingModRate]);
+    ringMod.setDepth(current[Snapshot::RingModDepth]);
+    effectChain.setBypassed<RingModIndex>(!current.isOn(Snapshot::RingModOn));
+
+    // --- Phaser ---
+    auto& phaser = effectChain.get<PhaserIndex>();
+    phaser.setRate(current[Snapshot::PhaserRate]);
+    phaser.setDepth(current[Snapshot::PhaserDepth]);
+    phaser.setFeedback(current[Snapshot::PhaserFeedback]);
+    phaser.setMix(current[Snapshot::PhaserMix]);
+    effectChain.setBypassed<PhaserIndex>(!current.isOn(Snapshot::PhaserOn));
+
+    // --- Chorus ---
+    auto& chorus = effectChain.get<ChorusIndex>();
+    chorus.setRate(current[Snapshot::ChorusRate]);
+    chorus.setDepth(current[Snapshot::ChorusDepth]);
+    chorus.setMix(current[Snapshot::ChorusMix]);
+    effectChain.setBypassed<ChorusIndex>(!current.isOn(Snapshot::ChorusOn));
+
+    // --- Tremolo ---
+    auto& tremolo = effectChain.get<TremoloIndex>();
+    tremolo.setRate(current[Snapshot::TremoloRate]);
+    tremolo.setDepth(current[Snapshot::TremoloDepth]);
+    effectChain.setBypassed<TremoloIndex>(!current.isOn(Snapshot::TremoloOn));
+
+    // --- Delay ---
+    auto& delay = effectChain.get<DelayIndex>();
+    delay.setDelayTime(current[Snapshot::DelayTime]);
+    delay.setFeedback(current[Snapshot::DelayFeedback]);
+    delay.setMix(current[Snapshot::DelayMix]);
+    effectChain.setBypassed<DelayIndex>(!current.isOn(Snapshot::DelayOn) || !delayState.isBound());
+
+
+    // --- Reverb ---
+    auto& reverb = effectChain.get<ReverbIndex>();
+    RoomReverb::Parameters reverbParams;
+    reverbParams.roomSize = current[Snapshot::ReverbRoomSize];
+    reverbParams.damping = current[Snapshot::ReverbDamping];
+    reverbParams.wetLevel = current[Snapshot::ReverbWetLevel];
+    reverbParams.dryLevel = current[Snapshot::ReverbDryLevel];
+    reverbParams.width = current[Snapshot::ReverbWidth];
+    reverb.setParameters(reverbParams);
+    effectChain.setBypassed<ReverbIndex>(!current.isOn(Snapshot::ReverbOn) || !reverbState.isBound());
+
+    // --- Multiband Compressor ---
+    auto& comp = effectChain.get<CompressorIndex>();
+    comp.setLowThreshold(current[Snapshot::CompressorLowThresh]);
+    comp.setMidThreshold(current[Snapshot::CompressorMidThresh]);
+    comp.setHighThreshold(current[Snapshot::CompressorHighThresh]);
+    comp.setRatio(current[Snapshot::CompressorRatio]);
+    comp.setAttack(current[Snapshot::CompressorAttack]);
+    comp.setRelease(current[Snapshot::CompressorRelease]);
+    comp.setMakeupGain(current[Snapshot::CompressorMakeup]);
+    effectChain.setBypassed<CompressorIndex>(!current.isOn(Snapshot::CompressorOn));
+
+    // --- Wah Wah ---
+    auto& wah = effectChain.get<WahIndex>();
+    wah.setRate(current[Snapshot::WahRate]);
+    wah.setDepth(current[Snapshot::WahDepth]);
+    wah.setCenterFreq(current[Snapshot::WahFreq]);
+    wah.setResonance(current[Snapshot::WahResonance]);
+    wah.setMix(current[Snapshot::WahMix]);
+    effectChain.setBypassed<WahIndex>(!current.isOn(Snapshot::WahOn));
+
+    // --- Fuzz ---
+    auto& fuzzProc = effectChain.get<FuzzIndex>();
+    fuzzProc.setDrive(current[Snapshot::FuzzDrive]);
+    fuzzProc.setTone(current[Snapshot::FuzzTone]);
+    fuzzProc.setLevel(current[Snapshot::FuzzLevel]);
+    fuzzProc.setMix(current[Snapshot::FuzzMix]);
+    effectChain.setBypassed<FuzzIndex>(!current.isOn(Snapshot::FuzzOn));
+
+}
 
 //==============================================================================
 MultiEffectProcessor::MultiEffectProcessor()
-#ifndef JucePlugin_PreferredChannelConfigurations
      : AudioProcessor (BusesProperties()
-                     #if ! JucePlugin_IsMidiEffect
-                      #if ! JucePlugin_IsSynth
                        .withInput  ("Input",  juce::AudioChannelSet::stereo(), true)
-                      #endif
-                       .withOutput ("Output", juce::AudioChannelSet::stereo(), true)
-                     #endif
-                       )
-#endif
-{
-    // Get raw pointers for quick access
-    bitcrusherOn = dynamic_cast<juce::AudioParameterBool*>(apvts.getParameter("bitcrusherOn"));
-    bitcrusherDepth = dynamic_cast<juce::AudioParameterFloat*>(apvts.getParameter("bitcrusherDepth"));
-    bitcrusherRate = dynamic_cast<juce::AudioParameterFloat*>(apvts.getParameter("bitcrusherRate"));
-
-    ringModOn = dynamic_cast<juce::AudioParameterBool*>(apvts.getParameter("ringModOn"));
-    ringModRate = dynamic_cast<juce::AudioParameterFloat*>(apvts.getParameter("ringModRate"));
-    ringModDepth = dynamic_cast<juce::AudioParameterFloat*>(apvts.getParameter("ringModDepth"));
-    
-    phaserOn = dynamic_cast<juce::AudioParameterBool*>(apvts.getParameter("phaserOn"));
-    phaserRate = dynamic_cast<juce::AudioParameterFloat*>(apvts.getParameter("phaserRate"));
-    phaserDepth = dynamic_cast<juce::AudioParameterFloat*>(apvts.getParameter("phaserDepth"));
-    phaserFeedback = dynamic_cast<juce::AudioParameterFloat*>(apvts.getParameter("phaserFeedback"));
-    phaserMix = dynamic_cast<juce::AudioParameterFloat*>(apvts.getParameter("phaserMix"));
-    
-    chorusOn = dynamic_cast<juce::AudioParameterBool*>(apvts.getParameter("chorusOn"));
-    chorusRate = dynamic_cast<juce::AudioParameterFloat*>(apvts.getParameter("chorusRate"));
-    chorusDepth = dynamic_cast<juce::AudioParameterFloat*>(apvts.getParameter("chorusDepth"));
-    chorusMix = dynamic_cast<juce::AudioParameterFloat*>(apvts.getParameter("chorusMix"));
-
-    tremoloOn = dynamic_cast<juce::AudioParameterBool*>(apvts.getParameter("tremoloOn"));
-    tremoloRate = dynamic_cast<juce::AudioParameterFloat*>(apvts.getParameter("tremoloRate"));
-    tremoloDepth = dynamic_cast<juce::AudioParameterFloat*>(apvts.getParameter("tremoloDepth"));
-
-    delayOn = dynamic_cast<juce::AudioParameterBool*>(apvts.getParameter("delayOn"));
-    delayTime = dynamic_cast<juce::AudioParameterFloat*>(apvts.getParameter("delayTime"));
-    delayFeedback = dynamic_cast<juce::AudioParameterFloat*>(apvts.getParameter("delayFeedback"));
-    delayMix = dynamic_cast<juce::AudioParameterFloat*>(apvts.getParameter("delayMix"));
-
-    reverbOn = dynamic_cast<juce::AudioParameterBool*>(apvts.getParameter("reverbOn"));
-    reverbRoomSize = dynamic_cast<juce::AudioParameterFloat*>(apvts.getParameter("reverbRoomSize"));
-    reverbDamping = dynamic_cast<juce::AudioParameterFloat*>(apvts.getParameter("reverbDamping"));
-    reverbWetLevel = dynamic_cast<juce::AudioParameterFloat*>(apvts.getParameter("reverbWetLevel"));
-    reverbDryLevel = dynamic_cast<juce::AudioParameterFloat*>(apvts.getParameter("reverbDryLevel"));
-    reverbWidth = dynamic_cast<juce::AudioParameterFloat*>(apvts.getParameter("reverbWidth"));
-
-    compressorOn = dynamic_cast<juce::AudioParameterBool*>(apvts.getParameter("compressorOn"));
-    compressorLowThresh = dynamic_cast<juce::AudioParameterFloat*>(apvts.getParameter("compressorLowThresh"));
-    compressorMidThresh = dynamic_cast<juce::AudioParameterFloat*>(apvts.getParameter("compressorMidThresh"));
-    compressorHighThresh = dynamic_cast<juce::AudioParameterFloat*>(apvts.getParameter("compressorHighThresh"));
-    compressorRatio = dynamic_cast<juce::AudioParameterFloat*>(apvts.getParameter("compressorRatio"));
-    compressorAttack = dynamic_cast<juce::AudioParameterFloat*>(apvts.getParameter("compressorAttack"));
-    compressorRelease = dynamic_cast<juce::AudioParameterFloat*>(apvts.getParameter("compressorRelease"));
-    compressorMakeup = dynamic_cast<juce::AudioParameterFloat*>(apvts.getParameter("compressorMakeup"));
-
-    wahOn = dynamic_cast<juce::AudioParameterBool*>(apvts.getParameter("wahOn"));
-    wahRate = dynamic_cast<juce::AudioParameterFloat*>(apvts.getParameter("wahRate"));
-    wahDepth = dynamic_cast<juce::AudioParameterFloat*>(apvts.getParameter("wahDepth"));
-    wahFreq = dynamic_cast<juce::AudioParameterFloat*>(apvts.getParameter("wahFreq"));
-    wahResonance = dynamic_cast<juce::AudioParameterFloat*>(apvts.getParameter("wahResonance"));
-    wahMix = dynamic_cast<juce::AudioParameterFloat*>(apvts.getParameter("wahMix"));
-
-    fuzzOn = dynamic_cast<juce::AudioParameterBool*>(apvts.getParameter("fuzzOn"));
-    fuzzDrive = dynamic_cast<juce::AudioParameterFloat*>(apvts.getParameter("fuzzDrive"));
-    fuzzTone = dynamic_cast<juce::AudioParameterFloat*>(apvts.getParameter("fuzzTone"));
-    fuzzLevel = dynamic_cast<juce::AudioParameterFloat*>(apvts.getParameter("fuzzLevel"));
-    fuzzMix = dynamic_cast<juce::AudioParameterFloat*>(apvts.getParameter("fuzzMix"));
+                       .withOutput ("Output", juce::AudioChannelSet::stereo(), true))
+{
+    // Raw atomic values in layout order; the snapshot indices must match it exactly,
+    // because presets store their values in the same order
+    for (int i = 0; i < ParameterSnapshot::NumParameters; ++i)
+    {
+        parameterValues[static_cast<size_t>(i)] = apvts.getRawParameterValue(ParameterSnapshot::ids[i]);
+        jassert(parameterValues[static_cast<size_t>(i)] != nullptr);
+        jassert(presetManager.getParameterIDs()[i] == ParameterSnapshot::ids[i]);
+    }
+
+    presetManager.onBeforeRecall = [this](const float* values) { beginPresetSwitch(values); };
+
+    // Any instance saving to the shared bank renumbers it for all of them
+    presetManager.onBankChanged = [this]
+    {
+        assignProgramSlotsFromBank();
+        updateHostDisplay(ChangeDetails().withProgramChanged(true));
+    };
+
+    const auto bankResult = presetManager.loadBank(PresetManager::getDefaultBankFile());
+    if (bankResult.failed())
+        DBG(bankResult.getErrorMessage());
+
+    assignProgramSlotsFromBank();
 }
 
 MultiEffectProcessor::~MultiEffectProcessor() {}
@@ -158,17 +313,40 @@ void MultiEffectProcessor::prepareToPlay(double sampleRate, int samplesPerBlock)
     spec.maximumBlockSize = samplesPerBlock;
     spec.numChannels = getTotalNumOutputChannels();
 
-    effectChain.prepare(spec);
+    ParameterSnapshot params;
+    captureParameters(params);
+    engines.forEachEngine([offline = isNonRealtime()](EffectEngine& engine) { engine.setNonRealtime(offline); });
+    engines.prepare(spec, params);
 
-    // Prepare Delay Line (needs specific setup)
-    auto& delayLine = effectChain.get<DelayIndex>();
-    delayLine.setMaximumDelayInSamples(int(sampleRate * 2.0)); // Max 2 seconds delay
-    delayLine.prepare(spec);
+    for (auto& ramp : midiRamps)
+        ramp.reset(sampleRate, midiRampSeconds);
+    ramping.reset();
+    preparedBlockSize = samplesPerBlock;
 
-    updateParameters(); // Set initial values
+    deadlineMonitor.prepare(sampleRate, juce::StringArray(ParameterSnapshot::ids, ParameterSnapshot::NumParameters));
+    blockCapture.prepare(sampleRate, samplesPerBlock, getTotalNumInputChannels());
+}
+
+DSPArena::Report MultiEffectProcessor::getMemoryReport() const
+{
+    DSPArena::Report report;
+    engines.forEachEngine([&report](const EffectEngine& engine)
+    {
+        const auto engineReport = engine.getMemoryReport();
+        report.arenaBytes += engineReport.arenaBytes;
+        for (const auto& entry : engineReport.entries)
+            report.addEntry(entry.owner, entry.bytes);
+    });
+
+    report.objectBytes = sizeof(*this);
+    return report;
 }
 
-void MultiEffectProcessor::releaseResources() {}
+void MultiEffectProcessor::releaseResources()
+{
+    // Audio has stopped: give back lazily allocated delay/reverb memory
+    engines.release();
+}
 
 bool MultiEffectProcessor::isBusesLayoutSupported(const BusesLayout& layouts) const
 {
@@ -178,92 +356,113 @@ bool MultiEffectProcessor::isBusesLayoutSupported(const BusesLayout& layouts) co
     return mainInput.size() > 0 && mainOutput.size() > 0 && mainInput == mainOutput;
 }
 
-void MultiEffectProcessor::updateParameters()
+void MultiEffectProcessor::captureParameters(ParameterSnapshot& snapshot) const noexcept
 {
-    // --- Bitcrusher ---
-    auto& bitcrusher = effectChain.get<BitcrusherIndex>();
-    bitcrusher.setBitDepth(bitcrusherDepth->get());
-    bitcrusher.setRate(bitcrusherRate->get());
-    effectChain.setBypassed<BitcrusherIndex>(!bitcrusherOn->get());
+    for (size_t i = 0; i < snapshot.values.size(); ++i)
+        snapshot.values[i] = parameterValues[i]->load();
+}
 
-    // --- Ring Mod ---
-    auto& ringMod = effectChain.get<RingModIndex>();
-    ringMod.setRate(ringModRate->get());
-    ringMod.setDepth(ringModDepth->get());
-    effectChain.setBypassed<RingModIndex>(!ringModOn->get());
+void MultiEffectProcessor::applyOverrides(ParameterSnapshot& snapshot, bool mirrored) noexcept
+{
+    if (overridden.none())
+        return;
 
-    // --- Phaser ---
-    auto& phaser = effectChain.get<PhaserIndex>();
-    phaser.setRate(phaserRate->get());
-    phaser.setDepth(phaserDepth->get());
-    phaser.setFeedback(phaserFeedback->get());
-    phaser.setMix(phaserMix->get());
-    effectChain.setBypassed<PhaserIndex>(!phaserOn->get());
+    if (mirrored)
+    {
+        overridden.reset(); // The APVTS holds these values now
+        return;
+    }
 
-    // --- Chorus ---
-    auto& chorus = effectChain.get<ChorusIndex>();
-    chorus.setRate(chorusRate->get());
-    chorus.setDepth(chorusDepth->get());
-    chorus.setMix(chorusMix->get());
-    effectChain.setBypassed<ChorusIndex>(!chorusOn->get());
+    for (size_t i = 0; i < snapshot.values.size(); ++i)
+        if (overridden[i])
+            snapshot.values[i] = overrideValues.values[i];
+}
 
-    // --- Tremolo ---
-    auto& tremolo = effectChain.get<TremoloIndex>();
-    tremolo.setRate(tremoloRate->get());
-    tremolo.setDepth(tremoloDepth->get());
-    effectChain.setBypassed<TremoloIndex>(!tremoloOn->get());
+void MultiEffectProcessor::switchToProgramSlot(const ParameterSnapshot& target, ParameterSnapshot& params) noexcept
+{
+    DSP4G_TRACE_INSTANT("Program change");
+
+    int suppressed = 0;
+    if (! engines.switchNow(target) && switchThrottle.allow(suppressed))
+        realtimeLog->log(RealtimeLog::Level::warning,
+                         "Program change while the spare engine was busy: parameters jumped without a crossfade ({} more suppressed)",
+                         suppressed);
+
+    params = target;
+    overrideValues = target;
+    overridden.set();
+    ramping.reset(); // The program wins over controller ramps still in flight
+
+    for (size_t i = 0; i < target.values.size(); ++i)
+        parameterMirror.push(i, target.values[i]);
+    parameterMirror.endBatch();
+}
 
-    // --- Delay ---
-    // Delay needs a more complex update (handle feedback, mix) - this is simplified
-    auto& delayLine = effectChain.get<DelayIndex>();
-    // We can't directly set params on DelayLine. We need a custom DSP class for full delay.
-    // This is a placeholder - a real delay needs feedback and mix logic here.
-    effectChain.setBypassed<DelayIndex>(!delayOn->get());
+void MultiEffectProcessor::decodePreset(const float* normalisedValues, ParameterSnapshot& dest) const
+{
+    const auto& params = getParameters();
 
+    for (int i = 0; i < ParameterSnapshot::NumParameters; ++i)
+        if (auto* ranged = dynamic_cast<juce::RangedAudioParameter*>(params[i]))
+            dest.values[static_cast<size_t>(i)] = ranged->convertFrom0to1(normalisedValues[i]);
+}
 
-    // --- Reverb ---
-    auto& reverb = effectChain.get<ReverbIndex>();
-    juce::dsp::Reverb::Parameters reverbParams;
-    reverbParams.roomSize = reverbRoomSize->get();
-    reverbParams.damping = reverbDamping->get();
-    reverbParams.wetLevel = reverbWetLevel->get();
-    reverbParams.dryLevel = reverbDryLevel->get();
-    reverbParams.width = reverbWidth->get();
-    reverb.setParameters(reverbParams);
-    effectChain.setBypassed<ReverbIndex>(!reverbOn->get());
+void MultiEffectProcessor::beginPresetSwitch(const float* normalisedValues)
+{
+    // Runs before PresetManager writes the values to the parameters, so the
+    // running engine is frozen before it could see any of them
+    DSP4G_TRACE_INSTANT("Preset switch");
+    ParameterSnapshot target;
+    decodePreset(normalisedValues, target);
+    engines.requestSwitch(target);
+}
 
-    // --- Multiband Compressor ---
-    auto& comp = effectChain.get<CompressorIndex>();
-    comp.setLowThreshold(compressorLowThresh->get());
-    comp.setMidThreshold(compressorMidThresh->get());
-    comp.setHighThreshold(compressorHighThresh->get());
-    comp.setRatio(compressorRatio->get());
-    comp.setAttack(compressorAttack->get());
-    comp.setRelease(compressorRelease->get());
-    comp.setMakeupGain(compressorMakeup->get());
-    effectChain.setBypassed<CompressorIndex>(!compressorOn->get());
+void MultiEffectProcessor::assignProgramSlot(int slot, int presetIndex)
+{
+    if (! juce::isPositiveAndBelow(slot, ProgramSlotTable::numSlots))
+        return;
 
-    // --- Wah Wah ---
-    auto& wah = effectChain.get<WahIndex>();
-    wah.setRate(wahRate->get());
-    wah.setDepth(wahDepth->get());
-    wah.setCenterFreq(wahFreq->get());
-    wah.setResonance(wahResonance->get());
-    wah.setMix(wahMix->get());
-    effectChain.setBypassed<WahIndex>(!wahOn->get());
+    const auto& bank = presetManager.getBank();
+    const auto index = static_cast<size_t>(slot);
+    programSlotModel.used[index] = juce::isPositiveAndBelow(presetIndex, bank.getNumPresets());
 
-    // --- Fuzz ---
-    auto& fuzzProc = effectChain.get<FuzzIndex>();
-    fuzzProc.setDrive(fuzzDrive->get());
-    fuzzProc.setTone(fuzzTone->get());
-    fuzzProc.setLevel(fuzzLevel->get());
-    fuzzProc.setMix(fuzzMix->get());
-    effectChain.setBypassed<FuzzIndex>(!fuzzOn->get());
+    if (programSlotModel.used[index])
+    {
+        std::array<float, ParameterSnapshot::NumParameters> normalised {};
+        bank.copyValues(presetIndex, normalised.data());
+        decodePreset(normalised.data(), programSlotModel.snapshots[index]);
+    }
 
+    programSlots.publish(std::make_unique<ProgramSlotTable>(programSlotModel));
+}
+
+void MultiEffectProcessor::assignProgramSlotsFromBank()
+{
+    const auto& bank = presetManager.getBank();
+    std::array<float, ParameterSnapshot::NumParameters> normalised {};
+
+    for (int slot = 0; slot < ProgramSlotTable::numSlots; ++slot)
+    {
+        const auto index = static_cast<size_t>(slot);
+        programSlotModel.used[index] = slot < bank.getNumPresets();
+
+        if (programSlotModel.used[index])
+        {
+            bank.copyValues(slot, normalised.data());
+            decodePreset(normalised.data(), programSlotModel.snapshots[index]);
+        }
+    }
+
+    programSlots.publish(std::make_unique<ProgramSlotTable>(programSlotModel));
 }
 
 void MultiEffectProcessor::processBlock(juce::AudioBuffer<float>& buffer, juce::MidiBuffer& midiMessages)
 {
+    DSP4G_TRACE_ZONE("MultiEffectProcessor::processBlock");
+
+    const bool realtime = ! isNonRealtime();
+    const auto callbackStart = realtime ? deadlineMonitor.beginCallback() : 0;
+
     juce::ScopedNoDenormals noDenormals;
     auto totalNumInputChannels  = getTotalNumInputChannels();
     auto totalNumOutputChannels = getTotalNumOutputChannels();
@@ -271,75 +470,316 @@ void MultiEffectProcessor::processBlock(juce::AudioBuffer<float>& buffer, juce::
     for (auto i = totalNumInputChannels; i < totalNumOutputChannels; ++i)
         buffer.clear (i, 0, buffer.getNumSamples());
 
-    updateParameters(); // Update DSPs before processing
-
-    // --- Simple Delay Implementation (Manual within processBlock for now) ---
-    // A proper implementation would use a custom DSP class inside the chain.
-    float dTime = delayTime->get();
-    float dFbk = delayFeedback->get();
-    float dMix = delayMix->get();
-    bool dOn = delayOn->get();
-    auto& delayLine = effectChain.get<DelayIndex>();
-    int delaySamples = int(getSampleRate() * dTime / 1000.0);
-    
-    // --- Create DSP Context ---
+    int suppressed = 0;
+    if (buffer.getNumSamples() > preparedBlockSize && blockSizeThrottle.allow(suppressed))
+        realtimeLog->log(RealtimeLog::Level::warning, "processBlock: {} samples, prepared for {} ({} more suppressed)",
+                         buffer.getNumSamples(), preparedBlockSize, suppressed);
+
+    // Check the mirror before capturing, so values it has just written are seen
+    const bool mirrored = parameterMirror.isUpToDate();
+
+    // Capture first: a preset switch requested after this point freezes the engine
+    ParameterSnapshot params;
+    captureParameters(params);
+
+    // What the host gave this block, before anything here changes it
+    blockCapture.pushBlock(buffer, totalNumInputChannels, midiMessages, params.values.data());
+
+    applyOverrides(params, mirrored);
+
+    // --- Process through the live engine (and an outgoing one while it rings out) ---
+    // The block is split at every Program Change and mapped controller, so each
+    // lands on its exact sample
+    const auto* slots = programSlots.acquire();
+    const auto* mappings = midiLearn.acquireTable();
     juce::dsp::AudioBlock<float> block(buffer);
-    juce::dsp::ProcessContextReplacing<float> context(block);
+    const auto numSamples = block.getNumSamples();
+
+    blockTaps = analysisEnabled.load(std::memory_order_acquire) ? &signalTaps : nullptr;
+    if (blockTaps != nullptr)
+        signalTaps[SignalTaps::Input].push(block);
 
-    // --- Process through the chain ---
-    effectChain.process(context);
+    size_t position = 0;
+    bool controlled = false;
 
-    // --- Manual Delay Processing (After chain for now) ---
-    if (dOn)
+    for (const auto metadata : midiMessages)
     {
-       auto numSamples = buffer.getNumSamples();
-       for (int channel = 0; channel < totalNumInputChannels; ++channel)
-       {
-           auto* channelData = buffer.getWritePointer(channel);
-           for (int sample = 0; sample < numSamples; ++sample)
-           {
-               float delayedSample = delayLine.popSample(channel);
-               float inputSample = channelData[sample];
-               delayLine.pushSample(channel, inputSample + (delayedSample * dFbk));
-               channelData[sample] = (inputSample * (1.0f - dMix)) + (delayedSample * dMix);
-           }
-       }
+        const auto message = metadata.getMessage();
+        const auto eventPosition = static_cast<size_t>(juce::jlimit(0, static_cast<int>(numSamples), metadata.samplePosition));
+
+        if (message.isControllerOfType(0))  { bankSelectMsb = message.getControllerValue(); continue; }
+        if (message.isControllerOfType(32)) { bankSelectLsb = message.getControllerValue(); continue; }
+
+        MidiLearn::Source source;
+        int number = 0;
+        float controllerPosition = 0.0f;
+        if (MidiLearn::decode(message, source, number, controllerPosition))
+        {
+            midiLearn.offer(source, number, message.getChannel());
+            if (mappings == nullptr)
+                continue;
+
+            renderSegment(block, position, eventPosition, params);
+            position = juce::jmax(position, eventPosition);
+            controlled |= applyMidiControl(*mappings, source, number, message.getChannel(), controllerPosition, params);
+            continue;
+        }
+
+        if (! message.isProgramChange() || slots == nullptr) continue;
+
+        const auto bankNumber = bankSelectMsb * 128 + bankSelectLsb;
+        const auto slot = bankNumber * ProgramSlotTable::programsPerBank + message.getProgramChangeNumber();
+        if (! juce::isPositiveAndBelow(slot, ProgramSlotTable::numSlots) || ! slots->used[static_cast<size_t>(slot)])
+        {
+            if (programThrottle.allow(suppressed))
+                realtimeLog->log(RealtimeLog::Level::warning, "Program change to empty slot {} (bank {}) ignored ({} more suppressed)",
+                                 slot, bankNumber, suppressed);
+            continue;
+        }
+
+        renderSegment(block, position, eventPosition, params);
+        position = juce::jmax(position, eventPosition);
+        switchToProgramSlot(slots->snapshots[static_cast<size_t>(slot)], params);
     }
+
+    renderSegment(block, position, numSamples, params);
+
+    checkOutput(buffer);
+
+    if (blockTaps != nullptr)
+        signalTaps[SignalTaps::Output].push(block);
+
+    if (controlled)
+        parameterMirror.endBatch();
+
+    // The snapshot is what this block rendered with at its end
+    if (realtime && deadlineMonitor.endCallback(callbackStart, buffer.getNumSamples()))
+        deadlineMonitor.recordOverrun(params.values.data(), ParameterSnapshot::NumParameters, presetManager.getCurrentPreset());
+}
+
+void MultiEffectProcessor::checkOutput(juce::AudioBuffer<float>& buffer) noexcept
+{
+    // Classified from the exponent bits: all ones is NaN or infinity, all zeros
+    // with a non-zero mantissa a denormal
+    int nonFinite = 0, denormals = 0, firstBadChannel = -1;
+
+    for (int ch = 0; ch < buffer.getNumChannels(); ++ch)
+    {
+        const auto* samples = buffer.getReadPointer(ch);
+        for (int i = 0; i < buffer.getNumSamples(); ++i)
+        {
+            juce::uint32 bits;
+            std::memcpy(&bits, samples + i, sizeof(bits));
+            const auto exponent = bits & 0x7f800000u;
+            const bool bad = exponent == 0x7f800000u;
+            nonFinite += bad ? 1 : 0;
+            denormals += (exponent == 0 && (bits & 0x007fffffu) != 0) ? 1 : 0;
+            if (bad && firstBadChannel < 0)
+                firstBadChannel = ch;
+        }
+    }
+
+    int suppressed = 0;
+    if (nonFinite > 0)
+    {
+        buffer.clear();
+        if (nonFiniteThrottle.allow(suppressed))
+            realtimeLog->log(RealtimeLog::Level::error, "{} NaN/Inf output samples (first in channel {}), block muted, preset {} ({} more suppressed)",
+                             nonFinite, firstBadChannel, presetManager.getCurrentPreset(), suppressed);
+    }
+    else if (denormals >= denormalBurstSamples && denormalThrottle.allow(suppressed))
+    {
+        realtimeLog->log(RealtimeLog::Level::warning, "{} denormal output samples in a {}-sample block, preset {} ({} more suppressed)",
+                         denormals, buffer.getNumSamples(), presetManager.getCurrentPreset(), suppressed);
+    }
+}
+
+void MultiEffectProcessor::renderSegment(const juce::dsp::AudioBlock<float>& block, size_t start, size_t end,
+                                         ParameterSnapshot& params) noexcept
+{
+    while (start < end)
+    {
+        auto length = end - start;
+
+        if (ramping.any())
+        {
+            length = juce::jmin(length, midiRampStepSamples);
+
+            for (size_t i = 0; i < params.values.size(); ++i)
+            {
+                if (! ramping[i])
+                    continue;
+
+                auto& ramp = midiRamps[i];
+                if (ramp.isSmoothing())
+                {
+                    params.values[i] = ramp.getCurrentValue();
+                    ramp.skip(static_cast<int>(length));
+                }
+                else
+                {
+                    params.values[i] = ramp.getTargetValue();
+                    ramping.reset(i);
+                }
+            }
+        }
+
+        engines.process(block.getSubBlock(start, length), params, blockTaps);
+        start += length;
+    }
+}
+
+bool MultiEffectProcessor::applyMidiControl(const MidiLearn::Table& mappings, MidiLearn::Source source, int number,
+                                            int channel, float position, ParameterSnapshot& params) noexcept
+{
+    bool applied = false;
+
+    for (const auto& entry : mappings.entries)
+    {
+        if (! entry.matches(source, number, channel))
+            continue;
+
+        const auto i = entry.parameterIndex;
+        const auto value = entry.lookup(position);
+
+        if (entry.isSwitch)
+        {
+            params.values[i] = value;
+            ramping.reset(i);
+        }
+        else
+        {
+            // Start from wherever the parameter is now, including mid-ramp
+            if (! ramping[i])
+                midiRamps[i].setCurrentAndTargetValue(params.values[i]);
+
+            midiRamps[i].setTargetValue(value);
+            ramping.set(i);
+        }
+
+        // Until the mirror has written it to the APVTS, later blocks keep the target
+        overrideValues.values[i] = value;
+        overridden.set(i);
+        parameterMirror.push(i, value);
+        applied = true;
+    }
+
+    return applied;
 }
 
 //==============================================================================
 // Standard JUCE boilerplate (getName, acceptsMidi, etc.)
-const juce::String MultiEffectProcessor::getName() const { return JucePlugin_Name; }
-bool MultiEffectProcessor::acceptsMidi() const { return false; }
+const juce::String MultiEffectProcessor::getName() const { return "DSP4Guitar"; }
+bool MultiEffectProcessor::acceptsMidi() const { return true; } // Program Change, Bank Select, MIDI learn
 bool MultiEffectProcessor::producesMidi() const { return false; }
 bool MultiEffectProcessor::isMidiEffect() const { return false; }
 double MultiEffectProcessor::getTailLengthSeconds() const { return 2.0; } // Account for Delay/Reverb
-int MultiEffectProcessor::getNumPrograms() { return 1; }
-int MultiEffectProcessor::getCurrentProgram() { return 0; }
-void MultiEffectProcessor::setCurrentProgram(int index) {}
-const juce::String MultiEffectProcessor::getProgramName(int index) { return {}; }
+int MultiEffectProcessor::getNumPrograms() { return juce::jmax(1, presetManager.getBank().getNumPresets()); }
+int MultiEffectProcessor::getCurrentProgram() { return juce::jmax(0, presetManager.getCurrentPreset()); }
+void MultiEffectProcessor::setCurrentProgram(int index) { presetManager.loadPreset(index); }
+const juce::String MultiEffectProcessor::getProgramName(int index) { return presetManager.getBank().getName(index); }
 void MultiEffectProcessor::changeProgramName(int index, const juce::String& newName) {}
-bool MultiEffectProcessor::hasEditor() const { return true; }
-juce::AudioProcessorEditor* MultiEffectProcessor::createEditor()
+bool MultiEffectProcessor::hasEditor() const { return false; } // see PluginEntry.cpp
+juce::AudioProcessorEditor* MultiEffectProcessor::createEditor() { return nullptr; }
+//==============================================================================
+namespace
+{
+    const juce::Identifier extraStateType { "Extra" };
+    const juce::Identifier settingsType { "Settings" };
+    const juce::Identifier presetCrossfadeID { "presetCrossfadeSeconds" };
+    const juce::Identifier idleReleaseID { "idleReleaseSeconds" };
+}
+
+void MultiEffectProcessor::setPresetCrossfadeSeconds(double seconds)
+{
+    engines.setCrossfadeSeconds(seconds);
+    updateHostDisplay(ChangeDetails().withNonParameterStateChanged(true));
+}
+
+void MultiEffectProcessor::setIdleReleaseSeconds(double seconds)
 {
-    return new MultiEffectProcessorEditor(*this);
+    engines.forEachEngine([seconds](EffectEngine& engine) { engine.setIdleReleaseSeconds(seconds); });
+    updateHostDisplay(ChangeDetails().withNonParameterStateChanged(true));
 }
+
+double MultiEffectProcessor::getIdleReleaseSeconds() const noexcept
+{
+    auto seconds = 0.0;
+    engines.forEachEngine([&seconds](const EffectEngine& engine) { seconds = engine.getIdleReleaseSeconds(); });
+    return seconds;
+}
+
+juce::ValueTree MultiEffectProcessor::createExtraState() const
+{
+    juce::ValueTree settings(settingsType);
+    settings.setProperty(presetCrossfadeID, getPresetCrossfadeSeconds(), nullptr);
+    settings.setProperty(idleReleaseID, getIdleReleaseSeconds(), nullptr);
+
+    juce::ValueTree extra(extraStateType);
+    extra.appendChild(midiLearn.createState(), nullptr);
+    extra.appendChild(settings, nullptr);
+    return extra;
+}
+
+void MultiEffectProcessor::restoreExtraState(const juce::ValueTree& extra)
+{
+    // Binary states saved before the settings held the MIDI mappings alone
+    midiLearn.restoreState(extra.hasType(MidiLearn::stateType) ? extra : extra.getChildWithName(MidiLearn::stateType));
+
+    const auto settings = extra.getChildWithName(settingsType);
+    engines.setCrossfadeSeconds(settings.getProperty(presetCrossfadeID, PresetSwitchEngine<EffectEngine>::defaultCrossfadeSeconds));
+
+    const double idleRelease = settings.getProperty(idleReleaseID, LazyEffectState<TapeDelay>::defaultIdleReleaseSeconds);
+    engines.forEachEngine([idleRelease](EffectEngine& engine) { engine.setIdleReleaseSeconds(idleRelease); });
+}
+
 void MultiEffectProcessor::getStateInformation(juce::MemoryBlock& destData)
 {
+    if (juce::ByteOrder::isLittleEndian())
+    {
+        std::array<float, ParameterSnapshot::NumParameters> values {};
+        stateCodec.capture(values.data());
+        stateCodec.write(values.data(), createExtraState(), destData);
+        return;
+    }
+
+    // The XML state carries the same children next to the parameters
     auto state = apvts.copyState();
+    for (const auto& child : createExtraState())
+    {
+        state.removeChild(state.getChildWithName(child.getType()), nullptr);
+        state.appendChild(child.createCopy(), nullptr);
+    }
+
     std::unique_ptr<juce::XmlElement> xml(state.createXml());
     copyXmlToBinary(*xml, destData);
 }
 void MultiEffectProcessor::setStateInformation(const void* data, int sizeInBytes)
 {
+    if (PluginState::isBinaryState(data, static_cast<size_t>(juce::jmax(0, sizeInBytes))))
+    {
+        std::array<float, ParameterSnapshot::NumParameters> values {};
+        juce::ValueTree extra;
+        const auto result = stateCodec.read(data, static_cast<size_t>(sizeInBytes), values.data(), extra);
+
+        if (result.failed())
+        {
+            DBG(result.getErrorMessage());
+            return;
+        }
+
+        restoreExtraState(extra);
+        stateCodec.apply(values.data());
+        return;
+    }
+
+    // Sessions saved before the binary format: XML, rewritten as binary on the next save
     std::unique_ptr<juce::XmlElement> xmlState(getXmlFromBinary(data, sizeInBytes));
     if (xmlState.get() != nullptr)
         if (xmlState->hasTagName(apvts.state.getType()))
-            apvts.replaceState(juce::ValueTree::fromXml(*xmlState));
-}
-
-// This creates new instances of the plugin..
-juce::AudioProcessor* JUCE_CALLTYPE createPluginFilter()
-{
-    return new MultiEffectProcessor();
+        {
+            auto state = juce::ValueTree::fromXml(*xmlState);
+            restoreExtraState(state);
+            apvts.replaceState(state);
+        }
 }
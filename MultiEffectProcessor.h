@@ -2,14 +2,132 @@
 
 #include <juce_audio_processors/juce_audio_processors.h>
 #include <juce_dsp/juce_dsp.h>
+#include "DSPArena.h"
+#include "LazyEffectState.h"
+#include "SharedDSPResources.h"
+#include "PresetManager.h"
+#include "PresetSwitchEngine.h"
+#include "RealtimePublisher.h"
+#include "ParameterMirror.h"
+#include "MidiLearn.h"
+#include "PluginState.h"
+#include "AudioTap.h"
+#include "DeadlineMonitor.h"
+#include "TraceRecorder.h"
+#include "RealtimeLog.h"
+#include "BlockCapture.h"
+#include <bitset>
+#include <utility>
+
+//==============================================================================
+// Transposed direct-form II biquad. Coefficients are plain floats (no
+// ref-counted Coefficients object, so updating them never allocates) and the
+// per-channel state is carved from the chain's DSPArena.
+class Biquad
+{
+public:
+    void carveFrom(DSPArena& arena, const char* owner, size_t channels)
+    {
+        numChannels = channels;
+        state = arena.carve<float>(owner, numChannels * 2);
+    }
+
+    /** Takes { b0, b1, b2, a0, a1, a2 } as returned by juce::dsp::IIR::ArrayCoefficients. */
+    void setCoefficients(const std::array<float, 6>& c) noexcept
+    {
+        const float a0Inv = 1.0f / c[3];
+        b0 = c[0] * a0Inv;
+        b1 = c[1] * a0Inv;
+        b2 = c[2] * a0Inv;
+        a1 = c[4] * a0Inv;
+        a2 = c[5] * a0Inv;
+    }
+
+    float processSample(size_t channel, float in) noexcept
+    {
+        float* s = state + channel * 2;
+        const float out = b0 * in + s[0];
+        s[0] = b1 * in - a1 * out + s[1];
+        s[1] = b2 * in - a2 * out;
+        return out;
+    }
+
+    void process(const juce::dsp::AudioBlock<float>& block) noexcept
+    {
+        const size_t numSamples = block.getNumSamples();
+        const size_t channels   = juce::jmin(block.getNumChannels(), numChannels);
+        for (size_t ch = 0; ch < channels; ++ch)
+        {
+            float* data = block.getChannelPointer(ch);
+            for (size_t i = 0; i < numSamples; ++i)
+                data[i] = processSample(ch, data[i]);
+        }
+    }
+
+    void reset() noexcept
+    {
+        if (state != nullptr)
+            std::fill(state, state + numChannels * 2, 0.0f);
+    }
+
+private:
+    float b0 = 1.0f, b1 = 0.0f, b2 = 0.0f, a1 = 0.0f, a2 = 0.0f;
+    float* state = nullptr;
+    size_t numChannels = 0;
+};
+
+//==============================================================================
+// Table-lookup sine LFO (same shape and frequency smoothing as a
+// juce::dsp::Oscillator initialised with a 128-point table). The table is
+// read-only and shared by every LFO in the process via SharedDSPResources.
+class SineLFO
+{
+public:
+    static constexpr size_t tableSize = 128;
+
+    SineLFO() : sharedTable(resources->getSineTable(tableSize)), table(sharedTable->samples.data()) {}
+
+    void prepare(const juce::dsp::ProcessSpec& spec)
+    {
+        sampleRate = spec.sampleRate;
+        reset();
+    }
+
+    void reset()
+    {
+        phase = 0.0f;
+        frequency.reset(sampleRate, 0.05);
+    }
+
+    void setFrequency(float newFrequency) { frequency.setTargetValue(newFrequency); }
+
+    /** Returns the next LFO value in [-1, 1]. */
+    float processSample() noexcept
+    {
+        const float position = phase * static_cast<float>(tableSize);
+        const auto index     = juce::jmin(static_cast<size_t>(position), tableSize - 1);
+        const float frac     = position - static_cast<float>(index);
+        const float out      = table[index] + frac * (table[index + 1] - table[index]);
+
+        phase += frequency.getNextValue() / static_cast<float>(sampleRate);
+        phase -= std::floor(phase);
+        return out;
+    }
+
+private:
+    juce::SharedResourcePointer<SharedDSPResources> resources;
+    std::shared_ptr<const SharedDSPResources::WaveTable> sharedTable;
+    const float* table = nullptr;
+    double sampleRate = 44100.0;
+    float phase = 0.0f;
+    juce::SmoothedValue<float> frequency { 1.0f };
+};
 
 //==============================================================================
 // Simple Ring Modulator DSP class
 class RingModulator
 {
 public:
-    RingModulator() { lfo.initialise([](float x) { return std::sin(x); }, 128); }
-
     void prepare(const juce::dsp::ProcessSpec& spec)
     {
         lfo.prepare(spec);
@@ -29,7 +147,7 @@ public:
 
         for (int sample = 0; sample < numSamples; ++sample)
         {
-            float lfoSample = (lfo.processSample(0.0f) * depth) + (1.0f - depth); // Mix LFO
+            float lfoSample = (lfo.processSample() * depth) + (1.0f - depth); // Mix LFO
             for (int channel = 0; channel < numChannels; ++channel)
             {
                 float inputSample = inputBlock.getSample(channel, sample);
@@ -43,7 +161,7 @@ public:
     void setDepth(float newDepth) { depth = newDepth; }
 
 private:
-    juce::dsp::Oscillator<float> lfo;
+    SineLFO lfo;
     float rate = 500.0f;
     float depth = 1.0f;
     double sampleRate = 44100.0;
@@ -107,8 +225,6 @@ private:
 class Tremolo
 {
 public:
-    Tremolo() { lfo.initialise([](float x) { return std::sin(x); }, 128); }
-
     void prepare(const juce::dsp::ProcessSpec& spec)
     {
         lfo.prepare(spec);
@@ -128,12 +244,12 @@ public:
 
         for (int sample = 0; sample < numSamples; ++sample)
         {
-            float lfoSample = (lfo.processSample(0.0f) + 1.0f) * 0.5f; // 0 to 1
+            float lfoSample = (lfo.processSample() + 1.0f) * 0.5f; // 0 to 1
             float gainValue = 1.0f - (depth * lfoSample);
             gain.setGainLinear(gainValue);
             gain.processSample(inputBlock.getSample(0, sample)); // Just to advance gain processor
         }
-        
+
         juce::dsp::ProcessContextReplacing<float> gainContext(outputBlock);
         gainContext.isBypassed = context.isBypassed;
         outputBlock.copyFrom(inputBlock); // Copy input to output first
@@ -146,7 +262,7 @@ public:
     void setDepth(float newDepth) { depth = newDepth; }
 
 private:
-    juce::dsp::Oscillator<float> lfo;
+    SineLFO lfo;
     juce::dsp::Gain<float> gain;
     float rate = 5.0f;
     float depth = 0.5f;
@@ -157,19 +273,23 @@ private:
 class MultibandCompressor
 {
 public:
-    using StereoFilter = juce::dsp::ProcessorDuplicator<
-        juce::dsp::IIR::Filter<float>,
-        juce::dsp::IIR::Coefficients<float>>;
+    void carveFrom(DSPArena& arena, const juce::dsp::ProcessSpec& spec)
+    {
+        numChannels = static_cast<size_t>(spec.numChannels);
+        maxSamples  = static_cast<size_t>(spec.maximumBlockSize);
+
+        lowBuf  = arena.carveChannels<float>("MultibandCompressor", numChannels, maxSamples);
+        midBuf  = arena.carveChannels<float>("MultibandCompressor", numChannels, maxSamples);
+        highBuf = arena.carveChannels<float>("MultibandCompressor", numChannels, maxSamples);
+
+        for (auto* f : { &lowLP, &midHP, &midLP, &highHP })
+            f->carveFrom(arena, "MultibandCompressor", numChannels);
+    }
 
     void prepare(const juce::dsp::ProcessSpec& spec)
     {
         sampleRate = spec.sampleRate;
 
-        lowLP.prepare(spec);
-        midHP.prepare(spec);
-        midLP.prepare(spec);
-        highHP.prepare(spec);
-
         lowComp.prepare(spec);
         midComp.prepare(spec);
         highComp.prepare(spec);
@@ -177,13 +297,8 @@ public:
         makeupGain.prepare(spec);
         makeupGain.setRampDurationSeconds(0.01);
 
-        int maxSamples = static_cast<int>(spec.maximumBlockSize);
-        int numCh      = static_cast<int>(spec.numChannels);
-        lowBuf.setSize(numCh, maxSamples);
-        midBuf.setSize(numCh, maxSamples);
-        highBuf.setSize(numCh, maxSamples);
-
         updateFilters();
+        reset();
     }
 
     template <typename ProcessContext>
@@ -193,36 +308,32 @@ public:
 
         const auto& inBlock = context.getInputBlock();
         auto& outBlock      = context.getOutputBlock();
-        const int numSamples  = static_cast<int>(inBlock.getNumSamples());
-        const int numChannels = static_cast<int>(inBlock.getNumChannels());
+        const size_t numSamples = inBlock.getNumSamples();
+        const size_t channels   = juce::jmin(inBlock.getNumChannels(), numChannels);
+        jassert(numSamples <= maxSamples);
 
         // Copy input into the three band buffers
-        for (int ch = 0; ch < numChannels; ++ch)
+        for (size_t ch = 0; ch < channels; ++ch)
         {
-            lowBuf.copyFrom(ch, 0, inBlock.getChannelPointer(ch), numSamples);
-            midBuf.copyFrom(ch, 0, inBlock.getChannelPointer(ch), numSamples);
-            highBuf.copyFrom(ch, 0, inBlock.getChannelPointer(ch), numSamples);
+            const float* in = inBlock.getChannelPointer(ch);
+            std::copy(in, in + numSamples, lowBuf[ch]);
+            std::copy(in, in + numSamples, midBuf[ch]);
+            std::copy(in, in + numSamples, highBuf[ch]);
         }
 
-        juce::dsp::AudioBlock<float> lowBlock(lowBuf.getArrayOfWritePointers(),
-                                               static_cast<size_t>(numChannels),
-                                               static_cast<size_t>(numSamples));
-        juce::dsp::AudioBlock<float> midBlock(midBuf.getArrayOfWritePointers(),
-                                               static_cast<size_t>(numChannels),
-                                               static_cast<size_t>(numSamples));
-        juce::dsp::AudioBlock<float> highBlock(highBuf.getArrayOfWritePointers(),
-                                                static_cast<size_t>(numChannels),
-                                                static_cast<size_t>(numSamples));
+        juce::dsp::AudioBlock<float> lowBlock(lowBuf, channels, numSamples);
+        juce::dsp::AudioBlock<float> midBlock(midBuf, channels, numSamples);
+        juce::dsp::AudioBlock<float> highBlock(highBuf, channels, numSamples);
 
         juce::dsp::ProcessContextReplacing<float> lowCtx(lowBlock);
         juce::dsp::ProcessContextReplacing<float> midCtx(midBlock);
         juce::dsp::ProcessContextReplacing<float> highCtx(highBlock);
 
         // Crossover filtering
-        lowLP.process(lowCtx);
-        midHP.process(midCtx);
-        midLP.process(midCtx);
-        highHP.process(highCtx);
+        lowLP.process(lowBlock);
+        midHP.process(midBlock);
+        midLP.process(midBlock);
+        highHP.process(highBlock);
 
         // Compression per band
         lowComp.process(lowCtx);
@@ -230,13 +341,13 @@ public:
         highComp.process(highCtx);
 
         // Sum bands into output
-        for (int ch = 0; ch < numChannels; ++ch)
+        for (size_t ch = 0; ch < channels; ++ch)
         {
-            const float* low  = lowBuf.getReadPointer(ch);
-            const float* mid  = midBuf.getReadPointer(ch);
-            const float* high = highBuf.getReadPointer(ch);
+            const float* low  = lowBuf[ch];
+            const float* mid  = midBuf[ch];
+            const float* high = highBuf[ch];
             float* out        = outBlock.getChannelPointer(ch);
-            for (int i = 0; i < numSamples; ++i)
+            for (size_t i = 0; i < numSamples; ++i)
                 out[i] = low[i] + mid[i] + high[i];
         }
 
@@ -263,19 +374,24 @@ public:
 private:
     void updateFilters()
     {
-        *lowLP.state  = *juce::dsp::IIR::Coefficients<float>::makeLowPass(sampleRate, 300.0f);
-        *midHP.state  = *juce::dsp::IIR::Coefficients<float>::makeHighPass(sampleRate, 300.0f);
-        *midLP.state  = *juce::dsp::IIR::Coefficients<float>::makeLowPass(sampleRate, 3000.0f);
-        *highHP.state = *juce::dsp::IIR::Coefficients<float>::makeHighPass(sampleRate, 3000.0f);
+        using Coeffs = juce::dsp::IIR::ArrayCoefficients<float>;
+        lowLP.setCoefficients(Coeffs::makeLowPass(sampleRate, 300.0f));
+        midHP.setCoefficients(Coeffs::makeHighPass(sampleRate, 300.0f));
+        midLP.setCoefficients(Coeffs::makeLowPass(sampleRate, 3000.0f));
+        highHP.setCoefficients(Coeffs::makeHighPass(sampleRate, 3000.0f));
     }
 
     double sampleRate = 44100.0;
+    size_t numChannels = 0;
+    size_t maxSamples = 0;
 
-    StereoFilter lowLP, midHP, midLP, highHP;
+    Biquad lowLP, midHP, midLP, highHP;
     juce::dsp::Compressor<float> lowComp, midComp, highComp;
     juce::dsp::Gain<float> makeupGain;
 
-    juce::AudioBuffer<float> lowBuf, midBuf, highBuf;
+    float** lowBuf  = nullptr;
+    float** midBuf  = nullptr;
+    float** highBuf = nullptr;
 };
 
 //==============================================================================
@@ -283,18 +399,18 @@ private:
 class WahWah
 {
 public:
-    WahWah() { lfo.initialise([](float x) { return std::sin(x); }, 128); }
+    void carveFrom(DSPArena& arena, const juce::dsp::ProcessSpec& spec)
+    {
+        filter.carveFrom(arena, "WahWah", static_cast<size_t>(spec.numChannels));
+    }
 
     void prepare(const juce::dsp::ProcessSpec& spec)
     {
         sampleRate = spec.sampleRate;
         lfo.prepare(spec);
-        for (auto& f : filters)
-        {
-            f.prepare(spec);
-            f.coefficients = juce::dsp::IIR::Coefficients<float>::makeBandPass(
-                sampleRate, centerFreq, resonance);
-        }
+        filter.setCoefficients(juce::dsp::IIR::ArrayCoefficients<float>::makeBandPass(
+            sampleRate, centerFreq, resonance));
+        filter.reset();
     }
 
     template <typename ProcessContext>
@@ -310,23 +426,21 @@ public:
 
         for (int s = 0; s < numSamples; ++s)
         {
-            const float lfoVal = lfo.processSample(0.0f); // -1 to +1
+            const float lfoVal = lfo.processSample(); // -1 to +1
 
             // Update filter coefficients every 8 samples to reduce CPU load
             if ((coeffCounter++ & 7) == 0)
             {
                 const float freq = juce::jlimit(200.0f, 4000.0f,
                                                 centerFreq + lfoVal * depth * sweepRange);
-                const auto newCoeffs = juce::dsp::IIR::Coefficients<float>::makeBandPass(
-                    sampleRate, freq, resonance);
-                for (auto& f : filters)
-                    f.coefficients = newCoeffs;
+                filter.setCoefficients(juce::dsp::IIR::ArrayCoefficients<float>::makeBandPass(
+                    sampleRate, freq, resonance));
             }
 
             for (int ch = 0; ch < numChannels; ++ch)
             {
                 const float in       = inBlock.getSample(ch, s);
-                const float filtered = filters[ch].processSample(in);
+                const float filtered = filter.processSample(static_cast<size_t>(ch), in);
                 outBlock.setSample(ch, s, (1.0f - mix) * in + mix * filtered);
             }
         }
@@ -335,7 +449,7 @@ public:
     void reset()
     {
         lfo.reset();
-        for (auto& f : filters) f.reset();
+        filter.reset();
         coeffCounter = 0;
     }
 
@@ -348,8 +462,8 @@ public:
 private:
     static constexpr float sweepRange = 1500.0f;
 
-    juce::dsp::Oscillator<float> lfo;
-    std::array<juce::dsp::IIR::Filter<float>, 2> filters;
+    SineLFO lfo;
+    Biquad filter; // one coefficient set shared by every channel
 
     double sampleRate = 44100.0;
     float rate        = 2.0f;
@@ -365,17 +479,18 @@ private:
 class Fuzz
 {
 public:
-    using StereoFilter = juce::dsp::ProcessorDuplicator<
-        juce::dsp::IIR::Filter<float>,
-        juce::dsp::IIR::Coefficients<float>>;
+    void carveFrom(DSPArena& arena, const juce::dsp::ProcessSpec& spec)
+    {
+        toneFilter.carveFrom(arena, "Fuzz", static_cast<size_t>(spec.numChannels));
+    }
 
     void prepare(const juce::dsp::ProcessSpec& spec)
     {
         sampleRate = spec.sampleRate;
-        toneFilter.prepare(spec);
         outputGain.prepare(spec);
         outputGain.setRampDurationSeconds(0.01);
         updateToneFilter();
+        toneFilter.reset();
     }
 
     template <typename ProcessContext>
@@ -403,7 +518,7 @@ public:
 
         // Tone filter + output level applied to the output block
         juce::dsp::ProcessContextReplacing<float> outCtx(outBlock);
-        toneFilter.process(outCtx);
+        toneFilter.process(outBlock);
         outputGain.process(outCtx);
     }
 
@@ -414,16 +529,23 @@ public:
     }
 
     void setDrive(float newDrive)   { drive = juce::jlimit(1.0f, 100.0f, newDrive); }
-    void setTone(float newTone)     { tone = juce::jlimit(0.0f, 1.0f, newTone); updateToneFilter(); }
     void setLevel(float newLevelDb) { outputGain.setGainDecibels(newLevelDb); }
     void setMix(float newMix)       { mix = newMix; }
 
+    void setTone(float newTone)
+    {
+        newTone = juce::jlimit(0.0f, 1.0f, newTone);
+        if (newTone == tone) return;
+        tone = newTone;
+        updateToneFilter();
+    }
+
 private:
     void updateToneFilter()
     {
         if (sampleRate <= 0.0) return;
         const float cutoff = 500.0f + tone * 8000.0f;
-        *toneFilter.state = *juce::dsp::IIR::Coefficients<float>::makeLowPass(sampleRate, cutoff);
+        toneFilter.setCoefficients(juce::dsp::IIR::ArrayCoefficients<float>::makeLowPass(sampleRate, cutoff));
     }
 
     double sampleRate = 44100.0;
@@ -431,42 +553,444 @@ private:
     float tone  = 0.5f;
     float mix   = 1.0f;
 
-    StereoFilter toneFilter;
+    Biquad toneFilter;
     juce::dsp::Gain<float> outputGain;
 };
 
 //==============================================================================
-class MultiEffectProcessor : public juce::AudioProcessor
+// Feedback delay ("simplified tape delay"). Its 2-second ring buffer lives in
+// an arena owned by a LazyEffectState, so it only exists while the delay is in
+// use; the processor must stay bypassed while detached.
+class TapeDelay
 {
 public:
-    MultiEffectProcessor();
-    ~MultiEffectProcessor() override;
+    static constexpr double maxDelaySeconds = 2.0;
+    static constexpr double fadeInSeconds   = 0.02;
 
-    void prepareToPlay(double sampleRate, int samplesPerBlock) override;
-    void releaseResources() override;
-    bool isBusesLayoutSupported(const BusesLayout& layouts) const override;
-    void processBlock(juce::AudioBuffer<float>&, juce::MidiBuffer&) override;
+    void carveFrom(DSPArena& arena, const juce::dsp::ProcessSpec& spec)
+    {
+        numChannels  = static_cast<size_t>(spec.numChannels);
+        bufferLength = static_cast<int>(spec.sampleRate * maxDelaySeconds) + 1;
+        buffer = arena.carveChannels<float>("TapeDelay", numChannels, static_cast<size_t>(bufferLength));
+        writePos = 0;
+    }
 
-    juce::AudioProcessorEditor* createEditor() override;
-    bool hasEditor() const override;
+    void detach() noexcept { buffer = nullptr; }
 
-    const juce::String getName() const override;
-    bool acceptsMidi() const override;
-    bool producesMidi() const override;
-    bool isMidiEffect() const override;
-    double getTailLengthSeconds() const override;
+    /** Ramps the wet signal in from fully dry, so binding fresh memory never clicks. */
+    void startFadeIn() noexcept
+    {
+        wetFade.setCurrentAndTargetValue(0.0f);
+        wetFade.setTargetValue(1.0f);
+    }
 
-    int getNumPrograms() override;
-    int getCurrentProgram() override;
-    void setCurrentProgram(int index) override;
-    const juce::String getProgramName(int index) override;
-    void changeProgramName(int index, const juce::String& newName) override;
+    void prepare(const juce::dsp::ProcessSpec& spec)
+    {
+        sampleRate = spec.sampleRate;
+        wetFade.reset(sampleRate, fadeInSeconds);
+        wetFade.setCurrentAndTargetValue(1.0f);
+        reset();
+    }
 
-    void getStateInformation(juce::MemoryBlock& destData) override;
-    void setStateInformation(const void* data, int sizeInBytes) override;
+    template <typename ProcessContext>
+    void process(const ProcessContext& context)
+    {
+        if (context.isBypassed) return;
 
-    static juce::AudioProcessorValueTreeState::ParameterLayout createParameterLayout();
-    juce::AudioProcessorValueTreeState apvts { *this, nullptr, "Parameters", createParameterLayout() };
+        const auto& inBlock  = context.getInputBlock();
+        auto& outBlock       = context.getOutputBlock();
+        const int numSamples = static_cast<int>(inBlock.getNumSamples());
+        const size_t channels = juce::jmin(inBlock.getNumChannels(), numChannels);
+
+        const int delaySamples = juce::jlimit(1, bufferLength - 1,
+                                              static_cast<int>(sampleRate * delayTimeMs / 1000.0));
+
+        for (size_t ch = 0; ch < channels; ++ch)
+        {
+            const float* in = inBlock.getChannelPointer(ch);
+            float* out      = outBlock.getChannelPointer(ch);
+            float* line     = buffer[ch];
+            int pos = writePos;
+            auto fade = wetFade; // every channel follows the same ramp
+
+            for (int s = 0; s < numSamples; ++s)
+            {
+                int readPos = pos - delaySamples;
+                if (readPos < 0) readPos += bufferLength;
+
+                const float wet           = mix * fade.getNextValue();
+                const float delayedSample = line[readPos];
+                const float inputSample   = in[s];
+                line[pos] = inputSample + delayedSample * feedback;
+                out[s]    = inputSample * (1.0f - wet) + delayedSample * wet;
+
+                if (++pos == bufferLength) pos = 0;
+            }
+        }
+
+        wetFade.skip(numSamples);
+        writePos = (writePos + numSamples) % bufferLength;
+    }
+
+    void reset()
+    {
+        writePos = 0;
+        if (buffer != nullptr)
+            for (size_t ch = 0; ch < numChannels; ++ch)
+                std::fill(buffer[ch], buffer[ch] + bufferLength, 0.0f);
+    }
+
+    void setDelayTime(float ms)     { delayTimeMs = ms; }
+    void setFeedback(float newFbk)  { feedback = newFbk; }
+    void setMix(float newMix)       { mix = newMix; }
+
+private:
+    float** buffer = nullptr;
+    size_t numChannels = 0;
+    int bufferLength = 1;
+    int writePos = 0;
+
+    double sampleRate = 44100.0;
+    float delayTimeMs = 300.0f;
+    float feedback    = 0.4f;
+    float mix         = 0.5f;
+    juce::SmoothedValue<float> wetFade { 1.0f };
+};
+
+//==============================================================================
+// Freeverb-style room reverb – the same algorithm, tunings and parameter
+// scaling as juce::dsp::Reverb, but with its comb and all-pass buffers carved
+// from an arena owned by a LazyEffectState. Must stay bypassed while detached.
+class RoomReverb
+{
+public:
+    using Parameters = juce::Reverb::Parameters;
+
+    void detach() noexcept
+    {
+        for (auto& channel : comb)    for (auto& c : channel) c.buffer = nullptr;
+        for (auto& channel : allPass) for (auto& a : channel) a.buffer = nullptr;
+    }
+
+    /** Starts fully dry and lets the 10 ms parameter smoothing glide to the real mix. */
+    void startFadeIn() noexcept
+    {
+        dryGain .setCurrentAndTargetValue(1.0f);
+        wetGain1.setCurrentAndTargetValue(0.0f);
+        wetGain2.setCurrentAndTargetValue(0.0f);
+        setParameters(parameters);
+    }
+
+    void carveFrom(DSPArena& arena, const juce::dsp::ProcessSpec& spec)
+    {
+        static constexpr int combTunings[numCombs]       = { 1116, 1188, 1277, 1356, 1422, 1491, 1557, 1617 };
+        static constexpr int allPassTunings[numAllPasses] = { 556, 441, 341, 225 };
+        static constexpr int stereoSpread = 23;
+
+        const int intSampleRate = static_cast<int>(spec.sampleRate);
+        numChannels = juce::jmin(static_cast<int>(spec.numChannels), 2);
+
+        for (int ch = 0; ch < numChannels; ++ch)
+        {
+            const int spread = ch * stereoSpread;
+            for (int i = 0; i < numCombs; ++i)
+                comb[ch][i].carveFrom(arena, (intSampleRate * (combTunings[i] + spread)) / 44100);
+            for (int i = 0; i < numAllPasses; ++i)
+                allPass[ch][i].carveFrom(arena, (intSampleRate * (allPassTunings[i] + spread)) / 44100);
+        }
+    }
+
+    void prepare(const juce::dsp::ProcessSpec& spec)
+    {
+        const double smoothTime = 0.01;
+        damping .reset(spec.sampleRate, smoothTime);
+        feedback.reset(spec.sampleRate, smoothTime);
+        dryGain .reset(spec.sampleRate, smoothTime);
+        wetGain1.reset(spec.sampleRate, smoothTime);
+        wetGain2.reset(spec.sampleRate, smoothTime);
+        setParameters(parameters);
+        reset();
+    }
+
+    template <typename ProcessContext>
+    void process(const ProcessContext& context)
+    {
+        if (context.isBypassed) return;
+
+        const auto& inBlock = context.getInputBlock();
+        auto& outBlock      = context.getOutputBlock();
+        const int numSamples = static_cast<int>(outBlock.getNumSamples());
+
+        if (context.usesSeparateInputAndOutputBlocks())
+            outBlock.copyFrom(inBlock);
+
+        if (outBlock.getNumChannels() == 1 || numChannels == 1)
+            processMono(outBlock.getChannelPointer(0), numSamples);
+        else
+            processStereo(outBlock.getChannelPointer(0), outBlock.getChannelPointer(1), numSamples);
+    }
+
+    void reset()
+    {
+        for (int ch = 0; ch < numChannels; ++ch)
+        {
+            for (auto& c : comb[ch])    c.clear();
+            for (auto& a : allPass[ch]) a.clear();
+        }
+    }
+
+    void setParameters(const Parameters& newParams)
+    {
+        const float wetScaleFactor = 3.0f;
+        const float dryScaleFactor = 2.0f;
+        const float roomScaleFactor = 0.28f;
+        const float roomOffset      = 0.7f;
+        const float dampScaleFactor = 0.4f;
+
+        const float wet = newParams.wetLevel * wetScaleFactor;
+        dryGain .setTargetValue(newParams.dryLevel * dryScaleFactor);
+        wetGain1.setTargetValue(0.5f * wet * (1.0f + newParams.width));
+        wetGain2.setTargetValue(0.5f * wet * (1.0f - newParams.width));
+
+        const bool frozen = newParams.freezeMode >= 0.5f;
+        gain = frozen ? 0.0f : 0.015f;
+        damping .setTargetValue(frozen ? 0.0f : newParams.damping * dampScaleFactor);
+        feedback.setTargetValue(frozen ? 1.0f : newParams.roomSize * roomScaleFactor + roomOffset);
+
+        parameters = newParams;
+    }
+
+private:
+    void processStereo(float* left, float* right, int numSamples) noexcept
+    {
+        for (int i = 0; i < numSamples; ++i)
+        {
+            const float input = (left[i] + right[i]) * gain;
+            float outL = 0.0f, outR = 0.0f;
+
+            const float damp    = damping.getNextValue();
+            const float feedbck = feedback.getNextValue();
+
+            for (int j = 0; j < numCombs; ++j)
+            {
+                outL += comb[0][j].process(input, damp, feedbck);
+                outR += comb[1][j].process(input, damp, feedbck);
+            }
+
+            for (int j = 0; j < numAllPasses; ++j)
+            {
+                outL = allPass[0][j].process(outL);
+                outR = allPass[1][j].process(outR);
+            }
+
+            const float dry  = dryGain.getNextValue();
+            const float wet1 = wetGain1.getNextValue();
+            const float wet2 = wetGain2.getNextValue();
+
+            left[i]  = outL * wet1 + outR * wet2 + left[i]  * dry;
+            right[i] = outR * wet1 + outL * wet2 + right[i] * dry;
+        }
+    }
+
+    void processMono(float* samples, int numSamples) noexcept
+    {
+        for (int i = 0; i < numSamples; ++i)
+        {
+            const float input = samples[i] * gain;
+            float output = 0.0f;
+
+            const float damp    = damping.getNextValue();
+            const float feedbck = feedback.getNextValue();
+
+            for (int j = 0; j < numCombs; ++j)
+                output += comb[0][j].process(input, damp, feedbck);
+
+            for (int j = 0; j < numAllPasses; ++j)
+                output = allPass[0][j].process(output);
+
+            const float dry  = dryGain.getNextValue();
+            const float wet1 = wetGain1.getNextValue();
+
+            samples[i] = output * wet1 + samples[i] * dry;
+        }
+    }
+
+    struct CombFilter
+    {
+        void carveFrom(DSPArena& arena, int size)
+        {
+            bufferSize = juce::jmax(1, size);
+            buffer = arena.carve<float>("RoomReverb", static_cast<size_t>(bufferSize));
+            bufferIndex = 0;
+            last = 0.0f;
+        }
+
+        void clear() noexcept
+        {
+            last = 0.0f;
+            bufferIndex = 0;
+            if (buffer != nullptr)
+                std::fill(buffer, buffer + bufferSize, 0.0f);
+        }
+
+        float process(float input, float damp, float feedbackLevel) noexcept
+        {
+            const float output = buffer[bufferIndex];
+            last = (output * (1.0f - damp)) + (last * damp);
+            JUCE_UNDENORMALISE(last);
+
+            float temp = input + (last * feedbackLevel);
+            JUCE_UNDENORMALISE(temp);
+            buffer[bufferIndex] = temp;
+            if (++bufferIndex == bufferSize) bufferIndex = 0;
+            return output;
+        }
+
+        float* buffer = nullptr;
+        int bufferSize = 1, bufferIndex = 0;
+        float last = 0.0f;
+    };
+
+    struct AllPassFilter
+    {
+        void carveFrom(DSPArena& arena, int size)
+        {
+            bufferSize = juce::jmax(1, size);
+            buffer = arena.carve<float>("RoomReverb", static_cast<size_t>(bufferSize));
+            bufferIndex = 0;
+        }
+
+        void clear() noexcept
+        {
+            bufferIndex = 0;
+            if (buffer != nullptr)
+                std::fill(buffer, buffer + bufferSize, 0.0f);
+        }
+
+        float process(float input) noexcept
+        {
+            const float bufferedValue = buffer[bufferIndex];
+            float temp = input + (bufferedValue * 0.5f);
+            JUCE_UNDENORMALISE(temp);
+            buffer[bufferIndex] = temp;
+            if (++bufferIndex == bufferSize) bufferIndex = 0;
+            return bufferedValue - input;
+        }
+
+        float* buffer = nullptr;
+        int bufferSize = 1, bufferIndex = 0;
+    };
+
+    static constexpr int numCombs = 8, numAllPasses = 4;
+
+    CombFilter comb[2][numCombs];
+    AllPassFilter allPass[2][numAllPasses];
+    int numChannels = 0;
+
+    Parameters parameters;
+    float gain = 0.015f;
+    juce::SmoothedValue<float> damping, feedback, dryGain, wetGain1, wetGain2;
+};
+
+//==============================================================================
+/**
+ * Flat copy of every plugin parameter (plain values, not normalised), indexed
+ * in createParameterLayout() order. The DSP side only ever consumes these, so
+ * an engine can be driven from the APVTS, a preset or a MIDI slot alike.
+ */
+struct ParameterSnapshot
+{
+    enum Index
+    {
+        BitcrusherOn, BitcrusherDepth, BitcrusherRate,
+        RingModOn, RingModRate, RingModDepth,
+        PhaserOn, PhaserRate, PhaserDepth, PhaserFeedback, PhaserMix,
+        ChorusOn, ChorusRate, ChorusDepth, ChorusMix,
+        TremoloOn, TremoloRate, TremoloDepth,
+        DelayOn, DelayTime, DelayFeedback, DelayMix,
+        ReverbOn, ReverbRoomSize, ReverbDamping, ReverbWetLevel, ReverbDryLevel, ReverbWidth,
+        CompressorOn, CompressorLowThresh, CompressorMidThresh, CompressorHighThresh, CompressorRatio, CompressorAttack, CompressorRelease, CompressorMakeup,
+        WahOn, WahRate, WahDepth, WahFreq, WahResonance, WahMix,
+        FuzzOn, FuzzDrive, FuzzTone, FuzzLevel, FuzzMix,
+        NumParameters
+    };
+
+    static const char* const ids[NumParameters];
+
+    float operator[](Index index) const noexcept { return values[static_cast<size_t>(index)]; }
+    bool isOn(Index index) const noexcept        { return values[static_cast<size_t>(index)] >= 0.5f; }
+
+    std::array<float, NumParameters> values {};
+};
+
+//==============================================================================
+/**
+ * MIDI program slots, pre-decoded from the preset bank so that a Program
+ * Change on the audio thread is a plain array copy. Slot = bank * 128 + program,
+ * where the bank comes from Bank Select (CC 0 MSB, CC 32 LSB).
+ */
+struct ProgramSlotTable
+{
+    static constexpr int programsPerBank = 128;
+    static constexpr int numBanks        = 4;
+    static constexpr int numSlots        = programsPerBank * numBanks;
+
+    std::array<ParameterSnapshot, numSlots> snapshots {};
+    std::array<bool, numSlots> used {};
+};
+
+//==============================================================================
+/**
+ * One complete effect chain with its memory: the arena holding the light
+ * per-processor state plus lazily allocated delay/reverb buffers. The
+ * processor runs two of these through PresetSwitchEngine so that presets can
+ * change without cutting tails.
+ */
+class EffectEngine
+{
+public:
+    using Snapshot = ParameterSnapshot;
+    using Taps = SignalTaps;
+
+    /** Audio stopped. Lays out the arena and prepares the chain for params. */
+    void prepare(const juce::dsp::ProcessSpec& newSpec, const Snapshot& params);
+
+    /** Frees the delay/reverb buffers (audio stopped, or engine not processing). */
+    void release();
+
+    /** How long delay/reverb must stay switched off before their buffers are freed. */
+    void setIdleReleaseSeconds(double seconds) noexcept
+    {
+        delayState.setIdleReleaseSeconds(seconds);
+        reverbState.setIdleReleaseSeconds(seconds);
+    }
+
+    double getIdleReleaseSeconds() const noexcept { return delayState.getIdleReleaseSeconds(); }
+
+    /** Audio stopped: offline renders allocate delay/reverb inline (see LazyEffectState). */
+    void setNonRealtime(bool isNonRealtime) noexcept
+    {
+        delayState.setSynchronous(isNonRealtime);
+        reverbState.setSynchronous(isNonRealtime);
+    }
+
+    /** Loads a preset into an engine that is not processing: allocates delay/reverb
+        if the preset uses them, clears all state and jumps every parameter. */
+    void load(const Snapshot& params);
+
+    /** Audio thread: takes effect at the next process() call. */
+    void setParameters(const Snapshot& params) noexcept { current = params; }
+
+    /** Audio thread: jumps to a preset without allocating. Bound delay/reverb memory is
+        cleared and reused; otherwise it is requested and fades in once allocated. */
+    void loadRealtime(const Snapshot& params) noexcept;
+
+    /** Audio thread. With taps, the chain runs stage by stage and the signal after
+        Fuzz and after the compressor is copied to them. */
+    void process(const juce::dsp::ProcessContextReplacing<float>& context, Taps* taps = nullptr) noexcept;
+
+    /** Arena slices per processor plus resident delay/reverb memory. */
+    DSPArena::Report getMemoryReport() const;
 
 private:
     // Define Effect Chain Order
@@ -495,70 +1019,199 @@ private:
         juce::dsp::Phaser<float>,
         juce::dsp::Chorus<float>,
         Tremolo,
-        juce::dsp::DelayLine<float>, // Simplified Tape Delay
-        juce::dsp::Reverb>;         // Basic Reverb
+        TapeDelay,                   // Simplified Tape Delay
+        RoomReverb>;                 // Basic Reverb
+
+    static constexpr const char* stageNames[NumEffects] = {
+        "Bitcrusher", "Fuzz", "MultibandCompressor", "RingModulator", "WahWah",
+        "Phaser", "Chorus", "Tremolo", "TapeDelay", "RoomReverb"
+    };
+
+    // Same as ProcessorChain::process, for a subset of the stages, with a trace zone per stage
+    template <size_t... Indices>
+    void processStages(const juce::dsp::ProcessContextReplacing<float>& context, std::index_sequence<Indices...>) noexcept
+    {
+        (processStage<Indices>(context), ...);
+    }
+
+    template <size_t Index>
+    void processStage(const juce::dsp::ProcessContextReplacing<float>& context) noexcept
+    {
+        DSP4G_TRACE_ZONE(stageNames[Index]);
+        auto stageContext = context;
+        stageContext.isBypassed = context.isBypassed || effectChain.template isBypassed<Index>();
+        effectChain.template get<Index>().process(stageContext);
+    }
+
+    void applyParameters() noexcept;                     // Pushes `current` into the chain
+    void carveChain(const juce::dsp::ProcessSpec& spec); // Lays every processor out in the arena
 
     EffectChain effectChain;
 
-    // Parameters (pointers for quick access in processBlock)
-    juce::AudioParameterBool* bitcrusherOn = nullptr;
-    juce::AudioParameterFloat* bitcrusherDepth = nullptr;
-    juce::AudioParameterFloat* bitcrusherRate = nullptr;
-
-    juce::AudioParameterBool* ringModOn = nullptr;
-    juce::AudioParameterFloat* ringModRate = nullptr;
-    juce::AudioParameterFloat* ringModDepth = nullptr;
-
-    juce::AudioParameterBool* phaserOn = nullptr;
-    juce::AudioParameterFloat* phaserRate = nullptr;
-    juce::AudioParameterFloat* phaserDepth = nullptr;
-    juce::AudioParameterFloat* phaserFeedback = nullptr;
-    juce::AudioParameterFloat* phaserMix = nullptr;
-
-    juce::AudioParameterBool* chorusOn = nullptr;
-    juce::AudioParameterFloat* chorusRate = nullptr;
-    juce::AudioParameterFloat* chorusDepth = nullptr;
-    juce::AudioParameterFloat* chorusMix = nullptr;
-
-    juce::AudioParameterBool* tremoloOn = nullptr;
-    juce::AudioParameterFloat* tremoloRate = nullptr;
-    juce::AudioParameterFloat* tremoloDepth = nullptr;
-    
-    juce::AudioParameterBool* delayOn = nullptr;
-    juce::AudioParameterFloat* delayTime = nullptr;
-    juce::AudioParameterFloat* delayFeedback = nullptr;
-    juce::AudioParameterFloat* delayMix = nullptr;
-
-    juce::AudioParameterBool* reverbOn = nullptr;
-    juce::AudioParameterFloat* reverbRoomSize = nullptr;
-    juce::AudioParameterFloat* reverbDamping = nullptr;
-    juce::AudioParameterFloat* reverbWetLevel = nullptr;
-    juce::AudioParameterFloat* reverbDryLevel = nullptr;
-    juce::AudioParameterFloat* reverbWidth = nullptr;
-
-    juce::AudioParameterBool*  compressorOn = nullptr;
-    juce::AudioParameterFloat* compressorLowThresh = nullptr;
-    juce::AudioParameterFloat* compressorMidThresh = nullptr;
-    juce::AudioParameterFloat* compressorHighThresh = nullptr;
-    juce::AudioParameterFloat* compressorRatio = nullptr;
-    juce::AudioParameterFloat* compressorAttack = nullptr;
-    juce::AudioParameterFloat* compressorRelease = nullptr;
-    juce::AudioParameterFloat* compressorMakeup = nullptr;
-
-    juce::AudioParameterBool*  wahOn = nullptr;
-    juce::AudioParameterFloat* wahRate = nullptr;
-    juce::AudioParameterFloat* wahDepth = nullptr;
-    juce::AudioParameterFloat* wahFreq = nullptr;
-    juce::AudioParameterFloat* wahResonance = nullptr;
-    juce::AudioParameterFloat* wahMix = nullptr;
-
-    juce::AudioParameterBool*  fuzzOn = nullptr;
-    juce::AudioParameterFloat* fuzzDrive = nullptr;
-    juce::AudioParameterFloat* fuzzTone = nullptr;
-    juce::AudioParameterFloat* fuzzLevel = nullptr;
-    juce::AudioParameterFloat* fuzzMix = nullptr;
-
-    void updateParameters(); // Function to update DSP based on APVTS
+    // Single aligned block holding every processor's buffers (see carveChain())
+    DSPArena arena;
+
+    // Delay and reverb buffers are only allocated while those effects are in use
+    LazyEffectState<TapeDelay> delayState { "TapeDelay (lazy)" };
+    LazyEffectState<RoomReverb> reverbState { "RoomReverb (lazy)" };
+
+    juce::dsp::ProcessSpec spec {};
+    Snapshot current;
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(EffectEngine)
+};
+
+//==============================================================================
+class MultiEffectProcessor : public juce::AudioProcessor
+{
+public:
+    MultiEffectProcessor();
+    ~MultiEffectProcessor() override;
+
+    void prepareToPlay(double sampleRate, int samplesPerBlock) override;
+    void releaseResources() override;
+    bool isBusesLayoutSupported(const BusesLayout& layouts) const override;
+    void processBlock(juce::AudioBuffer<float>&, juce::MidiBuffer&) override;
+
+    juce::AudioProcessorEditor* createEditor() override;
+    bool hasEditor() const override;
+
+    const juce::String getName() const override;
+    bool acceptsMidi() const override;
+    bool producesMidi() const override;
+    bool isMidiEffect() const override;
+    double getTailLengthSeconds() const override;
+
+    int getNumPrograms() override;
+    int getCurrentProgram() override;
+    void setCurrentProgram(int index) override;
+    const juce::String getProgramName(int index) override;
+    void changeProgramName(int index, const juce::String& newName) override;
+
+    void getStateInformation(juce::MemoryBlock& destData) override;
+    void setStateInformation(const void* data, int sizeInBytes) override;
+
+    static juce::AudioProcessorValueTreeState::ParameterLayout createParameterLayout();
+
+    /** Per-instance DSP memory footprint: arena slices per processor (both engines) plus
+        the object itself. Stock JUCE processors (Phaser, Chorus, the band Compressors) keep
+        their own small internal state and are only counted through the object size. */
+    DSPArena::Report getMemoryReport() const;
+
+    juce::AudioProcessorValueTreeState apvts { *this, nullptr, "Parameters", createParameterLayout() };
+
+    PresetManager& getPresetManager() noexcept { return presetManager; }
+
+    /** Message thread: decodes a bank preset into a MIDI program slot (-1 clears it)
+        and publishes the slot table to the audio thread. */
+    void assignProgramSlot(int slot, int presetIndex);
+
+    /** Message thread: slot n = bank preset n, for as many presets as there are slots. */
+    void assignProgramSlotsFromBank();
+
+    /** Length of the equal-power crossfade used when switching presets; saved with the state. */
+    void setPresetCrossfadeSeconds(double seconds);
+    double getPresetCrossfadeSeconds() const noexcept { return engines.getCrossfadeSeconds(); }
+
+    /** How long delay/reverb must stay switched off before their memory is freed; saved with the state. */
+    void setIdleReleaseSeconds(double seconds);
+    double getIdleReleaseSeconds() const noexcept;
+
+    /** CC / pitch bend / aftertouch mappings; edited from the editor, saved with the state. */
+    MidiLearn& getMidiLearn() noexcept { return midiLearn; }
+
+    /** Audio-to-UI taps (input, after Fuzz, after the compressor, output). The audio
+        thread only writes them while analysis is enabled, i.e. while the editor is open. */
+    SignalTaps& getSignalTaps() noexcept { return signalTaps; }
+    void setAnalysisEnabled(bool shouldBeEnabled) noexcept { analysisEnabled.store(shouldBeEnabled, std::memory_order_release); }
+
+    /** processBlock time against the buffer period, with a parameter snapshot per overrun;
+        dumped to a file only when the profiling menu switches it on. */
+    DeadlineMonitor& getDeadlineMonitor() noexcept { return deadlineMonitor; }
+
+    /** Opt-in recording of every block's input, MIDI and parameters, for DSP4GuitarReplay. */
+    BlockCapture& getBlockCapture() noexcept { return blockCapture; }
+
+private:
+    /** State that is not a parameter: the MIDI mappings and the settings. */
+    juce::ValueTree createExtraState() const;
+    void restoreExtraState(const juce::ValueTree& extra);
+
+    /** Reads every parameter's current plain value (audio thread, lock-free). */
+    void captureParameters(ParameterSnapshot& snapshot) const noexcept;
+
+    /** Audio thread: replaces captured values the audio thread itself changed until the
+        ParameterMirror has written them back to the APVTS. */
+    void applyOverrides(ParameterSnapshot& snapshot, bool mirrored) noexcept;
+
+    /** Audio thread: mutes a block holding NaN or infinity (so it cannot reach the host)
+        and logs it, and logs runs of denormals that ScopedNoDenormals did not flush. */
+    void checkOutput(juce::AudioBuffer<float>& buffer) noexcept;
+
+    /** Audio thread: crossfades to a MIDI program slot at the current sample. */
+    void switchToProgramSlot(const ParameterSnapshot& target, ParameterSnapshot& params) noexcept;
+
+    /** Audio thread: processes [start, end) of the block. While MIDI-controlled values
+        are ramping, renders in short steps and moves the ramps between steps. */
+    void renderSegment(const juce::dsp::AudioBlock<float>& block, size_t start, size_t end,
+                       ParameterSnapshot& params) noexcept;
+
+    /** Audio thread: starts a ramp towards the mapped value for every mapping of a controller. */
+    bool applyMidiControl(const MidiLearn::Table& mappings, MidiLearn::Source source, int number,
+                          int channel, float position, ParameterSnapshot& params) noexcept;
+
+    /** PresetManager hook: crossfades to the preset instead of jumping the running chain. */
+    void beginPresetSwitch(const float* normalisedValues);
+
+    void decodePreset(const float* normalisedValues, ParameterSnapshot& dest) const;
+
+    // Binary getStateInformation/setStateInformation (XML sessions still load)
+    PluginState stateCodec { *this };
+
+    // Raw APVTS values in layout order, for lock-free snapshots in processBlock
+    std::array<std::atomic<float>*, ParameterSnapshot::NumParameters> parameterValues {};
+
+    // Live + spare engine for gapless preset switching
+    PresetSwitchEngine<EffectEngine> engines;
+
+    // Binary preset bank; host programs map onto its presets (declared after apvts)
+    PresetManager presetManager { *this };
+
+    // MIDI program slots: edited on the message thread, published lock-free
+    ProgramSlotTable programSlotModel;
+    RealtimePublisher<ProgramSlotTable> programSlots;
+    int bankSelectMsb = 0, bankSelectLsb = 0; // audio thread
+
+    // Parameters changed on the audio thread, and their way back to the APVTS
+    ParameterMirror<ParameterSnapshot::NumParameters> parameterMirror { *this };
+    ParameterSnapshot overrideValues;                      // audio thread
+    std::bitset<ParameterSnapshot::NumParameters> overridden; // audio thread
+
+    // MIDI learn: mapped controllers ramp their parameters over a few milliseconds
+    MidiLearn midiLearn { *this };
+    std::array<juce::SmoothedValue<float>, ParameterSnapshot::NumParameters> midiRamps; // audio thread
+    std::bitset<ParameterSnapshot::NumParameters> ramping;                              // audio thread
+    static constexpr double midiRampSeconds = 0.005;
+    static constexpr size_t midiRampStepSamples = 32;
+
+    // Metering taps; blockTaps is &signalTaps for blocks processed while analysis is on
+    SignalTaps signalTaps;
+    std::atomic<bool> analysisEnabled { false };
+    SignalTaps* blockTaps = nullptr; // audio thread
+
+    // Real-time blocks only; offline renders have no deadline
+    DeadlineMonitor deadlineMonitor;
+    static_assert(ParameterSnapshot::NumParameters <= DeadlineMonitor::maxValues, "Overrun snapshots hold every parameter");
+
+    // Off unless started from the editor or the rig server
+    BlockCapture blockCapture { juce::StringArray(ParameterSnapshot::ids, ParameterSnapshot::NumParameters) };
+    static_assert(ParameterSnapshot::NumParameters <= BlockCapture::maxParameters, "Captured blocks hold every parameter");
+
+    // Audio-thread anomalies, each limited to one record a second
+    juce::SharedResourcePointer<RealtimeLog> realtimeLog;
+    RealtimeLog::Throttle nonFiniteThrottle, denormalThrottle, programThrottle, switchThrottle, blockSizeThrottle;
+    int preparedBlockSize = 0;
+    static constexpr int denormalBurstSamples = 16;
 
     JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(MultiEffectProcessor)
 };
@@ -0,0 +1,394 @@
+#include "OfflineRenderer.h"
+#include "MultiEffectProcessor.h"
+#include "PresetManager.h"
+#include <algorithm>
+
+namespace
+{
+    // Presets become folder names
+    juce::String toFileName(const juce::String& name)
+    {
+        return juce::File::createLegalFileName(name).trim().replaceCharacter(' ', '_');
+    }
+
+    juce::String toCsvField(const juce::String& text)
+    {
+        return text.containsAnyOf(",\"\n") ? text.replace("\"", "\"\"").quoted() : text;
+    }
+}
+
+//==============================================================================
+OfflineRenderer::Options OfflineRenderer::Options::fromCommandLine(const juce::String& commandLine)
+{
+    Options result;
+
+    for (const auto& argument : juce::StringArray::fromTokens(commandLine, true))
+    {
+        const auto key = argument.upToFirstOccurrenceOf("=", false, false);
+        const auto value = argument.fromFirstOccurrenceOf("=", false, false).unquoted();
+
+        if (key == "--in")                result.inputFolder = juce::File::getCurrentWorkingDirectory().getChildFile(value);
+        else if (key == "--out")          result.outputFolder = juce::File::getCurrentWorkingDirectory().getChildFile(value);
+        else if (key == "--states")       result.statesFolder = juce::File::getCurrentWorkingDirectory().getChildFile(value);
+        else if (key == "--bank")         result.bankFile = juce::File::getCurrentWorkingDirectory().getChildFile(value);
+        else if (key == "--presets")      result.bankPresets = juce::StringArray::fromTokens(value, ",", "\"");
+        else if (key == "--block")        result.blockSize = juce::jlimit(16, 65536, value.getIntValue());
+        else if (key == "--oversampling") result.oversamplingFactor = juce::jlimit(0, 3, value.getIntValue());
+        else if (key == "--filter")       result.linearPhase = value.equalsIgnoreCase("fir");
+        else if (key == "--threads")      result.numThreads = juce::jmax(1, value.getIntValue());
+    }
+
+    result.bankPresets.trim();
+    result.bankPresets.removeEmptyStrings();
+    return result;
+}
+
+//==============================================================================
+/**
+ * One pool thread's share of the jobs: takes the next job number until there
+ * are none left, on its own processor and oversampler.
+ */
+class OfflineRenderer::Worker : public juce::ThreadPoolJob
+{
+public:
+    Worker(OfflineRenderer& ownerToUse, int index)
+        : juce::ThreadPoolJob("Render worker " + juce::String(index)),
+          owner(ownerToUse)
+    {
+        processor.setNonRealtime(true);
+        midi.ensureSize(64);
+
+        const auto& options = owner.options;
+        if (options.oversamplingFactor > 0)
+        {
+            oversampling = std::make_unique<juce::dsp::Oversampling<float>>(
+                numChannels, static_cast<size_t>(options.oversamplingFactor),
+                options.linearPhase ? juce::dsp::Oversampling<float>::filterHalfBandFIREquiripple
+                                    : juce::dsp::Oversampling<float>::filterHalfBandPolyphaseIIR,
+                true, true); // maximum quality, whole-sample latency so it can be trimmed exactly
+            oversampling->initProcessing(static_cast<size_t>(options.blockSize));
+        }
+
+        buffer.setSize(numChannels, options.blockSize);
+    }
+
+    JobStatus runJob() override
+    {
+        const auto numJobs = owner.getNumJobs();
+
+        for (auto job = owner.nextJob.fetch_add(1); job < numJobs && ! shouldExit(); job = owner.nextJob.fetch_add(1))
+        {
+            const auto& input = owner.inputs[static_cast<size_t>(job) / owner.presets.size()];
+            const auto& preset = owner.presets[static_cast<size_t>(job) % owner.presets.size()];
+            owner.finishJob(render(input, preset));
+        }
+
+        return jobHasFinished;
+    }
+
+private:
+    static constexpr int numChannels = 2; // the processor's buses; mono DI is doubled
+
+    JobResult render(const juce::File& input, const Preset& preset)
+    {
+        JobResult result;
+        result.input = input;
+        result.preset = preset.name;
+        result.output = owner.options.outputFolder.getChildFile(toFileName(preset.name))
+                                                  .getChildFile(input.getFileNameWithoutExtension() + ".wav");
+
+        const auto startTicks = juce::Time::getHighResolutionTicks();
+
+        std::unique_ptr<juce::AudioFormatReader> reader(owner.formatManager.createReaderFor(input));
+        if (reader == nullptr || reader->sampleRate <= 0.0)
+        {
+            result.error = "cannot read input";
+            return result;
+        }
+
+        result.output.getParentDirectory().createDirectory();
+        result.output.deleteFile();
+
+        auto stream = std::make_unique<juce::FileOutputStream>(result.output, 1 << 20);
+        juce::WavAudioFormat wav;
+        std::unique_ptr<juce::AudioFormatWriter> writer(stream->openedOk()
+            ? wav.createWriterFor(stream.get(), reader->sampleRate, numChannels, 24, {}, 0) : nullptr);
+        if (writer == nullptr)
+        {
+            result.error = "cannot write output";
+            return result;
+        }
+        stream.release(); // Owned by the writer now
+
+        // The state is set before prepareToPlay, which loads it into the engines
+        const auto blockSize = owner.options.blockSize;
+        const auto factor = 1 << owner.options.oversamplingFactor;
+        processor.setStateInformation(preset.state.getData(), static_cast<int>(preset.state.getSize()));
+        processor.prepareToPlay(reader->sampleRate * factor, blockSize * factor);
+
+        int latency = 0;
+        if (oversampling != nullptr)
+        {
+            oversampling->reset();
+            latency = static_cast<int>(oversampling->getLatencyInSamples());
+        }
+
+        // The input, then the tail, then as much again as the oversampling filters delay it
+        const auto inputLength = reader->lengthInSamples;
+        const auto tailLength = static_cast<juce::int64>(processor.getTailLengthSeconds() * reader->sampleRate);
+        const auto totalLength = inputLength + tailLength + latency;
+        const auto readerChannels = juce::jmin(numChannels, static_cast<int>(reader->numChannels));
+        juce::int64 toSkip = latency;
+        juce::int64 processTicks = 0;
+
+        for (juce::int64 position = 0; position < totalLength; position += blockSize)
+        {
+            const auto numSamples = static_cast<int>(juce::jmin(static_cast<juce::int64>(blockSize), totalLength - position));
+            buffer.setSize(numChannels, numSamples, false, false, true);
+            buffer.clear();
+
+            if (position < inputLength)
+            {
+                const auto numToRead = static_cast<int>(juce::jmin(static_cast<juce::int64>(numSamples), inputLength - position));
+                reader->read(buffer.getArrayOfWritePointers(), readerChannels, position, numToRead);
+                if (readerChannels == 1)
+                    buffer.copyFrom(1, 0, buffer, 0, 0, numToRead);
+            }
+
+            const auto processStart = juce::Time::getHighResolutionTicks();
+            process(numSamples);
+            processTicks += juce::Time::getHighResolutionTicks() - processStart;
+
+            const auto skipped = static_cast<int>(juce::jmin(toSkip, static_cast<juce::int64>(numSamples)));
+            toSkip -= skipped;
+            if (skipped < numSamples && ! writer->writeFromAudioSampleBuffer(buffer, skipped, numSamples - skipped))
+            {
+                result.error = "write failed";
+                break;
+            }
+        }
+
+        writer = nullptr; // Flushes and closes the file
+        processor.releaseResources();
+
+        result.audioSeconds = static_cast<double>(inputLength) / reader->sampleRate;
+        result.wallSeconds = juce::Time::highResolutionTicksToSeconds(juce::Time::getHighResolutionTicks() - startTicks);
+        result.processSeconds = juce::Time::highResolutionTicksToSeconds(processTicks);
+        return result;
+    }
+
+    void process(int numSamples)
+    {
+        if (oversampling == nullptr)
+        {
+            midi.clear();
+            processor.processBlock(buffer, midi);
+            return;
+        }
+
+        auto block = juce::dsp::AudioBlock<float>(buffer).getSubBlock(0, static_cast<size_t>(numSamples));
+        auto upsampled = oversampling->processSamplesUp(block);
+
+        // The processor works on the oversampler's own buffer, in place
+        float* channels[numChannels];
+        for (int ch = 0; ch < numChannels; ++ch)
+            channels[ch] = upsampled.getChannelPointer(static_cast<size_t>(ch));
+        juce::AudioBuffer<float> upsampledBuffer(channels, numChannels, static_cast<int>(upsampled.getNumSamples()));
+
+        midi.clear();
+        processor.processBlock(upsampledBuffer, midi);
+        oversampling->processSamplesDown(block);
+    }
+
+    OfflineRenderer& owner;
+    MultiEffectProcessor processor;
+    std::unique_ptr<juce::dsp::Oversampling<float>> oversampling;
+    juce::AudioBuffer<float> buffer;
+    juce::MidiBuffer midi;
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(Worker)
+};
+
+//==============================================================================
+OfflineRenderer::OfflineRenderer(const Options& optionsToUse)
+    : options(optionsToUse)
+{
+    formatManager.registerBasicFormats();
+}
+
+OfflineRenderer::~OfflineRenderer() = default;
+
+juce::Result OfflineRenderer::collect()
+{
+    inputs.clear();
+    presets.clear();
+
+    if (! options.inputFolder.isDirectory())
+        return juce::Result::fail("Input folder not found: " + options.inputFolder.getFullPathName());
+    if (options.outputFolder == juce::File() || ! options.outputFolder.createDirectory())
+        return juce::Result::fail("Cannot create output folder: " + options.outputFolder.getFullPathName());
+
+    for (const auto& entry : juce::RangedDirectoryIterator(options.inputFolder, false, formatManager.getWildcardForAllFormats()))
+        inputs.push_back(entry.getFile());
+    std::sort(inputs.begin(), inputs.end());
+
+    if (inputs.empty())
+        return juce::Result::fail("No audio files in " + options.inputFolder.getFullPathName());
+
+    // Saved states (the standalone's "Save current state...") are used as they are
+    if (options.statesFolder != juce::File())
+    {
+        for (const auto& entry : juce::RangedDirectoryIterator(options.statesFolder, false))
+        {
+            Preset preset { entry.getFile().getFileNameWithoutExtension(), {} };
+            if (entry.getFile().loadFileAsData(preset.state) && preset.state.getSize() > 0)
+                presets.push_back(std::move(preset));
+        }
+    }
+
+    const auto bankResult = collectBankPresets();
+    if (bankResult.failed())
+        return bankResult;
+
+    if (presets.empty())
+        return juce::Result::fail("No presets: pass --states=<folder> or --presets=all|<names>");
+
+    std::sort(presets.begin(), presets.end(), [](const Preset& a, const Preset& b) { return a.name < b.name; });
+    return juce::Result::ok();
+}
+
+juce::Result OfflineRenderer::collectBankPresets()
+{
+    if (options.bankPresets.isEmpty())
+        return juce::Result::ok();
+
+    // One processor turns each bank preset into the state blob the workers load
+    MultiEffectProcessor processor;
+    auto& manager = processor.getPresetManager();
+    if (options.bankFile != juce::File())
+    {
+        const auto result = manager.loadBank(options.bankFile);
+        if (result.failed())
+            return result;
+    }
+
+    const auto& bank = manager.getBank();
+    juce::Array<int> indices;
+    if (options.bankPresets.contains("all", true))
+    {
+        for (int i = 0; i < bank.getNumPresets(); ++i)
+            indices.add(i);
+    }
+    else
+    {
+        for (const auto& name : options.bankPresets)
+        {
+            const auto index = bank.findPreset(name);
+            if (index < 0)
+                return juce::Result::fail("Preset not in the bank: " + name);
+            indices.add(index);
+        }
+    }
+
+    std::vector<float> values(static_cast<size_t>(manager.getNumParameters()));
+    for (const auto index : indices)
+    {
+        bank.copyValues(index, values.data());
+        manager.applyValues(values.data());
+
+        Preset preset { bank.getName(index), {} };
+        processor.getStateInformation(preset.state);
+        presets.push_back(std::move(preset));
+    }
+
+    return juce::Result::ok();
+}
+
+//==============================================================================
+void OfflineRenderer::run(std::function<void(const JobResult&, int)> onJobFinished)
+{
+    jobFinished = std::move(onJobFinished);
+    nextJob = 0;
+    numFinished = 0;
+    results.clear();
+    results.reserve(static_cast<size_t>(getNumJobs()));
+
+    const auto numWorkers = juce::jlimit(1, juce::jmax(1, getNumJobs()), options.numThreads);
+    const auto startTicks = juce::Time::getHighResolutionTicks();
+
+    // Workers (and their processors, which own timers) are created and deleted on this thread
+    juce::OwnedArray<Worker> workers;
+    for (int i = 0; i < numWorkers; ++i)
+        workers.add(new Worker(*this, i));
+
+    {
+        juce::ThreadPool pool(numWorkers);
+        for (auto* worker : workers)
+            pool.addJob(worker, false);
+
+        for (auto* worker : workers)
+            pool.waitForJobToFinish(worker, -1);
+    }
+
+    totalWallSeconds = juce::Time::highResolutionTicksToSeconds(juce::Time::getHighResolutionTicks() - startTicks);
+}
+
+void OfflineRenderer::finishJob(JobResult result)
+{
+    const juce::ScopedLock sl(resultLock);
+    results.push_back(std::move(result));
+    ++numFinished;
+
+    if (jobFinished)
+        jobFinished(results.back(), numFinished);
+}
+
+//==============================================================================
+juce::Result OfflineRenderer::writeReport(const juce::File& csvFile) const
+{
+    juce::String csv;
+    csv << "input,preset,output,audio_seconds,wall_seconds,process_seconds,realtime_factor,process_realtime_factor,"
+           "block_size,oversampling,filter,status" << juce::newLine;
+
+    for (const auto& result : results)
+    {
+        csv << toCsvField(result.input.getFileName()) << ","
+            << toCsvField(result.preset) << ","
+            << toCsvField(result.output.getFullPathName()) << ","
+            << juce::String(result.audioSeconds, 3) << ","
+            << juce::String(result.wallSeconds, 3) << ","
+            << juce::String(result.processSeconds, 3) << ","
+            << juce::String(result.getRealtimeFactor(), 2) << ","
+            << juce::String(result.processSeconds > 0.0 ? result.audioSeconds / result.processSeconds : 0.0, 2) << ","
+            << options.blockSize << ","
+            << (1 << options.oversamplingFactor) << "x,"
+            << (options.oversamplingFactor == 0 ? "none" : options.linearPhase ? "fir" : "iir") << ","
+            << (result.succeeded() ? juce::String("ok") : toCsvField(result.error)) << juce::newLine;
+    }
+
+    if (! csvFile.replaceWithText(csv))
+        return juce::Result::fail("Cannot write " + csvFile.getFullPathName());
+
+    return juce::Result::ok();
+}
+
+juce::String OfflineRenderer::getSummary() const
+{
+    int succeeded = 0;
+    double audioSeconds = 0.0, wallSeconds = 0.0;
+    for (const auto& result : results)
+    {
+        if (! result.succeeded())
+            continue;
+
+        ++succeeded;
+        audioSeconds += result.audioSeconds;
+        wallSeconds += result.wallSeconds;
+    }
+
+    juce::String summary;
+    summary << succeeded << " of " << getNumJobs() << " rendered, "
+            << juce::String(wallSeconds > 0.0 ? audioSeconds / wallSeconds : 0.0, 1) << "x realtime per thread, "
+            << juce::String(totalWallSeconds > 0.0 ? audioSeconds / totalWallSeconds : 0.0, 1) << "x overall";
+    return summary;
+}
@@ -0,0 +1,105 @@
+#pragma once
+
+#include <juce_audio_formats/juce_audio_formats.h>
+#include <juce_audio_processors/juce_audio_processors.h>
+#include <juce_dsp/juce_dsp.h>
+#include <atomic>
+#include <functional>
+#include <memory>
+#include <vector>
+
+//==============================================================================
+/**
+ * OfflineRenderer
+ *
+ * Re-amps a folder of DI files through a list of presets with no audio device
+ * and no window, for the DSP4GuitarRender console target. Every input/preset
+ * pair is one job; each renders to <out>/<preset>/<input>.wav, 24-bit, at the
+ * input's rate, with the effect tail after the end of the input.
+ *
+ * Jobs run on a ThreadPool with one long-lived worker per thread, and each
+ * worker owns its own MultiEffectProcessor, so nothing is shared between
+ * threads but the job counter. Processors are created on the calling (message)
+ * thread, since they own timers; the workers only set state, prepare and
+ * process. Offline, the processor runs non-realtime, at any block size and,
+ * optionally, oversampled: the renderer upsamples around the whole processor
+ * with juce::dsp::Oversampling and compensates the filters' latency.
+ *
+ * Every job's audio length, wall time and processing time go into a CSV, with
+ * the realtime factor (seconds of audio rendered per second) of each.
+ */
+class OfflineRenderer
+{
+public:
+    struct Options
+    {
+        juce::File inputFolder, outputFolder;
+        juce::File statesFolder;       // saved plugin states, one preset per file
+        juce::File bankFile;           // empty: the processor's default bank
+        juce::StringArray bankPresets; // names from the bank, or "all"
+        int blockSize = 512;
+        int oversamplingFactor = 0;    // log2: 0 = off, 1 = 2x ... 3 = 8x
+        bool linearPhase = false;      // FIR equiripple filters instead of polyphase IIR
+        int numThreads = juce::SystemStats::getNumCpus();
+
+        /** --in=<folder> --out=<folder> [--states=<folder>] [--presets=all|a,b] [--bank=<file>]
+            [--block=512] [--oversampling=0-3] [--filter=iir|fir] [--threads=N] */
+        static Options fromCommandLine(const juce::String& commandLine);
+    };
+
+    struct JobResult
+    {
+        juce::File input, output;
+        juce::String preset, error;
+        double audioSeconds = 0.0, wallSeconds = 0.0, processSeconds = 0.0;
+
+        bool succeeded() const noexcept { return error.isEmpty(); }
+        double getRealtimeFactor() const noexcept { return wallSeconds > 0.0 ? audioSeconds / wallSeconds : 0.0; }
+    };
+
+    explicit OfflineRenderer(const Options& options);
+    ~OfflineRenderer();
+
+    /** Message thread: finds the inputs and reads the presets into state blobs. */
+    juce::Result collect();
+
+    int getNumJobs() const noexcept { return static_cast<int>(inputs.size() * presets.size()); }
+
+    /** Message thread: renders every job and returns when all are done. onJobFinished
+        is called from the worker threads, one call at a time. */
+    void run(std::function<void(const JobResult&, int numFinished)> onJobFinished);
+
+    const std::vector<JobResult>& getResults() const noexcept { return results; }
+
+    /** input,preset,output,audio_seconds,wall_seconds,process_seconds,realtime_factor,... */
+    juce::Result writeReport(const juce::File& csvFile) const;
+
+    /** e.g. "24 of 24 rendered, 18.3x realtime per thread, 146.0x overall" */
+    juce::String getSummary() const;
+
+private:
+    struct Preset
+    {
+        juce::String name;
+        juce::MemoryBlock state;
+    };
+
+    class Worker;
+
+    juce::Result collectBankPresets();
+    void finishJob(JobResult result); // worker threads
+
+    Options options;
+    juce::AudioFormatManager formatManager;
+    std::vector<juce::File> inputs;
+    std::vector<Preset> presets;
+
+    std::atomic<int> nextJob { 0 };
+    juce::CriticalSection resultLock;
+    std::vector<JobResult> results;
+    int numFinished = 0;
+    double totalWallSeconds = 0.0;
+    std::function<void(const JobResult&, int)> jobFinished;
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(OfflineRenderer)
+};
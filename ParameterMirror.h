@@ -0,0 +1,117 @@
+#pragma once
+
+#include <juce_audio_processors/juce_audio_processors.h>
+#include <array>
+#include <atomic>
+
+//==============================================================================
+/**
+ * ParameterMirror
+ *
+ * Lets the audio thread change parameters (MIDI program changes, MIDI learn)
+ * without waiting for, or signalling, the message thread. The audio thread
+ * applies the new values to the DSP itself and queues them here; a message-
+ * thread timer later writes them to the host-visible parameters and
+ * acknowledges. Until then the audio thread keeps overriding the parameters
+ * it changed, so stale APVTS values can never pull the DSP back.
+ *
+ * NumParameters entries, indexed in the processor's parameter order.
+ */
+template <size_t NumParameters>
+class ParameterMirror : private juce::Timer
+{
+public:
+    explicit ParameterMirror(juce::AudioProcessor& processor)
+    {
+        const auto& params = processor.getParameters();
+        jassert(static_cast<size_t>(params.size()) >= NumParameters);
+
+        for (size_t i = 0; i < NumParameters; ++i)
+            parameters[i] = dynamic_cast<juce::RangedAudioParameter*>(params[static_cast<int>(i)]);
+
+        startTimerHz(30);
+    }
+
+    ~ParameterMirror() override { stopTimer(); }
+
+    //==============================================================================
+    /** Audio thread: queues one plain value. Call endBatch() after a group of pushes. */
+    void push(size_t index, float plainValue) noexcept
+    {
+        const auto scope = fifo.write(1);
+        if (scope.blockSize1 + scope.blockSize2 == 0)
+        {
+            dropped.fetch_add(1, std::memory_order_relaxed);
+            return;
+        }
+
+        auto& slot = scope.blockSize1 > 0 ? queue[static_cast<size_t>(scope.startIndex1)]
+                                          : queue[static_cast<size_t>(scope.startIndex2)];
+        slot = { index, plainValue };
+    }
+
+    void endBatch() noexcept { pushedSeq.fetch_add(1, std::memory_order_release); }
+
+    /** Audio thread: true once every pushed value has reached the parameters. */
+    bool isUpToDate() const noexcept
+    {
+        return appliedSeq.load(std::memory_order_acquire) == pushedSeq.load(std::memory_order_relaxed);
+    }
+
+    /** Values lost because the queue was full (diagnostics). */
+    int getNumDropped() const noexcept { return dropped.load(); }
+
+private:
+    struct Change
+    {
+        size_t index = 0;
+        float value = 0.0f;
+    };
+
+    void timerCallback() override
+    {
+        // Everything pushed before this sequence number is in the FIFO already
+        const auto seq = pushedSeq.load(std::memory_order_acquire);
+        if (seq == appliedSeq.load(std::memory_order_relaxed))
+            return;
+
+        std::array<float, NumParameters> latest {};
+        std::array<bool, NumParameters> changed {};
+
+        const auto scope = fifo.read(fifo.getNumReady());
+        auto take = [&](int start, int size)
+        {
+            for (int i = start; i < start + size; ++i)
+            {
+                const auto& change = queue[static_cast<size_t>(i)];
+                latest[change.index] = change.value;
+                changed[change.index] = true;
+            }
+        };
+        take(scope.startIndex1, scope.blockSize1);
+        take(scope.startIndex2, scope.blockSize2);
+
+        for (size_t i = 0; i < NumParameters; ++i)
+        {
+            if (changed[i] && parameters[i] != nullptr)
+            {
+                const auto normalised = parameters[i]->convertTo0to1(latest[i]);
+                if (parameters[i]->getValue() != normalised)
+                    parameters[i]->setValueNotifyingHost(normalised);
+            }
+        }
+
+        appliedSeq.store(seq, std::memory_order_release);
+    }
+
+    static constexpr int queueSize = 4096;
+
+    std::array<juce::RangedAudioParameter*, NumParameters> parameters {};
+    juce::AbstractFifo fifo { queueSize };
+    std::array<Change, queueSize> queue;
+
+    std::atomic<juce::uint32> pushedSeq { 0 }, appliedSeq { 0 };
+    std::atomic<int> dropped { 0 };
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(ParameterMirror)
+};
@@ -31,9 +31,49 @@ static constexpr int kHeaderH  = 58;   // height of the matrix-rain header
 static constexpr int kPanelW   = 300;  // width of one effect panel
 static constexpr int kPanelH   = 200;  // height of one effect panel
 static constexpr int kPanelPad = 2;    // gap between panels
+static constexpr int kWaveformH = 96;  // height of the waveform strip below the panels
+static constexpr int kDeadlineW = 240; // deadline histogram at the right of that strip
+
+static constexpr int kGlyphW     = 14; // one Matrix-rain character cell
+static constexpr int kGlyphH     = 12;
+static constexpr int kRainLevels = 16; // brightness steps in the glyph atlas
 
 static constexpr int kEditorW  = kPanelW * 3 + kPanelPad * 4;
-static constexpr int kEditorH  = kHeaderH + kPanelH * 4 + kPanelPad * 5;
+static constexpr int kEditorH  = kHeaderH + kPanelH * 4 + kPanelPad * 6 + kWaveformH;
+
+//==============================================================================
+// Effect panels. Draw order mirrors resized() layout (row, col):
+//  Row 0: Bitcrusher [0,0] | RingMod     [1,0] | Tremolo   [2,0]
+//  Row 1: Phaser     [0,1] | Chorus      [1,1] | Compressor[2,1]
+//  Row 2: Delay      [0,2] | Reverb      [1,2] | WahWah    [2,2]
+//  Row 3: Fuzz       [0,3] | Levels      [1,3] | Spectrum  [2,3]  (components, not cached)
+//  Below: output waveform strip | deadline histogram               (components)
+namespace
+{
+    struct PanelInfo
+    {
+        const char* name;
+        const char* onParameterID;
+        int col, row;
+        int chainOrder;
+    };
+
+    constexpr PanelInfo kPanels[] =
+    {
+        { "BITCRUSHER", "bitcrusherOn", 0, 0,  1 },
+        { "RING MOD",   "ringModOn",    1, 0,  4 },
+        { "TREMOLO",    "tremoloOn",    2, 0,  8 },
+        { "PHASER",     "phaserOn",     0, 1,  6 },
+        { "CHORUS",     "chorusOn",     1, 1,  7 },
+        { "COMPRESSOR", "compressorOn", 2, 1,  3 },
+        { "DELAY",      "delayOn",      0, 2,  9 },
+        { "REVERB",     "reverbOn",     1, 2, 10 },
+        { "WAH-WAH",    "wahOn",        2, 2,  5 },
+        { "FUZZ",       "fuzzOn",       0, 3,  2 },
+    };
+
+    static_assert(std::size(kPanels) == MultiEffectProcessorEditor::numPanels, "one cache per panel");
+}
 
 //==============================================================================
 // Layout helpers
@@ -62,6 +102,10 @@ MultiEffectProcessorEditor::MultiEffectProcessorEditor(MultiEffectProcessor& p)
     : AudioProcessorEditor(&p), audioProcessor(p)
 {
     setLookAndFeel(&cyberpunkLF);
+    setOpaque(true); // The cached background covers every pixel
+
+    for (size_t i = 0; i < numPanels; ++i)
+        panelOnValues[i] = audioProcessor.apvts.getRawParameterValue(kPanels[i].onParameterID);
 
     // ------------------------------------------------------------------
     // Seed & build matrix rain drops (time-based seed for varied patterns)
@@ -158,10 +202,18 @@ MultiEffectProcessorEditor::MultiEffectProcessorEditor(MultiEffectProcessor& p)
 
     // ------------------------------------------------------------------
     // Parameter attachments
+    auto& midiLearn = audioProcessor.getMidiLearn();
+    auto addLearnTarget = [&](const juce::String& id, juce::Component& c)
+    {
+        learnTargets.push_back({ &c, midiLearn.getParameterIndex(id) });
+        c.addMouseListener(this, true);
+    };
+
     auto attach = [&](const juce::String& id, juce::Slider& s)
     {
         sliderAttachments.push_back(
             std::make_unique<SliderAttachment>(audioProcessor.apvts, id, s));
+        addLearnTarget(id, s);
 
         // Double-click resets to the parameter's default value
         if (auto* param = dynamic_cast<juce::RangedAudioParameter*>(
@@ -177,13 +229,15 @@ MultiEffectProcessorEditor::MultiEffectProcessorEditor(MultiEffectProcessor& p)
                 + "\nRange: " + juce::String(range.start, 2)
                 + " \xe2\x80\x93 " + juce::String(range.end, 2)
                 + "\nDefault: " + juce::String(defaultVal, 2)
-                + "\n\xc2\xbb Double-click to reset";
+                + "\n\xc2\xbb Double-click to reset"
+                + "\n\xc2\xbb Right-click for MIDI learn";
             s.setTooltip(tip);
         }
     };
     auto attachBtn = [&](const juce::String& id, juce::ToggleButton& b) {
         buttonAttachments.push_back(
             std::make_unique<ButtonAttachment>(audioProcessor.apvts, id, b));
+        addLearnTarget(id, b);
     };
 
     attach("bitcrusherDepth",  bitcrusherDepthSlider);
@@ -243,58 +297,284 @@ MultiEffectProcessorEditor::MultiEffectProcessorEditor(MultiEffectProcessor& p)
     attach("fuzzMix",   fuzzMixSlider);
     attachBtn("fuzzOn", fuzzOnButton);
 
+    addAndMakeVisible(levelMeter);
+    addAndMakeVisible(spectrumDisplay);
+    addAndMakeVisible(waveformDisplay);
+    addAndMakeVisible(deadlineDisplay);
+    deadlineDisplay.addMouseListener(this, false); // right-click: trace recording
+
     setSize(kEditorW, kEditorH);
     startTimerHz(30);
 }
 
 MultiEffectProcessorEditor::~MultiEffectProcessorEditor()
 {
+    audioProcessor.getMidiLearn().cancelLearning();
     setLookAndFeel(nullptr);
     stopTimer();
 }
 
+//==============================================================================
+// MIDI learn
+
+void MultiEffectProcessorEditor::mouseDown(const juce::MouseEvent& e)
+{
+    if (! e.mods.isPopupMenu())
+        return;
+
+    if (e.eventComponent == &deadlineDisplay)
+    {
+        showProfilingMenu();
+        return;
+    }
+
+    for (const auto& target : learnTargets)
+    {
+        if (target.component == e.eventComponent || target.component->isParentOf(e.eventComponent))
+        {
+            showMidiLearnMenu(target.parameterIndex, *target.component);
+            return;
+        }
+    }
+}
+
+void MultiEffectProcessorEditor::showMidiLearnMenu(int parameterIndex, juce::Component& target)
+{
+    using Curve = MidiLearn::Curve;
+
+    auto& midiLearn = audioProcessor.getMidiLearn();
+    const auto mapping = midiLearn.getMapping(parameterIndex);
+    const bool learning = midiLearn.getLearningParameter() == parameterIndex;
+
+    juce::PopupMenu menu;
+    menu.addSectionHeader(midiLearn.getParameterName(parameterIndex)
+                          + (mapping ? "  \xc2\xbb  " + MidiLearn::describe(*mapping) : juce::String()));
+
+    menu.addItem(learning ? "Cancel MIDI Learn" : "MIDI Learn", [&midiLearn, parameterIndex, learning]
+    {
+        if (learning)
+            midiLearn.cancelLearning();
+        else
+            midiLearn.startLearning(parameterIndex);
+    });
+
+    if (mapping)
+    {
+        juce::PopupMenu curves;
+        for (auto curve : { Curve::Linear, Curve::Exponential, Curve::Logarithmic, Curve::SCurve })
+            curves.addItem(MidiLearn::getCurveName(curve), true, mapping->curve == curve,
+                           [&midiLearn, parameterIndex, curve] { midiLearn.setCurve(parameterIndex, curve); });
+
+        menu.addSubMenu("Response Curve", curves);
+
+        menu.addItem("Invert", true, mapping->rangeStart > mapping->rangeEnd, [&midiLearn, m = *mapping]() mutable
+        {
+            std::swap(m.rangeStart, m.rangeEnd);
+            midiLearn.setMapping(m);
+        });
+
+        menu.addItem("Forget MIDI Mapping", [&midiLearn, parameterIndex] { midiLearn.removeMapping(parameterIndex); });
+    }
+
+    menu.showMenuAsync(juce::PopupMenu::Options().withTargetComponent(&target));
+}
+
+void MultiEffectProcessorEditor::showProfilingMenu()
+{
+    auto& recorder = TraceRecorder::getInstance();
+    auto& monitor = audioProcessor.getDeadlineMonitor();
+
+    juce::PopupMenu menu;
+    menu.addSectionHeader("Profiling");
+    menu.addItem("Record Trace", true, recorder.isEnabled(), [&recorder] { recorder.setEnabled(! recorder.isEnabled()); });
+    menu.addItem("Export Chrome Trace", [&recorder]
+    {
+        const auto file = TraceRecorder::getDefaultTraceFile();
+        const auto result = recorder.exportChromeTrace(file);
+        if (result.failed())
+        {
+            juce::AlertWindow::showMessageBoxAsync(juce::MessageBoxIconType::WarningIcon, "Export Trace", result.getErrorMessage());
+            return;
+        }
+
+        file.revealToUser();
+        if (const auto missing = recorder.getNumUnrecordedThreads(); missing > 0)
+            juce::AlertWindow::showMessageBoxAsync(juce::MessageBoxIconType::WarningIcon, "Export Trace",
+                                                   juce::String(missing) + " thread(s) were not recorded: all "
+                                                       + juce::String(TraceRecorder::maxThreads) + " trace buffers were in use.");
+    });
+
+    if (const auto missing = recorder.getNumUnrecordedThreads(); missing > 0)
+        menu.addItem(juce::String(missing) + " thread(s) not recorded: trace buffers full", false, false, [] {});
+    menu.addSeparator();
+
+    auto& capture = audioProcessor.getBlockCapture();
+    menu.addItem(capture.isCapturing() ? "Stop Block Capture (" + capture.getSummary() + ")" : "Capture Blocks for Replay",
+                 [&capture]
+    {
+        if (capture.isCapturing())
+        {
+            capture.stop();
+            capture.getFile().revealToUser();
+            return;
+        }
+
+        juce::String error;
+        if (! capture.start(BlockCapture::getDefaultFile(), error))
+            juce::AlertWindow::showMessageBoxAsync(juce::MessageBoxIconType::WarningIcon, "Block Capture", error);
+    });
+    menu.addSeparator();
+    menu.addItem("Dump Deadline Report Every 10 s", true, monitor.isDumping(), [&monitor]
+    {
+        if (! monitor.isDumping())
+        {
+            monitor.startDumping(DeadlineMonitor::getDefaultDumpFile("Plugin"), 10);
+            return;
+        }
+
+        monitor.stopDumping();
+        if (monitor.getDumpFile().existsAsFile())
+            monitor.getDumpFile().revealToUser();
+    });
+    menu.addItem("Reset Deadline Statistics", [&monitor] { monitor.reset(); });
+    menu.addSeparator();
+
+    const auto memory = audioProcessor.getMemoryReport();
+    menu.addItem("Memory Report (" + juce::String(static_cast<double>(memory.getTotalBytes()) / 1024.0, 0) + " KiB)", [memory]
+    {
+        juce::AlertWindow::showMessageBoxAsync(juce::MessageBoxIconType::InfoIcon, "DSP Memory", memory.toString());
+    });
+
+    menu.addSectionHeader("Engine");
+    auto& processor = audioProcessor;
+
+    juce::PopupMenu crossfades;
+    const auto crossfadeMs = juce::roundToInt(processor.getPresetCrossfadeSeconds() * 1000.0);
+    for (const auto ms : { 10, 25, 50, 100, 250, 500, 1000 })
+        crossfades.addItem(juce::String(ms) + " ms", true, ms == crossfadeMs,
+                           [&processor, ms] { processor.setPresetCrossfadeSeconds(ms / 1000.0); });
+    menu.addSubMenu("Preset Crossfade", crossfades);
+
+    juce::PopupMenu idleReleases;
+    const auto idleSeconds = juce::roundToInt(processor.getIdleReleaseSeconds());
+    for (const auto seconds : { 5, 30, 60, 300, 1800 })
+        idleReleases.addItem(seconds < 60 ? juce::String(seconds) + " s" : juce::String(seconds / 60) + " min",
+                             true, seconds == idleSeconds,
+                             [&processor, seconds] { processor.setIdleReleaseSeconds(seconds); });
+    menu.addSubMenu("Free Unused Delay/Reverb After", idleReleases);
+
+    menu.showMenuAsync(juce::PopupMenu::Options().withTargetComponent(&deadlineDisplay));
+}
+
 //==============================================================================
 void MultiEffectProcessorEditor::timerCallback()
+{
+    DSP4G_TRACE_ZONE("Editor::timerCallback");
+
+    // Learn mode: the audio thread has caught a controller for the armed parameter
+    auto& midiLearn = audioProcessor.getMidiLearn();
+    midiLearn.pollLearnedMapping();
+
+    const auto learning = midiLearn.getLearningParameter();
+    if (learning != shownLearnParameter)
+    {
+        shownLearnParameter = learning;
+        repaint(learnPromptBounds());
+    }
+
+    // Panel images are only redrawn when their effect is switched on or off
+    for (size_t i = 0; i < numPanels; ++i)
+        if (panelCaches[i].image.isValid() && panelCaches[i].active != isPanelActive(i))
+            repaint(panelImageBounds(i));
+
+    analyser.update();
+    levelMeter.repaint();
+    spectrumDisplay.repaint();
+    waveformDisplay.repaint();
+    deadlineDisplay.refresh();
+
+    // Only the drops that moved a whole pixel or changed glyphs are repainted
+    for (const auto& area : advanceMatrixRain())
+        repaint(area);
+}
+
+juce::RectangleList<int> MultiEffectProcessorEditor::advanceMatrixRain()
 {
     ++matrixAnimCounter;
 
+    const juce::Rectangle<int> header(0, 0, getWidth(), kHeaderH);
+    const bool shiftChars = (matrixAnimCounter % 6) == 0;
+    juce::RectangleList<int> dirty;
+
     for (auto& drop : matrixDrops)
     {
+        const auto before = dropBounds(drop);
+
         drop.y += drop.speed;
-        if (drop.y > static_cast<float>(kHeaderH + drop.length * 12))
+        if (drop.y > static_cast<float>(kHeaderH + drop.length * kGlyphH))
         {
-            drop.y          = -static_cast<float>(drop.length * 12);
+            drop.y          = -static_cast<float>(drop.length * kGlyphH);
             drop.charOffset = randInt(0, matrixChars.length() - 1);
             drop.speed      = 0.4f + static_cast<float>(randInt(0, 12)) * 0.06f;
         }
         // Slowly shift the chars
-        if ((matrixAnimCounter % 6) == 0)
+        if (shiftChars)
             drop.charOffset = (drop.charOffset + 1) % matrixChars.length();
+
+        const auto after = dropBounds(drop);
+        if (shiftChars || after != before)
+            dirty.addWithoutMerging(before.getUnion(after).getIntersection(header));
     }
-    repaint(0, 0, getWidth(), kHeaderH);
+
+    dirty.consolidate();
+    return dirty;
+}
+
+juce::Rectangle<int> MultiEffectProcessorEditor::dropBounds(const MatrixDrop& drop) const
+{
+    // Glyph i of a drop sits at y - i * kGlyphH, the leading glyph lowest
+    const auto top = static_cast<int>(drop.y) - (drop.length - 1) * kGlyphH;
+    return { static_cast<int>(drop.x), top, kGlyphW, drop.length * kGlyphH };
+}
+
+juce::Rectangle<int> MultiEffectProcessorEditor::learnPromptBounds() const
+{
+    return { 260, 0, getWidth() - 430, kHeaderH };
 }
 
 //==============================================================================
-// Paint
+// Render caches
 //==============================================================================
-void MultiEffectProcessorEditor::paint(juce::Graphics& g)
+void MultiEffectProcessorEditor::updateRenderCaches(float scale)
 {
-    using CP = CyberpunkLookAndFeel;
+    if (scale == cacheScale && backgroundCache.getWidth() == juce::roundToInt(static_cast<float>(getWidth()) * scale)
+        && backgroundCache.getHeight() == juce::roundToInt(static_cast<float>(getHeight()) * scale))
+        return;
 
-    // ------------------------------------------------------------------ body
-    g.fillAll(CP::matrixDarkBG);
+    using CP = CyberpunkLookAndFeel;
+    cacheScale = scale;
 
-    // Subtle scan-line grid across the whole background
-    g.setColour(CP::matrixGreen.withAlpha(0.03f));
-    for (int y = kHeaderH; y < getHeight(); y += 4)
-        g.drawHorizontalLine(y, 0.0f, static_cast<float>(getWidth()));
-    for (int x = 0; x < getWidth(); x += 40)
-        g.drawVerticalLine(x, static_cast<float>(kHeaderH), static_cast<float>(getHeight()));
+    auto makeImage = [scale](int w, int h, juce::Image::PixelFormat format)
+    {
+        return juce::Image(format, juce::jmax(1, juce::roundToInt(static_cast<float>(w) * scale)),
+                           juce::jmax(1, juce::roundToInt(static_cast<float>(h) * scale)), true);
+    };
 
-    // ------------------------------------------------------------------ header
+    // ------------------------------------------------------------------ background
+    // Body fill, scan-line grid and header gradient: everything under the rain
+    backgroundCache = makeImage(getWidth(), getHeight(), juce::Image::RGB);
     {
-        juce::Rectangle<float> header(0.0f, 0.0f, static_cast<float>(getWidth()),
-                                      static_cast<float>(kHeaderH));
+        juce::Graphics g(backgroundCache);
+        g.addTransform(juce::AffineTransform::scale(scale));
+
+        g.fillAll(CP::matrixDarkBG);
+
+        // Subtle scan-line grid across the whole background
+        g.setColour(CP::matrixGreen.withAlpha(0.03f));
+        for (int y = kHeaderH; y < getHeight(); y += 4)
+            g.drawHorizontalLine(y, 0.0f, static_cast<float>(getWidth()));
+        for (int x = 0; x < getWidth(); x += 40)
+            g.drawVerticalLine(x, static_cast<float>(kHeaderH), static_cast<float>(getHeight()));
 
         // Header background gradient
         g.setGradientFill(juce::ColourGradient(
@@ -303,35 +583,15 @@ void MultiEffectProcessorEditor::paint(juce::Graphics& g)
             juce::Colour(0xFF050820),
             0.0f, static_cast<float>(kHeaderH),
             false));
-        g.fillRect(header);
-
-        // Matrix rain drops
-        auto monoFont = CyberpunkLookAndFeel::getCustomFont().withHeight(11.0f);
-        g.setFont(monoFont);
-
-        const int charH = 12;
-        for (const auto& drop : matrixDrops)
-        {
-            const int numChars = matrixChars.length();
-            for (int i = 0; i < drop.length; ++i)
-            {
-                const float cy = drop.y - static_cast<float>(i * charH);
-                if (cy < -charH || cy > static_cast<float>(kHeaderH + charH))
-                    continue;
+        g.fillRect(0, 0, getWidth(), kHeaderH);
+    }
 
-                const float brightness = 1.0f - static_cast<float>(i) / static_cast<float>(drop.length);
-                const juce::Colour charColour =
-                    (i == 0) ? juce::Colour(0xFFCCFFCC) // leading char is near-white
-                             : CP::matrixGreen.withAlpha(drop.opacity * brightness);
-                g.setColour(charColour);
-
-                const int charIdx = (drop.charOffset + i) % numChars;
-                g.drawText(juce::String::charToString(matrixChars[charIdx]),
-                           static_cast<int>(drop.x), static_cast<int>(cy),
-                           14, charH,
-                           juce::Justification::centred, false);
-            }
-        }
+    // ------------------------------------------------------------------ header overlay
+    // Separator, title and version tag, drawn over the rain
+    headerOverlayCache = makeImage(getWidth(), kHeaderH, juce::Image::ARGB);
+    {
+        juce::Graphics g(headerOverlayCache);
+        g.addTransform(juce::AffineTransform::scale(scale));
 
         // Horizontal separator line (glowing)
         g.setColour(CP::matrixGreen.withAlpha(0.6f));
@@ -361,31 +621,203 @@ void MultiEffectProcessorEditor::paint(juce::Graphics& g)
                    juce::Justification::centredRight);
     }
 
-    // ------------------------------------------------------------------ effect panels
-    // Panel draw order mirrors resized() layout (row, col):
-    //  Row 0: Bitcrusher [0,0] | RingMod     [1,0] | Tremolo   [2,0]
-    //  Row 1: Phaser     [0,1] | Chorus      [1,1] | Compressor[2,1]
-    //  Row 2: Delay      [0,2] | Reverb      [1,2] | WahWah    [2,2]
-    //  Row 3: Fuzz       [0,3] | [empty]            | [empty]
-
-    auto* apvts = &audioProcessor.apvts;
-    auto isOn   = [&](const juce::String& id) -> bool
-    {
-        if (auto* p = apvts->getParameter(id))
-            return p->getValue() > 0.5f;
-        return false;
+    // ------------------------------------------------------------------ glyph atlas
+    // One column per matrixChars glyph; rows 0..kRainLevels-1 are matrix green at
+    // increasing alpha, the last row is the near-white leading glyph
+    const int numChars = matrixChars.length();
+    glyphAtlas = makeImage(numChars * kGlyphW, (kRainLevels + 1) * kGlyphH, juce::Image::ARGB);
+    {
+        juce::Graphics g(glyphAtlas);
+        g.addTransform(juce::AffineTransform::scale(scale));
+        g.setFont(CyberpunkLookAndFeel::getCustomFont().withHeight(11.0f));
+
+        for (int row = 0; row <= kRainLevels; ++row)
+        {
+            g.setColour(row == kRainLevels ? juce::Colour(0xFFCCFFCC)
+                                           : CP::matrixGreen.withAlpha(static_cast<float>(row) / static_cast<float>(kRainLevels - 1)));
+
+            for (int c = 0; c < numChars; ++c)
+                g.drawText(juce::String::charToString(matrixChars[c]),
+                           c * kGlyphW, row * kGlyphH, kGlyphW, kGlyphH,
+                           juce::Justification::centred, false);
+        }
+    }
+}
+
+void MultiEffectProcessorEditor::drawMatrixRain(juce::Graphics& g) const
+{
+    const int numChars = matrixChars.length();
+    const auto atlasW = juce::roundToInt(static_cast<float>(kGlyphW) * cacheScale);
+    const auto atlasH = juce::roundToInt(static_cast<float>(kGlyphH) * cacheScale);
+
+    g.setOpacity(1.0f);
+
+    for (const auto& drop : matrixDrops)
+    {
+        if (! g.clipRegionIntersects(dropBounds(drop)))
+            continue;
+
+        for (int i = 0; i < drop.length; ++i)
+        {
+            const float cy = drop.y - static_cast<float>(i * kGlyphH);
+            if (cy < -kGlyphH || cy > static_cast<float>(kHeaderH + kGlyphH))
+                continue;
+
+            // Leading char is near-white; the trail fades, quantised to the atlas rows
+            int row = kRainLevels;
+            if (i > 0)
+            {
+                const float brightness = 1.0f - static_cast<float>(i) / static_cast<float>(drop.length);
+                row = juce::roundToInt(drop.opacity * brightness * static_cast<float>(kRainLevels - 1));
+                if (row == 0)
+                    continue;
+            }
+
+            const int charIdx = (drop.charOffset + i) % numChars;
+            g.drawImage(glyphAtlas,
+                        static_cast<int>(drop.x), static_cast<int>(cy), kGlyphW, kGlyphH,
+                        juce::roundToInt(static_cast<float>(charIdx * kGlyphW) * cacheScale),
+                        juce::roundToInt(static_cast<float>(row * kGlyphH) * cacheScale),
+                        atlasW, atlasH);
+        }
+    }
+}
+
+MultiEffectProcessorEditor::PaintTimings MultiEffectProcessorEditor::measurePaint(int frames)
+{
+    juce::Image target(juce::Image::RGB, getWidth(), getHeight(), true);
+    juce::Graphics g(target);
+    PaintTimings timings;
+
+    auto timePaint = [this, &g](const juce::RectangleList<int>& area)
+    {
+        const auto start = juce::Time::getHighResolutionTicks();
+        {
+            const juce::Graphics::ScopedSaveState state(g);
+            if (g.reduceClipRegion(area))
+                paintEntireComponent(g, false);
+        }
+        return juce::Time::highResolutionTicksToSeconds(juce::Time::getHighResolutionTicks() - start) * 1.0e6;
     };
 
-    drawEffectPanel(g, panelBounds(0, 0), "BITCRUSHER", isOn("bitcrusherOn"),  1);
-    drawEffectPanel(g, panelBounds(1, 0), "RING MOD",   isOn("ringModOn"),     4);
-    drawEffectPanel(g, panelBounds(2, 0), "TREMOLO",    isOn("tremoloOn"),     8);
-    drawEffectPanel(g, panelBounds(0, 1), "PHASER",     isOn("phaserOn"),      6);
-    drawEffectPanel(g, panelBounds(1, 1), "CHORUS",     isOn("chorusOn"),      7);
-    drawEffectPanel(g, panelBounds(2, 1), "COMPRESSOR", isOn("compressorOn"),  3);
-    drawEffectPanel(g, panelBounds(0, 2), "DELAY",      isOn("delayOn"),       9);
-    drawEffectPanel(g, panelBounds(1, 2), "REVERB",     isOn("reverbOn"),     10);
-    drawEffectPanel(g, panelBounds(2, 2), "WAH-WAH",    isOn("wahOn"),         5);
-    drawEffectPanel(g, panelBounds(0, 3), "FUZZ",       isOn("fuzzOn"),        2);
+    // Cold: drop every cache first
+    cacheScale = 0.0f;
+    for (auto& cache : panelCaches)
+        cache.image = {};
+
+    const juce::RectangleList<int> everything(getLocalBounds());
+    timings.coldPaintMicros = timePaint(everything);
+    timings.warmPaintMicros = timePaint(everything);
+
+    // Rain frames on a copy of the animation
+    const auto savedDrops = matrixDrops;
+    const auto savedCounter = matrixAnimCounter;
+    const juce::RectangleList<int> header(juce::Rectangle<int>(0, 0, getWidth(), kHeaderH));
+
+    for (int frame = 0; frame < frames; ++frame)
+    {
+        const auto micros = timePaint(advanceMatrixRain());
+        timings.averageFrameMicros += micros;
+        timings.worstFrameMicros = juce::jmax(timings.worstFrameMicros, micros);
+        timings.averageHeaderFrameMicros += timePaint(header);
+        ++timings.frames;
+    }
+
+    matrixDrops = savedDrops;
+    matrixAnimCounter = savedCounter;
+
+    if (timings.frames > 0)
+    {
+        timings.averageFrameMicros /= timings.frames;
+        timings.averageHeaderFrameMicros /= timings.frames;
+    }
+
+    return timings;
+}
+
+//==============================================================================
+// Paint
+//==============================================================================
+void MultiEffectProcessorEditor::paint(juce::Graphics& g)
+{
+    DSP4G_TRACE_ZONE("Editor::paint");
+    using CP = CyberpunkLookAndFeel;
+
+    // ------------------------------------------------------------------ cached layers
+    updateRenderCaches(g.getInternalContext().getPhysicalPixelScaleFactor());
+    g.drawImage(backgroundCache, getLocalBounds().toFloat());
+
+    // ------------------------------------------------------------------ header
+    const juce::Rectangle<int> headerArea(0, 0, getWidth(), kHeaderH);
+    if (g.clipRegionIntersects(headerArea))
+    {
+        drawMatrixRain(g);
+        g.drawImage(headerOverlayCache, headerArea.toFloat());
+
+        // MIDI learn prompt while a parameter is armed
+        const auto& midiLearn = audioProcessor.getMidiLearn();
+        const auto learning = midiLearn.getLearningParameter();
+        if (learning >= 0)
+        {
+            g.setFont(CyberpunkLookAndFeel::getCustomFont().withHeight(11.0f).boldened());
+            g.setColour(CP::matrixCyan);
+            g.drawText("MIDI LEARN \xc2\xbb " + midiLearn.getParameterName(learning).toUpperCase()
+                           + "  //  MOVE A CONTROLLER",
+                       learnPromptBounds(),
+                       juce::Justification::centred);
+        }
+    }
+
+    // Rain frames only touch the header
+    if (g.getClipBounds().getBottom() <= kHeaderH)
+        return;
+
+    // ------------------------------------------------------------------ effect panels
+    for (size_t i = 0; i < numPanels; ++i)
+        drawCachedPanel(g, i);
+}
+
+bool MultiEffectProcessorEditor::isPanelActive(size_t index) const
+{
+    return panelOnValues[index] != nullptr && panelOnValues[index]->load() >= 0.5f;
+}
+
+juce::Rectangle<int> MultiEffectProcessorEditor::panelImageBounds(size_t index) const
+{
+    // Room for the outer glow drawn around active panels
+    return panelBounds(kPanels[index].col, kPanels[index].row).expanded(3);
+}
+
+void MultiEffectProcessorEditor::drawCachedPanel(juce::Graphics& g, size_t index)
+{
+    const auto area = panelImageBounds(index);
+    if (! g.clipRegionIntersects(area))
+        return;
+
+    const auto scale = g.getInternalContext().getPhysicalPixelScaleFactor();
+    const bool active = isPanelActive(index);
+    auto& cache = panelCaches[index];
+
+    if (! cache.image.isValid() || cache.active != active || cache.scale != scale)
+    {
+        const auto& panel = kPanels[index];
+        cache.image = juce::Image(juce::Image::ARGB,
+                                  juce::jmax(1, juce::roundToInt(static_cast<float>(area.getWidth()) * scale)),
+                                  juce::jmax(1, juce::roundToInt(static_cast<float>(area.getHeight()) * scale)),
+                                  true);
+
+        juce::Graphics pg(cache.image);
+        pg.addTransform(juce::AffineTransform::translation(static_cast<float>(-area.getX()),
+                                                           static_cast<float>(-area.getY()))
+                            .scaled(scale));
+        drawEffectPanel(pg, panelBounds(panel.col, panel.row), panel.name, active, panel.chainOrder);
+
+        cache.active = active;
+        cache.scale = scale;
+    }
+
+    g.setOpacity(1.0f);
+    g.drawImage(cache.image, area.toFloat());
 }
 
 //==============================================================================
@@ -634,4 +1066,16 @@ void MultiEffectProcessorEditor::resized()
               {&fuzzMixSlider,   &fuzzMixLabel} },
             54, 72, 16);
     }
+
+    // ------------------------------------------------------------------
+    // Row 3 (cont.) – Levels | Spectrum
+
+    levelMeter.setBounds(panelBounds(1, 3));
+    spectrumDisplay.setBounds(panelBounds(2, 3));
+
+    const auto belowPanels = panelBounds(0, 3).getBottom() + kPanelPad;
+    auto strip = juce::Rectangle<int>(kPanelPad, belowPanels, getWidth() - 2 * kPanelPad, kWaveformH);
+    deadlineDisplay.setBounds(strip.removeFromRight(kDeadlineW));
+    strip.removeFromRight(kPanelPad);
+    waveformDisplay.setBounds(strip);
 }
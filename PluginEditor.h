@@ -2,6 +2,7 @@
 
 #include "MultiEffectProcessor.h"
 #include "CyberpunkLookAndFeel.h"
+#include "SignalAnalyser.h"
 #include <juce_gui_basics/juce_gui_basics.h>
 #include <array>
 #include <vector>
@@ -13,6 +14,7 @@
  * Cyberpunk / Matrix-terminal themed plugin UI.
  * Renders a scrolling Matrix-rain animation in the header, neon-bordered
  * effect panels, and custom rotary knobs / LED-style toggle buttons.
+ * Right-clicking a knob or toggle opens its MIDI-learn menu.
  */
 class MultiEffectProcessorEditor : public juce::AudioProcessorEditor,
                                    public juce::Timer
@@ -25,6 +27,24 @@ public:
     void paint(juce::Graphics&) override;
     void resized() override;
     void timerCallback() override;
+    void mouseDown(const juce::MouseEvent&) override;
+
+    /** Paint cost of the editor, measured off-screen. */
+    struct PaintTimings
+    {
+        double coldPaintMicros = 0.0;          // whole editor with every cache rebuilt, as when it opens
+        double warmPaintMicros = 0.0;          // whole editor from the caches
+        double averageFrameMicros = 0.0;       // Matrix-rain frames, clipped like timerCallback's repaints
+        double worstFrameMicros = 0.0;
+        double averageHeaderFrameMicros = 0.0; // the same frames repainting the whole header
+        int frames = 0;
+    };
+
+    /** Message thread: paints into an image, then puts the rain back where it was,
+        so the editor on screen does not jump. */
+    PaintTimings measurePaint(int frames);
+
+    static constexpr size_t numPanels = 10;
 
 private:
     MultiEffectProcessor& audioProcessor;
@@ -47,6 +67,23 @@ private:
     static const juce::String matrixChars;
     int matrixAnimCounter = 0;
 
+    /** Moves every drop one frame; returns the header areas that need repainting. */
+    juce::RectangleList<int> advanceMatrixRain();
+    juce::Rectangle<int> dropBounds(const MatrixDrop& drop) const;
+    juce::Rectangle<int> learnPromptBounds() const;
+    int shownLearnParameter = -1;
+
+    // ------------------------------------------------------------------
+    // Render caches, rebuilt when the size or display scale changes.
+    // The rain is blitted from a glyph atlas instead of laying out text per char.
+    void updateRenderCaches(float scale);
+    void drawMatrixRain(juce::Graphics& g) const;
+
+    juce::Image backgroundCache;    // body, scan-line grid, header gradient
+    juce::Image headerOverlayCache; // separator, title, version tag
+    juce::Image glyphAtlas;         // matrixChars x brightness levels
+    float cacheScale = 0.0f;
+
     // ------------------------------------------------------------------
     // UI Elements – grouped by effect
 
@@ -162,8 +199,47 @@ private:
     std::vector<std::unique_ptr<SliderAttachment>> sliderAttachments;
     std::vector<std::unique_ptr<ButtonAttachment>> buttonAttachments;
 
+    // Controls that open the MIDI-learn menu, with their parameter index
+    struct LearnTarget
+    {
+        juce::Component* component;
+        int parameterIndex;
+    };
+    std::vector<LearnTarget> learnTargets;
+
+    /** Learn / forget / curve menu for one parameter. */
+    void showMidiLearnMenu(int parameterIndex, juce::Component& target);
+
+    /** Right-click on the deadline display: trace recording and export. */
+    void showProfilingMenu();
+
+    // ------------------------------------------------------------------
+    // Meters and spectrum in the free row-3 slots, waveform below; the analyser switches the
+    // processor's signal taps on for as long as the editor exists
+    SignalAnalyser analyser { audioProcessor };
+    LevelMeterDisplay levelMeter { analyser };
+    SpectrumDisplay spectrumDisplay { analyser };
+    WaveformDisplay waveformDisplay { analyser.getWaveformHistory() };
+
+    // Callback load histogram at the right-hand end of the waveform strip
+    DeadlineDisplay deadlineDisplay { audioProcessor.getDeadlineMonitor() };
+
     // ------------------------------------------------------------------
     // Layout helpers
+    // Effect panels are rendered to images, redrawn only on on/off or scale changes
+    struct PanelCache
+    {
+        juce::Image image;
+        bool active = false;
+        float scale = 0.0f;
+    };
+    std::array<PanelCache, numPanels> panelCaches;
+    std::array<std::atomic<float>*, numPanels> panelOnValues {};
+
+    bool isPanelActive(size_t index) const;
+    juce::Rectangle<int> panelImageBounds(size_t index) const;
+    void drawCachedPanel(juce::Graphics& g, size_t index);
+
     /** Draws one cyberpunk effect panel (border, title, active indicator, chain order badge). */
     void drawEffectPanel (juce::Graphics& g,
                           juce::Rectangle<int> bounds,
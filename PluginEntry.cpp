@@ -0,0 +1,30 @@
+/*
+  ==============================================================================
+
+    PluginEntry.cpp
+    Plugin wrapper entry point, compiled into the DSP4Guitar plugin only.
+
+    MultiEffectProcessor has no editor of its own, so the host and the console
+    tools that share it never link the GUI; the plugin adds it here.
+
+  ==============================================================================
+*/
+
+#include "MultiEffectProcessor.h"
+#include "PluginEditor.h"
+
+namespace
+{
+    class DSP4GuitarPlugin : public MultiEffectProcessor
+    {
+    public:
+        bool hasEditor() const override { return true; }
+        juce::AudioProcessorEditor* createEditor() override { return new MultiEffectProcessorEditor(*this); }
+    };
+}
+
+// This creates new instances of the plugin..
+juce::AudioProcessor* JUCE_CALLTYPE createPluginFilter()
+{
+    return new DSP4GuitarPlugin();
+}
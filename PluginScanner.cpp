@@ -0,0 +1,424 @@
+#include "PluginScanner.h"
+#include "TraceRecorder.h"
+#include <juce_gui_basics/juce_gui_basics.h>
+#include <condition_variable>
+#include <deque>
+
+namespace
+{
+    // Command-line token that turns this executable into a scan worker
+    constexpr const char* workerID = "dsp4guitarpluginscanner";
+
+    juce::File getScanDataFolder()
+    {
+        return juce::File::getSpecialLocation(juce::File::userApplicationDataDirectory).getChildFile("DSP4Guitar");
+    }
+
+    //==============================================================================
+    // Worker side: scans one file per request on its own message thread and replies
+    // with the descriptions as XML.
+    class ScanWorker : public juce::ChildProcessWorker,
+                       private juce::AsyncUpdater
+    {
+    public:
+        ScanWorker() { formatManager.addDefaultFormats(); }
+        ~ScanWorker() override { cancelPendingUpdate(); }
+
+    private:
+        void handleMessageFromCoordinator(const juce::MemoryBlock& message) override
+        {
+            {
+                const std::lock_guard<std::mutex> sl(lock);
+                requests.push_back(message);
+            }
+            triggerAsyncUpdate();
+        }
+
+        void handleConnectionLost() override { juce::JUCEApplicationBase::quit(); }
+
+        void handleAsyncUpdate() override
+        {
+            for (;;)
+            {
+                juce::MemoryBlock request;
+                {
+                    const std::lock_guard<std::mutex> sl(lock);
+                    if (requests.empty())
+                        return;
+                    request = std::move(requests.front());
+                    requests.pop_front();
+                }
+                scan(request);
+            }
+        }
+
+        void scan(const juce::MemoryBlock& request)
+        {
+            juce::MemoryInputStream in(request, false);
+            const auto formatName = in.readString();
+            const auto fileOrIdentifier = in.readString();
+
+            juce::XmlElement reply("PLUGINS");
+            for (auto* format : formatManager.getFormats())
+            {
+                if (format->getName() != formatName)
+                    continue;
+
+                juce::OwnedArray<juce::PluginDescription> found;
+                format->findAllTypesForFile(found, fileOrIdentifier);
+                for (auto* description : found)
+                    reply.addChildElement(description->createXml().release());
+            }
+
+            const auto text = reply.toString();
+            sendMessageToCoordinator({ text.toRawUTF8(), text.getNumBytesAsUTF8() });
+        }
+
+        juce::AudioPluginFormatManager formatManager;
+        std::mutex lock;
+        std::deque<juce::MemoryBlock> requests;
+    };
+
+    //==============================================================================
+    // Host side: one worker process, used by one pool thread at a time.
+    class ScanProcess : private juce::ChildProcessCoordinator
+    {
+    public:
+        enum class State { waiting, finished, crashed };
+
+        ~ScanProcess() override { killWorkerProcess(); }
+
+        bool launch()
+        {
+            return launchWorkerProcess(juce::File::getSpecialLocation(juce::File::currentExecutableFile), workerID, 0, 0);
+        }
+
+        bool request(const juce::String& formatName, const juce::String& fileOrIdentifier)
+        {
+            {
+                const std::lock_guard<std::mutex> sl(lock);
+                reply.reset();
+                gotReply = false;
+            }
+
+            juce::MemoryOutputStream out;
+            out.writeString(formatName);
+            out.writeString(fileOrIdentifier);
+            return sendMessageToWorker(out.getMemoryBlock());
+        }
+
+        State wait(juce::OwnedArray<juce::PluginDescription>& found, int milliseconds)
+        {
+            std::unique_lock<std::mutex> sl(lock);
+            if (! replied.wait_for(sl, std::chrono::milliseconds(milliseconds), [this] { return gotReply || connectionLost; }))
+                return State::waiting;
+
+            if (! gotReply)
+                return State::crashed;
+
+            if (reply != nullptr)
+            {
+                for (auto* element : reply->getChildIterator())
+                {
+                    juce::PluginDescription description;
+                    if (description.loadFromXml(*element))
+                        found.add(new juce::PluginDescription(description));
+                }
+            }
+
+            return State::finished;
+        }
+
+    private:
+        void handleMessageFromWorker(const juce::MemoryBlock& message) override
+        {
+            auto xml = juce::parseXML(message.toString());
+            {
+                const std::lock_guard<std::mutex> sl(lock);
+                reply = std::move(xml);
+                gotReply = true;
+            }
+            replied.notify_one();
+        }
+
+        void handleConnectionLost() override
+        {
+            {
+                const std::lock_guard<std::mutex> sl(lock);
+                connectionLost = true;
+            }
+            replied.notify_one();
+        }
+
+        std::mutex lock;
+        std::condition_variable replied;
+        std::unique_ptr<juce::XmlElement> reply;
+        bool gotReply = false, connectionLost = false;
+    };
+
+    //==============================================================================
+    // Installed on the KnownPluginList, so PluginDirectoryScanner::scanNextFile() on a
+    // pool thread scans through a worker. Returning false blacklists the file.
+    class OutOfProcessScanner : public juce::KnownPluginList::CustomScanner
+    {
+    public:
+        bool findPluginTypesFor(juce::AudioPluginFormat& format,
+                                juce::OwnedArray<juce::PluginDescription>& result,
+                                const juce::String& fileOrIdentifier) override
+        {
+            auto process = acquire();
+
+            if (process == nullptr || ! process->request(format.getName(), fileOrIdentifier))
+            {
+                // No worker available: scan here, guarded only by the dead man's pedal
+                format.findAllTypesForFile(result, fileOrIdentifier);
+                return true;
+            }
+
+            for (;;)
+            {
+                switch (process->wait(result, 50))
+                {
+                    case ScanProcess::State::finished:
+                        release(std::move(process));
+                        return true;
+
+                    case ScanProcess::State::crashed:
+                        return false;
+
+                    case ScanProcess::State::waiting:
+                        break;
+                }
+
+                if (shouldExit())
+                    return true; // Cancelled: the busy worker is killed, nothing is blacklisted
+            }
+        }
+
+        void scanFinished() override
+        {
+            const std::lock_guard<std::mutex> sl(lock);
+            idle.clear();
+        }
+
+    private:
+        std::unique_ptr<ScanProcess> acquire()
+        {
+            {
+                const std::lock_guard<std::mutex> sl(lock);
+                if (! idle.empty())
+                {
+                    auto process = std::move(idle.back());
+                    idle.pop_back();
+                    return process;
+                }
+            }
+
+            auto process = std::make_unique<ScanProcess>();
+            return process->launch() ? std::move(process) : nullptr;
+        }
+
+        void release(std::unique_ptr<ScanProcess> process)
+        {
+            const std::lock_guard<std::mutex> sl(lock);
+            idle.push_back(std::move(process));
+        }
+
+        std::mutex lock;
+        std::vector<std::unique_ptr<ScanProcess>> idle;
+    };
+}
+
+//==============================================================================
+class PluginScanner::ScanJob : public juce::ThreadPoolJob
+{
+public:
+    explicit ScanJob(PluginScanner& scannerToServe) : ThreadPoolJob("Plugin scan"), owner(scannerToServe) {}
+
+    JobStatus runJob() override
+    {
+        // Every job pulls files from the same directory scanners until all are done
+        for (int f = 0; f < owner.formatsToScan.size() && ! shouldExit();)
+        {
+            auto* scanner = owner.getDirectoryScanner(f);
+            if (scanner == nullptr)
+            {
+                ++f;
+                continue;
+            }
+
+            owner.setCurrentFile(owner.formatsToScan[f]->getName(), scanner->getNextPluginFileThatWillBeScanned());
+
+            DSP4G_TRACE_ZONE("Scan plugin file");
+            juce::String scanned;
+            if (! scanner->scanNextFile(true, scanned))
+                ++f;
+        }
+
+        return jobHasFinished;
+    }
+
+private:
+    PluginScanner& owner;
+};
+
+//==============================================================================
+PluginScanner::PluginScanner(juce::AudioPluginFormatManager& formats, juce::KnownPluginList& list)
+    : formatManager(formats),
+      knownList(list),
+      pool(juce::jlimit(1, 4, juce::SystemStats::getNumCpus() - 1))
+{
+   #if ! (JUCE_IOS || JUCE_ANDROID)
+    knownList.setCustomScanner(std::make_unique<OutOfProcessScanner>());
+   #endif
+}
+
+PluginScanner::~PluginScanner()
+{
+    onScanFinished = nullptr;
+    cancelScan();
+    knownList.setCustomScanner(nullptr);
+}
+
+juce::File PluginScanner::getCacheFile()
+{
+    return getScanDataFolder().getChildFile("PluginCache.xml");
+}
+
+bool PluginScanner::loadCache()
+{
+    if (auto xml = juce::parseXML(getCacheFile()))
+    {
+        knownList.recreateFromXml(*xml);
+        return true;
+    }
+
+    return false;
+}
+
+void PluginScanner::saveCache() const
+{
+    if (auto xml = knownList.createXml())
+    {
+        getScanDataFolder().createDirectory();
+        if (! xml->writeTo(getCacheFile()))
+            juce::Logger::writeToLog("Could not write plugin cache: " + getCacheFile().getFullPathName());
+    }
+}
+
+//==============================================================================
+void PluginScanner::startScan(bool fullRescan)
+{
+    if (scanning)
+        return;
+
+    if (fullRescan)
+    {
+        knownList.clear();
+        knownList.clearBlacklistedFiles();
+    }
+
+    directoryScanners.clear();
+    formatsToScan.clear();
+    for (auto* format : formatManager.getFormats())
+        if (format->canScanForPlugins())
+            formatsToScan.add(format);
+
+    scanning = true;
+    for (int i = 0; i < pool.getNumThreads(); ++i)
+        pool.addJob(new ScanJob(*this), true);
+
+    startTimer(100);
+}
+
+void PluginScanner::cancelScan()
+{
+    pool.removeAllJobs(true, 10000);
+
+    if (scanning)
+        finishScan();
+}
+
+juce::PluginDirectoryScanner* PluginScanner::getDirectoryScanner(int formatIndex)
+{
+    const std::lock_guard<std::mutex> sl(scannersLock);
+
+    // Created on a pool thread: the directory walk can take a while too
+    while (directoryScanners.size() <= formatIndex)
+    {
+        auto* format = formatsToScan[directoryScanners.size()];
+        directoryScanners.add(new juce::PluginDirectoryScanner(knownList, *format,
+                                                               format->getDefaultLocationsToSearch(),
+                                                               true,
+                                                               getScanDataFolder().getChildFile("PluginScanInProgress.txt"),
+                                                               true));
+    }
+
+    return directoryScanners[formatIndex];
+}
+
+void PluginScanner::setCurrentFile(const juce::String& formatName, const juce::String& file)
+{
+    const std::lock_guard<std::mutex> sl(statusLock);
+    currentFormat = formatName;
+    currentFile = file;
+}
+
+juce::String PluginScanner::getStatus() const
+{
+    if (! scanning)
+        return {};
+
+    float progress = 0.0f;
+    {
+        const std::lock_guard<std::mutex> sl(scannersLock);
+        for (auto* scanner : directoryScanners)
+            progress += scanner->getProgress();
+    }
+    progress /= static_cast<float>(juce::jmax(1, formatsToScan.size()));
+
+    const std::lock_guard<std::mutex> sl(statusLock);
+    return "Scanning " + currentFormat + " (" + juce::String(juce::roundToInt(progress * 100.0f)) + "%): "
+           + juce::File::createFileWithoutCheckingPath(currentFile).getFileName();
+}
+
+void PluginScanner::timerCallback()
+{
+    if (pool.getNumJobs() == 0)
+        finishScan();
+}
+
+void PluginScanner::finishScan()
+{
+    stopTimer();
+    scanning = false;
+
+    // Drop listings whose plugin has been uninstalled
+    for (const auto& type : knownList.getTypes())
+    {
+        for (auto* format : formatsToScan)
+            if (format->getName() == type.pluginFormatName && ! format->doesPluginStillExist(type))
+                knownList.removeType(type);
+    }
+
+    directoryScanners.clear();
+    saveCache();
+
+    if (onScanFinished != nullptr)
+        onScanFinished();
+}
+
+//==============================================================================
+std::unique_ptr<juce::ChildProcessWorker> PluginScanner::createScanWorker(const juce::String& commandLine)
+{
+   #if JUCE_IOS || JUCE_ANDROID
+    juce::ignoreUnused(commandLine);
+    return nullptr;
+   #else
+    auto worker = std::make_unique<ScanWorker>();
+    if (worker->initialiseFromCommandLine(commandLine, workerID))
+        return worker;
+
+    return nullptr;
+   #endif
+}
@@ -0,0 +1,81 @@
+#pragma once
+
+#include <juce_audio_processors/juce_audio_processors.h>
+#include <juce_events/juce_events.h>
+#include <functional>
+#include <memory>
+#include <mutex>
+
+//==============================================================================
+/**
+ * PluginScanner
+ *
+ * Background plugin scanning for the standalone host. The message thread only
+ * starts a scan and later receives onScanFinished; the directory walk and every
+ * plugin load happen on a small thread pool, several files at a time.
+ *
+ * Each file is scanned in a child process (this executable relaunched in
+ * worker mode, see createScanWorker), so a plugin that crashes while being
+ * scanned only takes its worker down; the file is then blacklisted and the
+ * scan carries on. If no worker can be launched the file is scanned in
+ * process, guarded by a dead man's pedal file that blacklists it on the next
+ * start if the host dies.
+ *
+ * Results are kept in a KnownPluginList XML cache in the user's application
+ * data folder. A file whose listing is still up to date (same modification
+ * time as when it was scanned) is not loaded again, so after the first run a
+ * scan only touches new and changed plugins. Entries whose file has gone are
+ * dropped when a scan finishes.
+ */
+class PluginScanner : private juce::Timer
+{
+public:
+    PluginScanner(juce::AudioPluginFormatManager& formats, juce::KnownPluginList& list);
+    ~PluginScanner() override;
+
+    /** Message thread. Fills the list from the cache; false if there is none. */
+    bool loadCache();
+    void saveCache() const;
+    static juce::File getCacheFile();
+
+    /** Message thread. A full rescan forgets the cache and the blacklist first. */
+    void startScan(bool fullRescan = false);
+    void cancelScan();
+
+    bool isScanning() const noexcept { return scanning; }
+
+    /** Message thread: e.g. "Scanning VST3 (37%): Foo.vst3". */
+    juce::String getStatus() const;
+
+    /** Message thread, after the cache has been saved. */
+    std::function<void()> onScanFinished;
+
+    //==============================================================================
+    /** Call first thing in JUCEApplication::initialise. If this process was launched
+        as a scan worker, returns the worker to keep alive until the app quits (and the
+        app should create no window); otherwise nullptr. */
+    static std::unique_ptr<juce::ChildProcessWorker> createScanWorker(const juce::String& commandLine);
+
+private:
+    class ScanJob;
+
+    void timerCallback() override;
+    void finishScan();
+    juce::PluginDirectoryScanner* getDirectoryScanner(int formatIndex);
+    void setCurrentFile(const juce::String& formatName, const juce::String& file);
+
+    juce::AudioPluginFormatManager& formatManager;
+    juce::KnownPluginList& knownList;
+    juce::ThreadPool pool;
+
+    // One directory scanner per format, created by the first job that needs it
+    mutable std::mutex scannersLock;
+    juce::OwnedArray<juce::PluginDirectoryScanner> directoryScanners;
+    juce::Array<juce::AudioPluginFormat*> formatsToScan;
+
+    mutable std::mutex statusLock;
+    juce::String currentFormat, currentFile;
+    bool scanning = false;
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(PluginScanner)
+};
@@ -0,0 +1,164 @@
+#include "PluginState.h"
+#include "PresetBank.h"
+#include "SharedDSPResources.h"
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+
+namespace
+{
+    constexpr char stateMagic[4] = { 'D', '4', 'G', 'S' };
+}
+
+//==============================================================================
+PluginState::PluginState(juce::AudioProcessor& processor)
+{
+    juce::StringArray parameterIDs;
+
+    // Same indexing as PresetManager and ParameterSnapshot
+    for (auto* p : processor.getParameters())
+    {
+        if (auto* ranged = dynamic_cast<juce::RangedAudioParameter*>(p))
+        {
+            parameters.add(ranged);
+            parameterIDs.add(ranged->getParameterID());
+            idHashes.push_back(hashID(ranged->getParameterID()));
+            sortedHashes.emplace_back(idHashes.back(), parameters.size() - 1);
+            defaultValues.push_back(ranged->convertFrom0to1(ranged->getDefaultValue()));
+        }
+    }
+
+    std::sort(sortedHashes.begin(), sortedHashes.end());
+    jassert(std::adjacent_find(sortedHashes.begin(), sortedHashes.end(),
+                               [](const auto& a, const auto& b) { return a.first == b.first; })
+            == sortedHashes.end()); // Two parameter IDs hash alike: rename one
+
+    layoutHash = PresetBank::hashLayout(parameterIDs);
+}
+
+juce::uint32 PluginState::hashID(const juce::String& parameterID)
+{
+    const auto hash = SharedDSPResources::hash(parameterID.toRawUTF8());
+    return static_cast<juce::uint32>(hash ^ (hash >> 32));
+}
+
+int PluginState::findParameter(juce::uint32 idHash) const noexcept
+{
+    const auto it = std::lower_bound(sortedHashes.begin(), sortedHashes.end(), std::make_pair(idHash, 0));
+    return it != sortedHashes.end() && it->first == idHash ? it->second : -1;
+}
+
+bool PluginState::isBinaryState(const void* data, size_t numBytes) noexcept
+{
+    return data != nullptr && numBytes >= sizeof(Header)
+           && std::memcmp(data, stateMagic, sizeof(stateMagic)) == 0;
+}
+
+//==============================================================================
+void PluginState::capture(float* plainValues) const
+{
+    for (int i = 0; i < parameters.size(); ++i)
+        plainValues[i] = parameters.getUnchecked(i)->convertFrom0to1(parameters.getUnchecked(i)->getValue());
+}
+
+void PluginState::apply(const float* plainValues) const
+{
+    for (int i = 0; i < parameters.size(); ++i)
+    {
+        auto* parameter = parameters.getUnchecked(i);
+        const auto normalised = parameter->convertTo0to1(plainValues[i]);
+
+        if (parameter->getValue() != normalised)
+            parameter->setValueNotifyingHost(normalised);
+    }
+}
+
+void PluginState::write(const float* plainValues, const juce::ValueTree& extra, juce::MemoryBlock& dest) const
+{
+    jassert(juce::ByteOrder::isLittleEndian());
+
+    juce::MemoryOutputStream extraStream;
+    if (extra.isValid())
+        extra.writeToStream(extraStream);
+
+    const auto numRecords = idHashes.size();
+    dest.setSize(sizeof(Header) + numRecords * sizeof(Record) + extraStream.getDataSize(), false);
+
+    auto* out = static_cast<char*>(dest.getData());
+
+    Header header {};
+    std::memcpy(header.magic, stateMagic, sizeof(stateMagic));
+    header.version    = currentVersion;
+    header.numRecords = static_cast<juce::uint32>(numRecords);
+    header.extraBytes = static_cast<juce::uint32>(extraStream.getDataSize());
+    header.layoutHash = layoutHash;
+    std::memcpy(out, &header, sizeof(Header));
+
+    auto* records = reinterpret_cast<Record*>(out + sizeof(Header));
+    for (size_t i = 0; i < numRecords; ++i)
+        records[i] = { idHashes[i], plainValues[i] };
+
+    if (extraStream.getDataSize() > 0)
+        std::memcpy(out + sizeof(Header) + numRecords * sizeof(Record), extraStream.getData(), extraStream.getDataSize());
+}
+
+juce::Result PluginState::read(const void* data, size_t numBytes, float* plainValues, juce::ValueTree& extra) const
+{
+    if (! isBinaryState(data, numBytes))
+        return juce::Result::fail("Not a binary plugin state");
+
+    if (juce::ByteOrder::isBigEndian())
+        return juce::Result::fail("Binary plugin states are little-endian");
+
+    Header header;
+    std::memcpy(&header, data, sizeof(Header));
+
+    if (header.version == 0 || header.version > currentVersion)
+        return juce::Result::fail("Unsupported plugin state version " + juce::String(header.version));
+
+    const auto recordBytes = static_cast<juce::uint64>(header.numRecords) * sizeof(Record);
+    if (sizeof(Header) + recordBytes + header.extraBytes > numBytes)
+        return juce::Result::fail("Truncated plugin state");
+
+    const auto* bytes = static_cast<const char*>(data);
+    const auto* records = bytes + sizeof(Header);
+    auto recordAt = [records](size_t i)
+    {
+        Record record; // Host blobs need not be aligned
+        std::memcpy(&record, records + i * sizeof(Record), sizeof(Record));
+        return record;
+    };
+
+    if (header.layoutHash == layoutHash && header.numRecords == idHashes.size())
+    {
+        // Same layout: record i is parameter i
+        for (size_t i = 0; i < idHashes.size(); ++i)
+            plainValues[i] = recordAt(i).value;
+    }
+    else
+    {
+        std::copy(defaultValues.begin(), defaultValues.end(), plainValues);
+
+        for (size_t i = 0; i < header.numRecords; ++i)
+        {
+            const auto record = recordAt(i);
+            const auto index = findParameter(record.idHash);
+            if (index >= 0)
+                plainValues[index] = record.value; // Records of removed parameters are skipped
+        }
+    }
+
+    for (int i = 0; i < parameters.size(); ++i)
+    {
+        const auto& range = parameters.getUnchecked(i)->getNormalisableRange();
+        if (! std::isfinite(plainValues[i]))
+            plainValues[i] = defaultValues[static_cast<size_t>(i)];
+        plainValues[i] = juce::jlimit(range.start, range.end, plainValues[i]);
+    }
+
+    extra = header.extraBytes > 0
+                ? juce::ValueTree::readFromData(bytes + sizeof(Header) + recordBytes, header.extraBytes)
+                : juce::ValueTree();
+
+    return juce::Result::ok();
+}
@@ -0,0 +1,76 @@
+#pragma once
+
+#include <juce_audio_processors/juce_audio_processors.h>
+#include <vector>
+
+//==============================================================================
+/**
+ * PluginState
+ *
+ * Compact binary form of the plugin state for getStateInformation(), replacing
+ * the APVTS -> XML -> binary round trip. Hosts save, undo-snapshot and autosave
+ * every instance in a project, so this path runs far more often than it looks.
+ *
+ * Blob layout (little-endian, version 1):
+ *   Header   magic "D4GS", version, record count, extra size, layout hash
+ *   Records  { 32-bit parameter ID hash, plain value } per parameter
+ *   Extra    optional ValueTree (MIDI mappings, settings), ValueTree::writeToStream format
+ *
+ * The ID hashes are computed once per instance. A blob written with the same
+ * parameter layout is read back by index, record i -> parameter i; any other
+ * layout is matched record by record through a sorted hash index, and
+ * parameters missing from the blob take their default. Blobs that do not start
+ * with the magic are old XML states and are left to the caller to migrate.
+ */
+class PluginState
+{
+public:
+    static constexpr juce::uint32 currentVersion = 1;
+
+    explicit PluginState(juce::AudioProcessor& processor);
+
+    int getNumParameters() const noexcept { return parameters.size(); }
+
+    /** Plain value of every parameter, in layout order. */
+    void capture(float* plainValues) const;
+
+    /** Sets each parameter whose value differs, notifying the host. */
+    void apply(const float* plainValues) const;
+
+    void write(const float* plainValues, const juce::ValueTree& extra, juce::MemoryBlock& dest) const;
+
+    /** Fills every parameter's plain value (defaults where the blob has none) and extra. */
+    juce::Result read(const void* data, size_t numBytes, float* plainValues, juce::ValueTree& extra) const;
+
+    static bool isBinaryState(const void* data, size_t numBytes) noexcept;
+
+private:
+    struct Header
+    {
+        char magic[4];
+        juce::uint32 version;
+        juce::uint32 numRecords;
+        juce::uint32 extraBytes;
+        juce::uint64 layoutHash;
+    };
+
+    struct Record
+    {
+        juce::uint32 idHash;
+        float value;
+    };
+
+    static_assert(sizeof(Header) == 24, "state header layout must not change within a version");
+    static_assert(sizeof(Record) == 8, "state record layout must not change within a version");
+
+    static juce::uint32 hashID(const juce::String& parameterID);
+    int findParameter(juce::uint32 idHash) const noexcept;
+
+    juce::Array<juce::RangedAudioParameter*> parameters;
+    std::vector<juce::uint32> idHashes;                       // layout order
+    std::vector<std::pair<juce::uint32, int>> sortedHashes;   // hash -> parameter index
+    std::vector<float> defaultValues;                         // plain
+    juce::uint64 layoutHash = 0;
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(PluginState)
+};
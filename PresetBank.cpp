@@ -0,0 +1,422 @@
+#include "PresetBank.h"
+
+namespace
+{
+    constexpr char bankMagic[4] = { 'D', '4', 'G', 'B' };
+}
+
+//==============================================================================
+juce::uint64 PresetBank::hashLayout(const juce::StringArray& parameterIDs)
+{
+    // FNV-1a over the IDs, each terminated so "ab","c" differs from "a","bc"
+    juce::uint64 hash = 0xcbf29ce484222325ull;
+    for (const auto& id : parameterIDs)
+    {
+        for (auto* p = id.toRawUTF8(); ; ++p)
+        {
+            hash ^= static_cast<juce::uint8>(*p);
+            hash *= 0x100000001b3ull;
+            if (*p == 0)
+                break;
+        }
+    }
+    return hash;
+}
+
+//==============================================================================
+juce::Result PresetBank::open(const juce::File& bankFile, const juce::StringArray& parameterIDs,
+                              const std::vector<float>& defaultValues)
+{
+    jassert(static_cast<size_t>(parameterIDs.size()) == defaultValues.size());
+    close();
+
+    if (juce::ByteOrder::isBigEndian())
+        return juce::Result::fail("Preset banks are little-endian");
+
+    auto newMapping = std::make_unique<juce::MemoryMappedFile>(bankFile, juce::MemoryMappedFile::readOnly);
+    const auto* data = static_cast<const char*>(newMapping->getData());
+    const auto size = newMapping->getSize();
+
+    if (data == nullptr || size < sizeof(Header))
+        return juce::Result::fail("Cannot map preset bank " + bankFile.getFullPathName());
+
+    const auto* h = reinterpret_cast<const Header*>(data);
+
+    if (std::memcmp(h->magic, bankMagic, sizeof(bankMagic)) != 0)
+        return juce::Result::fail("Not a preset bank: " + bankFile.getFileName());
+
+    if (h->version == 0 || h->version > currentVersion)
+        return juce::Result::fail("Unsupported preset bank version " + juce::String(h->version));
+
+    auto fits = [size](juce::uint32 offset, juce::uint64 count, size_t elementSize)
+    {
+        return static_cast<juce::uint64>(offset) + count * elementSize <= static_cast<juce::uint64>(size);
+    };
+
+    if (! fits(h->parameterIDsOffset, h->numParameters, sizeof(StringRef))
+        || ! fits(h->presetsOffset, h->numPresets, sizeof(PresetRecord))
+        || ! fits(h->nameIndexOffset, h->numPresets, sizeof(juce::uint32))
+        || ! fits(h->tagsOffset, h->numTags, sizeof(TagRecord))
+        || ! fits(h->valuesOffset, static_cast<juce::uint64>(h->numPresets) * h->numParameters, sizeof(float))
+        || ! fits(h->stringsOffset, h->stringsSize, 1)
+        || (h->valuesOffset % alignof(float)) != 0)
+        return juce::Result::fail("Truncated or corrupt preset bank: " + bankFile.getFileName());
+
+    // Per-record ranges are checked once here so lookups never read past the mapping
+    const auto* presetRecords = reinterpret_cast<const PresetRecord*>(data + h->presetsOffset);
+    for (juce::uint32 i = 0; i < h->numPresets; ++i)
+        if (! fits(h->presetTagsOffset, static_cast<juce::uint64>(presetRecords[i].firstTag) + presetRecords[i].numTags, sizeof(juce::uint32)))
+            return juce::Result::fail("Corrupt preset tag list in " + bankFile.getFileName());
+
+    const auto* tagRecords = reinterpret_cast<const TagRecord*>(data + h->tagsOffset);
+    for (juce::uint32 i = 0; i < h->numTags; ++i)
+        if (! fits(h->tagPresetsOffset, static_cast<juce::uint64>(tagRecords[i].firstPreset) + tagRecords[i].numPresets, sizeof(juce::uint32)))
+            return juce::Result::fail("Corrupt tag index in " + bankFile.getFileName());
+
+    mapping = std::move(newMapping);
+    base = data;
+    header = h;
+    file = bankFile;
+    defaults = defaultValues;
+
+    // Match columns by parameter ID; a bank from the current layout copies straight through
+    layoutMatches = h->numParameters == static_cast<juce::uint32>(parameterIDs.size())
+                    && h->layoutHash == hashLayout(parameterIDs);
+
+    columnForParameter.assign(static_cast<size_t>(parameterIDs.size()), -1);
+
+    if (layoutMatches)
+    {
+        for (size_t i = 0; i < columnForParameter.size(); ++i)
+            columnForParameter[i] = static_cast<int>(i);
+    }
+    else
+    {
+        const auto* ids = at<StringRef>(h->parameterIDsOffset);
+        for (juce::uint32 column = 0; column < h->numParameters; ++column)
+        {
+            const auto index = parameterIDs.indexOf(getString(ids[column]));
+            if (index >= 0)
+                columnForParameter[static_cast<size_t>(index)] = static_cast<int>(column);
+        }
+    }
+
+    return juce::Result::ok();
+}
+
+void PresetBank::close()
+{
+    header = nullptr;
+    base = nullptr;
+    mapping.reset();
+    columnForParameter.clear();
+    defaults.clear();
+    layoutMatches = false;
+}
+
+//==============================================================================
+int PresetBank::getNumPresets() const noexcept
+{
+    return header != nullptr ? static_cast<int>(header->numPresets) : 0;
+}
+
+juce::String PresetBank::getString(StringRef ref) const
+{
+    if (static_cast<juce::uint64>(ref.offset) + ref.length > header->stringsSize)
+        return {};
+
+    return juce::String::fromUTF8(base + header->stringsOffset + ref.offset, static_cast<int>(ref.length));
+}
+
+juce::String PresetBank::getName(int presetIndex) const
+{
+    if (! juce::isPositiveAndBelow(presetIndex, getNumPresets()))
+        return {};
+
+    return getString(at<PresetRecord>(header->presetsOffset)[presetIndex].name);
+}
+
+juce::StringArray PresetBank::getTags(int presetIndex) const
+{
+    juce::StringArray result;
+    if (! juce::isPositiveAndBelow(presetIndex, getNumPresets()))
+        return result;
+
+    const auto& record = at<PresetRecord>(header->presetsOffset)[presetIndex];
+    const auto* tagIndices = at<juce::uint32>(header->presetTagsOffset) + record.firstTag;
+    const auto* tags = at<TagRecord>(header->tagsOffset);
+
+    for (juce::uint32 i = 0; i < record.numTags; ++i)
+        if (tagIndices[i] < header->numTags)
+            result.add(getString(tags[tagIndices[i]].name));
+
+    return result;
+}
+
+juce::StringArray PresetBank::getAllTags() const
+{
+    juce::StringArray result;
+    if (header == nullptr)
+        return result;
+
+    const auto* tags = at<TagRecord>(header->tagsOffset);
+    for (juce::uint32 i = 0; i < header->numTags; ++i)
+        result.add(getString(tags[i].name));
+
+    return result;
+}
+
+void PresetBank::copyValues(int presetIndex, float* dest) const noexcept
+{
+    if (! juce::isPositiveAndBelow(presetIndex, getNumPresets()))
+        return;
+
+    const auto* row = at<float>(header->valuesOffset) + static_cast<size_t>(presetIndex) * header->numParameters;
+
+    if (layoutMatches)
+    {
+        std::memcpy(dest, row, header->numParameters * sizeof(float));
+        return;
+    }
+
+    for (size_t i = 0; i < columnForParameter.size(); ++i)
+        dest[i] = columnForParameter[i] >= 0 ? row[columnForParameter[i]] : defaults[i];
+}
+
+//==============================================================================
+int PresetBank::findPreset(const juce::String& name) const
+{
+    if (header == nullptr)
+        return -1;
+
+    const auto* order = at<juce::uint32>(header->nameIndexOffset);
+    int low = 0, high = getNumPresets();
+
+    while (low < high)
+    {
+        const auto mid = (low + high) / 2;
+        const auto cmp = getName(static_cast<int>(order[mid])).compareIgnoreCase(name);
+
+        if (cmp == 0)
+            return static_cast<int>(order[mid]);
+
+        if (cmp < 0)
+            low = mid + 1;
+        else
+            high = mid;
+    }
+
+    return -1;
+}
+
+juce::Array<int> PresetBank::search(const juce::String& text) const
+{
+    juce::Array<int> result;
+    if (header == nullptr)
+        return result;
+
+    const auto* order = at<juce::uint32>(header->nameIndexOffset);
+    for (juce::uint32 i = 0; i < header->numPresets; ++i)
+        if (text.isEmpty() || getName(static_cast<int>(order[i])).containsIgnoreCase(text))
+            result.add(static_cast<int>(order[i]));
+
+    return result;
+}
+
+int PresetBank::findTag(const juce::String& tag) const
+{
+    if (header == nullptr)
+        return -1;
+
+    const auto* tags = at<TagRecord>(header->tagsOffset);
+    int low = 0, high = static_cast<int>(header->numTags);
+
+    while (low < high)
+    {
+        const auto mid = (low + high) / 2;
+        const auto cmp = getString(tags[mid].name).compareIgnoreCase(tag);
+
+        if (cmp == 0)
+            return mid;
+
+        if (cmp < 0)
+            low = mid + 1;
+        else
+            high = mid;
+    }
+
+    return -1;
+}
+
+juce::Array<int> PresetBank::getPresetsWithTag(const juce::String& tag) const
+{
+    juce::Array<int> result;
+    const auto tagIndex = findTag(tag);
+    if (tagIndex < 0)
+        return result;
+
+    const auto& record = at<TagRecord>(header->tagsOffset)[tagIndex];
+    const auto* presetIndices = at<juce::uint32>(header->tagPresetsOffset) + record.firstPreset;
+
+    for (juce::uint32 i = 0; i < record.numPresets; ++i)
+        if (presetIndices[i] < header->numPresets)
+            result.add(static_cast<int>(presetIndices[i]));
+
+    return result;
+}
+
+//==============================================================================
+PresetBank::Builder::Builder(const juce::StringArray& ids) : parameterIDs(ids) {}
+
+void PresetBank::Builder::addPreset(const juce::String& name, const juce::StringArray& tags, const float* values)
+{
+    Entry entry { name, tags, std::vector<float>(values, values + parameterIDs.size()) };
+    entry.tags.removeEmptyStrings();
+    entry.tags.removeDuplicates(true);
+
+    for (auto& existing : entries)
+    {
+        if (existing.name.equalsIgnoreCase(name))
+        {
+            existing = std::move(entry);
+            return;
+        }
+    }
+
+    entries.push_back(std::move(entry));
+}
+
+void PresetBank::Builder::addAllFrom(const PresetBank& bank)
+{
+    std::vector<float> values(static_cast<size_t>(parameterIDs.size()));
+
+    for (int i = 0; i < bank.getNumPresets(); ++i)
+    {
+        bank.copyValues(i, values.data());
+        addPreset(bank.getName(i), bank.getTags(i), values.data());
+    }
+}
+
+juce::MemoryBlock PresetBank::Builder::build() const
+{
+    const auto numParameters = static_cast<juce::uint32>(parameterIDs.size());
+    const auto numPresets    = static_cast<juce::uint32>(entries.size());
+
+    // --- String table ---
+    juce::MemoryOutputStream strings;
+    auto addString = [&strings](const juce::String& text)
+    {
+        const StringRef ref { static_cast<juce::uint32>(strings.getDataSize()),
+                              static_cast<juce::uint32>(text.getNumBytesAsUTF8()) };
+        strings.write(text.toRawUTF8(), ref.length);
+        return ref;
+    };
+
+    std::vector<StringRef> parameterRefs;
+    for (const auto& id : parameterIDs)
+        parameterRefs.push_back(addString(id));
+
+    // --- Sorted name index ---
+    std::vector<juce::uint32> nameIndex(numPresets);
+    for (juce::uint32 i = 0; i < numPresets; ++i)
+        nameIndex[i] = i;
+
+    std::stable_sort(nameIndex.begin(), nameIndex.end(), [this](juce::uint32 a, juce::uint32 b)
+    {
+        return entries[a].name.compareIgnoreCase(entries[b].name) < 0;
+    });
+
+    // --- Tags, sorted and de-duplicated ---
+    juce::StringArray allTags;
+    for (const auto& entry : entries)
+        for (const auto& tag : entry.tags)
+            allTags.addIfNotAlreadyThere(tag, true);
+    allTags.sort(true);
+
+    std::vector<PresetRecord> presetRecords(numPresets);
+    std::vector<juce::uint32> presetTags;
+
+    for (juce::uint32 i = 0; i < numPresets; ++i)
+    {
+        auto& record = presetRecords[i];
+        record.name = addString(entries[i].name);
+        record.firstTag = static_cast<juce::uint32>(presetTags.size());
+
+        for (const auto& tag : entries[i].tags)
+            presetTags.push_back(static_cast<juce::uint32>(allTags.indexOf(tag, true)));
+
+        record.numTags = static_cast<juce::uint32>(presetTags.size()) - record.firstTag;
+    }
+
+    std::vector<TagRecord> tagRecords(static_cast<size_t>(allTags.size()));
+    std::vector<juce::uint32> tagPresets;
+
+    for (size_t t = 0; t < tagRecords.size(); ++t)
+    {
+        auto& record = tagRecords[t];
+        record.name = addString(allTags[static_cast<int>(t)]);
+        record.firstPreset = static_cast<juce::uint32>(tagPresets.size());
+
+        for (auto presetIndex : nameIndex)
+            if (entries[presetIndex].tags.contains(allTags[static_cast<int>(t)], true))
+                tagPresets.push_back(presetIndex);
+
+        record.numPresets = static_cast<juce::uint32>(tagPresets.size()) - record.firstPreset;
+    }
+
+    // --- Lay out sections ---
+    Header header {};
+    std::memcpy(header.magic, bankMagic, sizeof(bankMagic));
+    header.version       = currentVersion;
+    header.numParameters = numParameters;
+    header.numPresets    = numPresets;
+    header.numTags       = static_cast<juce::uint32>(tagRecords.size());
+    header.layoutHash    = hashLayout(parameterIDs);
+
+    juce::MemoryOutputStream out;
+    out.write(&header, sizeof(header));
+
+    auto writeSection = [&out](const void* data, size_t numBytes, juce::uint32 alignment)
+    {
+        while (out.getDataSize() % alignment != 0)
+            out.writeByte(0);
+
+        const auto offset = static_cast<juce::uint32>(out.getDataSize());
+        if (numBytes > 0)
+            out.write(data, numBytes);
+        return offset;
+    };
+
+    header.parameterIDsOffset = writeSection(parameterRefs.data(), parameterRefs.size() * sizeof(StringRef), 8);
+    header.presetsOffset      = writeSection(presetRecords.data(), presetRecords.size() * sizeof(PresetRecord), 8);
+    header.nameIndexOffset    = writeSection(nameIndex.data(), nameIndex.size() * sizeof(juce::uint32), 4);
+    header.presetTagsOffset   = writeSection(presetTags.data(), presetTags.size() * sizeof(juce::uint32), 4);
+    header.tagsOffset         = writeSection(tagRecords.data(), tagRecords.size() * sizeof(TagRecord), 8);
+    header.tagPresetsOffset   = writeSection(tagPresets.data(), tagPresets.size() * sizeof(juce::uint32), 4);
+
+    header.valuesOffset = writeSection(nullptr, 0, 16);
+    for (const auto& entry : entries)
+        out.write(entry.values.data(), entry.values.size() * sizeof(float));
+
+    header.stringsSize   = static_cast<juce::uint32>(strings.getDataSize());
+    header.stringsOffset = writeSection(strings.getData(), strings.getDataSize(), 4);
+
+    auto block = out.getMemoryBlock();
+    block.copyFrom(&header, 0, sizeof(header));
+    return block;
+}
+
+juce::Result PresetBank::Builder::writeTo(const juce::File& bankFile) const
+{
+    const auto block = build();
+
+    // Write beside the target and swap in, so a mapped bank is never seen half-written
+    juce::TemporaryFile temp(bankFile);
+    if (! temp.getFile().replaceWithData(block.getData(), block.getSize()))
+        return juce::Result::fail("Cannot write preset bank " + temp.getFile().getFullPathName());
+
+    if (! temp.overwriteTargetFileWithTemporary())
+        return juce::Result::fail("Cannot replace preset bank " + bankFile.getFullPathName());
+
+    return juce::Result::ok();
+}
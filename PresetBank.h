@@ -0,0 +1,142 @@
+#pragma once
+
+#include <juce_core/juce_core.h>
+#include <memory>
+#include <vector>
+
+//==============================================================================
+/**
+ * PresetBank
+ *
+ * Compact, versioned binary preset bank, memory-mapped read-only when opened.
+ *
+ * Each preset is one row of normalised parameter values in
+ * createParameterLayout() order, so recall is a copy straight out of the
+ * mapped file. Names and tags live in a string table next to a sorted name
+ * index and a tag -> presets index used for search.
+ *
+ * Banks written with a different parameter layout still open: columns are
+ * matched by parameter ID once at load and parameters the bank does not know
+ * fall back to their defaults. Matching layouts recall with a single memcpy.
+ *
+ * File layout (little-endian, offsets from the start of the file):
+ *   Header
+ *   StringRef    parameterIDs[numParameters]
+ *   PresetRecord presets[numPresets]
+ *   uint32       nameIndex[numPresets]     preset indices sorted by name
+ *   uint32       presetTags[]              tag indices, grouped per preset
+ *   TagRecord    tags[numTags]             sorted by name
+ *   uint32       tagPresets[]              preset indices, grouped per tag
+ *   float        values[numPresets * numParameters]   (16-byte aligned)
+ *   char         strings[]                 UTF-8, not terminated
+ */
+class PresetBank
+{
+public:
+    static constexpr juce::uint32 currentVersion = 1;
+
+    PresetBank() = default;
+
+    /** Maps file and matches its columns against the current parameter layout. */
+    juce::Result open(const juce::File& bankFile, const juce::StringArray& parameterIDs,
+                      const std::vector<float>& defaultValues);
+    void close();
+
+    bool isOpen() const noexcept                { return header != nullptr; }
+    const juce::File& getFile() const noexcept  { return file; }
+
+    int getNumPresets() const noexcept;
+    juce::String getName(int presetIndex) const;
+    juce::StringArray getTags(int presetIndex) const;
+    juce::StringArray getAllTags() const;
+
+    /** Copies one preset's normalised values (one per current parameter) into dest. */
+    void copyValues(int presetIndex, float* dest) const noexcept;
+
+    /** Case-insensitive exact lookup through the sorted name index; -1 if absent. */
+    int findPreset(const juce::String& name) const;
+
+    /** Presets whose name contains text (case-insensitive), in name order. */
+    juce::Array<int> search(const juce::String& text) const;
+
+    /** Presets carrying tag (case-insensitive), in name order. */
+    juce::Array<int> getPresetsWithTag(const juce::String& tag) const;
+
+    static juce::uint64 hashLayout(const juce::StringArray& parameterIDs);
+
+    //==============================================================================
+    /** Collects presets in memory and serialises them to the bank format. */
+    class Builder
+    {
+    public:
+        explicit Builder(const juce::StringArray& parameterIDs);
+
+        /** Adds a preset, replacing any existing one with the same name. */
+        void addPreset(const juce::String& name, const juce::StringArray& tags, const float* values);
+
+        /** Copies every preset of an open bank (already matched to this layout). */
+        void addAllFrom(const PresetBank& bank);
+
+        int getNumPresets() const noexcept { return static_cast<int>(entries.size()); }
+
+        juce::MemoryBlock build() const;
+        juce::Result writeTo(const juce::File& bankFile) const;
+
+    private:
+        struct Entry
+        {
+            juce::String name;
+            juce::StringArray tags;
+            std::vector<float> values;
+        };
+
+        juce::StringArray parameterIDs;
+        std::vector<Entry> entries;
+    };
+
+private:
+    struct StringRef    { juce::uint32 offset, length; };
+    struct PresetRecord { StringRef name; juce::uint32 firstTag, numTags; };
+    struct TagRecord    { StringRef name; juce::uint32 firstPreset, numPresets; };
+
+    struct Header
+    {
+        char magic[4];
+        juce::uint32 version;
+        juce::uint32 numParameters;
+        juce::uint32 numPresets;
+        juce::uint32 numTags;
+        juce::uint32 reserved;
+        juce::uint64 layoutHash;
+        juce::uint32 parameterIDsOffset;
+        juce::uint32 presetsOffset;
+        juce::uint32 nameIndexOffset;
+        juce::uint32 presetTagsOffset;
+        juce::uint32 tagsOffset;
+        juce::uint32 tagPresetsOffset;
+        juce::uint32 valuesOffset;
+        juce::uint32 stringsOffset;
+        juce::uint32 stringsSize;
+        juce::uint32 padding;
+    };
+
+    static_assert(sizeof(Header) == 72, "bank header layout must not change within a version");
+
+    template <typename Type>
+    const Type* at(juce::uint32 offset) const noexcept { return reinterpret_cast<const Type*>(base + offset); }
+
+    juce::String getString(StringRef ref) const;
+    int findTag(const juce::String& tag) const;
+
+    juce::File file;
+    std::unique_ptr<juce::MemoryMappedFile> mapping;
+    const char* base = nullptr;
+    const Header* header = nullptr;
+
+    // Column of the bank that feeds each current parameter, -1 = use default
+    std::vector<int> columnForParameter;
+    std::vector<float> defaults;
+    bool layoutMatches = false;
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(PresetBank)
+};
@@ -1,17 +1,160 @@
 #include "PresetManager.h"
 
-PresetManager::PresetManager() {}
+//==============================================================================
+std::shared_ptr<SharedPresetBank> SharedPresetBank::get(const juce::File& bankFile, const juce::StringArray& parameterIDs,
+                                                        const std::vector<float>& defaultValues)
+{
+    juce::SharedResourcePointer<Registry> registry;
+    const juce::ScopedLock sl(registry->lock);
 
-void PresetManager::savePreset(const juce::String& presetName) {
-    auto preset = presetStore.getOrCreateChildWithName(presetName, nullptr);
-    preset.setProperty("drive", 1.0f, nullptr);
-    preset.setProperty("delay", 0.5f, nullptr);
+    for (auto it = registry->banks.begin(); it != registry->banks.end();)
+        it = it->second.expired() ? registry->banks.erase(it) : std::next(it);
+
+    auto& entry = registry->banks[bankFile.getFullPathName()];
+    if (auto existing = entry.lock())
+        return existing;
+
+    auto created = std::make_shared<SharedPresetBank>(bankFile, parameterIDs, defaultValues);
+    entry = created;
+    return created;
+}
+
+SharedPresetBank::SharedPresetBank(const juce::File& bankFile, const juce::StringArray& ids,
+                                   const std::vector<float>& defaults)
+    : file(bankFile), parameterIDs(ids), defaultValues(defaults)
+{
+    // Starts empty without a file; the first savePreset creates it
+    if (file.existsAsFile())
+        openResult = bank.open(file, parameterIDs, defaultValues);
+}
+
+juce::Result SharedPresetBank::savePreset(const juce::String& presetName, const juce::StringArray& tags, const float* values)
+{
+    if (file.existsAsFile() && ! bank.isOpen())
+        return juce::Result::fail("Refusing to overwrite unreadable preset bank " + file.getFullPathName());
+
+    PresetBank::Builder builder(parameterIDs);
+    builder.addAllFrom(bank);
+    builder.addPreset(presetName, tags, values);
+
+    // The process's only mapping of the file: unmapped, Windows lets it be replaced
+    bank.close();
+    file.getParentDirectory().createDirectory();
+
+    auto result = builder.writeTo(file);
+    const auto reopened = bank.open(file, parameterIDs, defaultValues);
+
+    if (result.wasOk())
+        result = reopened;
+
+    openResult = reopened;
+    listeners.call([](Listener& l) { l.presetBankChanged(); });
+    return result;
+}
+
+//==============================================================================
+PresetManager::PresetManager(juce::AudioProcessor& processor)
+{
+    // AudioProcessor::getParameters() keeps the order of createParameterLayout()
+    for (auto* p : processor.getParameters())
+    {
+        if (auto* ranged = dynamic_cast<juce::RangedAudioParameter*>(p))
+        {
+            parameters.add(ranged);
+            parameterIDs.add(ranged->getParameterID());
+            defaultValues.push_back(ranged->getDefaultValue());
+        }
+    }
+
+    scratch.resize(defaultValues.size());
+}
+
+PresetManager::~PresetManager()
+{
+    if (shared != nullptr)
+        shared->removeListener(this);
+}
+
+juce::File PresetManager::getDefaultBankFile()
+{
+    return juce::File::getSpecialLocation(juce::File::userApplicationDataDirectory)
+               .getChildFile("DSP4Guitar")
+               .getChildFile("Presets.d4gbank");
+}
+
+juce::Result PresetManager::loadBank(const juce::File& bankFile)
+{
+    if (shared != nullptr)
+        shared->removeListener(this);
+
+    shared = SharedPresetBank::get(bankFile, parameterIDs, defaultValues);
+    shared->addListener(this);
+
+    currentPreset = -1;
+    currentPresetName = {};
+    return shared->getOpenResult();
+}
+
+juce::Result PresetManager::savePreset(const juce::String& presetName, const juce::StringArray& tags)
+{
+    if (shared == nullptr)
+        loadBank(getDefaultBankFile());
+
+    captureValues(scratch.data());
+    const auto result = shared->savePreset(presetName, tags, scratch.data());
+
+    currentPresetName = presetName;
+    currentPreset = getBank().findPreset(presetName);
+    return result;
+}
+
+void PresetManager::presetBankChanged()
+{
+    currentPreset = currentPresetName.isNotEmpty() ? getBank().findPreset(currentPresetName) : -1;
+
+    if (onBankChanged != nullptr)
+        onBankChanged();
+}
+
+bool PresetManager::loadPreset(const juce::String& presetName)
+{
+    const auto index = getBank().findPreset(presetName);
+    if (index < 0)
+        return false;
+
+    loadPreset(index);
+    return true;
+}
+
+void PresetManager::loadPreset(int presetIndex)
+{
+    const auto& bank = getBank();
+    if (! juce::isPositiveAndBelow(presetIndex, bank.getNumPresets()))
+        return;
+
+    bank.copyValues(presetIndex, scratch.data());
+
+    if (onBeforeRecall != nullptr)
+        onBeforeRecall(scratch.data());
+
+    applyValues(scratch.data());
+    currentPreset = presetIndex;
+    currentPresetName = bank.getName(presetIndex);
+}
+
+//==============================================================================
+void PresetManager::captureValues(float* dest) const
+{
+    for (int i = 0; i < parameters.size(); ++i)
+        dest[i] = parameters.getUnchecked(i)->getValue();
 }
 
-void PresetManager::loadPreset(const juce::String& presetName) {
-    auto preset = presetStore.getChildWithName(presetName);
-    if (preset.isValid()) {
-        float drive = preset.getProperty("drive");
-        float delay = preset.getProperty("delay");
+void PresetManager::applyValues(const float* values)
+{
+    for (int i = 0; i < parameters.size(); ++i)
+    {
+        auto* param = parameters.getUnchecked(i);
+        if (param->getValue() != values[i])
+            param->setValueNotifyingHost(values[i]);
     }
 }
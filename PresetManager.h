@@ -1,13 +1,137 @@
 #pragma once
-#include <juce_core/juce_core.h>
-#include <juce_data_structures/juce_data_structures.h>
+#include <juce_audio_processors/juce_audio_processors.h>
+#include "PresetBank.h"
+#include <atomic>
+#include <map>
+#include <memory>
 
-class PresetManager {
+//==============================================================================
+/**
+ * SharedPresetBank
+ *
+ * One mapped PresetBank per bank file for the whole process, shared by every
+ * PresetManager that uses the file: plugin instances in a DAW, the host's
+ * built-in chain entries and the rig server's lanes. Each manager mapping the
+ * file itself meant a save replaced a file the others still had mapped, which
+ * Windows refuses. Here the only mapping is closed for the write, reopened,
+ * and every manager sharing it is told the presets changed.
+ *
+ * Banks are looked up by path in a registry of weak references, like
+ * SharedDSPResources: a bank lives while a manager holds it. Message thread
+ * only, apart from get() (locked) and reading getBank() while nobody saves.
+ */
+class SharedPresetBank
+{
 public:
-    PresetManager();
-    void savePreset(const juce::String& presetName);
-    void loadPreset(const juce::String& presetName);
+    /** Message thread. */
+    struct Listener
+    {
+        virtual ~Listener() = default;
+        virtual void presetBankChanged() = 0;
+    };
+
+    /** The shared bank for bankFile, opened against this parameter layout by its first user. */
+    static std::shared_ptr<SharedPresetBank> get(const juce::File& bankFile, const juce::StringArray& parameterIDs,
+                                                 const std::vector<float>& defaultValues);
+
+    SharedPresetBank(const juce::File& bankFile, const juce::StringArray& parameterIDs,
+                     const std::vector<float>& defaultValues);
+
+    const PresetBank& getBank() const noexcept   { return bank; }
+    const juce::File& getFile() const noexcept   { return file; }
+
+    /** Ok for a missing file (an empty bank, created by the first save). */
+    const juce::Result& getOpenResult() const noexcept { return openResult; }
+
+    /** Adds or replaces presetName with values, rewrites the file and notifies every listener. */
+    juce::Result savePreset(const juce::String& presetName, const juce::StringArray& tags, const float* values);
+
+    void addListener(Listener* listener)    { listeners.add(listener); }
+    void removeListener(Listener* listener) { listeners.remove(listener); }
 
 private:
-    juce::ValueTree presetStore{"Presets"};
+    struct Registry
+    {
+        juce::CriticalSection lock;
+        std::map<juce::String, std::weak_ptr<SharedPresetBank>> banks; // by full path
+    };
+
+    juce::SharedResourcePointer<Registry> registry; // alive while any bank is
+
+    const juce::File file;
+    const juce::StringArray parameterIDs;
+    const std::vector<float> defaultValues;
+
+    PresetBank bank;
+    juce::Result openResult { juce::Result::ok() };
+    juce::ListenerList<Listener> listeners;
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(SharedPresetBank)
+};
+
+//==============================================================================
+/**
+ * PresetManager
+ *
+ * Connects the processor's parameters to a memory-mapped PresetBank, shared
+ * with every other manager in the process that uses the same file (see
+ * SharedPresetBank). Parameters are addressed by index in
+ * createParameterLayout() order, so recalling a preset is an array copy out of
+ * the bank followed by one setValue per parameter that actually changed.
+ *
+ * Message thread only.
+ */
+class PresetManager : private SharedPresetBank::Listener
+{
+public:
+    explicit PresetManager(juce::AudioProcessor& processor);
+    ~PresetManager() override;
+
+    /** <user app data>/DSP4Guitar/Presets.d4gbank */
+    static juce::File getDefaultBankFile();
+
+    juce::Result loadBank(const juce::File& bankFile);
+    const PresetBank& getBank() const noexcept { return shared != nullptr ? shared->getBank() : noBank; }
+
+    /** Stores the current parameter values under presetName (replacing a preset of
+        the same name) and rewrites the bank file for every manager sharing it. */
+    juce::Result savePreset(const juce::String& presetName, const juce::StringArray& tags = {});
+
+    bool loadPreset(const juce::String& presetName);
+    void loadPreset(int presetIndex);
+    int getCurrentPreset() const noexcept { return currentPreset.load(std::memory_order_relaxed); }
+
+    /** Called with the preset's normalised values just before they are written to the
+        parameters, e.g. so the processor can crossfade instead of jumping. */
+    std::function<void(const float* normalisedValues)> onBeforeRecall;
+
+    /** Called after this or another manager sharing the bank saved a preset; preset
+        indices may have moved. getCurrentPreset() already follows its preset's name. */
+    std::function<void()> onBankChanged;
+
+    juce::Array<int> search(const juce::String& text) const          { return getBank().search(text); }
+    juce::Array<int> getPresetsWithTag(const juce::String& tag) const { return getBank().getPresetsWithTag(tag); }
+
+    //==============================================================================
+    int getNumParameters() const noexcept                { return parameters.size(); }
+    const juce::StringArray& getParameterIDs() const noexcept { return parameterIDs; }
+
+    /** Normalised value of every parameter, in layout order. */
+    void captureValues(float* dest) const;
+    void applyValues(const float* values);
+
+private:
+    void presetBankChanged() override;
+
+    juce::Array<juce::RangedAudioParameter*> parameters;
+    juce::StringArray parameterIDs;
+    std::vector<float> defaultValues;
+    std::vector<float> scratch;
+
+    std::shared_ptr<SharedPresetBank> shared;
+    PresetBank noBank; // until loadBank()
+    std::atomic<int> currentPreset { -1 }; // also read by the audio thread's deadline monitor
+    juce::String currentPresetName;
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(PresetManager)
 };
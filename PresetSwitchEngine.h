@@ -0,0 +1,330 @@
+#pragma once
+
+#include <juce_audio_basics/juce_audio_basics.h>
+#include <juce_dsp/juce_dsp.h>
+#include "LazyEffectState.h"
+#include <array>
+#include <atomic>
+#include <cmath>
+#include <vector>
+
+//==============================================================================
+/**
+ * PresetSwitchEngine
+ *
+ * Gapless preset switching with two complete engines. The live engine follows
+ * the parameters as usual. A switch loads the target preset into the spare
+ * engine on the shared background thread, then the audio thread crossfades
+ * the *input* between the engines with an equal-power law over a crossfade
+ * window set per instance (50 ms by default: no click, yet short enough to
+ * feel instant under the feet; longer suits pads and swells). The
+ * outgoing engine keeps running on silence afterwards, so its delay and reverb
+ * tails ring out under the new preset for up to maxTailSeconds (10 s); once it
+ * is quiet its heavy buffers are released and only its preallocated arena
+ * stays resident.
+ *
+ * The spare engine (always engines[1 - live]) changes hands through one atomic:
+ *   Idle      free; the background thread or the audio thread may claim it
+ *   Loading   background is loading the requested preset
+ *   Ready     loaded; the audio thread starts the crossfade at its next block
+ *   Playing   audio thread owns it (ringing out as the outgoing engine)
+ *   Retiring  tail finished; background releases its heavy state, then Idle
+ *
+ * switchNow() is the audio-thread variant for MIDI program changes: it loads
+ * the spare in place (no allocation) and starts the crossfade at the exact
+ * sample, cancelling any switch still queued from the message thread. While
+ * the spare is still crossfading or ringing out it is left alone (reloading it
+ * would cut its tail with a click) and the live engine jumps instead.
+ *
+ * While a switch is pending the live engine ignores parameter updates: the
+ * parameters already hold the incoming preset, and applying them to the
+ * outgoing engine is exactly the jump this class exists to avoid.
+ *
+ * EngineType needs Snapshot and Taps types, prepare(spec, snapshot), release(),
+ * load(snapshot) (engine not processing), and setParameters(snapshot),
+ * loadRealtime(snapshot) and process(context, taps) for the audio thread.
+ * Only the live engine is given the taps.
+ */
+template <typename EngineType>
+class PresetSwitchEngine : private juce::TimeSliceClient
+{
+public:
+    using Snapshot = typename EngineType::Snapshot;
+    using Taps = typename EngineType::Taps;
+
+    PresetSwitchEngine()           { backgroundThread->addTimeSliceClient(this); }
+    ~PresetSwitchEngine() override { backgroundThread->removeTimeSliceClient(this); }
+
+    //==============================================================================
+    /** Audio stopped. Prepares both engines; only the live one keeps delay/reverb memory. */
+    void prepare(const juce::dsp::ProcessSpec& newSpec, const Snapshot& params)
+    {
+        const juce::ScopedLock sl(lock);
+
+        spec = newSpec;
+        for (auto& engine : engines)
+            engine.prepare(spec, params);
+
+        live = 0;
+        engines[1].release();
+
+        spareBuffer.setSize(static_cast<int>(spec.numChannels), static_cast<int>(spec.maximumBlockSize), false, true, true);
+        gainIn.assign(spec.maximumBlockSize, 1.0f);
+        gainOut.assign(spec.maximumBlockSize, 0.0f);
+
+        outgoingActive = false;
+        liveSeq = requestSeq.load();
+        spareState = Idle;
+    }
+
+    /** Audio stopped. */
+    void release()
+    {
+        const juce::ScopedLock sl(lock);
+        for (auto& engine : engines)
+            engine.release();
+
+        outgoingActive = false;
+        spareState = Idle;
+    }
+
+    static constexpr double defaultCrossfadeSeconds = 0.05;
+    static constexpr double minCrossfadeSeconds = 0.005, maxCrossfadeSeconds = 2.0;
+
+    /** Any thread; takes effect at the next switch. */
+    void setCrossfadeSeconds(double seconds) noexcept
+    {
+        crossfadeSeconds.store(juce::jlimit(minCrossfadeSeconds, maxCrossfadeSeconds, seconds));
+    }
+
+    double getCrossfadeSeconds() const noexcept { return crossfadeSeconds.load(); }
+
+    template <typename Function>
+    void forEachEngine(Function&& f) const { for (const auto& engine : engines) f(engine); }
+
+    template <typename Function>
+    void forEachEngine(Function&& f)       { for (auto& engine : engines) f(engine); }
+
+    //==============================================================================
+    /** Any non-audio thread. The newest request wins if several arrive before the
+        spare engine is free. Call before writing the new values to the parameters. */
+    void requestSwitch(const Snapshot& target)
+    {
+        const juce::ScopedLock sl(pendingLock);
+        pending = target;
+        requestSeq.fetch_add(1);
+    }
+
+    bool isSwitchPending() const noexcept { return requestSeq.load() != liveSeq.load(); }
+
+    /** Audio thread: switches to target starting at the next processed sample.
+        Crossfades like requestSwitch() when the spare engine is free; otherwise
+        jumps the live engine's parameters and returns false. */
+    bool switchNow(const Snapshot& target) noexcept
+    {
+        // Anything queued from the message thread is older than this switch
+        liveSeq.store(requestSeq.load());
+
+        auto state = spareState.load(std::memory_order_acquire);
+        const bool claimed = (state == Idle || state == Ready)
+                             && spareState.compare_exchange_strong(state, Playing, std::memory_order_acq_rel);
+
+        if (! claimed)
+        {
+            engines[live].setParameters(target);
+            return false;
+        }
+
+        engines[1 - live].loadRealtime(target);
+        spareSeq.store(liveSeq.load());
+        startCrossfade();
+        return true;
+    }
+
+    //==============================================================================
+    /** Audio thread. params must be captured before this call (see requestSwitch). */
+    void process(const juce::dsp::AudioBlock<float>& block, const Snapshot& params, Taps* taps = nullptr) noexcept
+    {
+        const auto maxBlock = static_cast<size_t>(spareBuffer.getNumSamples());
+        if (maxBlock == 0)
+            return;
+
+        for (size_t start = 0; start < block.getNumSamples(); start += maxBlock)
+            processChunk(block.getSubBlock(start, juce::jmin(maxBlock, block.getNumSamples() - start)), params, taps);
+    }
+
+private:
+    enum SpareState { Idle, Loading, Ready, Playing, Retiring };
+
+    void processChunk(juce::dsp::AudioBlock<float> block, const Snapshot& params, Taps* taps) noexcept
+    {
+        if (spareState.load(std::memory_order_acquire) == Ready)
+        {
+            // A load overtaken by switchNow() is stale: hand it straight back
+            if (spareSeq.load() == liveSeq.load())
+                spareState.store(Retiring, std::memory_order_release);
+            else
+                startCrossfade();
+        }
+
+        auto& liveEngine = engines[live];
+        if (! isSwitchPending())
+            liveEngine.setParameters(params);
+
+        if (! outgoingActive)
+        {
+            liveEngine.process(juce::dsp::ProcessContextReplacing<float>(block), taps);
+            return;
+        }
+
+        const auto numSamples = block.getNumSamples();
+        auto outgoingBlock = juce::dsp::AudioBlock<float>(spareBuffer)
+                                 .getSubsetChannelBlock(0, block.getNumChannels())
+                                 .getSubBlock(0, numSamples);
+
+        if (fadePosition < fadeLength)
+        {
+            // Equal-power input crossfade: the new engine takes over the signal,
+            // the old one gets less and less of it but keeps its own output
+            for (size_t i = 0; i < numSamples; ++i)
+            {
+                const auto t = juce::jmin(1.0f, static_cast<float>(fadePosition + i) / static_cast<float>(fadeLength));
+                gainIn[i]  = std::sin(t * juce::MathConstants<float>::halfPi);
+                gainOut[i] = std::cos(t * juce::MathConstants<float>::halfPi);
+            }
+
+            for (size_t ch = 0; ch < block.getNumChannels(); ++ch)
+            {
+                auto* in = block.getChannelPointer(ch);
+                juce::FloatVectorOperations::multiply(outgoingBlock.getChannelPointer(ch), in, gainOut.data(), static_cast<int>(numSamples));
+                juce::FloatVectorOperations::multiply(in, gainIn.data(), static_cast<int>(numSamples));
+            }
+
+            fadePosition += numSamples;
+        }
+        else
+        {
+            outgoingBlock.clear();
+        }
+
+        liveEngine.process(juce::dsp::ProcessContextReplacing<float>(block), taps);
+        engines[1 - live].process(juce::dsp::ProcessContextReplacing<float>(outgoingBlock));
+
+        if (fadePosition >= fadeLength)
+            updateTail(outgoingBlock);
+
+        block.add(outgoingBlock);
+    }
+
+    void startCrossfade() noexcept
+    {
+        live = 1 - live.load();
+        liveSeq.store(spareSeq.load());
+        spareState.store(Playing, std::memory_order_release);
+
+        const auto sampleRate = spec.sampleRate;
+        fadeLength     = juce::jmax<size_t>(1, static_cast<size_t>(crossfadeSeconds.load() * sampleRate));
+        maxTailSamples = static_cast<size_t>(maxTailSeconds * sampleRate);
+        quietHoldSamples = static_cast<size_t>(quietHoldSeconds * sampleRate);
+
+        fadePosition = 0;
+        tailSamples = 0;
+        quietSamples = 0;
+        cutPosition = 0;
+        cutting = false;
+        outgoingActive = true;
+    }
+
+    /** Ring-out bookkeeping for the outgoing engine, after the crossfade. */
+    void updateTail(juce::dsp::AudioBlock<float>& outgoingBlock) noexcept
+    {
+        const auto numSamples = outgoingBlock.getNumSamples();
+
+        // A newer switch needs the spare engine: fade the remaining tail out instead
+        if (! cutting && isSwitchPending())
+            cutting = true;
+
+        if (cutting)
+        {
+            for (size_t i = 0; i < numSamples; ++i)
+                gainOut[i] = juce::jmax(0.0f, 1.0f - static_cast<float>(cutPosition + i) / static_cast<float>(fadeLength));
+
+            for (size_t ch = 0; ch < outgoingBlock.getNumChannels(); ++ch)
+                juce::FloatVectorOperations::multiply(outgoingBlock.getChannelPointer(ch), gainOut.data(), static_cast<int>(numSamples));
+
+            cutPosition += numSamples;
+        }
+
+        const auto range = outgoingBlock.findMinAndMax();
+        const auto peak = juce::jmax(std::abs(range.getStart()), std::abs(range.getEnd()));
+
+        quietSamples = peak < silenceThreshold ? quietSamples + numSamples : 0;
+        tailSamples += numSamples;
+
+        if (quietSamples >= quietHoldSamples || tailSamples >= maxTailSamples || (cutting && cutPosition >= fadeLength))
+        {
+            outgoingActive = false;
+            spareState.store(Retiring, std::memory_order_release);
+        }
+    }
+
+    int useTimeSlice() override
+    {
+        const juce::ScopedLock sl(lock);
+
+        // The audio thread never moves `live` while the spare is Loading or Retiring,
+        // so engines[1 - live] is only looked up once one of those states is held
+        if (spareState.load(std::memory_order_acquire) == Retiring)
+        {
+            engines[1 - live].release();
+            spareState.store(Idle, std::memory_order_release);
+        }
+
+        auto state = static_cast<int>(Idle);
+        if (isSwitchPending() && spec.sampleRate > 0.0
+            && spareState.compare_exchange_strong(state, Loading, std::memory_order_acq_rel))
+        {
+            Snapshot target;
+            juce::uint32 seq = 0;
+            {
+                const juce::ScopedLock pl(pendingLock);
+                target = pending;
+                seq = requestSeq.load();
+            }
+
+            engines[1 - live].load(target);
+            spareSeq.store(seq);
+            spareState.store(Ready, std::memory_order_release);
+        }
+
+        // Poll quickly while a switch is in flight, lazily otherwise
+        return spareState.load() == Idle && ! isSwitchPending() ? 20 : 2;
+    }
+
+    static constexpr float silenceThreshold = 1.0e-4f; // -80 dBFS
+    static constexpr double quietHoldSeconds = 0.1;
+    static constexpr double maxTailSeconds = 10.0;
+
+    juce::SharedResourcePointer<DSPBackgroundThread> backgroundThread;
+    juce::CriticalSection lock;        // background thread vs prepare/release
+    juce::CriticalSection pendingLock; // requesting thread vs background thread
+
+    std::array<EngineType, 2> engines;
+    juce::dsp::ProcessSpec spec {};
+    Snapshot pending;
+
+    // Audio thread (and prepare/release while audio is stopped); `live` is
+    // atomic only because the background thread peeks at it
+    std::atomic<int> live { 0 };
+    bool outgoingActive = false, cutting = false;
+    size_t fadeLength = 1, fadePosition = 0, cutPosition = 0;
+    size_t tailSamples = 0, quietSamples = 0, maxTailSamples = 0, quietHoldSamples = 0;
+    juce::AudioBuffer<float> spareBuffer;
+    std::vector<float> gainIn, gainOut;
+
+    std::atomic<int> spareState { Idle };
+    std::atomic<juce::uint32> requestSeq { 0 }, liveSeq { 0 }, spareSeq { 0 };
+    std::atomic<double> crossfadeSeconds { defaultCrossfadeSeconds };
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(PresetSwitchEngine)
+};
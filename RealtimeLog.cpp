@@ -0,0 +1,191 @@
+#include "RealtimeLog.h"
+
+namespace
+{
+    const char* getLevelName(RealtimeLog::Level level)
+    {
+        switch (level)
+        {
+            case RealtimeLog::Level::info:    return "info";
+            case RealtimeLog::Level::warning: return "warning";
+            case RealtimeLog::Level::error:   return "error";
+        }
+
+        return "?";
+    }
+
+    juce::File getRotatedFile(const juce::File& file, int index)
+    {
+        return file.getSiblingFile(file.getFileNameWithoutExtension() + "." + juce::String(index) + file.getFileExtension());
+    }
+}
+
+//==============================================================================
+RealtimeLog::RealtimeLog()
+    : juce::Thread("Realtime log writer"),
+      slots(new Slot[capacity])
+{
+    static_assert((capacity & (capacity - 1)) == 0, "capacity must be a power of two");
+
+    for (size_t i = 0; i < static_cast<size_t>(capacity); ++i)
+        slots[i].sequence.store(i, std::memory_order_relaxed);
+
+    startThread(juce::Thread::Priority::low);
+}
+
+RealtimeLog::~RealtimeLog()
+{
+    stopThread(2000);
+    writePending(); // Whatever arrived after the last pass
+}
+
+juce::File RealtimeLog::getLogFile()
+{
+    return juce::File::getSpecialLocation(juce::File::userApplicationDataDirectory)
+               .getChildFile("DSP4Guitar")
+               .getChildFile("Logs")
+               .getChildFile("realtime.log");
+}
+
+//==============================================================================
+bool RealtimeLog::push(const Record& record) noexcept
+{
+    auto position = enqueuePosition.load(std::memory_order_relaxed);
+
+    for (;;)
+    {
+        auto& slot = slots[position & static_cast<size_t>(capacity - 1)];
+        const auto sequence = slot.sequence.load(std::memory_order_acquire);
+        const auto difference = static_cast<std::ptrdiff_t>(sequence) - static_cast<std::ptrdiff_t>(position);
+
+        if (difference == 0)
+        {
+            if (enqueuePosition.compare_exchange_weak(position, position + 1, std::memory_order_relaxed))
+            {
+                slot.record = record;
+                slot.sequence.store(position + 1, std::memory_order_release);
+                return true;
+            }
+        }
+        else if (difference < 0)
+        {
+            dropped.fetch_add(1, std::memory_order_relaxed); // Full: the writer is behind
+            return false;
+        }
+        else
+        {
+            position = enqueuePosition.load(std::memory_order_relaxed);
+        }
+    }
+}
+
+bool RealtimeLog::pop(Record& record) noexcept
+{
+    auto& slot = slots[dequeuePosition & static_cast<size_t>(capacity - 1)];
+    if (slot.sequence.load(std::memory_order_acquire) != dequeuePosition + 1)
+        return false;
+
+    record = slot.record;
+    slot.sequence.store(dequeuePosition + static_cast<size_t>(capacity), std::memory_order_release);
+    ++dequeuePosition;
+    return true;
+}
+
+//==============================================================================
+void RealtimeLog::run()
+{
+    while (! threadShouldExit())
+    {
+        writePending();
+        wait(100);
+    }
+}
+
+void RealtimeLog::flush()
+{
+    writePending();
+}
+
+void RealtimeLog::writePending()
+{
+    const juce::ScopedLock sl(writeLock);
+
+    juce::String text;
+    Record record;
+    while (pop(record))
+        text << formatRecord(record) << juce::newLine;
+
+    const auto lost = dropped.load(std::memory_order_relaxed);
+    if (lost != droppedReported)
+    {
+        text << juce::Time::getCurrentTime().formatted("%Y-%m-%d %H:%M:%S") << " [warning] "
+             << static_cast<juce::int64>(lost - droppedReported) << " records dropped (log ring full)" << juce::newLine;
+        droppedReported = lost;
+    }
+
+    if (text.isEmpty())
+        return;
+
+    rotateIfNeeded(static_cast<int>(text.getNumBytesAsUTF8()));
+    if (stream != nullptr)
+    {
+        stream->writeText(text, false, false, nullptr);
+        stream->flush();
+    }
+}
+
+void RealtimeLog::rotateIfNeeded(int bytesToWrite)
+{
+    const auto file = getLogFile();
+
+    if (stream != nullptr && stream->getPosition() + bytesToWrite <= maxFileBytes)
+        return;
+
+    stream = nullptr;
+
+    if (file.getSize() + bytesToWrite > maxFileBytes)
+    {
+        // realtime.log -> realtime.1.log -> ... -> realtime.<numOldFiles>.log, the oldest deleted
+        getRotatedFile(file, numOldFiles).deleteFile();
+        for (int i = numOldFiles - 1; i >= 1; --i)
+            getRotatedFile(file, i).moveFileTo(getRotatedFile(file, i + 1));
+        file.moveFileTo(getRotatedFile(file, 1));
+    }
+
+    file.getParentDirectory().createDirectory();
+    stream = std::make_unique<juce::FileOutputStream>(file);
+    if (! stream->openedOk())
+        stream = nullptr;
+}
+
+juce::String RealtimeLog::formatRecord(const Record& record) const
+{
+    const auto millis = originMillis + (record.ticks - originTicks) * 1000 / juce::Time::getHighResolutionTicksPerSecond();
+    const auto time = juce::Time(millis);
+
+    juce::String line;
+    line << time.formatted("%Y-%m-%d %H:%M:%S") << "." << juce::String(time.getMilliseconds()).paddedLeft('0', 3)
+         << " [" << getLevelName(record.level) << "] ";
+
+    // "{}" takes the next argument; any left over are appended
+    int next = 0;
+    for (auto* c = record.format; c != nullptr && *c != 0; ++c)
+    {
+        if (c[0] == '{' && c[1] == '}' && next < record.numArgs)
+        {
+            const auto& arg = record.args[static_cast<size_t>(next++)];
+            switch (arg.type)
+            {
+                case Arg::Type::integer: line << arg.integer; break;
+                case Arg::Type::real:    line << juce::String(arg.real, 6); break;
+                case Arg::Type::text:    line << (arg.text != nullptr ? arg.text : "(null)"); break;
+            }
+            ++c;
+            continue;
+        }
+
+        line << juce::String::charToString(static_cast<juce::juce_wchar>(static_cast<unsigned char>(*c)));
+    }
+
+    return line;
+}
@@ -0,0 +1,175 @@
+#pragma once
+
+#include <juce_core/juce_core.h>
+#include <array>
+#include <atomic>
+#include <memory>
+#include <type_traits>
+
+//==============================================================================
+/**
+ * RealtimeLog
+ *
+ * A log the audio thread can write to. log() copies a binary record (the
+ * format string's address, a timestamp and up to four numbers or static
+ * strings) into a fixed-size lock-free ring and returns; nothing is formatted,
+ * allocated or locked on the calling thread. A background thread formats the
+ * records ("{}" in the format takes the next argument) and appends them to
+ * DSP4Guitar/Logs/realtime.log, rotating it at 1 MiB and keeping four old
+ * files. When the ring is full the record is dropped and counted, and the
+ * writer logs how many were lost.
+ *
+ * Format strings and text arguments must be string literals (or otherwise
+ * outlive the process): only their addresses are stored.
+ *
+ * One log per process, shared through juce::SharedResourcePointer<RealtimeLog>
+ * like SharedDSPResources; the writer thread runs while any holder exists.
+ *
+ *   log->log(RealtimeLog::Level::warning, "NaN in channel {} at sample {}", ch, i);
+ */
+class RealtimeLog : private juce::Thread
+{
+public:
+    enum class Level : juce::uint8 { info, warning, error };
+
+    static constexpr int capacity = 4096; // records; a power of two
+    static constexpr int maxArgs = 4;
+    static constexpr juce::int64 maxFileBytes = 1024 * 1024;
+    static constexpr int numOldFiles = 4;
+
+    RealtimeLog();
+    ~RealtimeLog() override;
+
+    /** Any thread, including real-time ones. False if the record was dropped. */
+    template <typename... Args>
+    bool log(Level level, const char* format, Args... args) noexcept
+    {
+        static_assert(sizeof...(Args) <= maxArgs, "RealtimeLog records hold at most maxArgs arguments");
+
+        Record record;
+        record.ticks = juce::Time::getHighResolutionTicks();
+        record.format = format;
+        record.level = level;
+        record.numArgs = static_cast<juce::uint8>(sizeof...(Args));
+        int index = 0;
+        (setArg(record.args[static_cast<size_t>(index++)], args), ...);
+        return push(record);
+    }
+
+    juce::uint64 getNumDropped() const noexcept { return dropped.load(std::memory_order_relaxed); }
+
+    /** Message thread: returns once everything logged so far is in the file. */
+    void flush();
+
+    static juce::File getLogFile();
+
+    //==============================================================================
+    /**
+     * Lets an event through at most once per interval and counts the rest, so a
+     * fault that repeats every block costs one record per second, not one per block.
+     * Owned and used by a single thread.
+     */
+    class Throttle
+    {
+    public:
+        explicit Throttle(double intervalSeconds = 1.0) noexcept
+            : intervalTicks(static_cast<juce::int64>(intervalSeconds * static_cast<double>(juce::Time::getHighResolutionTicksPerSecond()))) {}
+
+        /** True if this occurrence should be logged; suppressed is how many were skipped
+            since the last one that was. */
+        bool allow(int& suppressed) noexcept
+        {
+            const auto now = juce::Time::getHighResolutionTicks();
+            if (last != 0 && now - last < intervalTicks)
+            {
+                ++skipped;
+                return false;
+            }
+
+            last = now;
+            suppressed = skipped;
+            skipped = 0;
+            return true;
+        }
+
+    private:
+        juce::int64 intervalTicks;
+        juce::int64 last = 0;
+        int skipped = 0;
+    };
+
+private:
+    struct Arg
+    {
+        enum class Type : juce::uint8 { integer, real, text };
+        Type type = Type::integer;
+        union
+        {
+            juce::int64 integer;
+            double real;
+            const char* text;
+        };
+
+        Arg() : integer(0) {}
+    };
+
+    struct Record
+    {
+        juce::int64 ticks = 0;
+        const char* format = nullptr;
+        Level level = Level::info;
+        juce::uint8 numArgs = 0;
+        std::array<Arg, maxArgs> args;
+    };
+
+    // Bounded MPMC queue (Vyukov): a slot's sequence says whose turn it is
+    struct Slot
+    {
+        std::atomic<size_t> sequence { 0 };
+        Record record;
+    };
+
+    template <typename T>
+    static void setArg(Arg& arg, T value) noexcept
+    {
+        if constexpr (std::is_same_v<std::decay_t<T>, const char*> || std::is_same_v<std::decay_t<T>, char*>)
+        {
+            arg.type = Arg::Type::text;
+            arg.text = value;
+        }
+        else if constexpr (std::is_floating_point_v<T>)
+        {
+            arg.type = Arg::Type::real;
+            arg.real = static_cast<double>(value);
+        }
+        else
+        {
+            static_assert(std::is_integral_v<T> || std::is_enum_v<T>, "Only numbers and static strings can be logged");
+            arg.type = Arg::Type::integer;
+            arg.integer = static_cast<juce::int64>(value);
+        }
+    }
+
+    bool push(const Record& record) noexcept;
+    bool pop(Record& record) noexcept;
+
+    void run() override;
+    void writePending();
+    juce::String formatRecord(const Record& record) const;
+    void rotateIfNeeded(int bytesToWrite);
+
+    std::unique_ptr<Slot[]> slots;
+    std::atomic<size_t> enqueuePosition { 0 };
+    size_t dequeuePosition = 0; // writer thread
+    std::atomic<juce::uint64> dropped { 0 };
+    juce::uint64 droppedReported = 0;
+
+    // Wall-clock time of a high-resolution tick count
+    const juce::int64 originTicks = juce::Time::getHighResolutionTicks();
+    const juce::int64 originMillis = juce::Time::currentTimeMillis();
+
+    juce::CriticalSection writeLock; // writer thread vs flush()
+    std::unique_ptr<juce::FileOutputStream> stream;
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(RealtimeLog)
+};
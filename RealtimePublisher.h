@@ -0,0 +1,75 @@
+#pragma once
+
+#include <juce_core/juce_core.h>
+#include <atomic>
+#include <memory>
+
+//==============================================================================
+/**
+ * RealtimePublisher
+ *
+ * Hands immutable tables (MIDI program slots, MIDI-learn mappings) from one
+ * non-real-time writer to the audio thread without locks or allocation on the
+ * audio side. Same three-slot handoff as LazyEffectState:
+ *   pending – writer publishes a new object
+ *   current – audio thread's object, swapped in by acquire()
+ *   retired – audio hands the previous object back; the writer deletes it
+ *
+ * The audio thread only swaps when the retired slot is empty, so nothing is
+ * ever freed on the audio thread and at most three objects exist at once.
+ * publish() empties the retired slot after storing the new object, so the
+ * newest object is never held back until the writer calls again.
+ */
+template <typename Type>
+class RealtimePublisher
+{
+public:
+    RealtimePublisher() = default;
+
+    ~RealtimePublisher()
+    {
+        delete current;
+        delete pending.exchange(nullptr);
+        delete retired.exchange(nullptr);
+    }
+
+    /** Writer thread. Replaces any object the audio thread has not picked up yet. */
+    void publish(std::unique_ptr<Type> next)
+    {
+        collectGarbage();
+        delete pending.exchange(next.release(), std::memory_order_acq_rel);
+
+        // The audio thread may have adopted the previous object in between and filled
+        // retired again; emptied here, so next is picked up at the next block rather than
+        // waiting on the writer's next call
+        collectGarbage();
+    }
+
+    /** Writer thread. Frees the object the audio thread has finished with. */
+    void collectGarbage()
+    {
+        delete retired.exchange(nullptr, std::memory_order_acquire);
+    }
+
+    /** Audio thread, once per block: adopts the newest published object. May return nullptr. */
+    const Type* acquire() noexcept
+    {
+        if (retired.load(std::memory_order_relaxed) == nullptr)
+        {
+            if (auto* next = pending.exchange(nullptr, std::memory_order_acquire))
+            {
+                retired.store(current, std::memory_order_release);
+                current = next;
+            }
+        }
+
+        return current;
+    }
+
+private:
+    Type* current = nullptr; // audio thread
+    std::atomic<Type*> pending { nullptr };
+    std::atomic<Type*> retired { nullptr };
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(RealtimePublisher)
+};
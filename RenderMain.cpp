@@ -0,0 +1,74 @@
+/*
+  ==============================================================================
+
+    RenderMain.cpp
+    Entry point of DSP4GuitarRender, the headless batch renderer.
+
+    DSP4GuitarRender --in=<DI folder> --out=<folder> --presets=all
+                     [--states=<folder>] [--bank=<file>] [--block=512]
+                     [--oversampling=0-3] [--filter=iir|fir] [--threads=N]
+
+    Renders every input through every preset (see OfflineRenderer) and
+    writes render-report.csv to the output folder.
+
+  ==============================================================================
+*/
+
+#include "OfflineRenderer.h"
+#include <cstdio>
+
+int main(int argc, char* argv[])
+{
+    // The processors own timers, so there has to be a message manager, though no loop runs
+    juce::ScopedJuceInitialiser_GUI juceInitialiser;
+
+    // Back into one command line, values with spaces quoted, for Options::fromCommandLine
+    juce::StringArray arguments;
+    for (int i = 1; i < argc; ++i)
+    {
+        const juce::String argument(juce::CharPointer_UTF8(argv[i]));
+        arguments.add(argument.containsChar(' ') ? argument.upToFirstOccurrenceOf("=", true, false)
+                                                       + argument.fromFirstOccurrenceOf("=", false, false).quoted()
+                                                 : argument);
+    }
+
+    const auto options = OfflineRenderer::Options::fromCommandLine(arguments.joinIntoString(" "));
+    if (options.inputFolder == juce::File() || options.outputFolder == juce::File())
+    {
+        std::printf("usage: DSP4GuitarRender --in=<folder> --out=<folder> [--states=<folder>] [--presets=all|a,b]\n"
+                    "                        [--bank=<file>] [--block=512] [--oversampling=0-3] [--filter=iir|fir] [--threads=N]\n");
+        return 2;
+    }
+
+    OfflineRenderer renderer(options);
+    const auto collected = renderer.collect();
+    if (collected.failed())
+    {
+        std::printf("%s\n", collected.getErrorMessage().toRawUTF8());
+        return 1;
+    }
+
+    std::printf("Rendering %d jobs on %d threads, %d-sample blocks, %dx oversampling\n", renderer.getNumJobs(),
+                juce::jmin(options.numThreads, renderer.getNumJobs()), options.blockSize, 1 << options.oversamplingFactor);
+
+    const auto numJobs = renderer.getNumJobs();
+    renderer.run([numJobs](const OfflineRenderer::JobResult& result, int numFinished)
+    {
+        std::printf("[%d/%d] %s x %s: %s\n", numFinished, numJobs, result.input.getFileName().toRawUTF8(),
+                    result.preset.toRawUTF8(),
+                    result.succeeded() ? (juce::String(result.getRealtimeFactor(), 1) + "x realtime").toRawUTF8()
+                                       : result.error.toRawUTF8());
+        std::fflush(stdout);
+    });
+
+    const auto report = options.outputFolder.getChildFile("render-report.csv");
+    const auto written = renderer.writeReport(report);
+    std::printf("%s\n%s\n", renderer.getSummary().toRawUTF8(),
+                written.wasOk() ? ("Report: " + report.getFullPathName()).toRawUTF8() : written.getErrorMessage().toRawUTF8());
+
+    for (const auto& result : renderer.getResults())
+        if (! result.succeeded())
+            return 1;
+
+    return written.wasOk() ? 0 : 1;
+}
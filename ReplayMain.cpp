@@ -0,0 +1,69 @@
+/*
+  ==============================================================================
+
+    ReplayMain.cpp
+    Entry point of DSP4GuitarReplay, which replays a block capture.
+
+    DSP4GuitarReplay --capture=<file.d4gcap> [--report=<csv>] [--passes=N]
+
+    Runs the captured blocks through a fresh processor (see CaptureReplay),
+    as often as asked, and writes each block's processBlock time to a CSV.
+    Run it under perf, VTune or Instruments to profile exactly what was
+    played live.
+
+  ==============================================================================
+*/
+
+#include "CaptureReplay.h"
+#include <cstdio>
+
+int main(int argc, char* argv[])
+{
+    // The processors own timers, so there has to be a message manager, though no loop runs
+    juce::ScopedJuceInitialiser_GUI juceInitialiser;
+
+    // Back into one command line, values with spaces quoted, for Options::fromCommandLine
+    juce::StringArray arguments;
+    for (int i = 1; i < argc; ++i)
+    {
+        const juce::String argument(juce::CharPointer_UTF8(argv[i]));
+        arguments.add(argument.containsChar(' ') ? argument.upToFirstOccurrenceOf("=", true, false)
+                                                       + argument.fromFirstOccurrenceOf("=", false, false).quoted()
+                                                 : argument);
+    }
+
+    const auto options = CaptureReplay::Options::fromCommandLine(arguments.joinIntoString(" "));
+    if (options.captureFile == juce::File())
+    {
+        std::printf("usage: DSP4GuitarReplay --capture=<file.d4gcap> [--report=<csv>] [--passes=N]\n");
+        return 2;
+    }
+
+    CaptureReplay replay(options);
+    const auto loaded = replay.load();
+    if (loaded.failed())
+    {
+        std::printf("%s\n", loaded.getErrorMessage().toRawUTF8());
+        return 1;
+    }
+
+    std::printf("Replaying %d blocks, %d passes\n", replay.getNumBlocks(), options.passes);
+
+    const auto ran = replay.run([&options](int pass, double seconds)
+    {
+        std::printf("[%d/%d] %.2f s\n", pass + 1, options.passes, seconds);
+        std::fflush(stdout);
+    });
+
+    if (ran.failed())
+    {
+        std::printf("%s\n", ran.getErrorMessage().toRawUTF8());
+        return 1;
+    }
+
+    const auto written = replay.writeReport(options.reportFile);
+    std::printf("%s\n%s\n", replay.getSummary().toRawUTF8(),
+                written.wasOk() ? ("Report: " + options.reportFile.getFullPathName()).toRawUTF8() : written.getErrorMessage().toRawUTF8());
+
+    return written.wasOk() ? 0 : 1;
+}
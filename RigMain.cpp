@@ -0,0 +1,88 @@
+/*
+  ==============================================================================
+
+    RigMain.cpp
+    Entry point of DSP4GuitarRig, the headless multichannel rig server.
+
+    DSP4GuitarRig [--lanes=N] [--workers=N] [--port=9030] [--report=5]
+                  [--device=JACK|ALSA] [--rate=48000] [--period=64]
+                  [--rt-priority=70] [--audio-cpus=2] [--worker-cpus=3,4,5]
+
+    Runs a MultiEffectProcessor per input (see RigServer) until "quit" on the
+    control port, Ctrl+C or SIGTERM.
+
+  ==============================================================================
+*/
+
+#include "RigServer.h"
+#include <csignal>
+#include <cstdio>
+
+namespace
+{
+    volatile std::sig_atomic_t stopRequested = 0;
+
+    void requestStop(int) { stopRequested = 1; }
+
+    // Signal handlers can't touch the message loop, so the flag is polled
+    struct StopWatcher : private juce::Timer
+    {
+        StopWatcher() { startTimer(100); }
+
+        void timerCallback() override
+        {
+            if (stopRequested != 0)
+                juce::MessageManager::getInstance()->stopDispatchLoop();
+        }
+    };
+}
+
+int main(int argc, char* argv[])
+{
+    juce::ScopedJuceInitialiser_GUI juceInitialiser;
+
+    // Back into one command line, values with spaces quoted, for Options::fromCommandLine
+    juce::StringArray arguments;
+    for (int i = 1; i < argc; ++i)
+    {
+        const juce::String argument(juce::CharPointer_UTF8(argv[i]));
+        arguments.add(argument.containsChar(' ') ? argument.upToFirstOccurrenceOf("=", true, false)
+                                                       + argument.fromFirstOccurrenceOf("=", false, false).quoted()
+                                                 : argument);
+    }
+
+    const auto commandLine = arguments.joinIntoString(" ");
+    if (commandLine.contains("--help"))
+    {
+        std::printf("usage: DSP4GuitarRig [--lanes=N] [--workers=N] [--port=9030] [--report=5]\n"
+                    "                     [--device=JACK|ALSA] [--rate=48000] [--period=64] [--rt-priority=70]\n"
+                    "                     [--audio-cpus=2] [--worker-cpus=3,4,5]\n");
+        return 0;
+    }
+
+    const auto options = RigServer::Options::fromCommandLine(commandLine);
+
+    std::signal(SIGINT, requestStop);
+    std::signal(SIGTERM, requestStop);
+
+    RigServer server(options);
+    server.onQuit = [] { juce::MessageManager::getInstance()->stopDispatchLoop(); };
+
+    const auto started = server.start();
+    if (started.failed())
+    {
+        std::printf("%s\n", started.getErrorMessage().toRawUTF8());
+        return 1;
+    }
+
+    std::printf("%s\n", server.handleCommand("lanes").toRawUTF8());
+    if (options.port > 0)
+        std::printf("Control: 127.0.0.1:%d (send \"help\")\n", options.port);
+    std::fflush(stdout);
+
+    StopWatcher stopWatcher;
+    juce::MessageManager::getInstance()->runDispatchLoop();
+
+    server.stop();
+    return 0;
+}
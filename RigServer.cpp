@@ -0,0 +1,635 @@
+#include "RigServer.h"
+#include "MultiEffectProcessor.h"
+#include <cstdio>
+#include <thread>
+
+namespace
+{
+    juce::String describeLanes(const std::vector<int>& laneIndices)
+    {
+        juce::StringArray numbers;
+        for (auto index : laneIndices)
+            numbers.add(juce::String(index + 1));
+        return numbers.joinIntoString(",");
+    }
+}
+
+//==============================================================================
+struct RigServer::Lane
+{
+    std::unique_ptr<MultiEffectProcessor> processor;
+    juce::AudioBuffer<float> buffer; // stereo, the device's block size
+    juce::MidiBuffer midi;
+    int input = 0, outputLeft = -1, outputRight = -1;
+    Load load;
+};
+
+//==============================================================================
+class RigServer::Worker : public juce::Thread
+{
+public:
+    Worker(RigServer& ownerToUse, int index, int coreToUse)
+        : juce::Thread("Rig worker " + juce::String(index)), core(coreToUse), owner(ownerToUse) {}
+
+    void run() override
+    {
+        juce::uint32 policyGeneration = 0;
+        bool pinAttempted = false;
+
+        while (! threadShouldExit())
+        {
+            wakeUp.wait(-1);
+            if (threadShouldExit())
+                break;
+
+            // The policy's mask covers every worker core; each worker then keeps to its own
+            const auto previousGeneration = policyGeneration;
+            LowLatencyMode::applyThreadPolicy(LowLatencyMode::ThreadRole::worker, policyGeneration);
+            if (core >= 0 && (! pinAttempted || policyGeneration != previousGeneration))
+            {
+                LowLatencyMode::pinCurrentThread(core);
+                pinAttempted = true;
+            }
+
+            owner.processLanes(laneIndices, load);
+            owner.finishedWorkers.fetch_add(1, std::memory_order_release);
+        }
+    }
+
+    const int core;
+    std::vector<int> laneIndices;
+    Load load;
+    juce::WaitableEvent wakeUp;
+
+private:
+    RigServer& owner;
+};
+
+//==============================================================================
+/**
+ * Accepts one localhost connection at a time and runs each line it sends
+ * through handleCommand on the message thread.
+ */
+class RigServer::ControlServer : public juce::Thread
+{
+public:
+    ControlServer(RigServer& owner, int portToUse)
+        : juce::Thread("Rig control"), port(portToUse), target(std::make_shared<RigServer*>(&owner)) {}
+
+    ~ControlServer() override
+    {
+        *target = nullptr; // Commands still queued on the message thread find no server
+        signalThreadShouldExit();
+        listener.close();
+        stopThread(2000);
+    }
+
+    bool listen() { return listener.createListener(port, "127.0.0.1"); }
+
+    void run() override
+    {
+        while (! threadShouldExit())
+        {
+            std::unique_ptr<juce::StreamingSocket> connection(listener.waitForNextConnection());
+            if (connection != nullptr)
+                serve(*connection);
+        }
+    }
+
+private:
+    struct Call
+    {
+        juce::String line, reply { "error: server stopped" };
+        juce::WaitableEvent done;
+    };
+
+    void serve(juce::StreamingSocket& connection)
+    {
+        juce::String pending;
+        char data[1024];
+
+        while (! threadShouldExit() && connection.isConnected())
+        {
+            const auto ready = connection.waitUntilReady(true, 200);
+            if (ready < 0)
+                break;
+            if (ready == 0)
+                continue;
+
+            const auto numRead = connection.read(data, static_cast<int>(sizeof(data)), false);
+            if (numRead <= 0)
+                break;
+
+            pending += juce::String::fromUTF8(data, numRead);
+            while (pending.containsChar('\n'))
+            {
+                const auto line = pending.upToFirstOccurrenceOf("\n", false, false).trim();
+                pending = pending.fromFirstOccurrenceOf("\n", false, false);
+                if (line.isEmpty())
+                    continue;
+
+                const auto reply = runOnMessageThread(line) + "\n";
+                connection.write(reply.toRawUTF8(), static_cast<int>(reply.getNumBytesAsUTF8()));
+            }
+        }
+    }
+
+    juce::String runOnMessageThread(const juce::String& line)
+    {
+        auto call = std::make_shared<Call>();
+        call->line = line;
+
+        juce::MessageManager::callAsync([call, server = target]
+        {
+            if (*server != nullptr)
+                call->reply = (*server)->handleCommand(call->line);
+            call->done.signal();
+        });
+
+        return call->done.wait(2000) ? call->reply : juce::String("error: timed out");
+    }
+
+    const int port;
+    juce::StreamingSocket listener;
+    std::shared_ptr<RigServer*> target; // message thread
+};
+
+//==============================================================================
+RigServer::Options RigServer::Options::fromCommandLine(const juce::String& commandLine)
+{
+    Options result;
+    result.lowLatency = LowLatencyMode::Options::fromCommandLine(commandLine);
+    result.lowLatency.enabled = true; // A rig is always a stage machine
+
+    for (const auto& argument : juce::StringArray::fromTokens(commandLine, true))
+    {
+        const auto key = argument.upToFirstOccurrenceOf("=", false, false);
+        const auto value = argument.fromFirstOccurrenceOf("=", false, false).unquoted();
+
+        if (key == "--lanes")        result.numLanes = juce::jlimit(0, maxLanes, value.getIntValue());
+        else if (key == "--workers") result.numWorkers = juce::jmax(0, value.getIntValue());
+        else if (key == "--port")    result.port = juce::jlimit(0, 65535, value.getIntValue());
+        else if (key == "--report")  result.reportSeconds = juce::jmax(0, value.getIntValue());
+    }
+
+    return result;
+}
+
+//==============================================================================
+RigServer::RigServer(const Options& optionsToUse)
+    : options(optionsToUse)
+{
+}
+
+RigServer::~RigServer()
+{
+    stop();
+}
+
+juce::Result RigServer::start()
+{
+    // Enough channels for the largest rig; the device opens as many as it has
+    const auto error = deviceManager.initialise(maxLanes, maxLanes * 2, nullptr, true);
+    if (error.isNotEmpty())
+        return juce::Result::fail("Audio device: " + error);
+
+    lowLatency.apply(deviceManager, options.lowLatency);
+
+    auto* device = deviceManager.getCurrentAudioDevice();
+    if (device == nullptr)
+        return juce::Result::fail("No audio device could be opened");
+
+    const auto numInputs = device->getActiveInputChannels().countNumberOfSetBits();
+    const auto numLanes = juce::jmin(maxLanes, options.numLanes > 0 ? options.numLanes : numInputs);
+    if (numLanes == 0)
+        return juce::Result::fail(device->getName() + " has no inputs");
+
+    // Created here, on the message thread: the processors own timers
+    for (int i = 0; i < numLanes; ++i)
+    {
+        auto lane = std::make_unique<Lane>();
+        lane->processor = std::make_unique<MultiEffectProcessor>();
+        lane->input = i;
+        lanes.push_back(std::move(lane));
+    }
+
+    // One worker per listed core, else per spare CPU; never more threads than lanes
+    const auto& cores = options.lowLatency.workerCores;
+    auto numWorkers = options.numWorkers >= 0 ? options.numWorkers
+                                              : (cores.isEmpty() ? juce::SystemStats::getNumCpus() - 1 : cores.size());
+    numWorkers = juce::jlimit(0, numLanes - 1, numWorkers);
+
+    for (int i = 0; i < numWorkers; ++i)
+        workers.add(new Worker(*this, i, cores.isEmpty() ? -1 : cores[i % cores.size()]));
+
+    // Lanes dealt round-robin: thread 0 is the audio thread
+    for (int i = 0; i < numLanes; ++i)
+    {
+        const auto thread = i % (numWorkers + 1);
+        if (thread == 0)
+            audioLanes.push_back(i);
+        else
+            workers.getUnchecked(thread - 1)->laneIndices.push_back(i);
+    }
+
+    for (auto* worker : workers)
+        if (! worker->startRealtimeThread(juce::Thread::RealtimeOptions().withPriority(8)))
+            worker->startThread(juce::Thread::Priority::highest);
+
+    // MIDI channel n drives lane n, from every input
+    for (const auto& input : juce::MidiInput::getAvailableDevices())
+        deviceManager.setMidiInputDeviceEnabled(input.identifier, true);
+    deviceManager.addMidiInputDeviceCallback({}, this);
+
+    if (options.port > 0)
+    {
+        controlServer = std::make_unique<ControlServer>(*this, options.port);
+        if (! controlServer->listen())
+        {
+            controlServer = nullptr;
+            return juce::Result::fail("Cannot listen on 127.0.0.1:" + juce::String(options.port));
+        }
+        controlServer->startThread();
+    }
+
+    reportedBusy.assign(static_cast<size_t>(numWorkers + 1), 0);
+    reportedLaneBusy.assign(static_cast<size_t>(numLanes), 0);
+    lastReportTicks = juce::Time::getHighResolutionTicks();
+
+    deviceManager.addAudioCallback(this);
+
+    if (options.reportSeconds > 0)
+        startTimer(options.reportSeconds * 1000);
+
+    return juce::Result::ok();
+}
+
+void RigServer::stop()
+{
+    stopTimer();
+    controlServer = nullptr;
+
+    deviceManager.removeMidiInputDeviceCallback({}, this);
+    deviceManager.removeAudioCallback(this);
+    deviceManager.closeAudioDevice();
+
+    for (auto* worker : workers)
+    {
+        worker->signalThreadShouldExit();
+        worker->wakeUp.signal();
+    }
+
+    for (auto* worker : workers)
+        worker->stopThread(1000);
+
+    workers.clear();
+    audioLanes.clear();
+    lanes.clear();
+}
+
+//==============================================================================
+void RigServer::audioDeviceAboutToStart(juce::AudioIODevice* device)
+{
+    const auto rate = device->getCurrentSampleRate();
+    const auto size = device->getCurrentBufferSizeSamples();
+    const auto numOutputs = device->getActiveOutputChannels().countNumberOfSetBits();
+    const auto numLanes = static_cast<int>(lanes.size());
+
+    // A stereo pair per lane where the device has the outputs, else one mono output each
+    stereoOutputs = numOutputs >= numLanes * 2;
+
+    for (int i = 0; i < numLanes; ++i)
+    {
+        auto& lane = *lanes[static_cast<size_t>(i)];
+        lane.processor->setNonRealtime(false);
+        lane.processor->prepareToPlay(rate, size);
+        lane.buffer.setSize(2, size);
+        lane.midi.ensureSize(maxMidiEvents * 4);
+        lane.outputLeft = stereoOutputs ? i * 2 : (i < numOutputs ? i : -1);
+        lane.outputRight = stereoOutputs ? i * 2 + 1 : -1;
+    }
+
+    sampleRate.store(rate, std::memory_order_relaxed);
+    blockSize.store(size, std::memory_order_relaxed);
+}
+
+void RigServer::audioDeviceStopped()
+{
+    for (auto& lane : lanes)
+        lane->processor->releaseResources();
+}
+
+void RigServer::audioDeviceIOCallbackWithContext(const float* const* inputChannelData, int numInputChannels,
+                                                 float* const* outputChannelData, int numOutputChannels,
+                                                 int numSamples, const juce::AudioIODeviceCallbackContext&)
+{
+    LowLatencyMode::applyThreadPolicy(LowLatencyMode::ThreadRole::audio, audioPolicy);
+
+    for (int ch = 0; ch < numOutputChannels; ++ch)
+        if (outputChannelData[ch] != nullptr)
+            juce::FloatVectorOperations::clear(outputChannelData[ch], numSamples);
+
+    if (lanes.empty() || numSamples > lanes.front()->buffer.getNumSamples())
+        return;
+
+    dispatchMidi();
+
+    // Published to the workers by the event's signal
+    currentInputs = inputChannelData;
+    currentOutputs = outputChannelData;
+    currentNumInputs = numInputChannels;
+    currentNumOutputs = numOutputChannels;
+    currentNumSamples = numSamples;
+    finishedWorkers.store(0, std::memory_order_relaxed);
+
+    for (auto* worker : workers)
+        worker->wakeUp.signal();
+
+    processLanes(audioLanes, audioLoad);
+
+    // The barrier: the period is done when every thread's lanes are
+    while (finishedWorkers.load(std::memory_order_acquire) < workers.size())
+        std::this_thread::yield();
+}
+
+void RigServer::processLanes(const std::vector<int>& laneIndices, Load& load) noexcept
+{
+    const auto start = juce::Time::getHighResolutionTicks();
+
+    for (auto index : laneIndices)
+        processLane(*lanes[static_cast<size_t>(index)]);
+
+    const auto elapsed = juce::Time::getHighResolutionTicks() - start;
+    load.busyTicks.store(load.busyTicks.load(std::memory_order_relaxed) + elapsed, std::memory_order_relaxed);
+    if (elapsed > load.maxTicks.load(std::memory_order_relaxed))
+        load.maxTicks.store(elapsed, std::memory_order_relaxed);
+    load.core.store(LowLatencyMode::getCurrentCore(), std::memory_order_relaxed);
+}
+
+void RigServer::processLane(Lane& lane) noexcept
+{
+    const auto start = juce::Time::getHighResolutionTicks();
+    const auto numSamples = currentNumSamples;
+
+    // The lane's own buffer, at this period's length, without reallocating
+    float* channels[] = { lane.buffer.getWritePointer(0), lane.buffer.getWritePointer(1) };
+    juce::AudioBuffer<float> block(channels, 2, numSamples);
+
+    if (lane.input < currentNumInputs && currentInputs[lane.input] != nullptr)
+    {
+        block.copyFrom(0, 0, currentInputs[lane.input], numSamples);
+        block.copyFrom(1, 0, currentInputs[lane.input], numSamples);
+    }
+    else
+    {
+        block.clear();
+    }
+
+    lane.processor->processBlock(block, lane.midi);
+    lane.midi.clear();
+
+    auto* left = lane.outputLeft >= 0 && lane.outputLeft < currentNumOutputs ? currentOutputs[lane.outputLeft] : nullptr;
+    auto* right = lane.outputRight >= 0 && lane.outputRight < currentNumOutputs ? currentOutputs[lane.outputRight] : nullptr;
+
+    if (left != nullptr && right != nullptr)
+    {
+        juce::FloatVectorOperations::copy(left, block.getReadPointer(0), numSamples);
+        juce::FloatVectorOperations::copy(right, block.getReadPointer(1), numSamples);
+    }
+    else if (left != nullptr)
+    {
+        juce::FloatVectorOperations::copyWithMultiply(left, block.getReadPointer(0), 0.5f, numSamples);
+        juce::FloatVectorOperations::addWithMultiply(left, block.getReadPointer(1), 0.5f, numSamples);
+    }
+
+    const auto elapsed = juce::Time::getHighResolutionTicks() - start;
+    lane.load.busyTicks.store(lane.load.busyTicks.load(std::memory_order_relaxed) + elapsed, std::memory_order_relaxed);
+    if (elapsed > lane.load.maxTicks.load(std::memory_order_relaxed))
+        lane.load.maxTicks.store(elapsed, std::memory_order_relaxed);
+}
+
+//==============================================================================
+void RigServer::handleIncomingMidiMessage(juce::MidiInput*, const juce::MidiMessage& message)
+{
+    // Channel messages only; sysex and clock have no lane
+    if (message.getChannel() == 0 || message.getRawDataSize() > 3)
+        return;
+
+    const juce::SpinLock::ScopedLockType sl(midiLock); // Several inputs may call at once
+
+    int start1, size1, start2, size2;
+    midiFifo.prepareToWrite(1, start1, size1, start2, size2);
+    if (size1 == 0)
+        return; // Full: the audio thread is not running
+
+    auto& event = midiEvents[static_cast<size_t>(start1)];
+    event.size = message.getRawDataSize();
+    std::copy(message.getRawData(), message.getRawData() + event.size, event.data);
+    midiFifo.finishedWrite(1);
+}
+
+void RigServer::dispatchMidi() noexcept
+{
+    int start1, size1, start2, size2;
+    midiFifo.prepareToRead(midiFifo.getNumReady(), start1, size1, start2, size2);
+
+    const auto deliver = [this](int start, int size)
+    {
+        for (int i = start; i < start + size; ++i)
+        {
+            const auto& event = midiEvents[static_cast<size_t>(i)];
+            const auto lane = static_cast<size_t>(event.data[0] & 0x0f);
+            if (lane < lanes.size())
+                lanes[lane]->midi.addEvent(event.data, event.size, 0);
+        }
+    };
+
+    deliver(start1, size1);
+    deliver(start2, size2);
+    midiFifo.finishedRead(size1 + size2);
+}
+
+//==============================================================================
+RigServer::Lane* RigServer::findLane(const juce::String& number) const
+{
+    const auto index = number.getIntValue() - 1;
+    if (! number.containsOnly("0123456789") || index < 0 || index >= static_cast<int>(lanes.size()))
+        return nullptr;
+
+    return lanes[static_cast<size_t>(index)].get();
+}
+
+juce::String RigServer::handleCommand(const juce::String& line)
+{
+    auto tokens = juce::StringArray::fromTokens(line, true);
+    tokens.removeEmptyStrings();
+    const auto command = tokens[0].toLowerCase();
+
+    if (command == "help")
+        return "lanes | preset <lane> <name|index> | set <lane> <param> <value> | get <lane> <param> | capture <lane> | stats | quit";
+
+    if (command == "lanes")
+    {
+        juce::StringArray lines;
+        for (size_t i = 0; i < lanes.size(); ++i)
+        {
+            const auto& lane = *lanes[i];
+            auto& presets = lane.processor->getPresetManager();
+            const auto preset = presets.getCurrentPreset();
+
+            juce::String output = lane.outputLeft < 0 ? juce::String("none")
+                                                      : juce::String(lane.outputLeft + 1)
+                                                            + (lane.outputRight >= 0 ? "+" + juce::String(lane.outputRight + 1) : juce::String());
+            lines.add("lane " + juce::String(static_cast<int>(i) + 1) + ": in " + juce::String(lane.input + 1)
+                      + ", out " + output + ", preset "
+                      + (preset >= 0 ? presets.getBank().getName(preset).quoted() : juce::String("(none)")));
+        }
+        return lines.joinIntoString("\n");
+    }
+
+    if (command == "stats")
+        return getReport();
+
+    if (command == "quit")
+    {
+        // After the reply has gone out
+        if (onQuit)
+            juce::MessageManager::callAsync(onQuit);
+        return "ok";
+    }
+
+    auto* lane = findLane(tokens[1]);
+    if (lane == nullptr)
+        return "error: no lane " + tokens[1].quoted() + " (1-" + juce::String(static_cast<int>(lanes.size())) + ")";
+
+    if (command == "preset")
+    {
+        auto& presets = lane->processor->getPresetManager();
+        const auto name = tokens.joinIntoString(" ", 2).unquoted();
+
+        if (name.containsOnly("0123456789") && name.isNotEmpty())
+        {
+            const auto index = name.getIntValue();
+            if (index >= presets.getBank().getNumPresets())
+                return "error: no preset " + name;
+            presets.loadPreset(index);
+        }
+        else if (! presets.loadPreset(name))
+        {
+            return "error: no preset " + name.quoted();
+        }
+
+        return "ok " + tokens[1] + " " + presets.getBank().getName(presets.getCurrentPreset()).quoted();
+    }
+
+    if (command == "capture")
+    {
+        auto& capture = lane->processor->getBlockCapture();
+        if (capture.isCapturing())
+        {
+            capture.stop();
+            return "ok " + tokens[1] + " stopped " + capture.getFile().getFullPathName();
+        }
+
+        const auto file = BlockCapture::getDefaultFile();
+        juce::String error;
+        if (! capture.start(file.getSiblingFile(file.getFileNameWithoutExtension() + "-lane" + tokens[1] + ".d4gcap"), error))
+            return "error: " + error;
+
+        return "ok " + tokens[1] + " capturing to " + capture.getFile().getFullPathName();
+    }
+
+    if (command == "set" || command == "get")
+    {
+        auto* parameter = lane->processor->apvts.getParameter(tokens[2]);
+        if (parameter == nullptr)
+            return "error: no parameter " + tokens[2].quoted();
+
+        if (command == "set")
+        {
+            if (tokens.size() < 4)
+                return "error: set <lane> <param> <value>";
+            parameter->setValueNotifyingHost(parameter->convertTo0to1(tokens[3].getFloatValue()));
+        }
+
+        return "ok " + tokens[1] + " " + tokens[2] + " " + juce::String(parameter->convertFrom0to1(parameter->getValue()));
+    }
+
+    return "error: unknown command " + command.quoted() + " (try help)";
+}
+
+//==============================================================================
+juce::String RigServer::getReport()
+{
+    const auto now = juce::Time::getHighResolutionTicks();
+    const auto elapsed = static_cast<double>(juce::jmax(juce::int64(1), now - lastReportTicks));
+    lastReportTicks = now;
+
+    const auto rate = sampleRate.load(std::memory_order_relaxed);
+    const auto size = blockSize.load(std::memory_order_relaxed);
+    const auto periodTicks = rate > 0.0 ? static_cast<double>(size) / rate * static_cast<double>(juce::Time::getHighResolutionTicksPerSecond()) : 1.0;
+
+    juce::String report;
+    report << static_cast<int>(lanes.size()) << " lanes on " << workers.size() + 1 << " threads, " << size << " samples at "
+           << juce::String(rate, 0) << " Hz (" << juce::String(1000.0 * size / juce::jmax(1.0, rate), 2) << " ms period)\n";
+
+    // Busy: share of the wall time the thread's core spent on its lanes. Peak: the
+    // longest single period, against the period
+    double busiest = 0.0;
+    const auto describeThread = [&](const juce::String& name, const std::vector<int>& laneIndices, Load& load, size_t slot)
+    {
+        const auto busy = load.busyTicks.load(std::memory_order_relaxed);
+        const auto share = static_cast<double>(busy - reportedBusy[slot]) / elapsed;
+        reportedBusy[slot] = busy;
+        busiest = juce::jmax(busiest, share);
+
+        const auto core = load.core.load(std::memory_order_relaxed);
+        const auto peak = static_cast<double>(load.maxTicks.exchange(0, std::memory_order_relaxed)) / periodTicks;
+        report << "  " << name.paddedRight(' ', 9) << " core " << (core >= 0 ? juce::String(core) : juce::String("?")).paddedRight(' ', 3)
+               << " lanes " << describeLanes(laneIndices).paddedRight(' ', 12)
+               << juce::String(share * 100.0, 1) << "% busy, peak " << juce::String(peak * 100.0, 1) << "% of a period\n";
+    };
+
+    describeThread("audio", audioLanes, audioLoad, 0);
+    for (int i = 0; i < workers.size(); ++i)
+    {
+        auto* worker = workers.getUnchecked(i);
+        describeThread("worker " + juce::String(i + 1), worker->laneIndices, worker->load, static_cast<size_t>(i + 1));
+    }
+
+    double total = 0.0;
+    juce::StringArray laneShares;
+    for (size_t i = 0; i < lanes.size(); ++i)
+    {
+        auto& load = lanes[i]->load;
+        const auto busy = load.busyTicks.load(std::memory_order_relaxed);
+        const auto share = static_cast<double>(busy - reportedLaneBusy[i]) / elapsed;
+        reportedLaneBusy[i] = busy;
+        load.maxTicks.store(0, std::memory_order_relaxed);
+
+        total += share;
+        laneShares.add(juce::String(static_cast<int>(i) + 1) + ":" + juce::String(share * 100.0, 1) + "%");
+    }
+
+    // Run serially, the lanes would take `total` of one core; the busiest thread is the critical path
+    const auto speedup = busiest > 0.0 ? total / busiest : 0.0;
+    report << "  lanes    " << laneShares.joinIntoString(" ") << "\n"
+           << "  scaling  " << juce::String(total * 100.0, 1) << "% of one core in total, critical path "
+           << juce::String(busiest * 100.0, 1) << "%: " << juce::String(speedup, 2) << "x on " << workers.size() + 1
+           << " threads (" << juce::String(100.0 * speedup / (workers.size() + 1), 0) << "% efficiency)";
+
+    return report;
+}
+
+void RigServer::timerCallback()
+{
+    const auto lowLatencyReport = lowLatency.getReport();
+    if (lowLatencyReport != lastLowLatencyReport)
+    {
+        lastLowLatencyReport = lowLatencyReport;
+        std::printf("%s\n", lowLatencyReport.toRawUTF8());
+    }
+
+    std::printf("%s\n", getReport().toRawUTF8());
+    std::fflush(stdout);
+}
@@ -0,0 +1,152 @@
+#pragma once
+
+#include <juce_audio_devices/juce_audio_devices.h>
+#include <juce_audio_processors/juce_audio_processors.h>
+#include "LowLatencyMode.h"
+#include <array>
+#include <atomic>
+#include <functional>
+#include <memory>
+#include <vector>
+
+class MultiEffectProcessor;
+
+//==============================================================================
+/**
+ * RigServer
+ *
+ * One headless box for a whole band: opens a multichannel JACK or ALSA device
+ * through LowLatencyMode and runs an independent MultiEffectProcessor per
+ * input lane (DSP4GuitarRig console target).
+ *
+ * Lanes are dealt round-robin to the audio thread and a set of real-time
+ * worker threads, each pinned to its own core from --worker-cpus, so a lane
+ * always runs on the same core and keeps its state in that core's cache. Every
+ * period the audio thread wakes the workers, processes its own lanes, then
+ * waits at a barrier until every worker is done; each thread reads its lanes'
+ * inputs and writes their outputs itself, so the channels need no copies in
+ * between. The period costs as long as the busiest thread.
+ *
+ * Control: MIDI channel n goes to lane n (program changes, MIDI-learned
+ * controllers), and a line-based text protocol on a localhost TCP port sets
+ * presets and parameters per lane (see handleCommand). Commands run on the
+ * message thread.
+ *
+ * Load is measured per thread and per lane and reported per core every few
+ * seconds: how much of the period each core was busy, and how the sum of the
+ * lanes' time compares to the critical path, i.e. the speedup the threads buy.
+ */
+class RigServer : public juce::AudioIODeviceCallback,
+                  private juce::MidiInputCallback,
+                  private juce::Timer
+{
+public:
+    static constexpr int maxLanes = 32;
+    static constexpr int maxMidiEvents = 1024; // queued between two periods
+
+    struct Options
+    {
+        int numLanes = 0;   // 0: one per device input
+        int numWorkers = -1; // -1: one per --worker-cpus core, else per spare CPU
+        int port = 9030;    // 0: no control socket
+        int reportSeconds = 5;
+        LowLatencyMode::Options lowLatency;
+
+        /** [--lanes=N] [--workers=N] [--port=9030] [--report=5] plus LowLatencyMode's
+            --device, --rate, --period, --rt-priority, --audio-cpus, --worker-cpus, ... */
+        static Options fromCommandLine(const juce::String& commandLine);
+    };
+
+    explicit RigServer(const Options& options);
+    ~RigServer() override;
+
+    /** Message thread: opens the device, creates the lanes and starts processing. */
+    juce::Result start();
+    void stop();
+
+    /** Message thread. One command per line, lanes counted from 1:
+          lanes                       one line per lane: its channels and preset
+          preset <lane> <name|index>  recalls a bank preset (crossfaded)
+          set <lane> <param> <value>  plain value, e.g. "set 3 fuzzDrive 40"
+          get <lane> <param>
+          capture <lane>              starts or stops a block capture (BlockCapture)
+          stats                       the per-core report
+          quit
+        Returns the reply, which may span lines. */
+    juce::String handleCommand(const juce::String& line);
+
+    /** Per-core load since the last call (the first call: since start). */
+    juce::String getReport();
+
+    /** Called on the message thread after "quit". */
+    std::function<void()> onQuit;
+
+    //==============================================================================
+    void audioDeviceIOCallbackWithContext(const float* const* inputChannelData, int numInputChannels,
+                                          float* const* outputChannelData, int numOutputChannels,
+                                          int numSamples, const juce::AudioIODeviceCallbackContext& context) override;
+    void audioDeviceAboutToStart(juce::AudioIODevice* device) override;
+    void audioDeviceStopped() override;
+
+private:
+    struct Lane;
+    class Worker;
+    class ControlServer;
+
+    // Written by the thread that runs the lanes; read by getReport()
+    struct Load
+    {
+        std::atomic<juce::int64> busyTicks { 0 }, maxTicks { 0 };
+        std::atomic<int> core { -1 };
+    };
+
+    struct MidiEvent
+    {
+        juce::uint8 data[3];
+        int size = 0;
+    };
+
+    void handleIncomingMidiMessage(juce::MidiInput* source, const juce::MidiMessage& message) override;
+    void timerCallback() override;
+
+    // Audio thread and workers
+    void processLanes(const std::vector<int>& laneIndices, Load& load) noexcept;
+    void processLane(Lane& lane) noexcept;
+    void dispatchMidi() noexcept;
+
+    Lane* findLane(const juce::String& number) const;
+
+    Options options;
+    juce::AudioDeviceManager deviceManager;
+    LowLatencyMode lowLatency;
+
+    std::vector<std::unique_ptr<Lane>> lanes;
+    juce::OwnedArray<Worker> workers;
+    std::vector<int> audioLanes; // the audio thread's share
+    Load audioLoad;
+    std::unique_ptr<ControlServer> controlServer;
+
+    // Set by the audio thread for the workers, once per period
+    const float* const* currentInputs = nullptr;
+    float* const* currentOutputs = nullptr;
+    int currentNumInputs = 0, currentNumOutputs = 0, currentNumSamples = 0;
+    std::atomic<int> finishedWorkers { 0 };
+
+    // MIDI input thread -> audio thread
+    std::array<MidiEvent, maxMidiEvents> midiEvents;
+    juce::AbstractFifo midiFifo { maxMidiEvents };
+    juce::SpinLock midiLock; // between MIDI input threads only
+
+    // Audio thread
+    juce::uint32 audioPolicy = 0;
+
+    // Message thread
+    std::atomic<double> sampleRate { 0.0 };
+    std::atomic<int> blockSize { 0 };
+    bool stereoOutputs = false;
+    juce::int64 lastReportTicks = 0;
+    std::vector<juce::int64> reportedBusy, reportedLaneBusy;
+    juce::String lastLowLatencyReport;
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(RigServer)
+};
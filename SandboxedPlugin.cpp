@@ -0,0 +1,897 @@
+#include "SandboxedPlugin.h"
+#include "TraceRecorder.h"
+#include <juce_events/juce_events.h>
+#include <algorithm>
+#include <array>
+#include <condition_variable>
+#include <cstring>
+#include <deque>
+#include <functional>
+#include <vector>
+
+#if JUCE_LINUX
+ #include <fcntl.h>
+ #include <linux/futex.h>
+ #include <sys/mman.h>
+ #include <sys/stat.h>
+ #include <sys/syscall.h>
+ #include <unistd.h>
+ #include <ctime>
+#endif
+
+namespace
+{
+    // Command-line token that turns this executable into a plugin sandbox
+    constexpr const char* workerID = "dsp4guitarpluginsandbox";
+
+    // Replies start with this flag; the rest depends on the request
+    constexpr const char* okReply = "ok";
+
+    juce::MemoryBlock makeReply(const juce::String& error, const std::function<void(juce::MemoryOutputStream&)>& payload = {})
+    {
+        juce::MemoryOutputStream out;
+        out.writeString(error.isEmpty() ? juce::String(okReply) : error);
+        if (payload != nullptr && error.isEmpty())
+            payload(out);
+        return out.getMemoryBlock();
+    }
+
+   #if JUCE_LINUX
+    // Shared (not private) futexes: the two sides are different processes
+    void futexWake(std::atomic<juce::uint32>& word) noexcept
+    {
+        syscall(SYS_futex, reinterpret_cast<juce::uint32*>(&word), FUTEX_WAKE, 1, nullptr, nullptr, 0);
+    }
+
+    void futexWait(std::atomic<juce::uint32>& word, juce::uint32 expected, juce::int64 timeoutNanos) noexcept
+    {
+        timespec timeout { static_cast<time_t>(timeoutNanos / 1000000000), static_cast<long>(timeoutNanos % 1000000000) };
+        syscall(SYS_futex, reinterpret_cast<juce::uint32*>(&word), FUTEX_WAIT, expected, &timeout, nullptr, 0);
+    }
+
+    juce::int64 getThreadCpuNanos() noexcept
+    {
+        timespec now {};
+        clock_gettime(CLOCK_THREAD_CPUTIME_ID, &now);
+        return static_cast<juce::int64>(now.tv_sec) * 1000000000 + now.tv_nsec;
+    }
+   #endif
+}
+
+//==============================================================================
+// The one block both processes map. request and reply are futex words; the
+// waiting flags let the other side skip the wake-up syscall when nobody sleeps.
+struct SandboxedPlugin::SharedBlock
+{
+    std::atomic<juce::uint32> request { 0 }, reply { 0 };
+    std::atomic<juce::uint32> hostWaiting { 0 }, childWaiting { 0 };
+    std::atomic<juce::int32> numSamples { 0 }, numChannels { 0 };
+    alignas(64) float audio[maxChannels][maxBlockSize];
+};
+
+static_assert(std::atomic<juce::uint32>::is_always_lock_free && sizeof(std::atomic<juce::uint32>) == 4,
+              "Futex words must be plain 32-bit integers");
+
+class SandboxedPlugin::SharedMemory
+{
+public:
+    ~SharedMemory()
+    {
+       #if JUCE_LINUX
+        if (block != nullptr)
+            munmap(block, sizeof(SharedBlock));
+        if (owner)
+            shm_unlink(name.toRawUTF8());
+       #endif
+    }
+
+    /** Host: a new, zeroed block with a name unique to this process. */
+    static std::unique_ptr<SharedMemory> create(juce::String& error)
+    {
+       #if JUCE_LINUX
+        static std::atomic<int> counter { 0 };
+        auto memory = std::unique_ptr<SharedMemory>(new SharedMemory());
+        memory->name = "/dsp4guitar-sandbox-" + juce::String(static_cast<int>(getpid())) + "-" + juce::String(counter++);
+
+        const auto fd = shm_open(memory->name.toRawUTF8(), O_CREAT | O_EXCL | O_RDWR, 0600);
+        if (fd < 0)
+        {
+            error = "shm_open failed";
+            return nullptr;
+        }
+
+        memory->owner = true;
+        if (ftruncate(fd, sizeof(SharedBlock)) == 0)
+            memory->map(fd);
+        close(fd);
+
+        if (memory->block == nullptr)
+        {
+            error = "Could not map shared memory";
+            return nullptr;
+        }
+
+        new (memory->block) SharedBlock();
+        return memory;
+       #else
+        error = "Plugin sandboxing needs Linux";
+        return nullptr;
+       #endif
+    }
+
+    /** Child: the host's block. */
+    static std::unique_ptr<SharedMemory> open(const juce::String& name)
+    {
+       #if JUCE_LINUX
+        auto memory = std::unique_ptr<SharedMemory>(new SharedMemory());
+        memory->name = name;
+
+        const auto fd = shm_open(name.toRawUTF8(), O_RDWR, 0600);
+        if (fd < 0)
+            return nullptr;
+
+        memory->map(fd);
+        close(fd);
+        return memory->block != nullptr ? std::move(memory) : nullptr;
+       #else
+        juce::ignoreUnused(name);
+        return nullptr;
+       #endif
+    }
+
+    SharedBlock& get() noexcept { return *block; }
+    const juce::String& getName() const noexcept { return name; }
+
+private:
+    SharedMemory() = default;
+
+   #if JUCE_LINUX
+    void map(int fd)
+    {
+        auto* address = mmap(nullptr, sizeof(SharedBlock), PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+        if (address == MAP_FAILED)
+            return;
+
+        // Touched now, so the audio thread never page-faults on it
+        mlock(address, sizeof(SharedBlock));
+        block = static_cast<SharedBlock*>(address);
+    }
+   #endif
+
+    juce::String name;
+    SharedBlock* block = nullptr;
+    bool owner = false;
+};
+
+//==============================================================================
+// Host side of the control channel: one request at a time (callers hold
+// SandboxedPlugin::controlLock), each waiting for its reply.
+class SandboxedPlugin::Process : private juce::ChildProcessCoordinator
+{
+public:
+    explicit Process(SandboxedPlugin& pluginToNotify) : plugin(pluginToNotify) {}
+    ~Process() override { killWorkerProcess(); }
+
+    bool launch()
+    {
+        return launchWorkerProcess(juce::File::getSpecialLocation(juce::File::currentExecutableFile), workerID, 0, 0);
+    }
+
+    /** Sends request and waits for the reply; false with error set if there was none
+        or the child reported one. */
+    bool request(const juce::MemoryBlock& message, juce::MemoryBlock& reply, int timeoutMs, juce::String& error)
+    {
+        {
+            const std::lock_guard<std::mutex> sl(lock);
+            gotReply = false;
+        }
+
+        if (! sendMessageToWorker(message))
+        {
+            error = "The sandbox is not running";
+            return false;
+        }
+
+        std::unique_lock<std::mutex> sl(lock);
+        if (! replied.wait_for(sl, std::chrono::milliseconds(timeoutMs), [this] { return gotReply || connectionLost; }))
+        {
+            error = "The sandbox did not answer";
+            return false;
+        }
+
+        if (! gotReply)
+        {
+            error = "The sandbox crashed";
+            return false;
+        }
+
+        juce::MemoryInputStream in(replyData, false);
+        const auto status = in.readString();
+        if (status != okReply)
+        {
+            error = status;
+            return false;
+        }
+
+        reply.replaceAll(static_cast<const char*>(replyData.getData()) + in.getPosition(),
+                         replyData.getSize() - static_cast<size_t>(in.getPosition()));
+        return true;
+    }
+
+private:
+    void handleMessageFromWorker(const juce::MemoryBlock& message) override
+    {
+        {
+            const std::lock_guard<std::mutex> sl(lock);
+            replyData = message;
+            gotReply = true;
+        }
+        replied.notify_one();
+    }
+
+    void handleConnectionLost() override
+    {
+        // The audio thread bypasses from its next block; the watchdog restarts the child
+        auto running = State::running;
+        plugin.state.compare_exchange_strong(running, State::failed);
+
+        {
+            const std::lock_guard<std::mutex> sl(lock);
+            connectionLost = true;
+        }
+        replied.notify_one();
+    }
+
+    SandboxedPlugin& plugin;
+    std::mutex lock;
+    std::condition_variable replied;
+    juce::MemoryBlock replyData;
+    bool gotReply = false, connectionLost = false;
+};
+
+//==============================================================================
+class SandboxedPlugin::Watchdog : public juce::Thread
+{
+public:
+    explicit Watchdog(SandboxedPlugin& pluginToWatch)
+        : juce::Thread("Sandbox watchdog: " + pluginToWatch.getName()), plugin(pluginToWatch) {}
+
+    void run() override
+    {
+        while (! threadShouldExit())
+        {
+            if (plugin.state.load(std::memory_order_acquire) == State::failed)
+            {
+                plugin.restart();
+
+                // A plugin that dies on load is retried once a second, not in a tight loop
+                if (plugin.state.load(std::memory_order_acquire) != State::running)
+                    wait(1000);
+            }
+
+            wait(20);
+        }
+    }
+
+private:
+    SandboxedPlugin& plugin;
+};
+
+//==============================================================================
+// Worker side: control requests on the child's message thread, audio on a
+// real-time thread that sleeps on the request futex.
+class SandboxedPlugin::Worker : public juce::ChildProcessWorker,
+                                private juce::AsyncUpdater,
+                                private juce::Thread
+{
+public:
+    Worker() : juce::Thread("Sandbox audio") { formatManager.addDefaultFormats(); }
+
+    ~Worker() override
+    {
+        cancelPendingUpdate();
+        stopThread(1000);
+    }
+
+private:
+    void handleMessageFromCoordinator(const juce::MemoryBlock& message) override
+    {
+        {
+            const std::lock_guard<std::mutex> sl(lock);
+            requests.push_back(message);
+        }
+        triggerAsyncUpdate();
+    }
+
+    void handleConnectionLost() override { juce::JUCEApplicationBase::quit(); }
+
+    void handleAsyncUpdate() override
+    {
+        for (;;)
+        {
+            juce::MemoryBlock request;
+            {
+                const std::lock_guard<std::mutex> sl(lock);
+                if (requests.empty())
+                    return;
+                request = std::move(requests.front());
+                requests.pop_front();
+            }
+            handle(request);
+        }
+    }
+
+    void handle(const juce::MemoryBlock& request)
+    {
+        juce::MemoryInputStream in(request, false);
+        const auto command = in.readString();
+
+        if (command == "load")
+        {
+            load(in.readString(), in.readString());
+            return;
+        }
+
+        if (command == "prepare")
+        {
+            const auto sampleRate = in.readDouble();
+            const auto blockSize = in.readInt();
+            int latency = 0;
+
+            if (instance != nullptr)
+            {
+                const std::lock_guard<std::mutex> sl(processLock);
+                instance->setRateAndBufferSizeDetails(sampleRate, blockSize);
+                instance->prepareToPlay(sampleRate, blockSize);
+                instance->enableAllBuses();
+                latency = instance->getLatencySamples();
+            }
+
+            sendMessageToCoordinator(makeReply({}, [latency](juce::MemoryOutputStream& out) { out.writeInt(latency); }));
+            return;
+        }
+
+        if (command == "release")
+        {
+            if (instance != nullptr)
+            {
+                const std::lock_guard<std::mutex> sl(processLock);
+                instance->releaseResources();
+            }
+            sendMessageToCoordinator(makeReply({}));
+            return;
+        }
+
+        if (command == "getState")
+        {
+            juce::MemoryBlock state;
+            if (instance != nullptr)
+                instance->getStateInformation(state);
+            sendMessageToCoordinator(makeReply({}, [&state](juce::MemoryOutputStream& out) { out << state; }));
+            return;
+        }
+
+        if (command == "setState")
+        {
+            juce::MemoryBlock state;
+            in.readIntoMemoryBlock(state);
+            if (instance != nullptr && state.getSize() > 0)
+                instance->setStateInformation(state.getData(), static_cast<int>(state.getSize()));
+            sendMessageToCoordinator(makeReply({}));
+            return;
+        }
+
+        sendMessageToCoordinator(makeReply("Unknown request: " + command));
+    }
+
+    void load(const juce::String& sharedName, const juce::String& descriptionXml)
+    {
+        memory = SharedMemory::open(sharedName);
+        if (memory == nullptr)
+        {
+            sendMessageToCoordinator(makeReply("Could not open " + sharedName));
+            return;
+        }
+
+        auto startAudio = [this]
+        {
+            if (! startRealtimeThread(juce::Thread::RealtimeOptions().withPriority(9)))
+                startThread(juce::Thread::Priority::highest);
+        };
+
+        juce::PluginDescription description;
+        const auto xml = juce::parseXML(descriptionXml);
+        if (xml == nullptr || ! description.loadFromXml(*xml))
+        {
+            startAudio(); // No plugin: a pass-through sandbox
+            sendMessageToCoordinator(makeReply({}));
+            return;
+        }
+
+        // Async, so formats that need this (the child's) message thread free can load
+        formatManager.createPluginInstanceAsync(description, 44100.0, 512,
+            [this, startAudio](std::unique_ptr<juce::AudioPluginInstance> created, const juce::String& error)
+            {
+                if (created == nullptr)
+                {
+                    sendMessageToCoordinator(makeReply(error.isNotEmpty() ? error : juce::String("Could not create the plugin")));
+                    return;
+                }
+
+                instance = std::move(created);
+                startAudio();
+                sendMessageToCoordinator(makeReply({}));
+            });
+    }
+
+    void run() override
+    {
+        auto& block = memory->get();
+
+        // A restarted child takes over the host's counters where the last one stopped
+        auto seen = block.request.load(std::memory_order_acquire);
+        block.reply.store(seen, std::memory_order_release);
+
+        std::array<float*, maxChannels> channels {};
+        for (size_t ch = 0; ch < channels.size(); ++ch)
+            channels[ch] = block.audio[ch];
+
+        while (! threadShouldExit())
+        {
+            const auto request = block.request.load(std::memory_order_acquire);
+            if (request == seen)
+            {
+               #if JUCE_LINUX
+                block.childWaiting.store(1);
+                if (block.request.load() == seen)
+                    futexWait(block.request, seen, 100000000); // Wakes to check threadShouldExit
+                block.childWaiting.store(0);
+               #endif
+                continue;
+            }
+
+            seen = request;
+            process(block, channels);
+
+            block.reply.store(request, std::memory_order_seq_cst);
+           #if JUCE_LINUX
+            if (block.hostWaiting.load() != 0)
+                futexWake(block.reply);
+           #endif
+        }
+    }
+
+    void process(SharedBlock& block, std::array<float*, maxChannels>& channels) noexcept
+    {
+        // A prepare in progress leaves the block as it came in
+        std::unique_lock<std::mutex> sl(processLock, std::try_to_lock);
+        if (! sl.owns_lock() || instance == nullptr)
+            return;
+
+        const auto numSamples = juce::jlimit(0, maxBlockSize, static_cast<int>(block.numSamples.load(std::memory_order_relaxed)));
+        const auto hostChannels = juce::jlimit(0, maxChannels, static_cast<int>(block.numChannels.load(std::memory_order_relaxed)));
+        const auto numChannels = juce::jlimit(hostChannels, maxChannels,
+                                              juce::jmax(instance->getTotalNumInputChannels(), instance->getTotalNumOutputChannels()));
+
+        for (int ch = hostChannels; ch < numChannels; ++ch)
+            std::fill_n(channels[static_cast<size_t>(ch)], numSamples, 0.0f);
+
+        // Processed in place, in the shared block
+        juce::AudioBuffer<float> buffer(channels.data(), numChannels, numSamples);
+        midi.clear();
+        instance->processBlock(buffer, midi);
+    }
+
+    juce::AudioPluginFormatManager formatManager;
+    std::unique_ptr<juce::AudioPluginInstance> instance;
+    std::unique_ptr<SharedMemory> memory;
+    std::mutex processLock;
+    juce::MidiBuffer midi;
+
+    std::mutex lock;
+    std::deque<juce::MemoryBlock> requests;
+};
+
+//==============================================================================
+SandboxedPlugin::SandboxedPlugin(const juce::PluginDescription& descriptionToLoad)
+    : AudioProcessor(BusesProperties().withInput("Input", juce::AudioChannelSet::stereo(), true)
+                                      .withOutput("Output", juce::AudioChannelSet::stereo(), true)),
+      description(descriptionToLoad),
+      traceName(TraceRecorder::getInstance().intern(descriptionToLoad.name.isNotEmpty() ? descriptionToLoad.name : juce::String("pass-through")))
+{
+}
+
+SandboxedPlugin::~SandboxedPlugin()
+{
+    if (watchdog != nullptr)
+        watchdog->stopThread(2000);
+
+    process = nullptr; // Kills the child before its shared memory goes
+}
+
+bool SandboxedPlugin::isSupported() noexcept
+{
+   #if JUCE_LINUX
+    return true;
+   #else
+    return false;
+   #endif
+}
+
+std::unique_ptr<SandboxedPlugin> SandboxedPlugin::create(const juce::PluginDescription& description,
+                                                         double sampleRate, int blockSize, juce::String& error)
+{
+    auto plugin = std::unique_ptr<SandboxedPlugin>(new SandboxedPlugin(description));
+    plugin->setRateAndBufferSizeDetails(sampleRate, blockSize);
+
+    plugin->shared = SharedMemory::create(error);
+    if (plugin->shared == nullptr)
+        return nullptr;
+
+    {
+        const std::lock_guard<std::mutex> sl(plugin->controlLock);
+        if (! plugin->launch(error))
+            return nullptr;
+    }
+
+    plugin->state.store(State::running, std::memory_order_release);
+    plugin->watchdog = std::make_unique<Watchdog>(*plugin);
+    plugin->watchdog->startThread(juce::Thread::Priority::high);
+    return plugin;
+}
+
+bool SandboxedPlugin::launch(juce::String& error)
+{
+    process = std::make_unique<Process>(*this);
+    if (! process->launch())
+    {
+        error = "Could not start the sandbox process";
+        return false;
+    }
+
+    juce::MemoryOutputStream out;
+    out.writeString("load");
+    out.writeString(shared->getName());
+    out.writeString(description.name.isNotEmpty() ? description.createXml()->toString() : juce::String());
+
+    juce::MemoryBlock reply;
+    if (! process->request(out.getMemoryBlock(), reply, 30000, error))
+        return false;
+
+    if (lastState.getSize() > 0)
+    {
+        juce::MemoryOutputStream stateRequest;
+        stateRequest.writeString("setState");
+        stateRequest << lastState;
+        process->request(stateRequest.getMemoryBlock(), reply, 5000, error);
+    }
+
+    return true;
+}
+
+bool SandboxedPlugin::sendPrepare()
+{
+    juce::MemoryOutputStream out;
+    out.writeString("prepare");
+    out.writeDouble(preparedRate);
+    out.writeInt(preparedBlockSize);
+
+    juce::MemoryBlock reply;
+    juce::String error;
+    if (process == nullptr || ! process->request(out.getMemoryBlock(), reply, 10000, error))
+        return false;
+
+    juce::MemoryInputStream in(reply, false);
+    setLatencySamples(in.readInt());
+    return true;
+}
+
+void SandboxedPlugin::restart()
+{
+    state.store(State::starting, std::memory_order_release);
+    restarts.fetch_add(1, std::memory_order_relaxed);
+    juce::Logger::writeToLog("Sandbox: restarting " + description.name);
+
+    const std::lock_guard<std::mutex> sl(controlLock);
+    process = nullptr;
+
+    juce::String error;
+    if (! launch(error) || (preparedRate > 0.0 && ! sendPrepare()))
+    {
+        juce::Logger::writeToLog("Sandbox: " + description.name + " failed to restart: " + error);
+        process = nullptr;
+        state.store(State::failed, std::memory_order_release);
+        return;
+    }
+
+    state.store(State::running, std::memory_order_release);
+}
+
+//==============================================================================
+void SandboxedPlugin::prepareToPlay(double sampleRate, int maximumExpectedSamplesPerBlock)
+{
+    const auto ticksPerSecond = static_cast<double>(juce::Time::getHighResolutionTicksPerSecond());
+    ticksPerSample = ticksPerSecond / sampleRate;
+    hungTicks = static_cast<juce::int64>(hungSeconds * ticksPerSecond);
+    awaitingReply = false;
+
+    const std::lock_guard<std::mutex> sl(controlLock);
+    preparedRate = sampleRate;
+    preparedBlockSize = maximumExpectedSamplesPerBlock;
+    sendPrepare();
+}
+
+void SandboxedPlugin::releaseResources()
+{
+    const std::lock_guard<std::mutex> sl(controlLock);
+    preparedRate = 0.0;
+
+    if (process != nullptr)
+    {
+        juce::MemoryOutputStream out;
+        out.writeString("release");
+        juce::MemoryBlock reply;
+        juce::String error;
+        process->request(out.getMemoryBlock(), reply, 5000, error);
+    }
+}
+
+void SandboxedPlugin::getStateInformation(juce::MemoryBlock& destData)
+{
+    const std::lock_guard<std::mutex> sl(controlLock);
+
+    if (process != nullptr && state.load(std::memory_order_acquire) == State::running)
+    {
+        juce::MemoryOutputStream out;
+        out.writeString("getState");
+        juce::MemoryBlock reply;
+        juce::String error;
+        if (process->request(out.getMemoryBlock(), reply, 2000, error))
+        {
+            juce::MemoryInputStream in(reply, false);
+            in.readIntoMemoryBlock(lastState);
+        }
+    }
+
+    destData = lastState;
+}
+
+void SandboxedPlugin::setStateInformation(const void* data, int sizeInBytes)
+{
+    const std::lock_guard<std::mutex> sl(controlLock);
+    lastState.replaceAll(data, static_cast<size_t>(sizeInBytes));
+
+    if (process != nullptr)
+    {
+        juce::MemoryOutputStream out;
+        out.writeString("setState");
+        out << lastState;
+        juce::MemoryBlock reply;
+        juce::String error;
+        process->request(out.getMemoryBlock(), reply, 5000, error);
+    }
+}
+
+SandboxedPlugin::Stats SandboxedPlugin::getStats() const noexcept
+{
+    Stats stats;
+    stats.roundTrips = roundTrips.load(std::memory_order_relaxed);
+    stats.missedDeadlines = missedDeadlines.load(std::memory_order_relaxed);
+    stats.bypassedBlocks = bypassedBlocks.load(std::memory_order_relaxed);
+    stats.restarts = restarts.load(std::memory_order_relaxed);
+
+    const auto microsPerTick = 1.0e6 / static_cast<double>(juce::Time::getHighResolutionTicksPerSecond());
+    if (stats.roundTrips > 0)
+        stats.averageMicros = static_cast<double>(roundTripTicks.load(std::memory_order_relaxed)) * microsPerTick
+                              / static_cast<double>(stats.roundTrips);
+    stats.maxMicros = static_cast<double>(maxRoundTripTicks.load(std::memory_order_relaxed)) * microsPerTick;
+    return stats;
+}
+
+//==============================================================================
+void SandboxedPlugin::processBlock(juce::AudioBuffer<float>& buffer, juce::MidiBuffer&)
+{
+    DSP4G_TRACE_ZONE("SandboxedPlugin::processBlock");
+
+    for (int start = 0; start < buffer.getNumSamples(); start += maxBlockSize)
+        processChunk(buffer, start, juce::jmin(maxBlockSize, buffer.getNumSamples() - start));
+}
+
+void SandboxedPlugin::processChunk(juce::AudioBuffer<float>& buffer, int start, int numSamples) noexcept
+{
+    if (state.load(std::memory_order_acquire) != State::running)
+    {
+        // Bypassed until the watchdog has a child running again
+        awaitingReply = false;
+        consecutiveMisses = 0;
+        bypassedBlocks.fetch_add(1, std::memory_order_relaxed);
+        return;
+    }
+
+    auto& block = shared->get();
+    const auto begin = juce::Time::getHighResolutionTicks();
+
+    // After a miss the child may still be writing the shared block: stay out of it
+    // (and leave this block dry) until it has finished the late one
+    if (awaitingReply && block.reply.load(std::memory_order_acquire) != sequence)
+    {
+        recordMiss(begin, false);
+        return;
+    }
+    awaitingReply = false;
+
+    const auto numChannels = juce::jmin(buffer.getNumChannels(), maxChannels);
+    for (int ch = 0; ch < numChannels; ++ch)
+        std::memcpy(block.audio[ch], buffer.getReadPointer(ch, start), sizeof(float) * static_cast<size_t>(numSamples));
+
+    block.numSamples.store(numSamples, std::memory_order_relaxed);
+    block.numChannels.store(numChannels, std::memory_order_relaxed);
+    block.request.store(++sequence, std::memory_order_seq_cst);
+
+   #if JUCE_LINUX
+    if (block.childWaiting.load() != 0)
+        futexWake(block.request);
+   #endif
+
+    const auto deadline = begin + static_cast<juce::int64>(numSamples * ticksPerSample * deadlineFraction);
+    if (! waitForReply(block, deadline))
+    {
+        awaitingReply = true;
+        recordMiss(begin, true);
+        return;
+    }
+
+    for (int ch = 0; ch < numChannels; ++ch)
+        std::memcpy(buffer.getWritePointer(ch, start), block.audio[ch], sizeof(float) * static_cast<size_t>(numSamples));
+
+    consecutiveMisses = 0;
+    const auto elapsed = juce::Time::getHighResolutionTicks() - begin;
+    roundTrips.fetch_add(1, std::memory_order_relaxed);
+    roundTripTicks.fetch_add(elapsed, std::memory_order_relaxed);
+    if (elapsed > maxRoundTripTicks.load(std::memory_order_relaxed))
+        maxRoundTripTicks.store(elapsed, std::memory_order_relaxed);
+}
+
+bool SandboxedPlugin::waitForReply(SharedBlock& block, juce::int64 deadline) noexcept
+{
+    // Spin first: a light plugin answers within microseconds of being woken, sooner
+    // than the futex round trip would take
+    const auto spinEnd = juce::jmin(deadline, juce::Time::getHighResolutionTicks()
+                                                  + juce::Time::getHighResolutionTicksPerSecond() / 50000); // 20 us
+    while (juce::Time::getHighResolutionTicks() < spinEnd)
+        if (block.reply.load(std::memory_order_acquire) == sequence)
+            return true;
+
+   #if JUCE_LINUX
+    const auto nanosPerTick = 1.0e9 / static_cast<double>(juce::Time::getHighResolutionTicksPerSecond());
+
+    for (;;)
+    {
+        block.hostWaiting.store(1);
+        const auto observed = block.reply.load();
+        const auto remaining = deadline - juce::Time::getHighResolutionTicks();
+
+        if (observed == sequence || remaining <= 0 || state.load(std::memory_order_acquire) != State::running)
+        {
+            block.hostWaiting.store(0);
+            return observed == sequence;
+        }
+
+        futexWait(block.reply, observed, static_cast<juce::int64>(static_cast<double>(remaining) * nanosPerTick));
+        block.hostWaiting.store(0);
+    }
+   #else
+    return false;
+   #endif
+}
+
+void SandboxedPlugin::recordMiss(juce::int64 now, bool deadlineMissed) noexcept
+{
+    bypassedBlocks.fetch_add(1, std::memory_order_relaxed);
+    if (deadlineMissed)
+        missedDeadlines.fetch_add(1, std::memory_order_relaxed);
+
+    if (consecutiveMisses++ == 0)
+        firstMissTicks = now;
+
+    int suppressed = 0;
+    if (deadlineMissed && missThrottle.allow(suppressed))
+        realtimeLog->log(RealtimeLog::Level::warning, "Sandbox: {} missed its deadline, block left dry ({} more suppressed)",
+                         traceName, suppressed);
+
+    if (now - firstMissTicks < hungTicks)
+        return;
+
+    // Hung: the watchdog kills the child and starts another
+    auto running = State::running;
+    if (state.compare_exchange_strong(running, State::failed))
+        realtimeLog->log(RealtimeLog::Level::error, "Sandbox: {} hung for {} blocks, bypassed until restarted",
+                         traceName, consecutiveMisses);
+}
+
+//==============================================================================
+std::unique_ptr<juce::ChildProcessWorker> SandboxedPlugin::createWorker(const juce::String& commandLine)
+{
+   #if JUCE_LINUX
+    auto worker = std::make_unique<Worker>();
+    if (worker->initialiseFromCommandLine(commandLine, workerID))
+        return worker;
+   #endif
+
+    juce::ignoreUnused(commandLine);
+    return nullptr;
+}
+
+juce::String SandboxedPlugin::measureOverhead(double sampleRate, int blockSize, int numBlocks)
+{
+   #if JUCE_LINUX
+    juce::String error;
+    auto sandbox = create({}, sampleRate, blockSize, error);
+    if (sandbox == nullptr)
+        return "Sandbox unavailable: " + error;
+
+    sandbox->prepareToPlay(sampleRate, blockSize);
+
+    juce::AudioBuffer<float> buffer(2, blockSize), copy(2, blockSize);
+    juce::MidiBuffer midi;
+    juce::Random random;
+    for (int ch = 0; ch < buffer.getNumChannels(); ++ch)
+        for (int i = 0; i < blockSize; ++i)
+            buffer.setSample(ch, i, random.nextFloat() * 2.0f - 1.0f);
+
+    std::vector<double> sandboxMicros, copyMicros;
+    sandboxMicros.reserve(static_cast<size_t>(numBlocks));
+    copyMicros.reserve(static_cast<size_t>(numBlocks));
+
+    const auto ticksPerSecond = static_cast<double>(juce::Time::getHighResolutionTicksPerSecond());
+    const auto microsPerTick = 1.0e6 / ticksPerSecond;
+    const auto periodMicros = blockSize * 1.0e6 / sampleRate;
+    juce::int64 cpuNanos = 0;
+
+    for (int n = 0; n < numBlocks; ++n)
+    {
+        // Paced like callbacks, so the child goes to sleep between blocks as it would live
+        juce::Thread::sleep(juce::jmax(1, juce::roundToInt(periodMicros / 1000.0)));
+
+        const auto cpuStart = getThreadCpuNanos();
+        auto start = juce::Time::getHighResolutionTicks();
+        sandbox->processBlock(buffer, midi);
+        sandboxMicros.push_back(static_cast<double>(juce::Time::getHighResolutionTicks() - start) * microsPerTick);
+        cpuNanos += getThreadCpuNanos() - cpuStart;
+
+        // Baseline: the same data in and out of another buffer, in process
+        start = juce::Time::getHighResolutionTicks();
+        for (int ch = 0; ch < buffer.getNumChannels(); ++ch)
+        {
+            copy.copyFrom(ch, 0, buffer, ch, 0, blockSize);
+            buffer.copyFrom(ch, 0, copy, ch, 0, blockSize);
+        }
+        copyMicros.push_back(static_cast<double>(juce::Time::getHighResolutionTicks() - start) * microsPerTick);
+    }
+
+    const auto percentile = [](std::vector<double> values, double p)
+    {
+        std::sort(values.begin(), values.end());
+        return values.empty() ? 0.0 : values[juce::jmin(values.size() - 1, static_cast<size_t>(p * static_cast<double>(values.size())))];
+    };
+
+    const auto stats = sandbox->getStats();
+    const auto p99 = percentile(sandboxMicros, 0.99);
+
+    juce::String report;
+    report << "Sandbox overhead, " << blockSize << " samples at " << sampleRate << " Hz (period "
+           << juce::String(periodMicros, 1) << " us), " << numBlocks << " blocks" << juce::newLine
+           << "  round trip   median " << juce::String(percentile(sandboxMicros, 0.5), 1) << " us"
+           << "  p99 " << juce::String(p99, 1) << " us"
+           << "  max " << juce::String(percentile(sandboxMicros, 1.0), 1) << " us"
+           << "  (p99 = " << juce::String(100.0 * p99 / periodMicros, 1) << " % of the period)" << juce::newLine
+           << "  host CPU     " << juce::String(static_cast<double>(cpuNanos) / 1000.0 / juce::jmax(1, numBlocks), 1) << " us per block" << juce::newLine
+           << "  in process   median " << juce::String(percentile(copyMicros, 0.5), 2) << " us (copy in and out)" << juce::newLine
+           << "  missed deadlines " << static_cast<juce::int64>(stats.missedDeadlines)
+           << ", bypassed blocks " << static_cast<juce::int64>(stats.bypassedBlocks);
+    return report;
+   #else
+    juce::ignoreUnused(sampleRate, blockSize, numBlocks);
+    return "Plugin sandboxing needs Linux";
+   #endif
+}
@@ -0,0 +1,144 @@
+#pragma once
+
+#include <juce_audio_processors/juce_audio_processors.h>
+#include "RealtimeLog.h"
+#include <atomic>
+#include <memory>
+#include <mutex>
+
+//==============================================================================
+/**
+ * SandboxedPlugin
+ *
+ * Stands in for a plugin that runs in a child process (this executable
+ * relaunched in sandbox mode, see createWorker), so a plugin that crashes or
+ * hangs takes down only its child, not the host.
+ *
+ * Audio moves through one shared-memory block: the host's processBlock copies
+ * the input into it, bumps a request counter and wakes the child with a futex;
+ * the child processes the block in place (no further copies) and bumps the
+ * reply counter. The host spins briefly, then sleeps on the reply futex until
+ * its deadline, a fraction of the buffer period. Control (loading, preparing,
+ * state) goes through ChildProcessCoordinator messages, as in PluginScanner.
+ *
+ * Watchdog: a reply that misses the deadline leaves that block dry, so a hung
+ * or crashed child costs at most one buffer before the plugin is bypassed.
+ * The host stops sending until the child catches up; after hungSeconds of
+ * misses, or as soon as the connection drops, the watchdog thread kills the
+ * child, starts a new one with the last known state and resumes.
+ *
+ * A bypassed plugin passes its input unchanged, without its latency.
+ * Shared memory and futexes are Linux-only; isSupported() is false elsewhere
+ * and HostChain loads such plugins in process.
+ */
+class SandboxedPlugin : public juce::AudioProcessor
+{
+public:
+    static constexpr int maxChannels = 8;
+    static constexpr int maxBlockSize = 8192; // larger blocks go through in pieces
+    static constexpr double deadlineFraction = 0.5; // of the buffer period
+    static constexpr double hungSeconds = 0.25;
+
+    /** Loader thread: launches a child and loads description into it. An empty
+        description makes a pass-through child (for measureOverhead). */
+    static std::unique_ptr<SandboxedPlugin> create(const juce::PluginDescription& description,
+                                                   double sampleRate, int blockSize, juce::String& error);
+
+    static bool isSupported() noexcept;
+
+    ~SandboxedPlugin() override;
+
+    //==============================================================================
+    struct Stats
+    {
+        juce::uint64 roundTrips = 0, missedDeadlines = 0, bypassedBlocks = 0;
+        int restarts = 0;
+        double averageMicros = 0.0, maxMicros = 0.0;
+    };
+
+    Stats getStats() const noexcept;
+
+    //==============================================================================
+    /** Call first thing in JUCEApplication::initialise. If this process was launched
+        as a sandbox, returns the worker to keep alive until the app quits (and the
+        app should create no window); otherwise nullptr. */
+    static std::unique_ptr<juce::ChildProcessWorker> createWorker(const juce::String& commandLine);
+
+    /** Round trips through a pass-through child at the given settings, paced like
+        audio callbacks: latency percentiles against the period and the host CPU
+        time per block, next to an in-process copy as the baseline. */
+    static juce::String measureOverhead(double sampleRate, int blockSize, int numBlocks);
+
+    //==============================================================================
+    const juce::String getName() const override { return description.name; }
+    void prepareToPlay(double sampleRate, int maximumExpectedSamplesPerBlock) override;
+    void releaseResources() override;
+    void processBlock(juce::AudioBuffer<float>&, juce::MidiBuffer&) override;
+
+    double getTailLengthSeconds() const override { return 0.0; }
+    bool acceptsMidi() const override { return false; }
+    bool producesMidi() const override { return false; }
+    juce::AudioProcessorEditor* createEditor() override { return nullptr; }
+    bool hasEditor() const override { return false; }
+    int getNumPrograms() override { return 1; }
+    int getCurrentProgram() override { return 0; }
+    void setCurrentProgram(int) override {}
+    const juce::String getProgramName(int) override { return {}; }
+    void changeProgramName(int, const juce::String&) override {}
+
+    /** Message or loader thread: asks the child, falling back to the last known state. */
+    void getStateInformation(juce::MemoryBlock& destData) override;
+    void setStateInformation(const void* data, int sizeInBytes) override;
+
+private:
+    struct SharedBlock;
+    class SharedMemory;
+    class Process;
+    class Watchdog;
+    class Worker;
+
+    enum class State { starting, running, failed };
+
+    explicit SandboxedPlugin(const juce::PluginDescription& description);
+
+    // Callers hold controlLock
+    bool launch(juce::String& error);
+    bool sendPrepare();
+
+    // Watchdog thread
+    void restart();
+
+    // Audio thread
+    void processChunk(juce::AudioBuffer<float>& buffer, int start, int numSamples) noexcept;
+    bool waitForReply(SharedBlock& block, juce::int64 deadline) noexcept;
+    void recordMiss(juce::int64 now, bool deadlineMissed) noexcept;
+
+    juce::PluginDescription description;
+    std::unique_ptr<SharedMemory> shared;
+    std::unique_ptr<Process> process;
+    std::unique_ptr<Watchdog> watchdog;
+
+    // Message/loader/watchdog threads
+    std::mutex controlLock;
+    juce::MemoryBlock lastState;
+    double preparedRate = 0.0;
+    int preparedBlockSize = 0;
+
+    // Audio thread
+    std::atomic<State> state { State::starting };
+    juce::uint32 sequence = 0;
+    bool awaitingReply = false;
+    int consecutiveMisses = 0;
+    double ticksPerSample = 0.0;
+    juce::int64 hungTicks = 0, firstMissTicks = 0;
+    const char* traceName = nullptr; // interned, for log records
+    juce::SharedResourcePointer<RealtimeLog> realtimeLog;
+    RealtimeLog::Throttle missThrottle;
+
+    // Written by the audio thread only
+    std::atomic<juce::uint64> roundTrips { 0 }, missedDeadlines { 0 }, bypassedBlocks { 0 };
+    std::atomic<juce::int64> roundTripTicks { 0 }, maxRoundTripTicks { 0 };
+    std::atomic<int> restarts { 0 };
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(SandboxedPlugin)
+};
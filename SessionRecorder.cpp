@@ -0,0 +1,426 @@
+#include "SessionRecorder.h"
+#include <cstring>
+#include <thread>
+
+#if JUCE_LINUX || JUCE_MAC
+ #include <fcntl.h>
+ #include <unistd.h>
+#endif
+
+namespace
+{
+    // Reserves the blocks up front without changing the file size, so the stream
+    // still starts at 0 and the file system does not have to grow it as it goes
+    void preallocate(const juce::File& file, juce::int64 bytes)
+    {
+       #if JUCE_LINUX || JUCE_MAC
+        const auto fd = ::open(file.getFullPathName().toRawUTF8(), O_WRONLY | O_CREAT, 0644);
+        if (fd < 0)
+            return;
+
+        #if JUCE_LINUX
+         fallocate(fd, FALLOC_FL_KEEP_SIZE, 0, static_cast<off_t>(bytes));
+        #else
+         fstore_t store { F_ALLOCATECONTIG, F_PEOFPOSMODE, 0, static_cast<off_t>(bytes), 0 };
+         if (fcntl(fd, F_PREALLOCATE, &store) == -1)
+         {
+             store.fst_flags = F_ALLOCATEALL;
+             fcntl(fd, F_PREALLOCATE, &store);
+         }
+        #endif
+
+        ::close(fd);
+       #else
+        juce::ignoreUnused(file, bytes);
+       #endif
+    }
+
+    // Gives back what the recording did not use
+    void trimPreallocation(const juce::File& file)
+    {
+       #if JUCE_LINUX || JUCE_MAC
+        if (file.existsAsFile())
+            ::truncate(file.getFullPathName().toRawUTF8(), static_cast<off_t>(file.getSize()));
+       #else
+        juce::ignoreUnused(file);
+       #endif
+    }
+
+    juce::String formatTime(juce::int64 frames, double sampleRate)
+    {
+        const auto seconds = sampleRate > 0.0 ? static_cast<double>(frames) / sampleRate : 0.0;
+        const auto whole = static_cast<int>(seconds);
+        return juce::String::formatted("%02d:%02d:%02d.%03d", whole / 3600, (whole / 60) % 60, whole % 60,
+                                       static_cast<int>((seconds - whole) * 1000.0));
+    }
+}
+
+//==============================================================================
+SessionRecorder::SessionRecorder()
+{
+    storage.setSize(numChannelsPerFile * 2, fifoFrames);
+    silence.setSize(numChannelsPerFile, minWriteFrames);
+    silence.clear();
+    writtenGaps.reserve(256);
+
+    diskThread.addTimeSliceClient(this);
+    diskThread.startThread(juce::Thread::Priority::high);
+}
+
+SessionRecorder::~SessionRecorder()
+{
+    stop();
+    diskThread.removeTimeSliceClient(this);
+    diskThread.stopThread(5000);
+}
+
+void SessionRecorder::prepare(double sampleRate)
+{
+    preparedRate.store(sampleRate, std::memory_order_release);
+}
+
+juce::File SessionRecorder::getDefaultFolder()
+{
+    return juce::File::getSpecialLocation(juce::File::userMusicDirectory).getChildFile("DSP4Guitar Recordings");
+}
+
+//==============================================================================
+std::unique_ptr<juce::AudioFormatWriter::ThreadedWriter> SessionRecorder::createWriter(const juce::File& file, Format fileFormat,
+                                                                                       const juce::String& description,
+                                                                                       juce::String& error)
+{
+    file.deleteFile();
+    preallocate(file, static_cast<juce::int64>(fileRate * 60.0 * preallocateMinutes) * numChannelsPerFile * 3);
+
+    // A large stream buffer turns the writer's small writes into 1 MiB ones
+    auto stream = std::make_unique<juce::FileOutputStream>(file, streamBufferBytes);
+    if (! stream->openedOk())
+    {
+        error = "Could not write " + file.getFullPathName();
+        return nullptr;
+    }
+
+    std::unique_ptr<juce::AudioFormatWriter> writer;
+    if (fileFormat == Format::flac)
+    {
+        juce::FlacAudioFormat flac;
+        writer.reset(flac.createWriterFor(stream.get(), fileRate, static_cast<unsigned int>(numChannelsPerFile), 24, {}, 0));
+    }
+    else
+    {
+        // Broadcast WAV: the start time lets the two files (and other recorders) be lined up
+        const auto metadata = juce::WavAudioFormat::createBWAVMetadata(description, "DSP4Guitar", {},
+                                                                       juce::Time::getCurrentTime(), 0, {});
+        juce::WavAudioFormat wav;
+        writer.reset(wav.createWriterFor(stream.get(), fileRate, static_cast<unsigned int>(numChannelsPerFile), 24, metadata, 0));
+    }
+
+    if (writer == nullptr)
+    {
+        error = "Could not create a writer for " + file.getFileName();
+        return nullptr;
+    }
+
+    stream.release(); // Owned by the writer now
+    return std::make_unique<juce::AudioFormatWriter::ThreadedWriter>(writer.release(), diskThread, writerBufferFrames);
+}
+
+bool SessionRecorder::start(const juce::File& destination, Format fileFormat, juce::String& error)
+{
+    stop();
+
+    fileRate = preparedRate.load(std::memory_order_acquire);
+    if (fileRate <= 0.0)
+    {
+        error = "Audio is not running";
+        return false;
+    }
+
+    if (! destination.createDirectory())
+    {
+        error = "Could not create " + destination.getFullPathName();
+        return false;
+    }
+
+    folder = destination;
+    format = fileFormat;
+
+    const auto base = "Show-" + juce::Time::getCurrentTime().formatted("%Y%m%d-%H%M%S");
+    const auto extension = fileFormat == Format::flac ? ".flac" : ".wav";
+    inputFile = destination.getNonexistentChildFile(base + "-DI", extension, false);
+    outputFile = destination.getNonexistentChildFile(base + "-Out", extension, false);
+
+    {
+        const juce::ScopedLock sl(writerLock);
+        inputWriter = createWriter(inputFile, fileFormat, "DI (dry input)", error);
+        outputWriter = inputWriter != nullptr ? createWriter(outputFile, fileFormat, "Processed output", error) : nullptr;
+
+        if (outputWriter == nullptr)
+        {
+            inputWriter = nullptr;
+            return false;
+        }
+
+        framesRead = 0;
+        silenceRemaining = 0;
+        inputDone = false;
+        writtenGaps.clear();
+        gapCount.store(0);
+        framesWritten.store(0);
+        flushing.store(false);
+    }
+
+    // The audio thread is out (armed is false), so its side can be reset here
+    fifo.reset();
+    gapFifo.reset();
+    framesPushed = 0;
+    pendingGap = 0;
+    droppedFrames.store(0);
+
+    armed.store(true, std::memory_order_seq_cst);
+    return true;
+}
+
+void SessionRecorder::stop()
+{
+    if (! armed.exchange(false, std::memory_order_seq_cst) && inputWriter == nullptr)
+        return;
+
+    // Let a block in progress finish, then drain whatever is buffered
+    while (busy.load(std::memory_order_seq_cst))
+        std::this_thread::yield();
+
+    flushing.store(true);
+    const auto giveUp = juce::Time::getMillisecondCounter() + 10000;
+    while (! isDrained() && juce::Time::getMillisecondCounter() < giveUp)
+        juce::Thread::sleep(5);
+
+    closeFiles();
+}
+
+bool SessionRecorder::isDrained()
+{
+    const juce::ScopedLock sl(writerLock);
+    return fifo.getNumReady() == 0 && gapFifo.getNumReady() == 0 && silenceRemaining == 0;
+}
+
+void SessionRecorder::closeFiles()
+{
+    std::vector<Gap> gapList;
+    std::unique_ptr<juce::AudioFormatWriter::ThreadedWriter> input, output;
+    {
+        const juce::ScopedLock sl(writerLock);
+        input = std::move(inputWriter);
+        output = std::move(outputWriter);
+        gapList.swap(writtenGaps);
+        writtenGaps.reserve(256);
+    }
+
+    // Each ThreadedWriter writes out its buffer, then its format writer finishes the header
+    input = nullptr;
+    output = nullptr;
+
+    trimPreallocation(inputFile);
+    trimPreallocation(outputFile);
+
+    if (gapList.empty() && droppedFrames.load() == 0)
+        return;
+
+    juce::String report;
+    report << "Dropped blocks, filled with silence (the disk was too slow)" << juce::newLine
+           << "Position      Length" << juce::newLine;
+    for (const auto& gap : gapList)
+        report << formatTime(gap.atFrame, fileRate) << "  " << gap.length << " samples" << juce::newLine;
+    report << "Total: " << droppedFrames.load() << " samples" << juce::newLine;
+
+    inputFile.getSiblingFile(inputFile.getFileNameWithoutExtension().upToLastOccurrenceOf("-DI", false, false) + "-gaps.txt")
+        .replaceWithText(report);
+}
+
+void SessionRecorder::update()
+{
+    // The device changed rate: the files can't, so start a new pair
+    const auto rate = preparedRate.load(std::memory_order_acquire);
+    if (isRecording() && rate > 0.0 && rate != fileRate)
+    {
+        juce::String error;
+        if (! start(folder, format, error))
+            juce::Logger::writeToLog("Recorder: could not restart after a rate change: " + error);
+    }
+}
+
+SessionRecorder::Stats SessionRecorder::getStats() const
+{
+    Stats stats;
+    stats.recording = isRecording();
+    stats.seconds = fileRate > 0.0 ? static_cast<double>(framesWritten.load()) / fileRate : 0.0;
+    stats.droppedFrames = droppedFrames.load(std::memory_order_relaxed);
+    stats.gaps = gapCount.load(std::memory_order_relaxed);
+    stats.fifoFill = static_cast<float>(fifo.getNumReady()) / static_cast<float>(fifoFrames);
+    return stats;
+}
+
+juce::String SessionRecorder::getSummary() const
+{
+    const auto stats = getStats();
+    if (! stats.recording)
+        return "Not recording";
+
+    const auto seconds = static_cast<int>(stats.seconds);
+    juce::String summary;
+    summary << "REC " << juce::String::formatted("%d:%02d", seconds / 60, seconds % 60)
+            << ", " << stats.droppedFrames << " dropped";
+    if (stats.fifoFill > 0.5f)
+        summary << " (disk behind: buffer " << juce::roundToInt(stats.fifoFill * 100.0f) << "% full)";
+    return summary;
+}
+
+//==============================================================================
+void SessionRecorder::copyIntoStorage(const juce::AudioBuffer<float>& buffer, int startSample, int firstChannel) noexcept
+{
+    for (int ch = 0; ch < numChannelsPerFile; ++ch)
+    {
+        const auto* source = buffer.getReadPointer(juce::jmin(ch, buffer.getNumChannels() - 1), startSample);
+        auto* dest = storage.getWritePointer(firstChannel + ch);
+
+        std::memcpy(dest + start1, source, static_cast<size_t>(size1) * sizeof(float));
+        if (size2 > 0)
+            std::memcpy(dest + start2, source + size1, static_cast<size_t>(size2) * sizeof(float));
+    }
+}
+
+void SessionRecorder::pushInput(const juce::AudioBuffer<float>& buffer, int startSample, int numSamples) noexcept
+{
+    reserved = false;
+
+    // busy before armed, so stop() either sees this block or this block sees stop()
+    busy.store(true, std::memory_order_seq_cst);
+    if (! armed.load(std::memory_order_seq_cst) || numSamples <= 0 || buffer.getNumChannels() == 0)
+    {
+        busy.store(false, std::memory_order_release);
+        return;
+    }
+
+    if (fifo.getFreeSpace() < numSamples)
+    {
+        pendingGap += numSamples;
+        droppedFrames.fetch_add(numSamples, std::memory_order_relaxed);
+
+        int suppressed = 0;
+        if (dropThrottle.allow(suppressed))
+            realtimeLog->log(RealtimeLog::Level::warning, "Recorder: disk too slow, dropped a {}-sample block ({} more suppressed)",
+                             numSamples, suppressed);
+
+        busy.store(false, std::memory_order_release);
+        return;
+    }
+
+    // The silence for earlier drops goes in before this block
+    if (pendingGap > 0 && gapFifo.getFreeSpace() > 0)
+    {
+        const auto scope = gapFifo.write(1);
+        gaps[static_cast<size_t>(scope.startIndex1)] = { framesPushed, pendingGap };
+        pendingGap = 0;
+    }
+
+    fifo.prepareToWrite(numSamples, start1, size1, start2, size2);
+    copyIntoStorage(buffer, startSample, 0);
+    reserved = true;
+}
+
+void SessionRecorder::pushOutput(const juce::AudioBuffer<float>& buffer, int startSample, int numSamples) noexcept
+{
+    if (! reserved)
+        return;
+
+    jassert(numSamples == size1 + size2);
+    juce::ignoreUnused(numSamples);
+    copyIntoStorage(buffer, startSample, numChannelsPerFile);
+
+    fifo.finishedWrite(size1 + size2);
+    framesPushed += size1 + size2;
+    reserved = false;
+    busy.store(false, std::memory_order_release);
+}
+
+//==============================================================================
+const SessionRecorder::Gap* SessionRecorder::peekGap() noexcept
+{
+    int start, size, unusedStart, unusedSize;
+    gapFifo.prepareToRead(1, start, size, unusedStart, unusedSize);
+    return size > 0 ? &gaps[static_cast<size_t>(start)] : nullptr;
+}
+
+bool SessionRecorder::writeBoth(const float* const* input, const float* const* output, int numSamples)
+{
+    // A chunk the output writer had no room for is retried without writing the input twice
+    if (! inputDone && ! inputWriter->write(input, numSamples))
+        return false;
+    inputDone = true;
+
+    if (! outputWriter->write(output, numSamples))
+        return false;
+    inputDone = false;
+
+    framesWritten.fetch_add(numSamples, std::memory_order_relaxed);
+    return true;
+}
+
+int SessionRecorder::useTimeSlice()
+{
+    const juce::ScopedLock sl(writerLock);
+    if (inputWriter == nullptr || outputWriter == nullptr)
+        return 100;
+
+    // Silence for dropped blocks, at the position they were dropped from
+    const auto* gap = peekGap();
+    if (silenceRemaining == 0 && gap != nullptr && gap->atFrame <= framesRead)
+    {
+        silenceRemaining = gap->length;
+        if (writtenGaps.size() < writtenGaps.capacity())
+            writtenGaps.push_back({ framesWritten.load(), gap->length });
+        gapCount.fetch_add(1, std::memory_order_relaxed);
+        gapFifo.finishedRead(1);
+        gap = peekGap();
+    }
+
+    if (silenceRemaining > 0)
+    {
+        const auto numSamples = static_cast<int>(juce::jmin<juce::int64>(silenceRemaining, silence.getNumSamples()));
+        if (! writeBoth(silence.getArrayOfReadPointers(), silence.getArrayOfReadPointers(), numSamples))
+            return 20; // The writers are full: give them the thread
+        silenceRemaining -= numSamples;
+        return 0;
+    }
+
+    // Stop short of the next gap
+    auto ready = static_cast<juce::int64>(fifo.getNumReady());
+    bool atBoundary = false;
+    if (gap != nullptr)
+    {
+        atBoundary = gap->atFrame - framesRead <= ready;
+        ready = juce::jmin(ready, gap->atFrame - framesRead);
+    }
+
+    // Large writes only, unless flushing or a gap comes first
+    if (ready == 0 || (ready < minWriteFrames && ! atBoundary && ! flushing.load()))
+        return 10;
+
+    int readStart1, readSize1, readStart2, readSize2;
+    fifo.prepareToRead(static_cast<int>(ready), readStart1, readSize1, readStart2, readSize2);
+
+    // The first contiguous part only; the rest comes next slice
+    std::array<const float*, numChannelsPerFile> input {}, output {};
+    for (int ch = 0; ch < numChannelsPerFile; ++ch)
+    {
+        input[static_cast<size_t>(ch)] = storage.getReadPointer(ch, readStart1);
+        output[static_cast<size_t>(ch)] = storage.getReadPointer(numChannelsPerFile + ch, readStart1);
+    }
+
+    if (! writeBoth(input.data(), output.data(), readSize1))
+        return 20;
+
+    fifo.finishedRead(readSize1);
+    framesRead += readSize1;
+    return 0;
+}
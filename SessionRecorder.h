@@ -0,0 +1,134 @@
+#pragma once
+
+#include <juce_audio_formats/juce_audio_formats.h>
+#include "RealtimeLog.h"
+#include <array>
+#include <atomic>
+#include <memory>
+#include <vector>
+
+//==============================================================================
+/**
+ * SessionRecorder
+ *
+ * Records the dry input (DI, for re-amping) and the processed output of the
+ * standalone host to two sample-aligned files, WAV or FLAC.
+ *
+ * The audio thread copies each block's input (pushInput, before processing)
+ * and output (pushOutput, after) into one preallocated AbstractFifo, so both
+ * files always get the same frames. A background TimeSliceThread drains it in
+ * large chunks into an AudioFormatWriter::ThreadedWriter per file, which
+ * writes to disk through a 1 MiB stream buffer; the files are preallocated on
+ * start (Linux and macOS) and trimmed on stop.
+ *
+ * Backpressure: a slow disk fills the writers' buffers, then the FIFO, and the
+ * audio thread drops whole blocks rather than wait. Dropped blocks are counted
+ * and logged, and written as silence where they fell, so the recording stays
+ * in time; their positions go into a "-gaps.txt" file next to the recording.
+ */
+class SessionRecorder : private juce::TimeSliceClient
+{
+public:
+    enum class Format { wav, flac };
+
+    static constexpr int numChannelsPerFile = 2;   // mono input is duplicated
+    static constexpr int fifoFrames = 1 << 19;     // ~11 s at 48 kHz
+    static constexpr int minWriteFrames = 16384;   // drained in chunks of at least this
+    static constexpr int writerBufferFrames = 1 << 18;
+    static constexpr int streamBufferBytes = 1 << 20;
+    static constexpr int preallocateMinutes = 30;
+
+    struct Stats
+    {
+        bool recording = false;
+        double seconds = 0.0;
+        juce::int64 droppedFrames = 0;
+        int gaps = 0;
+        float fifoFill = 0.0f; // 0..1
+    };
+
+    SessionRecorder();
+    ~SessionRecorder() override;
+
+    /** Audio stopped (prepareToPlay). A new rate while recording starts a new pair of
+        files at the next update(). */
+    void prepare(double sampleRate);
+
+    //==============================================================================
+    /** Message thread. Starts "<folder>/Show-<date>-DI" and "-Out". */
+    bool start(const juce::File& folder, Format format, juce::String& error);
+
+    /** Message thread. Writes out what is buffered and closes the files. */
+    void stop();
+
+    bool isRecording() const noexcept { return armed.load(std::memory_order_acquire); }
+
+    /** Message thread, from a UI timer. */
+    void update();
+    Stats getStats() const;
+
+    /** e.g. "REC 12:34, 0 dropped" */
+    juce::String getSummary() const;
+
+    static juce::File getDefaultFolder();
+
+    //==============================================================================
+    /** Audio thread, before processing: reserves the block in the FIFO and copies the input. */
+    void pushInput(const juce::AudioBuffer<float>& buffer, int startSample, int numSamples) noexcept;
+
+    /** Audio thread, after processing: copies the output and commits the block. */
+    void pushOutput(const juce::AudioBuffer<float>& buffer, int startSample, int numSamples) noexcept;
+
+private:
+    struct Gap
+    {
+        juce::int64 atFrame = 0, length = 0;
+    };
+
+    int useTimeSlice() override;
+    const Gap* peekGap() noexcept;
+    bool isDrained();
+    void copyIntoStorage(const juce::AudioBuffer<float>& buffer, int startSample, int firstChannel) noexcept;
+    bool writeBoth(const float* const* input, const float* const* output, int numSamples);
+    std::unique_ptr<juce::AudioFormatWriter::ThreadedWriter> createWriter(const juce::File& file, Format format,
+                                                                          const juce::String& description, juce::String& error);
+    void closeFiles();
+
+    juce::TimeSliceThread diskThread { "Session recorder" };
+
+    // Channels 0-1 input, 2-3 output
+    juce::AudioBuffer<float> storage;
+    juce::AbstractFifo fifo { fifoFrames };
+    std::array<Gap, 64> gaps;
+    juce::AbstractFifo gapFifo { 64 };
+
+    // Audio thread
+    std::atomic<bool> armed { false }, busy { false };
+    bool reserved = false;
+    int start1 = 0, size1 = 0, start2 = 0, size2 = 0;
+    juce::int64 framesPushed = 0, pendingGap = 0;
+    juce::SharedResourcePointer<RealtimeLog> realtimeLog;
+    RealtimeLog::Throttle dropThrottle;
+
+    // Written by the audio thread only
+    std::atomic<juce::int64> droppedFrames { 0 };
+
+    // Disk thread, under writerLock
+    juce::CriticalSection writerLock;
+    std::unique_ptr<juce::AudioFormatWriter::ThreadedWriter> inputWriter, outputWriter;
+    juce::AudioBuffer<float> silence;
+    juce::int64 framesRead = 0, silenceRemaining = 0;
+    bool inputDone = false;
+    std::atomic<bool> flushing { false };
+    std::atomic<juce::int64> framesWritten { 0 };
+    std::atomic<int> gapCount { 0 };
+    std::vector<Gap> writtenGaps; // reserved up front, for the gaps file
+
+    // Message thread
+    std::atomic<double> preparedRate { 0.0 };
+    double fileRate = 0.0;
+    juce::File folder, inputFile, outputFile;
+    Format format = Format::wav;
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(SessionRecorder)
+};
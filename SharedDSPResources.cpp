@@ -0,0 +1,58 @@
+#include "SharedDSPResources.h"
+#include <cstring>
+
+//==============================================================================
+juce::uint64 SharedDSPResources::hash(const void* data, size_t numBytes, juce::uint64 seed) noexcept
+{
+    auto h = seed;
+    const auto* bytes = static_cast<const juce::uint8*>(data);
+    for (size_t i = 0; i < numBytes; ++i)
+    {
+        h ^= bytes[i];
+        h *= 0x100000001b3ull;
+    }
+    return h;
+}
+
+juce::uint64 SharedDSPResources::hash(const char* text, juce::uint64 seed) noexcept
+{
+    return hash(text, std::strlen(text), seed);
+}
+
+void SharedDSPResources::pruneExpired()
+{
+    for (auto it = entries.begin(); it != entries.end();)
+    {
+        if (it->second.expired())
+            it = entries.erase(it);
+        else
+            ++it;
+    }
+}
+
+//==============================================================================
+std::shared_ptr<const SharedDSPResources::WaveTable> SharedDSPResources::getSineTable(size_t numPoints)
+{
+    const auto key = hash(&numPoints, sizeof(numPoints), hash("sine-table"));
+
+    return getOrCreate<WaveTable>(key, [numPoints]
+    {
+        auto table = std::make_shared<WaveTable>();
+        table->samples.resize(numPoints + 1);
+
+        for (size_t i = 0; i <= numPoints; ++i)
+            table->samples[i] = std::sin(juce::MathConstants<float>::twoPi * static_cast<float>(i) / static_cast<float>(numPoints)
+                                         - juce::MathConstants<float>::pi);
+        return table;
+    });
+}
+
+std::shared_ptr<const juce::dsp::FFT> SharedDSPResources::getFFT(int order)
+{
+    const auto key = hash(&order, sizeof(order), hash("fft"));
+
+    return getOrCreate<juce::dsp::FFT>(key, [order]
+    {
+        return std::make_shared<juce::dsp::FFT>(order);
+    });
+}
@@ -0,0 +1,78 @@
+#pragma once
+
+#include <juce_core/juce_core.h>
+#include <juce_dsp/juce_dsp.h>
+#include <map>
+#include <memory>
+#include <vector>
+
+//==============================================================================
+/**
+ * SharedDSPResources
+ *
+ * Process-wide cache of immutable DSP data (oscillator tables, waveshaper
+ * LUTs, FFT setups) shared by every plugin instance.
+ *
+ * Entries are keyed by a 64-bit hash of what they are built from (a
+ * resource that depends on the sample rate hashes it in). The cache only
+ * holds weak references: a resource lives as long as at least one instance
+ * holds the returned shared_ptr, and is rebuilt the next time someone asks
+ * after the last user has gone.
+ *
+ * Access it through juce::SharedResourcePointer<SharedDSPResources>. Lookups
+ * take a lock, so call them from constructors / prepareToPlay, never from the
+ * audio thread; the returned data itself is read-only and safe anywhere.
+ */
+class SharedDSPResources
+{
+public:
+    using Key = juce::uint64; // see hash()
+
+    /** Single-cycle table with one guard point at the end for interpolation. */
+    struct WaveTable
+    {
+        std::vector<float> samples;
+        size_t size() const noexcept { return samples.size() - 1; }
+    };
+
+    SharedDSPResources() = default;
+
+    //==============================================================================
+    /** FNV-1a over raw bytes; chain calls through seed to hash several fields. */
+    static juce::uint64 hash(const void* data, size_t numBytes,
+                             juce::uint64 seed = 0xcbf29ce484222325ull) noexcept;
+    static juce::uint64 hash(const char* text, juce::uint64 seed = 0xcbf29ce484222325ull) noexcept;
+
+    /** Returns the cached resource for key, building it with create() if nobody holds one. */
+    template <typename Resource, typename Factory>
+    std::shared_ptr<const Resource> getOrCreate(Key key, Factory&& create)
+    {
+        const juce::ScopedLock sl(lock);
+        pruneExpired();
+
+        auto& entry = entries[key];
+        if (auto existing = entry.lock())
+            return std::static_pointer_cast<const Resource>(existing);
+
+        std::shared_ptr<const Resource> created = create();
+        entry = created;
+        return created;
+    }
+
+    //==============================================================================
+    // Typed helpers for the resources the chain uses
+
+    /** Sine over [-pi, pi), the shape juce::dsp::Oscillator builds for std::sin. */
+    std::shared_ptr<const WaveTable> getSineTable(size_t numPoints);
+
+    /** Shared FFT engine; juce::dsp::FFT's transforms are const and thread-safe. */
+    std::shared_ptr<const juce::dsp::FFT> getFFT(int order);
+
+private:
+    void pruneExpired();
+
+    juce::CriticalSection lock;
+    std::map<Key, std::weak_ptr<const void>> entries;
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(SharedDSPResources)
+};
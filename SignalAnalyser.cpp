@@ -0,0 +1,349 @@
+#include "SignalAnalyser.h"
+#include "CyberpunkLookAndFeel.h"
+#include <cmath>
+
+namespace
+{
+    constexpr float peakFallDbPerSecond = 20.0f;
+    constexpr float spectrumFallDbPerSecond = 40.0f;
+    constexpr double rmsSeconds = 0.3;
+    constexpr double reductionSeconds = 0.1;
+    constexpr float lowestFrequency = 20.0f, highestFrequency = 20000.0f;
+
+    float toDb(float gain) { return juce::Decibels::gainToDecibels(gain, SignalAnalyser::minDb); }
+}
+
+//==============================================================================
+SignalAnalyser::SignalAnalyser(MultiEffectProcessor& p)
+    : processor(p), fft(resources->getFFT(fftOrder))
+{
+    spectrumDb.fill(minDb);
+
+    auto& apvts = processor.apvts;
+    compressorOn  = apvts.getRawParameterValue("compressorOn");
+    thresholds[0] = apvts.getRawParameterValue("compressorLowThresh");
+    thresholds[1] = apvts.getRawParameterValue("compressorMidThresh");
+    thresholds[2] = apvts.getRawParameterValue("compressorHighThresh");
+    ratio         = apvts.getRawParameterValue("compressorRatio");
+    attack        = apvts.getRawParameterValue("compressorAttack");
+    release       = apvts.getRawParameterValue("compressorRelease");
+
+    // Whatever is queued predates this analyser
+    for (auto& tap : processor.getSignalTaps().points)
+        tap.discard();
+
+    processor.setAnalysisEnabled(true);
+    lastUpdateMs = juce::Time::getMillisecondCounterHiRes();
+}
+
+SignalAnalyser::~SignalAnalyser()
+{
+    processor.setAnalysisEnabled(false);
+}
+
+float SignalAnalyser::getSpectrumBandFrequency(float band) noexcept
+{
+    const auto proportion = band / static_cast<float>(numSpectrumBands);
+    return lowestFrequency * std::pow(highestFrequency / lowestFrequency, proportion);
+}
+
+//==============================================================================
+void SignalAnalyser::update()
+{
+    const auto now = juce::Time::getMillisecondCounterHiRes();
+    const auto seconds = juce::jlimit(0.0, 1.0, (now - lastUpdateMs) * 0.001);
+    lastUpdateMs = now;
+
+    auto& taps = processor.getSignalTaps();
+
+    for (size_t point = 0; point < taps.points.size(); ++point)
+    {
+        const auto numSamples = taps.points[point].read(scratch);
+        updateLevel(point, numSamples, seconds);
+
+        if (point == SignalTaps::PostFuzz)
+            updateGainReduction(numSamples, seconds);
+        else if (point == SignalTaps::Output)
+        {
+            updateSpectrum(numSamples, seconds);
+            waveform.append(scratch, numSamples, processor.getSampleRate());
+        }
+    }
+}
+
+void SignalAnalyser::updateLevel(size_t point, int numSamples, double seconds)
+{
+    auto& level = levels[point];
+
+    const auto peak = numSamples > 0 ? scratch.getMagnitude(0, numSamples) : 0.0f;
+    level.peakDb = juce::jmax(toDb(peak), level.peakDb - peakFallDbPerSecond * static_cast<float>(seconds));
+
+    if (numSamples > 0)
+    {
+        float sum = 0.0f;
+        for (int ch = 0; ch < scratch.getNumChannels(); ++ch)
+        {
+            const auto rms = scratch.getRMSLevel(ch, 0, numSamples);
+            sum += rms * rms;
+        }
+
+        const auto coefficient = static_cast<float>(std::exp(-seconds / rmsSeconds));
+        meanSquare[point] = coefficient * meanSquare[point]
+                            + (1.0f - coefficient) * sum / static_cast<float>(scratch.getNumChannels());
+    }
+    else
+    {
+        meanSquare[point] *= static_cast<float>(std::exp(-seconds / rmsSeconds));
+    }
+
+    level.rmsDb = toDb(std::sqrt(meanSquare[point]));
+}
+
+//==============================================================================
+void SignalAnalyser::prepareCompressorModel(double sampleRate)
+{
+    modelSampleRate = sampleRate;
+    bandInput.assign(static_cast<size_t>(AudioTap::capacity), 0.0f);
+    bandOutput.assign(static_cast<size_t>(AudioTap::capacity), 0.0f);
+
+    // Same crossover as MultibandCompressor: low < 300 Hz < mid < 3 kHz < high
+    using Coefficients = juce::dsp::IIR::Coefficients<float>;
+    bands[0].lowPass.coefficients  = Coefficients::makeLowPass(sampleRate, 300.0f);
+    bands[1].highPass.coefficients = Coefficients::makeHighPass(sampleRate, 300.0f);
+    bands[1].lowPass.coefficients  = Coefficients::makeLowPass(sampleRate, 3000.0f);
+    bands[2].highPass.coefficients = Coefficients::makeHighPass(sampleRate, 3000.0f);
+    bands[0].useLowPass = bands[1].useHighPass = bands[1].useLowPass = bands[2].useHighPass = true;
+
+    const juce::dsp::ProcessSpec spec { sampleRate, static_cast<juce::uint32>(AudioTap::capacity), 1 };
+    for (auto& band : bands)
+    {
+        band.highPass.reset();
+        band.lowPass.reset();
+        band.compressor.prepare(spec);
+        band.reductionDb = 0.0f;
+    }
+}
+
+void SignalAnalyser::updateGainReduction(int numSamples, double seconds)
+{
+    const auto sampleRate = processor.getSampleRate();
+    if (sampleRate <= 0.0)
+        return;
+
+    if (sampleRate != modelSampleRate)
+        prepareCompressorModel(sampleRate);
+
+    const auto coefficient = static_cast<float>(std::exp(-seconds / reductionSeconds));
+    const bool active = compressorOn->load() >= 0.5f && numSamples > 0;
+
+    for (size_t b = 0; b < bands.size(); ++b)
+    {
+        auto& band = bands[b];
+        auto targetDb = 0.0f;
+
+        if (active)
+        {
+            // Mono model: the mean of both channels
+            const auto n = static_cast<size_t>(numSamples);
+            for (size_t i = 0; i < n; ++i)
+                bandInput[i] = 0.5f * (scratch.getSample(0, static_cast<int>(i)) + scratch.getSample(1, static_cast<int>(i)));
+
+            float* channels[] = { bandInput.data() };
+            juce::dsp::AudioBlock<float> inputBlock(channels, 1, n);
+            juce::dsp::ProcessContextReplacing<float> filterContext(inputBlock);
+            if (band.useHighPass) band.highPass.process(filterContext);
+            if (band.useLowPass)  band.lowPass.process(filterContext);
+
+            std::copy(bandInput.begin(), bandInput.begin() + static_cast<std::ptrdiff_t>(n), bandOutput.begin());
+            float* outputChannels[] = { bandOutput.data() };
+            juce::dsp::AudioBlock<float> outputBlock(outputChannels, 1, n);
+
+            band.compressor.setThreshold(thresholds[b]->load());
+            band.compressor.setRatio(ratio->load());
+            band.compressor.setAttack(attack->load());
+            band.compressor.setRelease(release->load());
+            band.compressor.process(juce::dsp::ProcessContextReplacing<float>(outputBlock));
+
+            float sumIn = 0.0f, sumOut = 0.0f;
+            for (size_t i = 0; i < n; ++i)
+            {
+                sumIn  += bandInput[i] * bandInput[i];
+                sumOut += bandOutput[i] * bandOutput[i];
+            }
+
+            if (sumIn > 1.0e-10f)
+                targetDb = juce::jmin(0.0f, 10.0f * std::log10(sumOut / sumIn));
+        }
+
+        band.reductionDb = coefficient * band.reductionDb + (1.0f - coefficient) * targetDb;
+    }
+}
+
+//==============================================================================
+void SignalAnalyser::updateSpectrum(int numSamples, double seconds)
+{
+    // Append the newest audio (mono) to the analysis history
+    const auto start = juce::jmax(0, numSamples - fftSize);
+    for (int i = start; i < numSamples; ++i)
+    {
+        history[static_cast<size_t>(historyPosition)] = 0.5f * (scratch.getSample(0, i) + scratch.getSample(1, i));
+        historyPosition = (historyPosition + 1) % fftSize;
+    }
+
+    const auto fall = spectrumFallDbPerSecond * static_cast<float>(seconds);
+    const auto sampleRate = processor.getSampleRate();
+
+    if (numSamples == 0 || sampleRate <= 0.0)
+    {
+        for (auto& db : spectrumDb)
+            db = juce::jmax(minDb, db - fall);
+        return;
+    }
+
+    // One transform per update, however many samples arrived (time decimation)
+    for (int i = 0; i < fftSize; ++i)
+        fftData[static_cast<size_t>(i)] = history[static_cast<size_t>((historyPosition + i) % fftSize)];
+    std::fill(fftData.begin() + fftSize, fftData.end(), 0.0f);
+
+    window.multiplyWithWindowingTable(fftData.data(), static_cast<size_t>(fftSize));
+    fft->performFrequencyOnlyForwardTransform(fftData.data(), true);
+
+    // Hann coherent gain is 0.5: a full-scale sine reads 0 dB
+    const auto scale = 4.0f / static_cast<float>(fftSize);
+    const auto binWidth = sampleRate / fftSize;
+
+    // Bins to log-spaced display bands (frequency decimation), peak per band
+    for (int b = 0; b < numSpectrumBands; ++b)
+    {
+        const auto lowBin  = juce::jlimit(1, fftSize / 2, static_cast<int>(getSpectrumBandFrequency(static_cast<float>(b)) / binWidth));
+        const auto highBin = juce::jlimit(lowBin, fftSize / 2, static_cast<int>(getSpectrumBandFrequency(static_cast<float>(b + 1)) / binWidth));
+
+        float magnitude = 0.0f;
+        for (int k = lowBin; k <= highBin; ++k)
+            magnitude = juce::jmax(magnitude, fftData[static_cast<size_t>(k)]);
+
+        auto& db = spectrumDb[static_cast<size_t>(b)];
+        db = juce::jmax(toDb(magnitude * scale), db - fall);
+    }
+}
+
+//==============================================================================
+namespace
+{
+    void drawFrame(juce::Graphics& g, juce::Rectangle<int> bounds, const juce::String& title)
+    {
+        using CP = CyberpunkLookAndFeel;
+
+        g.fillAll(CP::matrixDarkBG);
+        g.setColour(juce::Colour(0xFF080812));
+        g.fillRoundedRectangle(bounds.toFloat(), 5.0f);
+        g.setColour(CP::matrixGreen.withAlpha(0.6f));
+        g.drawRoundedRectangle(bounds.toFloat().reduced(0.5f), 5.0f, 1.2f);
+
+        g.setFont(CyberpunkLookAndFeel::getCustomFont().withHeight(12.0f).boldened());
+        g.setColour(CP::matrixGreen);
+        g.drawText(title, bounds.removeFromTop(28), juce::Justification::centred);
+    }
+
+    float dbToProportion(float db)
+    {
+        return juce::jlimit(0.0f, 1.0f, (db - SignalAnalyser::minDb) / -SignalAnalyser::minDb);
+    }
+}
+
+void LevelMeterDisplay::paint(juce::Graphics& g)
+{
+    using CP = CyberpunkLookAndFeel;
+
+    drawFrame(g, getLocalBounds(), "LEVELS");
+
+    auto area = getLocalBounds().reduced(12).withTrimmedTop(22);
+    auto labels = area.removeFromBottom(14);
+    g.setFont(CyberpunkLookAndFeel::getCustomFont().withHeight(9.0f));
+
+    const char* pointNames[] = { "IN", "FUZZ", "COMP", "OUT" };
+    const char* bandNames[]  = { "GR-L", "GR-M", "GR-H" };
+    const int numBars = SignalTaps::NumPoints + SignalAnalyser::numCompressorBands;
+    const int barWidth = area.getWidth() / numBars;
+
+    for (int i = 0; i < numBars; ++i)
+    {
+        auto bar = area.withX(area.getX() + i * barWidth).withWidth(barWidth).reduced(5, 0);
+        const auto labelArea = labels.withX(bar.getX() - 4).withWidth(bar.getWidth() + 8);
+
+        g.setColour(CP::matrixBlack);
+        g.fillRect(bar);
+
+        if (i < SignalTaps::NumPoints)
+        {
+            const auto level = analyser.getLevel(static_cast<SignalTaps::Point>(i));
+            const auto height = static_cast<float>(bar.getHeight());
+
+            // RMS body, peak line; red-shifted near 0 dBFS
+            const auto rmsTop = height * (1.0f - dbToProportion(level.rmsDb));
+            g.setColour(level.peakDb > -3.0f ? CP::matrixPurple : CP::matrixGreen);
+            g.fillRect(bar.toFloat().withTrimmedTop(rmsTop));
+
+            const auto peakY = static_cast<float>(bar.getY()) + height * (1.0f - dbToProportion(level.peakDb));
+            g.setColour(CP::matrixCyan);
+            g.drawHorizontalLine(juce::roundToInt(peakY), static_cast<float>(bar.getX()), static_cast<float>(bar.getRight()));
+
+            g.setColour(CP::matrixGreen);
+            g.drawText(pointNames[i], labelArea, juce::Justification::centred, false);
+        }
+        else
+        {
+            // Gain reduction grows downwards from the top, 0 to -24 dB
+            const auto band = i - SignalTaps::NumPoints;
+            const auto reduction = juce::jlimit(0.0f, 1.0f, -analyser.getGainReductionDb(band) / 24.0f);
+            g.setColour(CP::matrixCyan.withAlpha(0.8f));
+            g.fillRect(bar.toFloat().withHeight(static_cast<float>(bar.getHeight()) * reduction));
+
+            g.setColour(CP::matrixCyan);
+            g.drawText(bandNames[band], labelArea, juce::Justification::centred, false);
+        }
+    }
+}
+
+void SpectrumDisplay::paint(juce::Graphics& g)
+{
+    using CP = CyberpunkLookAndFeel;
+
+    drawFrame(g, getLocalBounds(), "SPECTRUM");
+
+    const auto area = getLocalBounds().reduced(12).withTrimmedTop(22).toFloat();
+    g.setColour(CP::matrixBlack);
+    g.fillRect(area);
+
+    // Decade grid
+    g.setColour(CP::matrixGreen.withAlpha(0.12f));
+    for (auto frequency : { 100.0f, 1000.0f, 10000.0f })
+    {
+        const auto x = area.getX() + area.getWidth() * std::log(frequency / lowestFrequency)
+                                                      / std::log(highestFrequency / lowestFrequency);
+        g.drawVerticalLine(juce::roundToInt(x), area.getY(), area.getBottom());
+    }
+
+    const auto& spectrum = analyser.getSpectrumDb();
+    juce::Path curve;
+    for (int b = 0; b < SignalAnalyser::numSpectrumBands; ++b)
+    {
+        const auto x = area.getX() + area.getWidth() * (static_cast<float>(b) + 0.5f) / static_cast<float>(SignalAnalyser::numSpectrumBands);
+        const auto y = area.getBottom() - area.getHeight() * dbToProportion(spectrum[static_cast<size_t>(b)]);
+
+        if (b == 0)
+            curve.startNewSubPath(area.getX(), y);
+        curve.lineTo(x, y);
+    }
+    curve.lineTo(area.getRight(), curve.getCurrentPosition().y);
+
+    auto fill = curve;
+    fill.lineTo(area.getBottomRight());
+    fill.lineTo(area.getBottomLeft());
+    fill.closeSubPath();
+
+    g.setColour(CP::matrixGreen.withAlpha(0.15f));
+    g.fillPath(fill);
+    g.setColour(CP::matrixGreen);
+    g.strokePath(curve, juce::PathStrokeType(1.5f));
+}
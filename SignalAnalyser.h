@@ -0,0 +1,125 @@
+#pragma once
+
+#include "MultiEffectProcessor.h"
+#include "WaveformHistory.h"
+#include <juce_gui_basics/juce_gui_basics.h>
+#include <array>
+#include <memory>
+#include <vector>
+
+//==============================================================================
+/**
+ * SignalAnalyser
+ *
+ * Message-thread side of the processor's SignalTaps. Attaching one switches
+ * the taps on; destroying it switches them off again, so with the editor
+ * closed the audio thread does no metering work at all.
+ *
+ * update() (call from a timer, ~30 Hz) drains every tap and computes
+ *   - peak (with 20 dB/s fall-off) and RMS (300 ms) per tap point
+ *   - per-band gain reduction of the multiband compressor, by running a
+ *     model of its crossover and band compressors on the post-Fuzz signal with
+ *     the current parameters (the audio thread exports nothing but samples)
+ *   - a Hann-windowed 2048-point spectrum of the output, once per update no
+ *     matter how much audio arrived, decimated into log-spaced display bands
+ *   - the output's min/max peak pyramid (WaveformHistory)
+ */
+class SignalAnalyser
+{
+public:
+    static constexpr float minDb = -60.0f;
+    static constexpr int numCompressorBands = 3;
+    static constexpr int fftOrder = 11;
+    static constexpr int fftSize = 1 << fftOrder;
+    static constexpr int numSpectrumBands = 48;
+
+    struct Level
+    {
+        float peakDb = minDb;
+        float rmsDb = minDb;
+    };
+
+    explicit SignalAnalyser(MultiEffectProcessor& processor);
+    ~SignalAnalyser();
+
+    void update();
+
+    Level getLevel(SignalTaps::Point point) const noexcept { return levels[static_cast<size_t>(point)]; }
+
+    /** 0 or negative, in dB. */
+    float getGainReductionDb(int band) const noexcept { return bands[static_cast<size_t>(band)].reductionDb; }
+
+    const std::array<float, numSpectrumBands>& getSpectrumDb() const noexcept { return spectrumDb; }
+    static float getSpectrumBandFrequency(float band) noexcept;
+
+    const WaveformHistory& getWaveformHistory() const noexcept { return waveform; }
+
+private:
+    struct CompressorBand
+    {
+        juce::dsp::IIR::Filter<float> highPass, lowPass;
+        bool useHighPass = false, useLowPass = false;
+        juce::dsp::Compressor<float> compressor;
+        float reductionDb = 0.0f;
+    };
+
+    void updateLevel(size_t point, int numSamples, double seconds);
+    void updateGainReduction(int numSamples, double seconds);
+    void updateSpectrum(int numSamples, double seconds);
+    void prepareCompressorModel(double sampleRate);
+
+    MultiEffectProcessor& processor;
+    juce::AudioBuffer<float> scratch { AudioTap::maxChannels, AudioTap::capacity };
+    double lastUpdateMs = 0.0;
+
+    std::array<Level, SignalTaps::NumPoints> levels;
+    std::array<float, SignalTaps::NumPoints> meanSquare {};
+
+    // Compressor model, fed from the post-Fuzz tap
+    std::array<CompressorBand, numCompressorBands> bands;
+    std::vector<float> bandInput, bandOutput;
+    double modelSampleRate = 0.0;
+    std::atomic<float>* compressorOn = nullptr;
+    std::array<std::atomic<float>*, numCompressorBands> thresholds {};
+    std::atomic<float>* ratio = nullptr;
+    std::atomic<float>* attack = nullptr;
+    std::atomic<float>* release = nullptr;
+
+    // Output spectrum
+    juce::SharedResourcePointer<SharedDSPResources> resources;
+    std::shared_ptr<const juce::dsp::FFT> fft;
+    juce::dsp::WindowingFunction<float> window { static_cast<size_t>(fftSize), juce::dsp::WindowingFunction<float>::hann, false };
+    std::vector<float> history = std::vector<float>(fftSize, 0.0f);
+    int historyPosition = 0;
+    std::vector<float> fftData = std::vector<float>(2 * fftSize, 0.0f);
+    std::array<float, numSpectrumBands> spectrumDb;
+
+    WaveformHistory waveform;
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(SignalAnalyser)
+};
+
+//==============================================================================
+/** Peak/RMS bars for the four tap points plus compressor gain-reduction bars. */
+class LevelMeterDisplay : public juce::Component
+{
+public:
+    explicit LevelMeterDisplay(const SignalAnalyser& analyserToShow) : analyser(analyserToShow) { setOpaque(true); }
+    void paint(juce::Graphics&) override;
+
+private:
+    const SignalAnalyser& analyser;
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(LevelMeterDisplay)
+};
+
+/** Output spectrum, 20 Hz - 20 kHz on a log axis. */
+class SpectrumDisplay : public juce::Component
+{
+public:
+    explicit SpectrumDisplay(const SignalAnalyser& analyserToShow) : analyser(analyserToShow) { setOpaque(true); }
+    void paint(juce::Graphics&) override;
+
+private:
+    const SignalAnalyser& analyser;
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(SpectrumDisplay)
+};
@@ -0,0 +1,109 @@
+#include "CaptureReplay.h"
+#include "MultiEffectProcessor.h"
+
+//==============================================================================
+class CaptureReplayTests : public juce::UnitTest
+{
+public:
+    CaptureReplayTests() : juce::UnitTest("CaptureReplay", "DSP4Guitar") {}
+
+    void runTest() override
+    {
+        beginTest("A replayed capture renders bit-identical output");
+        {
+            // Delay and reverb on before the prepare, so both are allocated up front
+            juce::TemporaryFile captureFile(".d4gcap");
+            const auto liveHash = renderLive(captureFile.getFile(),
+                                             { "fuzzOn", "compressorOn", "delayOn", "reverbOn" }, {});
+
+            const auto hashes = replay(captureFile.getFile());
+            for (const auto hash : hashes)
+                expect(hash == liveHash, "replayed output differs from the live run");
+        }
+
+        beginTest("Effects switched on mid-capture replay the same on every pass");
+        {
+            // Live, their memory arrives from the background thread; offline, at the same block every pass
+            juce::TemporaryFile captureFile(".d4gcap");
+            renderLive(captureFile.getFile(), { "tremoloOn", "chorusOn" }, { "delayOn", "reverbOn" });
+
+            const auto hashes = replay(captureFile.getFile());
+            expect(hashes.size() == 2 && hashes[0] == hashes[1], "replay passes differ");
+        }
+    }
+
+private:
+    static constexpr double sampleRate = 48000.0;
+    static constexpr int blockSize = 256, numBlocks = 200;
+
+    /** Captures numBlocks of a sine; switchOnLater goes on halfway. Returns the output hash. */
+    juce::uint64 renderLive(const juce::File& captureFile, std::initializer_list<const char*> switchOn,
+                            std::initializer_list<const char*> switchOnLater)
+    {
+        MultiEffectProcessor live;
+
+        // Raw values, as the replay writes them
+        auto setOn = [&live](std::initializer_list<const char*> ids)
+        {
+            for (const auto* id : ids)
+                if (auto* value = live.apvts.getRawParameterValue(id))
+                    value->store(1.0f);
+        };
+
+        setOn(switchOn);
+        live.setPlayConfigDetails(2, 2, sampleRate, blockSize);
+        live.prepareToPlay(sampleRate, blockSize);
+
+        juce::String error;
+        expect(live.getBlockCapture().start(captureFile, error), error);
+
+        juce::AudioBuffer<float> buffer(2, blockSize);
+        juce::MidiBuffer midi;
+        double phase = 0.0;
+        auto hash = CaptureReplay::outputHashSeed;
+
+        for (int block = 0; block < numBlocks; ++block)
+        {
+            if (block == numBlocks / 2)
+                setOn(switchOnLater);
+
+            // Some short blocks, as hosts send around loop points
+            const auto numSamples = block % 7 == 3 ? blockSize / 2 : blockSize;
+            juce::AudioBuffer<float> view(buffer.getArrayOfWritePointers(), 2, numSamples);
+
+            for (int i = 0; i < numSamples; ++i)
+            {
+                const auto sample = static_cast<float>(0.5 * std::sin(phase));
+                view.setSample(0, i, sample);
+                view.setSample(1, i, sample);
+                phase += juce::MathConstants<double>::twoPi * 110.0 / sampleRate;
+            }
+
+            live.processBlock(view, midi);
+            hash = CaptureReplay::hashOutput(hash, view);
+        }
+
+        live.getBlockCapture().stop();
+        live.releaseResources();
+        return hash;
+    }
+
+    std::vector<juce::uint64> replay(const juce::File& captureFile)
+    {
+        CaptureReplay::Options options;
+        options.captureFile = captureFile;
+        options.passes = 2;
+
+        CaptureReplay capture(options);
+        const auto loaded = capture.load();
+        expect(loaded.wasOk(), loaded.getErrorMessage());
+        expectEquals(capture.getNumBlocks(), numBlocks);
+
+        const auto result = capture.run(nullptr);
+        expect(result.wasOk(), result.getErrorMessage());
+        expectEquals(static_cast<int>(capture.getOutputHashes().size()), options.passes);
+        return capture.getOutputHashes();
+    }
+};
+
+static CaptureReplayTests captureReplayTests;
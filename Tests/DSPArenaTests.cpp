@@ -0,0 +1,126 @@
+#include "DSPArena.h"
+
+//==============================================================================
+class DSPArenaTests : public juce::UnitTest
+{
+public:
+    DSPArenaTests() : juce::UnitTest("DSPArena", "DSP4Guitar") {}
+
+    void runTest() override
+    {
+        DSPArena arena;
+
+        beginTest("The measuring pass hands out nothing");
+        {
+            arena.beginLayout();
+            const auto measured = carveAll(arena, 100);
+            expect(measured.mono == nullptr && measured.coefficients == nullptr && measured.channels == nullptr);
+            expect(! arena.isAllocated());
+        }
+
+        beginTest("Slices are aligned, in carve order and rounded up to the alignment");
+        {
+            arena.allocate();
+            const auto slices = carveAll(arena, 100);
+            expect(arena.isAllocated());
+
+            for (const void* pointer : { static_cast<const void*>(slices.mono), static_cast<const void*>(slices.coefficients),
+                                         static_cast<const void*>(slices.channels), static_cast<const void*>(slices.channels[0]),
+                                         static_cast<const void*>(slices.channels[1]) })
+                expectEquals(static_cast<int>(reinterpret_cast<uintptr_t>(pointer) % DSPArena::alignment), 0);
+
+            // 100 floats = 400 -> 448 bytes, 3 doubles -> 64, 2 pointers -> 64, 2 x 448
+            expectEquals(distance(slices.mono, slices.coefficients), 448);
+            expectEquals(distance(slices.coefficients, slices.channels), 64);
+            expectEquals(distance(slices.channels, slices.channels[0]), 64);
+            expectEquals(distance(slices.channels[0], slices.channels[1]), 448);
+            expectEquals(static_cast<int>(arena.getCarvedBytes()), 1472);
+        }
+
+        beginTest("The carved memory is zeroed on every layout");
+        {
+            arena.beginLayout();
+            carveAll(arena, 100);
+            arena.allocate();
+            auto slices = carveAll(arena, 100);
+
+            expect(isZero(slices.mono, 100) && isZero(slices.coefficients, 3)
+                   && isZero(slices.channels[0], 100) && isZero(slices.channels[1], 100));
+
+            std::fill(slices.mono, slices.mono + 100, 1.0f);
+            std::fill(slices.channels[1], slices.channels[1] + 100, -1.0f);
+
+            arena.beginLayout();
+            carveAll(arena, 100);
+            arena.allocate();
+            slices = carveAll(arena, 100);
+            expect(isZero(slices.mono, 100) && isZero(slices.channels[1], 100));
+        }
+
+        beginTest("The report lists each owner and the carved size, also after a shrink");
+        {
+            auto report = arena.getReport();
+            expectEquals(static_cast<int>(report.arenaBytes), 1472);
+            expectEquals(static_cast<int>(report.entries.size()), 3);
+            expectEquals(juce::String(report.entries[0].owner), juce::String("Mono"));
+            expectEquals(static_cast<int>(report.entries[0].bytes), 448);
+            expectEquals(static_cast<int>(report.entries[2].bytes), 64 + 2 * 448);
+
+            arena.beginLayout();
+            carveAll(arena, 10);
+            arena.allocate();
+            carveAll(arena, 10);
+
+            // 10 floats -> 64 bytes each; the block keeps its larger capacity
+            report = arena.getReport();
+            expectEquals(static_cast<int>(arena.getCarvedBytes()), 64 + 64 + 64 + 2 * 64);
+            expectEquals(static_cast<int>(report.arenaBytes), 320);
+            expectEquals(static_cast<int>(arena.getCapacity()), 1472);
+        }
+
+        beginTest("A larger layout reallocates; release frees everything");
+        {
+            arena.beginLayout();
+            carveAll(arena, 1000);
+            arena.allocate();
+            const auto slices = carveAll(arena, 1000);
+            expect(isZero(slices.channels[1], 1000));
+            expectEquals(static_cast<int>(arena.getCapacity()), static_cast<int>(arena.getCarvedBytes()));
+
+            arena.release();
+            expect(! arena.isAllocated());
+            expectEquals(static_cast<int>(arena.getCarvedBytes()), 0);
+            expectEquals(static_cast<int>(arena.getReport().entries.size()), 0);
+        }
+    }
+
+private:
+    struct Slices
+    {
+        float* mono = nullptr;
+        double* coefficients = nullptr;
+        float** channels = nullptr;
+    };
+
+    static Slices carveAll(DSPArena& arena, size_t numSamples)
+    {
+        Slices slices;
+        slices.mono = arena.carve<float>("Mono", numSamples);
+        slices.coefficients = arena.carve<double>("Coefficients", 3);
+        slices.channels = arena.carveChannels<float>("Stereo", 2, numSamples);
+        return slices;
+    }
+
+    static int distance(const void* from, const void* to)
+    {
+        return static_cast<int>(static_cast<const char*>(to) - static_cast<const char*>(from));
+    }
+
+    template <typename Type>
+    static bool isZero(const Type* data, size_t count)
+    {
+        return std::all_of(data, data + count, [](Type value) { return value == Type(); });
+    }
+};
+
+static DSPArenaTests dspArenaTests;
@@ -0,0 +1,30 @@
+#include "PluginEditor.h"
+
+//==============================================================================
+class PluginEditorTests : public juce::UnitTest
+{
+public:
+    PluginEditorTests() : juce::UnitTest("PluginEditor", "DSP4Guitar") {}
+
+    void runTest() override
+    {
+        beginTest("Paint cost, off-screen");
+
+        MultiEffectProcessor processor;
+        MultiEffectProcessorEditor editor(processor);
+
+        const auto timings = editor.measurePaint(600);
+
+        logMessage(juce::String::formatted("Editor paint: cold %.0f us, from caches %.0f us",
+                                           timings.coldPaintMicros, timings.warmPaintMicros));
+        logMessage(juce::String::formatted("Rain frame: clipped %.1f us (worst %.1f us), whole header %.1f us",
+                                           timings.averageFrameMicros, timings.worstFrameMicros,
+                                           timings.averageHeaderFrameMicros));
+
+        expectEquals(timings.frames, 600);
+        expect(timings.warmPaintMicros < timings.coldPaintMicros, "the caches do not pay for themselves");
+        expect(timings.averageFrameMicros < timings.averageHeaderFrameMicros, "clipping rain frames does not pay");
+    }
+};
+
+static PluginEditorTests pluginEditorTests;
@@ -0,0 +1,160 @@
+#include "MultiEffectProcessor.h"
+#include <cmath>
+#include <vector>
+
+//==============================================================================
+class PluginStateTests : public juce::UnitTest
+{
+public:
+    PluginStateTests() : juce::UnitTest("PluginState", "DSP4Guitar") {}
+
+    void runTest() override
+    {
+        beginTest("The binary state round-trips every parameter");
+        {
+            MultiEffectProcessor source;
+            setDistinctValues(source);
+
+            juce::MemoryBlock state;
+            source.getStateInformation(state);
+            expect(PluginState::isBinaryState(state.getData(), state.getSize()) == juce::ByteOrder::isLittleEndian());
+
+            MultiEffectProcessor restored;
+            restored.setStateInformation(state.getData(), static_cast<int>(state.getSize()));
+            expectSameValues(source, restored);
+        }
+
+        beginTest("Settings round-trip with the parameters");
+        {
+            MultiEffectProcessor source;
+            source.setPresetCrossfadeSeconds(0.25);
+            source.setIdleReleaseSeconds(300.0);
+
+            juce::MemoryBlock state;
+            source.getStateInformation(state);
+
+            MultiEffectProcessor restored;
+            restored.setStateInformation(state.getData(), static_cast<int>(state.getSize()));
+            expectEquals(restored.getPresetCrossfadeSeconds(), 0.25);
+            expectEquals(restored.getIdleReleaseSeconds(), 300.0);
+        }
+
+        beginTest("An XML state from before the binary format migrates");
+        {
+            MultiEffectProcessor source;
+            setDistinctValues(source);
+
+            std::unique_ptr<juce::XmlElement> xml(source.apvts.copyState().createXml());
+            juce::MemoryBlock legacy;
+            juce::AudioProcessor::copyXmlToBinary(*xml, legacy);
+            expect(! PluginState::isBinaryState(legacy.getData(), legacy.getSize()));
+
+            MultiEffectProcessor restored;
+            restored.setStateInformation(legacy.getData(), static_cast<int>(legacy.getSize()));
+            expectSameValues(source, restored);
+
+            // ...and is written back in the binary format
+            juce::MemoryBlock resaved;
+            restored.getStateInformation(resaved);
+            expect(PluginState::isBinaryState(resaved.getData(), resaved.getSize()) == juce::ByteOrder::isLittleEndian());
+        }
+
+        if (juce::ByteOrder::isLittleEndian())
+        {
+            beginTest("Binary save and load are faster than the XML path they replaced");
+            {
+                MultiEffectProcessor processor;
+                setDistinctValues(processor);
+                const auto timings = measureSaveAndLoad(processor, 2000);
+
+                logMessage(juce::String::formatted("State save: XML %.1f us, binary %.1f us (%.1fx)",
+                                                   timings.xmlSave, timings.binarySave, timings.xmlSave / timings.binarySave));
+                logMessage(juce::String::formatted("State load: XML %.1f us, binary %.1f us (%.1fx)",
+                                                   timings.xmlLoad, timings.binaryLoad, timings.xmlLoad / timings.binaryLoad));
+                expect(timings.binarySave < timings.xmlSave);
+                expect(timings.binaryLoad < timings.xmlLoad);
+            }
+
+            beginTest("A truncated binary state is rejected");
+
+            MultiEffectProcessor processor;
+            juce::MemoryBlock state;
+            processor.getStateInformation(state);
+
+            PluginState codec(processor);
+            std::vector<float> values(static_cast<size_t>(codec.getNumParameters()));
+            juce::ValueTree extra;
+            expect(codec.read(state.getData(), state.getSize(), values.data(), extra).wasOk());
+            expect(codec.read(state.getData(), state.getSize() / 2, values.data(), extra).failed());
+        }
+    }
+
+private:
+    /** Average microseconds per save and per load of a whole instance. */
+    struct Timings
+    {
+        double xmlSave = 0.0, xmlLoad = 0.0;
+        double binarySave = 0.0, binaryLoad = 0.0;
+    };
+
+    /** The processor's own (binary) get/setStateInformation against the APVTS -> XML ->
+        binary path it used before. Parameters end up where they started either way. */
+    static Timings measureSaveAndLoad(MultiEffectProcessor& processor, int iterations)
+    {
+        auto time = [iterations](auto&& body)
+        {
+            body(); // warm-up: first-use allocations are not what a host pays per save
+            const auto start = juce::Time::getHighResolutionTicks();
+            for (int i = 0; i < iterations; ++i)
+                body();
+            return juce::Time::highResolutionTicksToSeconds(juce::Time::getHighResolutionTicks() - start)
+                   * 1.0e6 / iterations;
+        };
+
+        juce::MemoryBlock xmlBlob, binaryBlob;
+        Timings timings;
+
+        timings.xmlSave = time([&]
+        {
+            auto state = processor.apvts.copyState();
+            state.removeChild(state.getChildWithName(MidiLearn::stateType), nullptr);
+            state.appendChild(processor.getMidiLearn().createState(), nullptr);
+            std::unique_ptr<juce::XmlElement> xml(state.createXml());
+            juce::AudioProcessor::copyXmlToBinary(*xml, xmlBlob);
+        });
+
+        timings.xmlLoad = time([&]
+        {
+            if (auto xml = juce::AudioProcessor::getXmlFromBinary(xmlBlob.getData(), static_cast<int>(xmlBlob.getSize())))
+            {
+                auto state = juce::ValueTree::fromXml(*xml);
+                processor.getMidiLearn().restoreState(state.getChildWithName(MidiLearn::stateType));
+                processor.apvts.replaceState(state);
+            }
+        });
+
+        timings.binarySave = time([&] { processor.getStateInformation(binaryBlob); });
+        timings.binaryLoad = time([&] { processor.setStateInformation(binaryBlob.getData(), static_cast<int>(binaryBlob.getSize())); });
+        return timings;
+    }
+
+    static void setDistinctValues(juce::AudioProcessor& processor)
+    {
+        const auto& parameters = processor.getParameters();
+        for (int i = 0; i < parameters.size(); ++i)
+            parameters[i]->setValueNotifyingHost(static_cast<float>(std::fmod(0.37 * (i + 1), 1.0)));
+    }
+
+    void expectSameValues(juce::AudioProcessor& expected, juce::AudioProcessor& actual)
+    {
+        const auto& expectedParameters = expected.getParameters();
+        const auto& actualParameters = actual.getParameters();
+        expectEquals(actualParameters.size(), expectedParameters.size());
+
+        for (int i = 0; i < juce::jmin(expectedParameters.size(), actualParameters.size()); ++i)
+            expectWithinAbsoluteError(actualParameters[i]->getValue(), expectedParameters[i]->getValue(), 1.0e-4f,
+                                      expectedParameters[i]->getName(64));
+    }
+};
+
+static PluginStateTests pluginStateTests;
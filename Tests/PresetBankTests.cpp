@@ -0,0 +1,100 @@
+#include "PresetBank.h"
+
+//==============================================================================
+class PresetBankTests : public juce::UnitTest
+{
+public:
+    PresetBankTests() : juce::UnitTest("PresetBank", "DSP4Guitar") {}
+
+    void runTest() override
+    {
+        PresetBank::Builder builder(ids);
+        const float clean[] = { 0.1f, 0.2f, 0.3f };
+        const float lead[]  = { 0.9f, 0.7f, 0.6f };
+        builder.addPreset("Lead", { "drive", "solo" }, lead);
+        builder.addPreset("Clean", { "clean" }, clean);
+
+        const auto bytes = builder.build();
+        juce::TemporaryFile bankFile(".d4gbank");
+
+        beginTest("A written bank reads back");
+        {
+            expect(builder.writeTo(bankFile.getFile()).wasOk());
+
+            PresetBank bank;
+            expect(bank.open(bankFile.getFile(), ids, defaults).wasOk());
+            expectEquals(bank.getNumPresets(), 2);
+
+            const auto leadIndex = bank.findPreset("lead");
+            expect(leadIndex >= 0);
+            expectEquals(bank.getName(leadIndex), juce::String("Lead"));
+            expect(bank.getTags(leadIndex).contains("solo"));
+            expectEquals(bank.getPresetsWithTag("clean").size(), 1);
+
+            float values[3] = {};
+            bank.copyValues(leadIndex, values);
+            for (int i = 0; i < 3; ++i)
+                expectEquals(values[i], lead[i]);
+        }
+
+        beginTest("Parameters the bank does not know take their default");
+        {
+            const juce::StringArray otherIDs { "level", "mix", "gain" };
+            const std::vector<float> otherDefaults { 0.0f, 0.25f, 0.0f };
+
+            PresetBank bank;
+            expect(bank.open(bankFile.getFile(), otherIDs, otherDefaults).wasOk());
+
+            float values[3] = {};
+            bank.copyValues(bank.findPreset("Clean"), values);
+            expectEquals(values[0], clean[2]);
+            expectEquals(values[1], 0.25f);
+            expectEquals(values[2], clean[0]);
+        }
+
+        beginTest("Corrupt banks are rejected");
+        {
+            expectRejected("empty file", {});
+            expectRejected("truncated", juce::MemoryBlock(bytes.getData(), bytes.getSize() / 2));
+
+            auto wrongMagic = bytes;
+            wrongMagic[0] = 'X';
+            expectRejected("wrong magic", wrongMagic);
+
+            expectRejected("newer version", patched(bytes, versionOffset, 99u));
+            expectRejected("values out of range", patched(bytes, valuesOffsetOffset, 0x7fffff00u));
+
+            // First preset record: { name offset, name length, firstTag, numTags }
+            juce::uint32 presetsOffset = 0;
+            bytes.copyTo(&presetsOffset, presetsOffsetOffset, sizeof(presetsOffset));
+            expectRejected("tag list out of range", patched(bytes, static_cast<int>(presetsOffset) + 8, 0x7fffff00u));
+        }
+    }
+
+private:
+    // Header field offsets, see PresetBank::Header
+    static constexpr int versionOffset = 4, presetsOffsetOffset = 36, valuesOffsetOffset = 56;
+
+    const juce::StringArray ids { "gain", "tone", "level" };
+    const std::vector<float> defaults { 0.5f, 0.5f, 0.5f };
+
+    static juce::MemoryBlock patched(const juce::MemoryBlock& bytes, int offset, juce::uint32 value)
+    {
+        auto copy = bytes;
+        copy.copyFrom(&value, offset, sizeof(value));
+        return copy;
+    }
+
+    void expectRejected(const juce::String& what, const juce::MemoryBlock& contents)
+    {
+        juce::TemporaryFile corruptFile(".d4gbank");
+        expect(corruptFile.getFile().replaceWithData(contents.getData(), contents.getSize()));
+
+        PresetBank bank;
+        expect(bank.open(corruptFile.getFile(), ids, defaults).failed(), what);
+        expect(! bank.isOpen(), what);
+        expectEquals(bank.getNumPresets(), 0, what);
+    }
+};
+
+static PresetBankTests presetBankTests;
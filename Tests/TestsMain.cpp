@@ -0,0 +1,30 @@
+/*
+  ==============================================================================
+
+    TestsMain.cpp
+    Entry point of DSP4GuitarTests, which runs every juce::UnitTest in the
+    "DSP4Guitar" category and exits non-zero if any of them failed.
+
+    DSP4GuitarTests        (or ctest in the build directory)
+
+  ==============================================================================
+*/
+
+#include <juce_core/juce_core.h>
+#include <juce_events/juce_events.h>
+
+int main()
+{
+    // The processors own timers, so there has to be a message manager, though no loop runs
+    juce::ScopedJuceInitialiser_GUI juceInitialiser;
+
+    juce::UnitTestRunner runner;
+    runner.setAssertOnFailure(false);
+    runner.runTestsInCategory("DSP4Guitar");
+
+    int failures = 0;
+    for (int i = 0; i < runner.getNumResults(); ++i)
+        failures += runner.getResult(i)->failures;
+
+    return failures > 0 ? 1 : 0;
+}
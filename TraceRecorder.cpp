@@ -0,0 +1,203 @@
+#include "TraceRecorder.h"
+#include <juce_events/juce_events.h>
+#include <cstddef>
+#include <cstdio>
+#include <limits>
+#include <vector>
+
+//==============================================================================
+TraceRecorder& TraceRecorder::getInstance()
+{
+    static TraceRecorder instance;
+    return instance;
+}
+
+void TraceRecorder::setEnabled(bool shouldBeEnabled)
+{
+    if (shouldBeEnabled && buffers == nullptr)
+        buffers.reset(new ThreadBuffer[maxThreads]);
+
+    enabled.store(shouldBeEnabled, std::memory_order_release);
+}
+
+const char* TraceRecorder::intern(const juce::String& name)
+{
+    const std::lock_guard<std::mutex> sl(internLock);
+    return internedNames.insert(name.toStdString()).first->c_str();
+}
+
+juce::File TraceRecorder::getDefaultTraceFile()
+{
+    return juce::File::getSpecialLocation(juce::File::userApplicationDataDirectory)
+               .getChildFile("DSP4Guitar")
+               .getChildFile("Traces")
+               .getChildFile("trace-" + juce::Time::getCurrentTime().formatted("%Y%m%d-%H%M%S") + ".json");
+}
+
+//==============================================================================
+TraceRecorder::ThreadBuffer* TraceRecorder::getThreadBuffer() noexcept
+{
+    // Hands the ring back when the thread exits
+    struct Claim
+    {
+        ThreadBuffer* buffer = nullptr;
+        bool counted = false;
+
+        ~Claim()
+        {
+            if (buffer != nullptr)
+                buffer->state.store(released, std::memory_order_release);
+        }
+    };
+
+    thread_local Claim claim;
+
+    if (claim.buffer != nullptr)
+        return claim.buffer;
+
+    const auto index = claimBuffer();
+    if (index < 0)
+    {
+        // Counted once; retried at the next event in case a thread has exited since
+        if (! claim.counted)
+            unrecordedThreads.fetch_add(1, std::memory_order_relaxed);
+
+        claim.counted = true;
+        return nullptr;
+    }
+
+    auto* buffer = &buffers[static_cast<size_t>(index)];
+    buffer->written.store(0, std::memory_order_release); // a reused ring starts over
+
+    // Named once per claim, without allocating
+    auto* name = buffer->threadName;
+    if (auto* thread = juce::Thread::getCurrentThread())
+        thread->getThreadName().copyToUTF8(name, sizeof(buffer->threadName));
+    else if (juce::MessageManager::existsAndIsCurrentThread())
+        std::snprintf(name, sizeof(buffer->threadName), "Message thread");
+    else
+        std::snprintf(name, sizeof(buffer->threadName), "Thread %d (audio device?)", index);
+
+    claim.buffer = buffer;
+    return buffer;
+}
+
+int TraceRecorder::claimBuffer() noexcept
+{
+    // Unused rings first, so an exited thread's events stay for the export as long as possible
+    for (const auto from : { unused, released })
+    {
+        for (int i = 0; i < maxThreads; ++i)
+        {
+            auto expected = static_cast<int>(from);
+            if (buffers[static_cast<size_t>(i)].state.compare_exchange_strong(expected, owned, std::memory_order_acq_rel))
+                return i;
+        }
+    }
+
+    return -1;
+}
+
+void TraceRecorder::record(const char* name, juce::int64 start, juce::int64 duration) noexcept
+{
+    auto* buffer = getThreadBuffer();
+    if (buffer == nullptr)
+        return;
+
+    // Single writer per ring: the count is published after the event
+    const auto count = buffer->written.load(std::memory_order_relaxed);
+    buffer->events[static_cast<size_t>(count % eventsPerThread)] = { name, start, duration };
+    buffer->written.store(count + 1, std::memory_order_release);
+}
+
+//==============================================================================
+juce::Result TraceRecorder::exportChromeTrace(const juce::File& file) const
+{
+    if (buffers == nullptr)
+        return juce::Result::fail("Nothing has been recorded");
+
+    struct ThreadEvents
+    {
+        int tid;
+        juce::String name;
+        std::vector<Event> events;
+    };
+
+    constexpr auto capacity = static_cast<juce::uint64>(eventsPerThread);
+    std::vector<ThreadEvents> threads;
+    auto origin = std::numeric_limits<juce::int64>::max();
+
+    for (int i = 0; i < maxThreads; ++i)
+    {
+        const auto& buffer = buffers[static_cast<size_t>(i)];
+        if (buffer.state.load(std::memory_order_acquire) == unused)
+            continue;
+
+        const auto written = buffer.written.load(std::memory_order_acquire);
+        const auto first = written > capacity ? written - capacity : 0;
+
+        ThreadEvents thread { i + 1, juce::String::fromUTF8(buffer.threadName), {} };
+        thread.events.reserve(static_cast<size_t>(written - first));
+        for (auto n = first; n < written; ++n)
+            thread.events.push_back(buffer.events[static_cast<size_t>(n % capacity)]);
+
+        // Another thread took the ring over while we copied: nothing in it is reliable
+        const auto writtenAfter = buffer.written.load(std::memory_order_acquire);
+        if (writtenAfter < written)
+            continue;
+
+        // Drop what the thread may have overwritten (or be overwriting) while we copied
+        const auto firstValid = writtenAfter >= capacity ? writtenAfter - capacity + 1 : 0;
+        if (firstValid > first)
+            thread.events.erase(thread.events.begin(),
+                                thread.events.begin() + static_cast<std::ptrdiff_t>(juce::jmin(firstValid - first, written - first)));
+
+        for (const auto& event : thread.events)
+            origin = juce::jmin(origin, event.start);
+
+        threads.push_back(std::move(thread));
+    }
+
+    file.getParentDirectory().createDirectory();
+    juce::FileOutputStream out(file);
+    if (! out.openedOk())
+        return juce::Result::fail("Could not write " + file.getFullPathName());
+
+    out.setPosition(0);
+    out.truncate();
+
+    const auto microsPerTick = 1.0e6 / static_cast<double>(juce::Time::getHighResolutionTicksPerSecond());
+    bool firstEvent = true;
+    const auto separator = [&out, &firstEvent]
+    {
+        out << (firstEvent ? "\n" : ",\n");
+        firstEvent = false;
+    };
+
+    out << "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[";
+
+    for (const auto& thread : threads)
+    {
+        separator();
+        out << "{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":" << thread.tid
+            << ",\"args\":{\"name\":" << juce::JSON::toString(thread.name) << "}}";
+
+        for (const auto& event : thread.events)
+        {
+            separator();
+            out << "{\"name\":" << juce::JSON::toString(juce::String::fromUTF8(event.name))
+                << ",\"pid\":1,\"tid\":" << thread.tid
+                << ",\"ts\":" << juce::String(static_cast<double>(event.start - origin) * microsPerTick, 3);
+
+            if (event.duration < 0)
+                out << ",\"ph\":\"i\",\"s\":\"t\"}";
+            else
+                out << ",\"ph\":\"X\",\"dur\":" << juce::String(static_cast<double>(event.duration) * microsPerTick, 3) << "}";
+        }
+    }
+
+    out << "\n],\"otherData\":{\"unrecordedThreads\":" << getNumUnrecordedThreads() << "}}\n";
+    out.flush();
+
+    return out.getStatus();
+}
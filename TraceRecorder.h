@@ -0,0 +1,138 @@
+#pragma once
+
+#include <juce_core/juce_core.h>
+#include <array>
+#include <atomic>
+#include <memory>
+#include <mutex>
+#include <set>
+#include <string>
+
+#ifndef DSP4GUITAR_TRACING
+ #define DSP4GUITAR_TRACING 1
+#endif
+
+//==============================================================================
+/**
+ * TraceRecorder
+ *
+ * Timeline of what every thread was doing (audio callbacks, chain stages,
+ * plugin scans and loads, editor paints, preset switches), exported as Chrome
+ * trace JSON for chrome://tracing or ui.perfetto.dev.
+ *
+ * Each thread writes into its own ring of fixed-size events, claimed from a
+ * pool allocated by setEnabled(true), so recording never locks or allocates;
+ * the oldest events are overwritten. A ring goes back to the pool when its
+ * thread exits (pool workers, loaders, a new audio thread per device restart
+ * come and go) and keeps its events until another thread reuses it. Threads
+ * that find all maxThreads rings taken go unrecorded until one is free; they
+ * are counted, and the export and the profiling menus say so. Event names must
+ * outlive the recording: string literals, or intern() for names built at run
+ * time (plugin names).
+ *
+ * Cost: with recording off a zone is one atomic load; with it on, two
+ * high-resolution timer reads and a 24-byte store. Building with
+ * DSP4GUITAR_TRACING=0 removes the zones altogether.
+ *
+ *   void process()
+ *   {
+ *       DSP4G_TRACE_ZONE("process");
+ *       ...
+ *   }
+ */
+class TraceRecorder
+{
+public:
+    static constexpr int maxThreads = 16;
+    static constexpr int eventsPerThread = 32768; // ~3 s of the audio thread at 64-sample buffers
+
+    static TraceRecorder& getInstance();
+
+    /** Message thread. Turning it on allocates the thread rings (once); turning it off
+        keeps what was recorded for export. */
+    void setEnabled(bool shouldBeEnabled);
+    bool isEnabled() const noexcept { return enabled.load(std::memory_order_acquire); }
+
+    /** Any thread but a real-time one: a copy of name that lives as long as the recorder. */
+    const char* intern(const juce::String& name);
+
+    /** Writes every thread's events as Chrome trace JSON. Safe while recording; events
+        being overwritten during the export are left out. */
+    juce::Result exportChromeTrace(const juce::File& file) const;
+
+    static juce::File getDefaultTraceFile();
+
+    /** Threads that lost events because every ring was taken (since the recorder was created). */
+    int getNumUnrecordedThreads() const noexcept { return unrecordedThreads.load(std::memory_order_relaxed); }
+
+    //==============================================================================
+    /** Records a complete event from construction to destruction. */
+    class Zone
+    {
+    public:
+        explicit Zone(const char* zoneName) noexcept
+            : name(zoneName),
+              start(getInstance().isEnabled() ? juce::Time::getHighResolutionTicks() : 0) {}
+
+        ~Zone()
+        {
+            if (start != 0)
+                getInstance().record(name, start, juce::Time::getHighResolutionTicks() - start);
+        }
+
+    private:
+        const char* name;
+        juce::int64 start;
+
+        JUCE_DECLARE_NON_COPYABLE(Zone)
+    };
+
+    /** A point in time, e.g. a preset switch. */
+    static void instant(const char* name) noexcept
+    {
+        auto& recorder = getInstance();
+        if (recorder.isEnabled())
+            recorder.record(name, juce::Time::getHighResolutionTicks(), -1);
+    }
+
+private:
+    struct Event
+    {
+        const char* name;
+        juce::int64 start;
+        juce::int64 duration; // -1: instant
+    };
+
+    enum BufferState { unused, owned, released };
+
+    struct ThreadBuffer
+    {
+        std::array<Event, eventsPerThread> events;
+        std::atomic<juce::uint64> written { 0 };
+        std::atomic<int> state { unused };
+        char threadName[48] {};
+    };
+
+    TraceRecorder() = default;
+
+    void record(const char* name, juce::int64 start, juce::int64 duration) noexcept;
+    ThreadBuffer* getThreadBuffer() noexcept;
+    int claimBuffer() noexcept; // index, or -1 if every ring is owned
+
+    std::atomic<bool> enabled { false };
+    std::unique_ptr<ThreadBuffer[]> buffers; // set once, before enabled is first true
+    std::atomic<int> unrecordedThreads { 0 };
+
+    mutable std::mutex internLock;
+    std::set<std::string> internedNames;
+
+    JUCE_DECLARE_NON_COPYABLE(TraceRecorder)
+};
+
+#if DSP4GUITAR_TRACING
+ #define DSP4G_TRACE_ZONE(name)    const TraceRecorder::Zone JUCE_JOIN_MACRO(traceZone_, __LINE__) (name)
+ #define DSP4G_TRACE_INSTANT(name) TraceRecorder::instant(name)
+#else
+ #define DSP4G_TRACE_ZONE(name)
+ #define DSP4G_TRACE_INSTANT(name)
+#endif
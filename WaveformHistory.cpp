@@ -0,0 +1,175 @@
+#include "WaveformHistory.h"
+#include "CyberpunkLookAndFeel.h"
+#include <cmath>
+
+//==============================================================================
+void WaveformHistory::clear()
+{
+    std::fill(peaks.begin(), peaks.end(), Peak {});
+    pending = emptyPeak;
+    pendingSamples = 0;
+    completedBuckets = 0;
+}
+
+void WaveformHistory::append(const juce::AudioBuffer<float>& audio, int numSamples, double newSampleRate)
+{
+    if (newSampleRate != sampleRate)
+    {
+        clear();
+        sampleRate = newSampleRate;
+    }
+
+    const auto numChannels = audio.getNumChannels();
+
+    for (int i = 0; i < numSamples; ++i)
+    {
+        for (int ch = 0; ch < numChannels; ++ch)
+        {
+            const auto sample = audio.getSample(ch, i);
+            pending.min = juce::jmin(pending.min, sample);
+            pending.max = juce::jmax(pending.max, sample);
+        }
+
+        if (++pendingSamples == baseBucketSamples)
+            completeBucket();
+    }
+}
+
+void WaveformHistory::completeBucket()
+{
+    bucket(0, completedBuckets) = pending;
+    pending = emptyPeak;
+    pendingSamples = 0;
+    ++completedBuckets;
+
+    // Level k gains a bucket each time 2^k level-0 buckets are complete
+    for (int level = 1; level < numLevels; ++level)
+    {
+        if ((completedBuckets & ((juce::int64(1) << level) - 1)) != 0)
+            break;
+
+        const auto index = (completedBuckets >> level) - 1;
+        const auto& a = bucket(level - 1, 2 * index);
+        const auto& b = bucket(level - 1, 2 * index + 1);
+        bucket(level, index) = { juce::jmin(a.min, b.min), juce::jmax(a.max, b.max) };
+    }
+}
+
+//==============================================================================
+double WaveformHistory::getMaxSeconds() const noexcept
+{
+    if (sampleRate <= 0.0)
+        return 0.0;
+
+    return static_cast<double>(bucketSamples(numLevels - 1) * (bucketsPerLevel - 1)) / sampleRate;
+}
+
+void WaveformHistory::getColumns(double seconds, Peak* columns, int numColumns) const
+{
+    std::fill(columns, columns + numColumns, Peak {});
+    if (numColumns <= 0 || sampleRate <= 0.0 || completedBuckets == 0)
+        return;
+
+    seconds = juce::jlimit(0.001, getMaxSeconds(), seconds);
+    const auto samplesPerColumn = seconds * sampleRate / numColumns;
+
+    // Coarsest level whose buckets still fit in a column
+    auto level = 0;
+    while (level + 1 < numLevels && static_cast<double>(bucketSamples(level + 1)) <= samplesPerColumn)
+        ++level;
+
+    const auto size = bucketSamples(level);
+    const auto written = completedBuckets >> level;
+    const auto oldest = juce::jmax(juce::int64(0), written - bucketsPerLevel);
+    const auto end = static_cast<double>(written * size); // lags the newest audio by under a column
+
+    for (int c = 0; c < numColumns; ++c)
+    {
+        const auto columnStart = end - (numColumns - c) * samplesPerColumn;
+        const auto columnEnd = columnStart + samplesPerColumn;
+
+        auto first = static_cast<juce::int64>(std::floor(columnStart / static_cast<double>(size)));
+        auto last = static_cast<juce::int64>(std::ceil(columnEnd / static_cast<double>(size)));
+        first = juce::jmax(first, oldest);
+        last = juce::jmin(last, written);
+
+        if (first >= last)
+            continue;
+
+        auto peak = emptyPeak;
+        for (auto i = first; i < last; ++i)
+        {
+            const auto& b = bucket(level, i);
+            peak.min = juce::jmin(peak.min, b.min);
+            peak.max = juce::jmax(peak.max, b.max);
+        }
+        columns[c] = peak;
+    }
+}
+
+//==============================================================================
+WaveformDisplay::WaveformDisplay(const WaveformHistory& historyToShow)
+    : history(historyToShow)
+{
+    setOpaque(true);
+    setTooltip("Output waveform, " + juce::String(WaveformHistory::getMemoryBytes() / 1024) + " KiB of min/max history. "
+               "Scroll to zoom from seconds to minutes.");
+}
+
+void WaveformDisplay::mouseWheelMove(const juce::MouseEvent&, const juce::MouseWheelDetails& wheel)
+{
+    const auto maxSeconds = juce::jmax(1.0, history.getMaxSeconds());
+    visibleSeconds = juce::jlimit(0.5, maxSeconds, visibleSeconds * std::pow(2.0, -wheel.deltaY * 4.0));
+    repaint();
+}
+
+void WaveformDisplay::paint(juce::Graphics& g)
+{
+    using CP = CyberpunkLookAndFeel;
+
+    const auto bounds = getLocalBounds();
+    g.fillAll(CP::matrixDarkBG);
+    g.setColour(juce::Colour(0xFF080812));
+    g.fillRoundedRectangle(bounds.toFloat(), 5.0f);
+    g.setColour(CP::matrixGreen.withAlpha(0.6f));
+    g.drawRoundedRectangle(bounds.toFloat().reduced(0.5f), 5.0f, 1.2f);
+
+    auto area = bounds.reduced(8);
+    const auto titleArea = area.removeFromLeft(72);
+
+    g.setFont(CyberpunkLookAndFeel::getCustomFont().withHeight(12.0f).boldened());
+    g.setColour(CP::matrixGreen);
+    g.drawText("OUTPUT", titleArea.withTrimmedBottom(titleArea.getHeight() / 2), juce::Justification::centredLeft);
+
+    g.setFont(CyberpunkLookAndFeel::getCustomFont().withHeight(10.0f));
+    g.setColour(CP::matrixCyan);
+    const auto span = visibleSeconds < 60.0 ? juce::String(visibleSeconds, 1) + " s"
+                                            : juce::String(visibleSeconds / 60.0, 1) + " min";
+    g.drawText(span, titleArea.withTrimmedTop(titleArea.getHeight() / 2), juce::Justification::centredLeft);
+
+    g.setColour(CP::matrixBlack);
+    g.fillRect(area);
+
+    const auto width = area.getWidth();
+    if (width <= 0)
+        return;
+
+    columns.resize(static_cast<size_t>(width));
+    history.getColumns(visibleSeconds, columns.data(), width);
+
+    const auto centre = static_cast<float>(area.getCentreY());
+    const auto halfHeight = static_cast<float>(area.getHeight()) * 0.5f;
+
+    g.setColour(CP::matrixGreen.withAlpha(0.2f));
+    g.drawHorizontalLine(area.getCentreY(), static_cast<float>(area.getX()), static_cast<float>(area.getRight()));
+
+    // One vertical span per pixel column
+    g.setColour(CP::matrixGreen);
+    for (int x = 0; x < width; ++x)
+    {
+        const auto& peak = columns[static_cast<size_t>(x)];
+        const auto top = centre - juce::jlimit(-1.0f, 1.0f, peak.max) * halfHeight;
+        const auto bottom = centre - juce::jlimit(-1.0f, 1.0f, peak.min) * halfHeight;
+        g.drawVerticalLine(area.getX() + x, top, juce::jmax(bottom, top + 1.0f));
+    }
+}
@@ -0,0 +1,103 @@
+#pragma once
+
+#include <juce_audio_basics/juce_audio_basics.h>
+#include <juce_gui_basics/juce_gui_basics.h>
+#include <limits>
+#include <vector>
+
+//==============================================================================
+/**
+ * WaveformHistory
+ *
+ * Recent output audio kept only as min/max peaks, in a pyramid of
+ * power-of-two levels: a level-0 bucket covers baseBucketSamples samples and
+ * each level above halves the resolution. Every level is a ring of the same
+ * number of buckets, so level k reaches 2^k times further back and the whole
+ * history lives in one allocation made in the constructor:
+ *
+ *   numLevels * bucketsPerLevel * sizeof(Peak) = 384 KiB
+ *   level 0: ~5.5 s, top level: ~3 h at 48 kHz
+ *
+ * append() is incremental: raw samples fold into the current level-0 bucket,
+ * and each completed bucket pair is merged one level up. getColumns() reads
+ * the level whose buckets are nearest below one column wide, so a view of any
+ * length costs a few buckets per column.
+ *
+ * Message thread only; fed by SignalAnalyser from the processor's output tap.
+ */
+class WaveformHistory
+{
+public:
+    static constexpr int baseBucketSamples = 64;
+    static constexpr int bucketsPerLevel = 4096;
+    static constexpr int numLevels = 12;
+
+    struct Peak
+    {
+        float min = 0.0f, max = 0.0f;
+    };
+
+    WaveformHistory() : peaks(static_cast<size_t>(numLevels * bucketsPerLevel)) {}
+
+    /** Adds numSamples of each channel; a new sample rate clears the history. */
+    void append(const juce::AudioBuffer<float>& audio, int numSamples, double sampleRate);
+    void clear();
+
+    /** Min/max of the newest `seconds` of audio in numColumns columns, oldest first.
+        Columns from before the history starts are empty ({0, 0}). */
+    void getColumns(double seconds, Peak* columns, int numColumns) const;
+
+    /** Longest view getColumns() can fill, at the current sample rate. */
+    double getMaxSeconds() const noexcept;
+
+    static constexpr size_t getMemoryBytes() noexcept
+    {
+        return static_cast<size_t>(numLevels) * bucketsPerLevel * sizeof(Peak);
+    }
+
+private:
+    static constexpr juce::int64 bucketSamples(int level) noexcept { return juce::int64(baseBucketSamples) << level; }
+
+    Peak& bucket(int level, juce::int64 index) noexcept
+    {
+        return peaks[static_cast<size_t>(level * bucketsPerLevel + index % bucketsPerLevel)];
+    }
+
+    const Peak& bucket(int level, juce::int64 index) const noexcept
+    {
+        return peaks[static_cast<size_t>(level * bucketsPerLevel + index % bucketsPerLevel)];
+    }
+
+    void completeBucket();
+
+    // Start of a running min/max: the first sample folded in replaces both ends
+    static constexpr Peak emptyPeak { std::numeric_limits<float>::infinity(), -std::numeric_limits<float>::infinity() };
+
+    std::vector<Peak> peaks;             // level-major rings
+    Peak pending = emptyPeak;            // level-0 bucket being filled
+    int pendingSamples = 0;
+    juce::int64 completedBuckets = 0;    // level-0 buckets written so far
+    double sampleRate = 0.0;
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(WaveformHistory)
+};
+
+//==============================================================================
+/** Scrolling min/max waveform of the output; the mouse wheel zooms from
+    seconds to minutes. */
+class WaveformDisplay : public juce::Component,
+                        public juce::SettableTooltipClient
+{
+public:
+    explicit WaveformDisplay(const WaveformHistory& historyToShow);
+
+    void paint(juce::Graphics&) override;
+    void mouseWheelMove(const juce::MouseEvent&, const juce::MouseWheelDetails&) override;
+
+private:
+    const WaveformHistory& history;
+    double visibleSeconds = 4.0;
+    std::vector<WaveformHistory::Peak> columns; // one per pixel, reused
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(WaveformDisplay)
+};